@@ -525,3 +525,43 @@ void aotgen(const char *outfile, char **argv, int argc)
 
    ACLEAR(units);
 }
+
+void cgen_jit_cache(jit_t *jit, const char *so_path)
+{
+   // Wait for any background compilation to finish
+   jit_cgen_barrier(jit);
+
+   jit_handle_t *handles LOCAL = NULL;
+   const int count = jit_get_hot_funcs(jit, &handles);
+   if (count == 0)
+      return;   // Cache is already up to date
+
+   llvm_obj_t *obj = llvm_obj_new("jitcache");
+   llvm_add_abi_version(obj);
+
+   for (int i = 0; i < count; i++)
+      llvm_cache_compile(obj, jit, handles[i]);
+
+   llvm_opt_level_t olevel = opt_get_int(OPT_OPTIMISE);
+   llvm_obj_finalise(obj, olevel);
+
+   char *objfile LOCAL = nvc_temp_file();
+   llvm_obj_emit(obj, objfile);
+
+   // Link to a temporary file first as the old cache may still be
+   // mapped into this process
+   char *tmpfile LOCAL = xasprintf("%s.%d", so_path, getpid());
+   preload_do_link(tmpfile, objfile);
+
+   if (remove(objfile) != 0)
+      warnf("remove: %s: %s", objfile, last_os_error());
+
+   if (rename(tmpfile, so_path) != 0)
+      warnf("rename: %s: %s", tmpfile, last_os_error());
+   else
+      jit_sign_cache(so_path);
+
+   if (opt_get_int(OPT_JIT_LOG))
+      debugf("saved %d function%s to code cache %s", count,
+             count != 1 ? "s" : "", so_path);
+}
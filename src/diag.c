@@ -93,6 +93,7 @@ static file_list_t      loc_files;
 static vhdl_severity_t  exit_severity = SEVERITY_ERROR;
 static diag_level_t     stderr_level = DIAG_DEBUG;
 static nvc_lock_t       diag_lock = 0;
+static nvc_lock_t       loc_lock = 0;
 
 static __thread diag_consumer_t consumer = NULL;
 
@@ -275,24 +276,27 @@ void loc_read(loc_t *loc, loc_rd_ctx_t *ctx)
          fatal("corrupt location file reference %x", old_ref);
 
       if (ctx->ref_map[old_ref] == FILE_INVALID) {
+         // Databases may be read concurrently by several threads
+         SCOPED_LOCK(loc_lock);
+
          for (unsigned i = 0; i < loc_files.count; i++) {
             if (strcmp(loc_files.items[i].name_str,
                        ctx->file_map[old_ref]) == 0)
                ctx->ref_map[old_ref] = loc_files.items[i].ref;
          }
-      }
 
-      if (ctx->ref_map[old_ref] == FILE_INVALID) {
-         loc_file_t new = {
-            .linebuf  = NULL,
-            .name_str = ctx->file_map[old_ref],
-            .ref      = loc_files.count
-         };
+         if (ctx->ref_map[old_ref] == FILE_INVALID) {
+            loc_file_t new = {
+               .linebuf  = NULL,
+               .name_str = ctx->file_map[old_ref],
+               .ref      = loc_files.count
+            };
 
-         APUSH(loc_files, new);
+            APUSH(loc_files, new);
 
-         ctx->ref_map[old_ref]  = new.ref;
-         ctx->file_map[old_ref] = NULL;   // Owned by loc_file_t now
+            ctx->ref_map[old_ref]  = new.ref;
+            ctx->file_map[old_ref] = NULL;   // Owned by loc_file_t now
+         }
       }
 
       new_ref = ctx->ref_map[old_ref];
@@ -560,21 +564,18 @@ static const char *diag_get_source(const loc_t *loc)
    if (file->linebuf == NULL && !file->tried_open) {
       file->tried_open = true;
 
+      // Opening a named pipe would block if the source was streamed
+      struct stat buf;
+      if (stat(file->name_str, &buf) != 0 || !S_ISREG(buf.st_mode))
+         return NULL;
+
       int fd = open(file->name_str, O_RDONLY);
       if (fd < 0)
          return NULL;
 
-      struct stat buf;
-      if (fstat(fd, &buf) != 0)
-         goto close_file;
-
-      if (!S_ISREG(buf.st_mode))
-         goto close_file;
-
       if (buf.st_size > 0)
          file->linebuf = map_file(fd, buf.st_size);
 
-   close_file:
       close(fd);
    }
 
@@ -49,6 +49,7 @@ typedef struct _elab_ctx {
    lib_t             library;
    hash_t           *generics;
    hash_t           *subprograms;
+   hash_t           *instances;
    eval_t           *eval;
    tree_list_t       enames;
 } elab_ctx_t;
@@ -59,6 +60,11 @@ typedef struct {
    tree_list_t external_names;
 } elab_copy_ctx_t;
 
+typedef struct {
+   tree_t      genvar;
+   tree_list_t copied_subs;
+} elab_genvar_ctx_t;
+
 typedef struct {
    lib_t    lib;
    ident_t  name;
@@ -1111,6 +1117,7 @@ static void elab_inherit_context(elab_ctx_t *ctx, const elab_ctx_t *parent)
    ctx->parent      = parent;
    ctx->eval        = parent->eval;
    ctx->subprograms = parent->subprograms;
+   ctx->instances   = parent->instances;
    ctx->root        = parent->root;
    ctx->dotted      = ctx->dotted ?: parent->dotted;
    ctx->path        = ctx->path ?: parent->path;
@@ -1119,6 +1126,133 @@ static void elab_inherit_context(elab_ctx_t *ctx, const elab_ctx_t *parent)
    ctx->out         = ctx->out ?: parent->out;
 }
 
+static bool elab_write_memo_value(text_buf_t *tb, tree_t value)
+{
+   switch (tree_kind(value)) {
+   case T_LITERAL:
+      switch (tree_subkind(value)) {
+      case L_INT:
+         tb_printf(tb, "%"PRIi64, tree_ival(value));
+         return true;
+      case L_REAL:
+         tb_printf(tb, "%a", tree_dval(value));
+         return true;
+      default:
+         return false;
+      }
+   case T_REF:
+      {
+         tree_t decl = tree_ref(value);
+         if (tree_kind(decl) != T_ENUM_LIT)
+            return false;
+
+         tb_printf(tb, "'%u", tree_pos(decl));
+         return true;
+      }
+   case T_STRING:
+      {
+         tb_append(tb, '"');
+         const int nchars = tree_chars(value);
+         for (int i = 0; i < nchars; i++)
+            tb_istr(tb, tree_ident(tree_char(value, i)));
+         tb_append(tb, '"');
+         return true;
+      }
+   default:
+      return false;
+   }
+}
+
+static ident_t elab_memo_key(tree_t inst, tree_t arch)
+{
+   // Instances of the same architecture with identical constant
+   // generic values can share a single elaborated copy of it
+
+   const tree_kind_t kind = tree_kind(tree_ref(inst));
+   if (kind != T_ENTITY && kind != T_ARCH)
+      return NULL;
+
+   tree_t entity = tree_primary(arch);
+
+   const int ngenerics = tree_generics(entity);
+   for (int i = 0; i < ngenerics; i++) {
+      if (tree_class(tree_generic(entity, i)) != C_CONSTANT)
+         return NULL;
+   }
+
+   const int nports = tree_ports(entity);
+   for (int i = 0; i < nports; i++) {
+      if (tree_flags(tree_port(entity, i)) & TREE_F_UNCONSTRAINED)
+         return NULL;
+   }
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   tb_istr(tb, tree_ident(arch));
+
+   const int ngenmaps = tree_genmaps(inst);
+   for (int i = 0; i < ngenmaps; i++) {
+      tree_t map = tree_genmap(inst, i);
+      if (tree_subkind(map) != P_POS)
+         return NULL;
+
+      tb_printf(tb, "%c%d=", i == 0 ? '(' : ',', tree_pos(map));
+      if (!elab_write_memo_value(tb, tree_value(map)))
+         return NULL;
+   }
+
+   if (ngenmaps > 0)
+      tb_append(tb, ')');
+
+   return ident_new(tb_get(tb));
+}
+
+static void elab_shareable_cb(tree_t t, void *ctx)
+{
+   bool *shareable = ctx;
+
+   switch (tree_kind(t)) {
+   case T_ATTR_REF:
+      {
+         // These are lowered to a different string in each instance
+         const attr_kind_t which = tree_subkind(t);
+         if (which == ATTR_PATH_NAME || which == ATTR_INSTANCE_NAME)
+            *shareable = false;
+      }
+      break;
+   case T_FUNC_DECL:
+   case T_PROC_DECL:
+      if (!(tree_flags(t) & TREE_F_PREDEFINED))
+         *shareable = false;
+      break;
+   case T_FUNC_BODY:
+   case T_PROC_BODY:
+   case T_FUNC_INST:
+   case T_PROC_INST:
+   case T_PROT_BODY:
+   case T_PACKAGE:
+   case T_PACK_BODY:
+   case T_PACK_INST:
+   case T_EXTERNAL_NAME:
+      // Have names or scopes which are specific to one instance
+      *shareable = false;
+      break;
+   default:
+      break;
+   }
+}
+
+static bool elab_is_shareable(tree_t arch_copy, const elab_ctx_t *ctx)
+{
+   if (ctx->enames.count > 0)
+      return false;
+
+   bool shareable = true;
+   tree_visit(tree_primary(arch_copy), elab_shareable_cb, &shareable);
+   tree_visit(arch_copy, elab_shareable_cb, &shareable);
+
+   return shareable;
+}
+
 static void elab_instance(tree_t t, const elab_ctx_t *ctx)
 {
    tree_t arch = NULL, config = NULL;
@@ -1182,10 +1316,19 @@ static void elab_instance(tree_t t, const elab_ctx_t *ctx)
 
    elab_subprogram_prefix(arch, &new_ctx);
 
-   tree_t arch_copy;
-   if (config != NULL)
+   ident_t key = NULL;
+   tree_t arch_copy = NULL;
+   if (config == NULL && (key = elab_memo_key(t, arch))) {
+      if ((arch_copy = hash_get(ctx->instances, key)) == (void *)-1) {
+         key = NULL;   // Cannot be shared
+         arch_copy = NULL;
+      }
+   }
+
+   const bool memo_hit = (arch_copy != NULL);
+   if (!memo_hit && config != NULL)
       arch_copy = elab_root_config(config, &new_ctx);
-   else
+   else if (!memo_hit)
       arch_copy = elab_copy(arch, &new_ctx);
 
    tree_t entity = tree_primary(arch_copy);
@@ -1195,16 +1338,25 @@ static void elab_instance(tree_t t, const elab_ctx_t *ctx)
    elab_context(entity);
    elab_context(arch_copy);
    elab_generics(entity, comp, t, &new_ctx);
-   simplify_global(entity, new_ctx.generics, ctx->eval);
+   if (!memo_hit)
+      simplify_global(entity, new_ctx.generics, ctx->eval);
    elab_ports(entity, comp, t, &new_ctx);
    elab_decls(entity, &new_ctx);
 
    if (error_count() == 0) {
       bounds_check(b);
-      diag_add_hint_fn(elab_hint_fn, t);
-      simplify_global(arch_copy, new_ctx.generics, ctx->eval);
-      bounds_check(arch_copy);
-      diag_remove_hint_fn(elab_hint_fn);
+
+      if (!memo_hit) {
+         diag_add_hint_fn(elab_hint_fn, t);
+         simplify_global(arch_copy, new_ctx.generics, ctx->eval);
+         bounds_check(arch_copy);
+         diag_remove_hint_fn(elab_hint_fn);
+      }
+   }
+
+   if (key != NULL && !memo_hit && error_count() == 0) {
+      const bool shareable = elab_is_shareable(arch_copy, &new_ctx);
+      hash_put(ctx->instances, key, shareable ? arch_copy : (void *)-1);
    }
 
    if (error_count() == 0)
@@ -1389,10 +1541,68 @@ static void elab_pop_scope(elab_ctx_t *ctx)
    }
 }
 
-static bool elab_copy_genvar_cb(tree_t t, void *ctx)
+static bool elab_copy_genvar_cb(tree_t t, void *__ctx)
 {
-   tree_t genvar = ctx;
-   return tree_kind(t) == T_REF && tree_ref(t) == genvar;
+   elab_genvar_ctx_t *ctx = __ctx;
+
+   switch (tree_kind(t)) {
+   case T_REF:
+      return tree_ref(t) == ctx->genvar;
+   case T_FUNC_DECL:
+   case T_PROC_DECL:
+      return !(tree_flags(t) & TREE_F_PREDEFINED);
+   case T_FUNC_BODY:
+   case T_PROC_BODY:
+   case T_FUNC_INST:
+   case T_PROC_INST:
+      // Subprograms may refer to attributes such as 'PATH_NAME which
+      // differ between iterations so each needs its own copy
+      return true;
+   default:
+      return false;
+   }
+}
+
+static void elab_genvar_copy_cb(tree_t t, void *__ctx)
+{
+   elab_genvar_ctx_t *ctx = __ctx;
+
+   if (is_subprogram(t))
+      APUSH(ctx->copied_subs, t);
+}
+
+static void elab_rename_generate_subs(elab_genvar_ctx_t *gctx, ident_t from,
+                                      ident_t to, const elab_ctx_t *ctx)
+{
+   // Replace the generate label in the mangled name of each copied
+   // subprogram with the label of this iteration
+   const size_t fromlen = ident_len(from);
+   for (unsigned i = 0; i < gctx->copied_subs.count; i++) {
+      tree_t decl = gctx->copied_subs.items[i];
+      if (tree_kind(decl) == T_GENERIC_DECL)
+         continue;   // Does not yet have mangled name
+
+      ident_t orig = tree_ident2(decl);
+      if (!ident_starts_with(orig, from) || istr(orig)[fromlen] != '.')
+         continue;
+
+      LOCAL_TEXT_BUF tb = tb_new();
+      tb_istr(tb, to);
+      tb_cat(tb, istr(orig) + fromlen);
+
+      ident_t mangled = ident_new(tb_get(tb));
+      tree_set_ident2(decl, mangled);
+
+      const tree_kind_t kind = tree_kind(decl);
+      const bool may_need_to_lower =
+         kind == T_FUNC_BODY || kind == T_PROC_BODY
+         || kind == T_FUNC_INST || kind == T_PROC_INST
+         || (kind == T_FUNC_DECL && tree_subkind(decl) != S_USER);
+
+      if (may_need_to_lower)
+         hash_put(ctx->subprograms, mangled, decl);
+   }
+   ACLEAR(gctx->copied_subs);
 }
 
 static void elab_generate_range(tree_t r, int64_t *low, int64_t *high,
@@ -1468,8 +1678,11 @@ static void elab_for_generate(tree_t t, const elab_ctx_t *ctx)
       tree_add_generic(b, g);
       tree_add_genmap(b, map);
 
+      elab_genvar_ctx_t gctx = { .genvar = g };
+
       tree_t roots[] = { t };
-      tree_copy(roots, 1, elab_copy_genvar_cb, NULL, NULL, NULL, g);
+      tree_copy(roots, 1, elab_copy_genvar_cb, NULL,
+                elab_genvar_copy_cb, NULL, &gctx);
 
       tree_t copy = roots[0];
 
@@ -1478,6 +1691,9 @@ static void elab_for_generate(tree_t t, const elab_ctx_t *ctx)
       ident_t ninst = hpathf(ctx->inst, ':', "%s(%"PRIi64")", label, i);
       ident_t ndotted = ident_prefix(ctx->dotted, id, '.');
 
+      elab_rename_generate_subs(&gctx, ident_prefix(ctx->dotted, base, '.'),
+                                ndotted, ctx);
+
       elab_ctx_t new_ctx = {
          .out      = b,
          .path     = npath,
@@ -1872,6 +2088,7 @@ tree_t elab(tree_t top)
    };
 
    ctx.subprograms = hash_new(256);
+   ctx.instances   = hash_new(64);
 
    eval_set_lower_fn(ctx.eval, elab_lower_cb, ctx.subprograms);
 
@@ -1896,6 +2113,7 @@ tree_t elab(tree_t top)
    }
 
    hash_free(ctx.subprograms);
+   hash_free(ctx.instances);
    eval_free(ctx.eval);
 
    if (error_count() > 0)
@@ -18,6 +18,7 @@
 #include "util.h"
 #include "fbuf.h"
 #include "fastlz.h"
+#include "thread.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -86,7 +87,8 @@ struct _fbuf {
    fbuf_zip_t   zip;
 };
 
-static fbuf_t *open_list = NULL;
+static fbuf_t     *open_list = NULL;
+static nvc_lock_t  open_lock = 0;
 
 #define ADLER_MOD		65521
 #define ADLER_CHUNK_LEN_32	5552
@@ -363,7 +365,7 @@ static void fbuf_decompress(fbuf_t *f)
 
    f->origsz = len;
    f->checksum.expect = checksum;
-   f->rbuf = xmalloc(f->origsz);
+   f->rbuf = xmalloc(f->origsz + 16);   // Final block may be padded
 
    for (uint8_t *dst = f->rbuf, *src = rmap + 16; dst < f->rbuf + f->origsz;) {
       const uint32_t blksz = UNPACK_BE32(src);
@@ -398,7 +400,6 @@ static fbuf_t *fbuf_new(FILE *file, char *fname, fbuf_mode_t mode,
    f->file  = file;
    f->fname = fname;
    f->mode  = mode;
-   f->next  = open_list;
    f->zip   = zip;
 
    checksum_init(&(f->checksum), csum);
@@ -410,6 +411,10 @@ static fbuf_t *fbuf_new(FILE *file, char *fname, fbuf_mode_t mode,
    else
       fbuf_decompress(f);
 
+   SCOPED_LOCK(open_lock);
+
+   f->next = open_list;
+
    if (open_list != NULL)
       open_list->prev = f;
 
@@ -443,6 +448,10 @@ static void fbuf_maybe_flush(fbuf_t *f, size_t more)
 {
    assert(more <= BLOCK_SIZE);
    if (f->wpend + more > BLOCK_SIZE) {
+      // Padding is not included in the decompressed length so that
+      // readers can locate data relative to the end of the file
+      f->wtotal += f->wpend;
+
       if (f->wpend < 16) {
          // Write dummy bytes at end to meet fastlz block size requirement
          memset(f->wbuf + f->wpend, '\0', 16 - f->wpend);
@@ -461,7 +470,6 @@ static void fbuf_maybe_flush(fbuf_t *f, size_t more)
 
       fbuf_write_raw(f, out, ret);
 
-      f->wtotal += f->wpend;
       f->wpend = 0;
    }
 }
@@ -490,16 +498,20 @@ void fbuf_close(fbuf_t *f, uint32_t *checksum)
 
    fclose(f->file);
 
-   if (f->prev == NULL) {
-      assert(f == open_list);
-      if (f->next != NULL)
-         f->next->prev = NULL;
-      open_list = f->next;
-   }
-   else {
-      f->prev->next = f->next;
-      if (f->next != NULL)
-         f->next->prev = f->prev;
+   {
+      SCOPED_LOCK(open_lock);
+
+      if (f->prev == NULL) {
+         assert(f == open_list);
+         if (f->next != NULL)
+            f->next->prev = NULL;
+         open_list = f->next;
+      }
+      else {
+         f->prev->next = f->next;
+         if (f->next != NULL)
+            f->next->prev = f->prev;
+      }
    }
 
    if (checksum != NULL)
@@ -581,6 +593,32 @@ void write_double(double d, fbuf_t *f)
    write_u64(u.i, f);
 }
 
+size_t fbuf_tell(fbuf_t *f)
+{
+   if (f->mode == FBUF_OUT)
+      return f->wtotal + f->wpend;
+   else
+      return f->rptr;
+}
+
+void fbuf_seek(fbuf_t *f, ptrdiff_t offset, int whence)
+{
+   assert(f->mode == FBUF_IN);
+
+   switch (whence) {
+   case SEEK_SET: break;
+   case SEEK_CUR: offset += f->rptr; break;
+   case SEEK_END: offset += f->origsz; break;
+   default:
+      fatal_trace("invalid whence %d", whence);
+   }
+
+   if (offset < 0 || offset > f->origsz)
+      fatal_trace("seek to invalid offset %td in %s", offset, f->fname);
+
+   f->rptr = offset;
+}
+
 uint64_t fbuf_get_uint(fbuf_t *f)
 {
    uint8_t dec[10];
@@ -44,6 +44,8 @@ fbuf_t *fbuf_fdopen(int fd, fbuf_mode_t mode, fbuf_cs_t csum);
 void fbuf_close(fbuf_t *f, uint32_t *checksum);
 void fbuf_cleanup(void);
 const char *fbuf_file_name(fbuf_t *f);
+size_t fbuf_tell(fbuf_t *f);
+void fbuf_seek(fbuf_t *f, ptrdiff_t offset, int whence);
 
 int64_t fbuf_get_int(fbuf_t *f);
 uint64_t fbuf_get_uint(fbuf_t *f);
@@ -37,7 +37,9 @@
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -51,22 +53,49 @@
 #include <dlfcn.h>
 #endif
 
-#define FUNC_HASH_SZ    1024
-#define FUNC_LIST_SZ    512
-#define COMPILE_TIMEOUT 100000
+#define FUNC_HASH_SZ     1024
+#define FUNC_LIST_SZ     512
+#define COMPILE_TIMEOUT  100000
+#define MAX_CGEN_THREADS 16
 
 typedef struct _jit_tier {
    jit_tier_t    *next;
    int            threshold;
    jit_plugin_t   plugin;
    void          *context;
+   unsigned       ncompiled;
+   uint64_t       queue_us;
+   uint64_t       max_queue_us;
+   uint64_t       compile_us;
 } jit_tier_t;
 
+typedef struct {
+   jit_func_t *func;
+   jit_tier_t *tier;
+   uint64_t    queued_us;
+} cgen_request_t;
+
+typedef A(cgen_request_t) cgen_request_list_t;
+
+typedef struct {
+   nvc_lock_t           lock;
+   cgen_request_list_t  pending;
+   int                  active;
+   unsigned             cancelled;
+   int                  nthreads;
+   nvc_thread_t        *threads[MAX_CGEN_THREADS];
+} cgen_queue_t;
+
 typedef struct {
    size_t      length;
    jit_func_t *items[0];
 } func_array_t;
 
+typedef struct {
+   unsigned calls;
+   unsigned backedges;
+} jit_profile_t;
+
 typedef struct _aot_dll {
    jit_dll_t  *dll;
    jit_pack_t *pack;
@@ -100,21 +129,46 @@ typedef struct _jit {
    jit_tier_t     *tiers;
    aot_dll_t      *aotlib;
    aot_dll_t      *preloadlib;
+   aot_dll_t      *cachelib;
    func_array_t   *funcs;
    unsigned        next_handle;
    nvc_lock_t      lock;
    int32_t        *cover_mem[4];
+   int32_t        *cover_owned;
+   hash_t         *profile;
+   char           *profile_file;
+   cgen_queue_t    cgenq;
+   unsigned        counters;
 } jit_t;
 
+static void jit_cgen_shutdown(jit_t *j);
+
+static inline uint64_t jit_heat(unsigned calls, unsigned backedges)
+{
+   return (uint64_t)calls + backedges / JIT_LOOP_WEIGHT;
+}
+
 static void jit_oom_cb(mspace_t *m, size_t size)
 {
    diag_t *d = diag_new(DIAG_FATAL, NULL);
    diag_printf(d, "out of memory attempting to allocate %zu byte object", size);
 
-   const size_t heapsize = opt_get_size(OPT_HEAP_SIZE);
-   diag_hint(d, NULL, "the current heap size is %zu bytes which you can "
-             "increase with the $bold$-H$$ option, for example $bold$-H %zum$$",
-             heapsize, MAX(1, (heapsize * 2) / 1024 / 1024));
+   mspace_stats_t stats;
+   mspace_get_stats(m, &stats);
+
+   if (stats.limited)
+      diag_hint(d, NULL, "the heap has grown to %zu bytes and cannot grow "
+                "past its hard limit of %zu bytes as no more address space "
+                "could be reserved; check the virtual memory limit set with "
+                "$bold$ulimit -v$$", stats.heap_size, stats.reserved);
+   else
+      diag_hint(d, NULL, "the heap has grown to %zu bytes and cannot grow "
+                "past its hard limit of %zu bytes which is set from the soft "
+                "limit of %zu bytes; you can increase the soft limit with the "
+                "$bold$--heap-limit$$ option, for example "
+                "$bold$--heap-limit=%zum$$", stats.heap_size, stats.reserved,
+                stats.soft_limit,
+                MAX(1, (stats.soft_limit * 2) / 1024 / 1024));
 
    diag_emit(d);
    jit_abort(EXIT_FAILURE);
@@ -136,7 +190,8 @@ jit_t *jit_new(void)
 {
    jit_t *j = xcalloc(sizeof(jit_t));
    j->index = chash_new(FUNC_HASH_SZ);
-   j->mspace = mspace_new(opt_get_size(OPT_HEAP_SIZE));
+   j->mspace = mspace_new_growable(opt_get_size(OPT_HEAP_SIZE),
+                                   opt_get_size(OPT_HEAP_LIMIT));
 
    j->funcs = xcalloc_flex(sizeof(func_array_t),
                            FUNC_LIST_SZ, sizeof(jit_func_t *));
@@ -144,6 +199,8 @@ jit_t *jit_new(void)
 
    mspace_set_oom_handler(j->mspace, jit_oom_cb);
 
+   j->counters = MAX(opt_get_int(OPT_JIT_COUNTERS), 0);
+
    // Ensure we can resolve symbols from the executable
    ffi_load_dll(NULL);
 
@@ -155,17 +212,255 @@ static void jit_free_func(jit_func_t *f)
    jit_free_cfg(f);
    mptr_free(f->jit->mspace, &(f->privdata));
    free(f->irbuf);
+   free(f->predecode);
    free(f->linktab);
+   if (f->counters != NULL) {
+      free(f->counters->ops);
+      free(f->counters->sites);
+      ihash_free(f->counters->index);
+      free(f->counters);
+   }
+   free(f->inlines);
    if (f->owns_cpool) free(f->cpool);
    free(f);
 }
 
+static void jit_print_stats(jit_t *j)
+{
+   for (int i = 0; i < j->next_handle; i++) {
+      jit_func_t *f = j->funcs->items[i];
+      if (f->calls == 0 || !opt_get_verbose(OPT_JIT_VERBOSE, istr(f->name)))
+         continue;
+
+      const bool compiled = load_acquire(&f->entry) != jit_interp;
+      debugf("%s: %u call%s, %u backedge%s, %s", istr(f->name), f->calls,
+             f->calls != 1 ? "s" : "", f->backedges,
+             f->backedges != 1 ? "s" : "",
+             compiled ? "compiled" : "interpreted");
+   }
+
+   for (jit_tier_t *t = j->tiers; t; t = t->next) {
+      if (t->ncompiled == 0)
+         continue;
+
+      debugf("%s tier: compiled %u function%s in %"PRIu64" ms; queue latency "
+             "mean %"PRIu64" us, max %"PRIu64" us", t->plugin.name,
+             t->ncompiled, t->ncompiled != 1 ? "s" : "",
+             t->compile_us / 1000, t->queue_us / t->ncompiled,
+             t->max_queue_us);
+   }
+
+   if (j->cgenq.cancelled > 0)
+      debugf("cancelled %u queued compilation%s at shutdown",
+             j->cgenq.cancelled, j->cgenq.cancelled != 1 ? "s" : "");
+}
+
+static int jit_cmp_rows(const void *a, const void *b)
+{
+   const uint64_t ca = ((const counter_row_t *)a)->count;
+   const uint64_t cb = ((const counter_row_t *)b)->count;
+   return ca < cb ? 1 : (ca > cb ? -1 : 0);
+}
+
+static void jit_merge_rows(counter_row_list_t *list, const counter_row_t *row)
+{
+   for (int i = 0; i < list->count; i++) {
+      if (list->items[i].kind == row->kind) {
+         list->items[i].count += row->count;
+         return;
+      }
+   }
+
+   APUSH(*list, *row);
+}
+
+void jit_summarise_counters(jit_t *j, jit_counter_summary_t *s)
+{
+   memset(s, '\0', sizeof(jit_counter_summary_t));
+
+   for (int i = 0; i < j->next_handle; i++) {
+      jit_func_t *f = j->funcs->items[i];
+      jit_counters_t *c = f->counters;
+      if (c == NULL)
+         continue;
+
+      for (int k = 0; k < c->nsites; k++) {
+         const counter_row_t row = {
+            .count = c->sites[k].count,
+            .func  = f,
+            .irpos = c->sites[k].irpos,
+            .kind  = c->sites[k].which,
+         };
+         APUSH(s->sites, row);
+         jit_merge_rows(&s->kinds, &row);
+         s->nexits += row.count;
+      }
+
+      if (c->ops == NULL)
+         continue;
+
+      uint64_t byop[256] = {};
+      counter_row_t total = { .func = f, .kind = J_NOP };
+      for (int k = 0; k < f->nirs; k++) {
+         const jit_op_t op = f->irbuf[k].op;
+         if (op == J_DEBUG || op == J_NOP)
+            continue;   // Not executed by the threaded interpreter
+
+         byop[op] += c->ops[k];
+         total.count += c->ops[k];
+      }
+
+      for (int op = 0; op < ARRAY_LEN(byop); op++) {
+         if (byop[op] == 0)
+            continue;
+
+         const counter_row_t row = { .count = byop[op], .kind = op };
+         jit_merge_rows(&s->ops, &row);
+
+         if (byop[op] > byop[total.kind])
+            total.kind = op;
+      }
+
+      if (total.count > 0)
+         APUSH(s->funcs, total);
+
+      s->nops += total.count;
+   }
+
+   qsort(s->sites.items, s->sites.count, sizeof(counter_row_t), jit_cmp_rows);
+   qsort(s->kinds.items, s->kinds.count, sizeof(counter_row_t), jit_cmp_rows);
+   qsort(s->ops.items, s->ops.count, sizeof(counter_row_t), jit_cmp_rows);
+   qsort(s->funcs.items, s->funcs.count, sizeof(counter_row_t), jit_cmp_rows);
+}
+
+void jit_free_counter_summary(jit_counter_summary_t *s)
+{
+   ACLEAR(s->sites);
+   ACLEAR(s->kinds);
+   ACLEAR(s->ops);
+   ACLEAR(s->funcs);
+}
+
+static void jit_print_counters(jit_t *j)
+{
+   jit_counter_summary_t s;
+   jit_summarise_counters(j, &s);
+
+   const int limit = j->counters;
+
+   if (s.nexits > 0) {
+      debugf("%-24s %14s %7s", "Exit", "Count", "Share");
+      for (int i = 0; i < MIN(s.kinds.count, limit); i++)
+         debugf("%-24s %14"PRIu64" %6.1f%%",
+                jit_exit_name(s.kinds.items[i].kind), s.kinds.items[i].count,
+                s.kinds.items[i].count * 100.0 / s.nexits);
+
+      debugf("%-24s %14s  %s", "Exit", "Count", "Call site");
+      for (int i = 0; i < MIN(s.sites.count, limit); i++)
+         debugf("%-24s %14"PRIu64"  %s+%u",
+                jit_exit_name(s.sites.items[i].kind), s.sites.items[i].count,
+                istr(s.sites.items[i].func->name), s.sites.items[i].irpos);
+   }
+
+   if (s.nops > 0) {
+      debugf("%-24s %14s %7s", "Opcode", "Count", "Share");
+      for (int i = 0; i < MIN(s.ops.count, limit); i++)
+         debugf("%-24s %14"PRIu64" %6.1f%%", jit_op_name(s.ops.items[i].kind),
+                s.ops.items[i].count, s.ops.items[i].count * 100.0 / s.nops);
+
+      debugf("%-24s %14s  %s", "Top opcode", "Count", "Interpreted function");
+      for (int i = 0; i < MIN(s.funcs.count, limit); i++)
+         debugf("%-24s %14"PRIu64"  %s", jit_op_name(s.funcs.items[i].kind),
+                s.funcs.items[i].count, istr(s.funcs.items[i].func->name));
+   }
+
+   if (s.nexits > 0 || s.nops > 0)
+      debugf("%"PRIu64" exit%s from %u site%s; %"PRIu64" interpreted "
+             "instruction%s in %u function%s", s.nexits,
+             s.nexits != 1 ? "s" : "", s.sites.count,
+             s.sites.count != 1 ? "s" : "", s.nops, s.nops != 1 ? "s" : "",
+             s.funcs.count, s.funcs.count != 1 ? "s" : "");
+
+   jit_free_counter_summary(&s);
+}
+
+static void jit_save_profile(jit_t *j)
+{
+   // Keep a decaying average of the counts so the profile follows the
+   // recent runs rather than growing without bound: entries for
+   // functions not called in this run decay away
+   hash_iter_t it = HASH_BEGIN;
+   const void *key;
+   void *value;
+   while (hash_iter(j->profile, &it, &key, &value)) {
+      jit_profile_t *p = value;
+      p->calls /= 2;
+      p->backedges /= 2;
+   }
+
+   for (int i = 0; i < j->next_handle; i++) {
+      jit_func_t *f = j->funcs->items[i];
+      if (f->calls == 0 && f->backedges == 0)
+         continue;
+
+      jit_profile_t *p = hash_get(j->profile, f->name);
+      if (p == NULL) {
+         p = xcalloc(sizeof(jit_profile_t));
+         p->calls     = f->calls;
+         p->backedges = f->backedges;
+         hash_put(j->profile, f->name, p);
+      }
+      else {
+         p->calls     += (f->calls + 1) / 2;
+         p->backedges += (f->backedges + 1) / 2;
+      }
+   }
+
+   // Write to a temporary file first so a concurrent run never reads a
+   // partially written profile
+   char *tmpfile LOCAL = xasprintf("%s.%d", j->profile_file, getpid());
+
+   FILE *file = fopen(tmpfile, "w");
+   if (file == NULL)
+      warnf("cannot create %s: %s", tmpfile, last_os_error());
+
+   it = HASH_BEGIN;
+   while (hash_iter(j->profile, &it, &key, &value)) {
+      const jit_profile_t *p = value;
+      if (file != NULL && (p->calls > 0 || p->backedges > 0))
+         fprintf(file, "%u %u %s\n", p->calls, p->backedges,
+                 istr((ident_t)key));
+      free(value);
+   }
+
+   if (file != NULL) {
+      fclose(file);
+
+      if (rename(tmpfile, j->profile_file) != 0) {
+         warnf("rename: %s: %s", tmpfile, last_os_error());
+         remove(tmpfile);
+      }
+   }
+
+   hash_free(j->profile);
+   free(j->profile_file);
+}
+
 void jit_free(jit_t *j)
 {
    store_release(&j->shutdown, true);
-   async_barrier();
+   jit_cgen_shutdown(j);
+
+   if (opt_get_str(OPT_JIT_VERBOSE) != NULL)
+      jit_print_stats(j);
+
+   if (j->counters > 0)
+      jit_print_counters(j);
 
-   aot_dll_t *libs[] = { j->aotlib, j->preloadlib };
+   if (j->profile != NULL)
+      jit_save_profile(j);
+
+   aot_dll_t *libs[] = { j->aotlib, j->preloadlib, j->cachelib };
    for (int i = 0; i < ARRAY_LEN(libs); i++) {
       if (libs[i] != NULL) {
          ffi_unload_dll(libs[i]->dll);
@@ -178,8 +473,7 @@ void jit_free(jit_t *j)
       jit_free_func(j->funcs->items[i]);
    free(j->funcs);
 
-   for (int i = 0; i < ARRAY_LEN(j->cover_mem); i++)
-      free(j->cover_mem[i]);
+   free(j->cover_owned);
 
    if (j->layouts != NULL) {
       hash_iter_t it = HASH_BEGIN;
@@ -240,6 +534,84 @@ static void jit_install(jit_t *j, jit_func_t *f)
    if (f->unit) chash_put(j->index, f->unit, f);
 }
 
+static void jit_init_counters(jit_t *j, jit_func_t *f)
+{
+   if (j->counters == 0)
+      return;
+
+   f->counters = xcalloc(sizeof(jit_counters_t));
+   f->counters->index = ihash_new(16);
+}
+
+static jit_handle_t jit_lazy_compile_locked(jit_t *j, ident_t name);
+
+static void jit_apply_relocs(jit_t *j, aot_descr_t *descr)
+{
+   assert_lock_held(&j->lock);
+
+   for (aot_reloc_t *r = descr->relocs; r->kind != RELOC_NULL; r++) {
+      const char *str = (char *)r->ptr;
+      if (r->kind == RELOC_FOREIGN) {
+         const char *eptr = strchr(str, '\b');
+         if (eptr == NULL)
+            fatal_trace("invalid foreign reloc '%s'", str);
+
+         ffi_spec_t spec = ffi_spec_new(str, eptr - str);
+
+         ident_t id = ident_new(eptr + 1);
+         r->ptr = jit_ffi_get(id) ?: jit_ffi_bind(id, spec, NULL);
+      }
+      else if (r->kind == RELOC_COVER) {
+         // TODO: get rid of the double indirection here by
+         //       allocating coverage memory earlier
+         if (strcmp(str, "stmt") == 0)
+            r->ptr = &(j->cover_mem[JIT_COVER_STMT]);
+         else if (strcmp(str, "branch") == 0)
+            r->ptr = &(j->cover_mem[JIT_COVER_BRANCH]);
+         else if (strcmp(str, "expr") == 0)
+            r->ptr = &(j->cover_mem[JIT_COVER_EXPRESSION]);
+         else if (strcmp(str, "toggle") == 0)
+            r->ptr = &(j->cover_mem[JIT_COVER_TOGGLE]);
+         else
+            fatal_trace("relocation against invalid coverage kind %s", str);
+      }
+      else {
+         jit_handle_t h = jit_lazy_compile_locked(j, ident_new(str));
+         if (h == JIT_HANDLE_INVALID)
+            fatal_trace("relocation against invalid function %s", str);
+
+         switch (r->kind) {
+         case RELOC_FUNC:
+            r->ptr = jit_get_func(j, h);
+            break;
+         case RELOC_HANDLE:
+            r->ptr = (void *)(uintptr_t)h;
+            break;
+         case RELOC_PRIVDATA:
+            r->ptr = jit_get_privdata_ptr(j, jit_get_func(j, h));
+            break;
+         default:
+            fatal_trace("unhandled relocation kind %d", r->kind);
+         }
+      }
+   }
+}
+
+static void jit_init_hotness(jit_t *j, jit_func_t *f)
+{
+   f->next_tier = j->tiers;
+   f->hotness   = f->next_tier ? f->next_tier->threshold : 0;
+
+   jit_profile_t *p;
+   if (f->next_tier != NULL && j->profile != NULL
+       && (p = hash_get(j->profile, f->name)) != NULL) {
+      // Functions that were hot in a previous run are compiled as soon
+      // as they are first called
+      const uint64_t heat = jit_heat(p->calls, p->backedges);
+      f->hotness = heat < f->hotness ? f->hotness - heat : 1;
+   }
+}
+
 static jit_handle_t jit_lazy_compile_locked(jit_t *j, ident_t name)
 {
    assert_lock_held(&j->lock);
@@ -264,17 +636,15 @@ static jit_handle_t jit_lazy_compile_locked(jit_t *j, ident_t name)
       }
    }
 
-   vcode_unit_t vu = vcode_find_unit(name);
+   // Avoid reading vcode from the library when there is AOT code
+   vcode_unit_t vu = descr ? NULL : vcode_find_unit(name);
 
    if (vu == NULL && descr == NULL) {
       if (opt_get_verbose(OPT_JIT_VERBOSE, NULL))
          debugf("loading vcode for %s", istr(name));
 
-      tree_t unit = lib_get_qualified(name);
-      if (unit != NULL && tree_kind(unit) == T_PACKAGE)
-         (void)body_of(unit);  // Make sure body is loaded
-
-      vu = vcode_find_unit(name);
+      if (lib_load_vcode(name, true))
+         vu = vcode_find_unit(name);
    }
 
    ident_t alias = NULL;
@@ -302,11 +672,12 @@ static jit_handle_t jit_lazy_compile_locked(jit_t *j, ident_t name)
    f->unit      = vu;
    f->jit       = j;
    f->handle    = j->next_handle++;
-   f->next_tier = j->tiers;
-   f->hotness   = f->next_tier ? f->next_tier->threshold : 0;
    f->entry     = descr ? descr->entry : jit_interp;
    f->object    = vu ? vcode_unit_object(vu) : NULL;
 
+   jit_init_hotness(j, f);
+   jit_init_counters(j, f);
+
    // Install now to allow circular references in relocations
    jit_install(j, f);
 
@@ -314,53 +685,7 @@ static jit_handle_t jit_lazy_compile_locked(jit_t *j, ident_t name)
       chash_put(j->index, name, f);
 
    if (descr != NULL) {
-      for (aot_reloc_t *r = descr->relocs; r->kind != RELOC_NULL; r++) {
-         const char *str = (char *)r->ptr;
-         if (r->kind == RELOC_FOREIGN) {
-            const char *eptr = strchr(str, '\b');
-            if (eptr == NULL)
-               fatal_trace("invalid foreign reloc '%s'", str);
-
-            ffi_spec_t spec = ffi_spec_new(str, eptr - str);
-
-            ident_t id = ident_new(eptr + 1);
-            r->ptr = jit_ffi_get(id) ?: jit_ffi_bind(id, spec, NULL);
-         }
-         else if (r->kind == RELOC_COVER) {
-            // TODO: get rid of the double indirection here by
-            //       allocating coverage memory earlier
-            if (strcmp(str, "stmt") == 0)
-               r->ptr = &(j->cover_mem[JIT_COVER_STMT]);
-            else if (strcmp(str, "branch") == 0)
-               r->ptr = &(j->cover_mem[JIT_COVER_BRANCH]);
-            else if (strcmp(str, "expr") == 0)
-               r->ptr = &(j->cover_mem[JIT_COVER_EXPRESSION]);
-            else if (strcmp(str, "toggle") == 0)
-               r->ptr = &(j->cover_mem[JIT_COVER_TOGGLE]);
-            else
-               fatal_trace("relocation against invalid coverage kind %s", str);
-         }
-         else {
-            jit_handle_t h = jit_lazy_compile_locked(j, ident_new(str));
-            if (h == JIT_HANDLE_INVALID)
-               fatal_trace("relocation against invalid function %s", str);
-
-            switch (r->kind) {
-            case RELOC_FUNC:
-               r->ptr = jit_get_func(j, h);
-               break;
-            case RELOC_HANDLE:
-               r->ptr = (void *)(uintptr_t)h;
-               break;
-            case RELOC_PRIVDATA:
-               r->ptr = jit_get_privdata_ptr(j, jit_get_func(j, h));
-               break;
-            default:
-               fatal_trace("unhandled relocation kind %d", r->kind);
-            }
-         }
-      }
-
+      jit_apply_relocs(j, descr);
       store_release(&f->state, JIT_FUNC_READY);
    }
 
@@ -396,6 +721,44 @@ static inline bool jit_fill_from_aot(jit_func_t *f, aot_dll_t *lib)
    return lib != NULL && jit_pack_fill(lib->pack, f->jit, f);
 }
 
+static void jit_fill_from_cache(jit_func_t *f)
+{
+   jit_t *j = f->jit;
+   if (j->cachelib == NULL)
+      return;
+
+   LOCAL_TEXT_BUF tb = safe_symbol(f->name);
+   const size_t baselen = tb_len(tb);
+   tb_cat(tb, ".hash");
+
+   // The cached code is only valid if it was generated from identical
+   // IR which also covers changes to the design since the last run
+   const uint64_t *hash = ffi_find_symbol(j->cachelib->dll, tb_get(tb));
+   if (hash == NULL || *hash != jit_pack_hash(f))
+      return;
+
+   tb_trim(tb, baselen);
+   tb_cat(tb, ".descr");
+
+   aot_descr_t *descr = ffi_find_symbol(j->cachelib->dll, tb_get(tb));
+   if (descr == NULL)
+      return;
+
+   {
+      SCOPED_LOCK(j->lock);
+      jit_apply_relocs(j, descr);
+   }
+
+   if (opt_get_int(OPT_JIT_LOG))
+      debugf("%s loaded from code cache", istr(f->name));
+
+   f->hotness   = 0;
+   f->next_tier = NULL;
+   f->cached    = true;
+
+   store_release(&f->entry, descr->entry);
+}
+
 void jit_fill_irbuf(jit_func_t *f)
 {
    const func_state_t state = load_acquire(&(f->state));
@@ -427,12 +790,48 @@ void jit_fill_irbuf(jit_func_t *f)
       return;
    else if (jit_fill_from_aot(f, f->jit->preloadlib))
       return;
-   else if (f->unit)
+   else if (f->unit) {
       jit_irgen(f);
+      jit_fill_from_cache(f);
+   }
    else
       fatal_trace("cannot generate JIT IR for %s", istr(f->name));
 }
 
+static inline bool jit_in_aot(jit_func_t *f, aot_dll_t *lib)
+{
+   size_t size;
+   return lib != NULL && jit_pack_get(lib->pack, f->name, &size) != NULL;
+}
+
+bool jit_irbuf_available(jit_func_t *f, int maxops)
+{
+   // True if the IR has already been generated or can be unpacked from
+   // a precompiled library, or else if the function has at most maxops
+   // vcode operations and so is cheap to generate now
+   if (load_acquire(&(f->state)) == JIT_FUNC_READY && f->irbuf != NULL)
+      return true;
+   else if (jit_in_aot(f, f->jit->aotlib) || jit_in_aot(f, f->jit->preloadlib))
+      return true;
+   else if (f->unit == NULL)
+      return false;
+
+   vcode_state_t state;
+   vcode_state_save(&state);
+
+   vcode_select_unit(f->unit);
+
+   int nops = 0;
+   const int nblocks = vcode_count_blocks();
+   for (int i = 0; i < nblocks && nops <= maxops; i++) {
+      vcode_select_block(i);
+      nops += vcode_count_ops();
+   }
+
+   vcode_state_restore(&state);
+   return nops <= maxops;
+}
+
 jit_handle_t jit_compile(jit_t *j, ident_t name)
 {
    jit_handle_t handle = jit_lazy_compile(j, name);
@@ -459,15 +858,18 @@ void *jit_link(jit_t *j, jit_handle_t handle)
    vcode_state_t state;
    vcode_state_save(&state);
 
-   vcode_select_unit(f->unit);
-   const vunit_kind_t kind = vcode_unit_kind();
-   if (kind != VCODE_UNIT_PACKAGE && kind != VCODE_UNIT_INSTANCE)
-      fatal_trace("cannot link unit %s", istr(f->name));
+   if (f->unit != NULL) {
+      vcode_select_unit(f->unit);
+      const vunit_kind_t kind = vcode_unit_kind();
+      if (kind != VCODE_UNIT_PACKAGE && kind != VCODE_UNIT_INSTANCE)
+         fatal_trace("cannot link unit %s", istr(f->name));
+   }
 
    tlab_t tlab = jit_null_tlab(j);
    jit_scalar_t p1 = { .pointer = NULL }, p2 = p1, result;
    if (!jit_fastcall(j, f->handle, &result, p1, p2, &tlab)) {
-      error_at(&(f->object->loc), "failed to initialise %s", istr(f->name));
+      const loc_t *loc = f->object ? &(f->object->loc) : NULL;
+      error_at(loc, "failed to initialise %s", istr(f->name));
       result.pointer = NULL;
    }
    else if (result.pointer == NULL)
@@ -534,40 +936,72 @@ static void jit_emit_trace(diag_t *d, const loc_t *loc, tree_t enclosing,
    }
 }
 
+static void jit_fill_frame(jit_frame_t *frame, jit_func_t *f,
+                           jit_func_t *code, int pos, int bound)
+{
+   frame->decl = NULL;
+   if (f->object != NULL)
+      frame->decl = tree_from_object(f->object);
+
+   // Scan backwards to find the last debug info
+   assert(pos < (int)code->nirs);
+   frame->loc = frame->decl ? *tree_loc(frame->decl) : LOC_INVALID;
+   for (int i = pos; i >= bound; i--) {
+      jit_ir_t *ir = &(code->irbuf[i]);
+      if (ir->op == J_DEBUG) {
+         frame->loc = ir->arg1.loc;
+         break;
+      }
+      else if (ir->target)
+         break;
+   }
+
+   frame->symbol = f->name;
+}
+
+static int jit_count_inlines(jit_anchor_t *a)
+{
+   int count = 0;
+   for (int i = 0; i < a->func->ninlines; i++) {
+      const jit_inline_t *in = &(a->func->inlines[i]);
+      count += (a->irpos >= in->first && a->irpos <= in->last);
+   }
+
+   return count;
+}
+
 jit_stack_trace_t *jit_stack_trace(void)
 {
    jit_thread_local_t *thread = jit_thread_local();
 
    int count = 0;
-   for (jit_anchor_t *a = thread->anchor; a; a = a->caller)
-      count++;
+   for (jit_anchor_t *a = thread->anchor; a; a = a->caller) {
+      jit_fill_irbuf(a->func);
+      count += 1 + jit_count_inlines(a);
+   }
 
    jit_stack_trace_t *stack =
       xmalloc_flex(sizeof(jit_stack_trace_t), count, sizeof(jit_frame_t));
    stack->count = count;
 
    jit_frame_t *frame = stack->frames;
-   for (jit_anchor_t *a = thread->anchor; a; a = a->caller, frame++) {
-      jit_fill_irbuf(a->func);
+   for (jit_anchor_t *a = thread->anchor; a; a = a->caller) {
+      // Inlined calls are nested with the outermost first so walk
+      // backwards to produce a frame for each callee
+      int pos = a->irpos;
+      for (int i = a->func->ninlines - 1; i >= 0; i--) {
+         const jit_inline_t *in = &(a->func->inlines[i]);
+         if (a->irpos < in->first || a->irpos > in->last)
+            continue;
 
-      frame->decl = NULL;
-      if (a->func->object != NULL)
-         frame->decl = tree_from_object(a->func->object);
-
-      // Scan backwards to find the last debug info
-      assert(a->irpos < a->func->nirs);
-      frame->loc = frame->decl ? *tree_loc(frame->decl) : LOC_INVALID;
-      for (jit_ir_t *ir = &(a->func->irbuf[a->irpos]);
-           ir >= a->func->irbuf; ir--) {
-         if (ir->op == J_DEBUG) {
-            frame->loc = ir->arg1.loc;
-            break;
-         }
-         else if (ir->target)
-            break;
+         jit_func_t *callee = jit_get_func(a->func->jit, in->handle);
+         jit_fill_irbuf(callee);   // Sets object for decl
+
+         jit_fill_frame(frame++, callee, a->func, pos, in->first);
+         pos = in->first - 1;
       }
 
-      frame->symbol = a->func->name;
+      jit_fill_frame(frame++, a->func, a->func, pos, 0);
    }
 
    return stack;
@@ -1077,13 +1511,141 @@ int jit_exit_status(jit_t *j)
    return j->exit_status;
 }
 
-static void jit_async_cgen(void *context, void *arg)
+static bool jit_cgen_idle(void *arg)
+{
+   jit_t *j = arg;
+   return relaxed_load(&j->cgenq.pending.count) == 0
+      && !load_acquire(&j->shutdown);
+}
+
+static bool jit_cgen_busy(void *arg)
+{
+   jit_t *j = arg;
+   // Must read the queue length first: see jit_cgen_next
+   return load_acquire(&j->cgenq.pending.count) > 0
+      || load_acquire(&j->cgenq.active) > 0;
+}
+
+static bool jit_cgen_next(jit_t *j, cgen_request_t *req)
+{
+   cgen_queue_t *q = &(j->cgenq);
+   SCOPED_LOCK(q->lock);
+
+   if (load_acquire(&j->shutdown) || q->pending.count == 0)
+      return false;
+
+   // Functions keep running in the interpreter while they wait in the
+   // queue so pick the one that is hottest now rather than when it was
+   // queued
+   int best = 0;
+   uint64_t maxheat = 0;
+   for (int i = 0; i < q->pending.count; i++) {
+      jit_func_t *f = q->pending.items[i].func;
+      const uint64_t heat = jit_heat(relaxed_load(&f->calls),
+                                     relaxed_load(&f->backedges));
+      if (heat > maxheat) {
+         best = i;
+         maxheat = heat;
+      }
+   }
+
+   // Count the request as active before it leaves the queue so that
+   // jit_cgen_busy, which does not take the lock, cannot observe it in
+   // neither place
+   relaxed_store(&q->active, q->active + 1);
+
+   *req = q->pending.items[best];
+   q->pending.items[best] = q->pending.items[q->pending.count - 1];
+   store_release(&q->pending.count, q->pending.count - 1);
+
+   return true;
+}
+
+static void *jit_cgen_thread(void *arg)
 {
-   jit_func_t *f = context;
-   jit_tier_t *tier = arg;
+   jit_t *j = arg;
+   cgen_queue_t *q = &(j->cgenq);
+
+   while (!load_acquire(&j->shutdown)) {
+      thread_wait(j, jit_cgen_idle);
 
-   if (!load_acquire(&f->jit->shutdown))
-      (*tier->plugin.cgen)(f->jit, f->handle, tier->context);
+      cgen_request_t req;
+      if (!jit_cgen_next(j, &req))
+         continue;
+
+      const uint64_t start_us = get_timestamp_us();
+      (*req.tier->plugin.cgen)(j, req.func->handle, req.tier->context);
+      const uint64_t end_us = get_timestamp_us();
+
+      {
+         SCOPED_LOCK(q->lock);
+
+         jit_tier_t *t = req.tier;
+         t->ncompiled++;
+         t->queue_us += start_us - req.queued_us;
+         t->max_queue_us = MAX(t->max_queue_us, start_us - req.queued_us);
+         t->compile_us += end_us - start_us;
+
+         store_release(&q->active, q->active - 1);
+      }
+
+      thread_notify(j);
+   }
+
+   return NULL;
+}
+
+static void jit_cgen_enqueue(jit_func_t *f, jit_tier_t *tier)
+{
+   jit_t *j = f->jit;
+   cgen_queue_t *q = &(j->cgenq);
+
+   {
+      SCOPED_LOCK(q->lock);
+
+      const cgen_request_t req = {
+         .func      = f,
+         .tier      = tier,
+         .queued_us = get_timestamp_us(),
+      };
+      APUSH(q->pending, req);
+
+      // Start another compile thread if all the existing ones are busy
+      const int limit =
+         MAX(1, MIN(opt_get_int(OPT_JIT_THREADS), MAX_CGEN_THREADS));
+      if (q->nthreads < limit && q->active == q->nthreads) {
+         const int id = q->nthreads++;
+         q->threads[id] = thread_create(jit_cgen_thread, j, "jit-cgen-%d", id);
+      }
+   }
+
+   thread_notify(j);
+}
+
+void jit_cgen_barrier(jit_t *j)
+{
+   thread_wait(j, jit_cgen_busy);
+}
+
+static void jit_cgen_shutdown(jit_t *j)
+{
+   cgen_queue_t *q = &(j->cgenq);
+   assert(load_acquire(&j->shutdown));
+
+   {
+      // Compilations already in progress cannot be interrupted but any
+      // still waiting in the queue are discarded
+      SCOPED_LOCK(q->lock);
+      q->cancelled += q->pending.count;
+      ACLEAR(q->pending);
+   }
+
+   thread_notify(j);
+
+   for (int i = 0; i < q->nthreads; i++)
+      thread_join(q->threads[i]);
+
+   q->nthreads = 0;
 }
 
 void jit_tier_up(jit_func_t *f)
@@ -1091,8 +1653,13 @@ void jit_tier_up(jit_func_t *f)
    assert(f->hotness <= 0);
    assert(f->next_tier != NULL);
 
+   if (opt_get_int(OPT_JIT_LOG))
+      debugf("tier up %s after %u call%s and %u backedge%s", istr(f->name),
+             f->calls, f->calls != 1 ? "s" : "", f->backedges,
+             f->backedges != 1 ? "s" : "");
+
    if (opt_get_int(OPT_JIT_ASYNC))
-      async_do(jit_async_cgen, f, f->next_tier);
+      jit_cgen_enqueue(f, f->next_tier);
    else
       (f->next_tier->plugin.cgen)(f->jit, f->handle, f->next_tier->context);
 
@@ -1100,6 +1667,227 @@ void jit_tier_up(jit_func_t *f)
    f->next_tier = NULL;
 }
 
+uint64_t *jit_get_op_counters(jit_func_t *f)
+{
+   jit_counters_t *c = f->counters;
+
+   uint64_t *ops = load_acquire(&c->ops);
+   if (ops == NULL) {
+      uint64_t *new = xcalloc_array(f->nirs, sizeof(uint64_t));
+      if (atomic_cas(&c->ops, NULL, new))
+         ops = new;
+      else {
+         // Another thread allocated the counters first
+         free(new);
+         ops = load_acquire(&c->ops);
+      }
+   }
+
+   return ops;
+}
+
+void jit_count_exit(jit_func_t *f, uint32_t irpos, jit_exit_t which)
+{
+   jit_counters_t *c = f->counters;
+   SCOPED_LOCK(c->lock);
+
+   const uint64_t key = ((uint64_t)irpos << 8) | which;
+
+   uintptr_t index = (uintptr_t)ihash_get(c->index, key);
+   if (index == 0) {
+      if (c->nsites == c->maxsites) {
+         c->maxsites = MAX(c->maxsites * 2, 16);
+         c->sites = xrealloc_array(c->sites, c->maxsites, sizeof(jit_site_t));
+      }
+
+      c->sites[c->nsites++] = (jit_site_t){ irpos, which, 0 };
+      ihash_put(c->index, key, (void *)(index = c->nsites));
+   }
+
+   c->sites[index - 1].count++;
+}
+
+void jit_load_profile(jit_t *j, const char *file)
+{
+   assert(j->profile == NULL);
+
+   j->profile      = hash_new(256);
+   j->profile_file = xstrdup(file);
+
+   FILE *f = fopen(file, "r");
+   if (f == NULL) {
+      // The profile is created when the JIT is freed
+      if (errno != ENOENT)
+         warnf("cannot open %s: %s", file, last_os_error());
+      return;
+   }
+
+   char *line LOCAL = NULL;
+   size_t linesz = 0;
+   for (int lineno = 1; getline(&line, &linesz, f) != -1; lineno++) {
+      unsigned calls, backedges;
+      int pos = 0;
+      if (sscanf(line, "%u %u %n", &calls, &backedges, &pos) != 2
+          || line[pos] == '\0') {
+         warnf("%s:%d: ignoring malformed JIT profile", file, lineno);
+         break;
+      }
+
+      char *eptr = strchr(line + pos, '\n');
+      if (eptr != NULL)
+         *eptr = '\0';
+
+      jit_profile_t *p = xcalloc(sizeof(jit_profile_t));
+      p->calls     = calls;
+      p->backedges = backedges;
+
+      ident_t name = ident_new(line + pos);
+      free(hash_get(j->profile, name));
+      hash_put(j->profile, name, p);
+   }
+
+   fclose(f);
+
+   if (opt_get_int(OPT_JIT_LOG))
+      debugf("loaded JIT profile from %s", file);
+}
+
+static bool jit_cache_checksum(const char *path, size_t *size,
+                               uint64_t *hash)
+{
+   int fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return false;
+
+   struct stat st;
+   if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      return false;
+   }
+
+   const uint8_t *map = map_file(fd, st.st_size);
+   close(fd);
+
+   // FNV-1a hash of the whole file
+   uint64_t h = UINT64_C(0xcbf29ce484222325);
+   for (off_t i = 0; i < st.st_size; i++)
+      h = (h ^ map[i]) * UINT64_C(0x100000001b3);
+
+   unmap_file((void *)map, st.st_size);
+
+   *size = st.st_size;
+   *hash = h;
+   return true;
+}
+
+void jit_sign_cache(const char *path)
+{
+   size_t size;
+   uint64_t hash;
+   if (!jit_cache_checksum(path, &size, &hash)) {
+      warnf("cannot read %s: %s", path, last_os_error());
+      return;
+   }
+
+   char *sumfile LOCAL = xasprintf("%s.sum", path);
+   char *tmpfile LOCAL = xasprintf("%s.%d", sumfile, getpid());
+
+   FILE *f = fopen(tmpfile, "w");
+   if (f == NULL) {
+      warnf("cannot create %s: %s", tmpfile, last_os_error());
+      return;
+   }
+
+   fprintf(f, "%zu %"PRIx64"\n", size, hash);
+   fclose(f);
+
+   if (rename(tmpfile, sumfile) != 0) {
+      warnf("rename: %s: %s", tmpfile, last_os_error());
+      remove(tmpfile);
+   }
+}
+
+static bool jit_cache_valid(const char *path)
+{
+   // Loading a truncated or otherwise damaged shared library can crash
+   // the dynamic linker so check it against the size and hash recorded
+   // when it was written
+   char *sumfile LOCAL = xasprintf("%s.sum", path);
+   FILE *f = fopen(sumfile, "r");
+   if (f == NULL)
+      return false;
+
+   size_t expect_size;
+   uint64_t expect_hash;
+   const bool parsed =
+      fscanf(f, "%zu %"SCNx64, &expect_size, &expect_hash) == 2;
+   fclose(f);
+
+   size_t size;
+   uint64_t hash;
+   return parsed && jit_cache_checksum(path, &size, &hash)
+      && size == expect_size && hash == expect_hash;
+}
+
+void jit_load_cache(jit_t *j, const char *path)
+{
+   assert(j->cachelib == NULL);
+
+   if (access(path, F_OK) != 0)
+      return;
+
+   // A damaged cache is not an error as it will be overwritten at the
+   // end of the simulation
+   jit_dll_t *dll = jit_cache_valid(path) ? ffi_try_load_dll(path) : NULL;
+   if (dll == NULL) {
+      if (opt_get_int(OPT_JIT_LOG))
+         debugf("ignoring invalid code cache %s", path);
+      return;
+   }
+
+   const uint32_t *p = ffi_find_symbol(dll, "__nvc_abi_version");
+   if (p == NULL || *p != RT_ABI_VERSION) {
+      // Generated by a different version: will be overwritten later
+      ffi_unload_dll(dll);
+      return;
+   }
+
+   j->cachelib = xcalloc(sizeof(aot_dll_t));
+   j->cachelib->dll  = dll;
+   j->cachelib->pack = jit_pack_new();
+
+   if (opt_get_int(OPT_JIT_LOG))
+      debugf("loaded code cache from %s", path);
+}
+
+int jit_get_hot_funcs(jit_t *j, jit_handle_t **handles)
+{
+   jit_handle_t *list = xmalloc_array(j->next_handle, sizeof(jit_handle_t));
+   int count = 0;
+   bool changed = false;
+
+   for (int i = 0; i < j->next_handle; i++) {
+      jit_func_t *f = j->funcs->items[i];
+      if (f->object == NULL || f->irbuf == NULL)
+         continue;
+      else if (f->cached)
+         list[count++] = f->handle;
+      else if (f->next_tier == NULL && f->calls > 0 && j->tiers != NULL) {
+         list[count++] = f->handle;
+         changed = true;
+      }
+   }
+
+   if (!changed) {
+      free(list);
+      *handles = NULL;
+      return 0;
+   }
+
+   *handles = list;
+   return count;
+}
+
 void jit_add_tier(jit_t *j, int threshold, const jit_plugin_t *plugin)
 {
    assert(threshold > 0);
@@ -1141,10 +1929,10 @@ jit_handle_t jit_assemble(jit_t *j, ident_t name, const char *text)
    f->state     = JIT_FUNC_READY;
    f->jit       = j;
    f->handle    = j->next_handle++;
-   f->next_tier = j->tiers;
-   f->hotness   = f->next_tier ? f->next_tier->threshold : 0;
    f->entry     = jit_interp;
 
+   jit_init_hotness(j, f);
+   jit_init_counters(j, f);
    jit_install(j, f);
 
    enum { LABEL, INS, CCSIZE, RESULT, ARG1, ARG2, NEWLINE } state = LABEL;
@@ -1423,16 +2211,19 @@ bool jit_will_abort(jit_ir_t *ir)
 }
 
 void jit_alloc_cover_mem(jit_t *j, int n_stmts, int n_branches, int n_toggles,
-                         int n_expressions)
-{
-   j->cover_mem[JIT_COVER_STMT] =
-      xcalloc_array(n_stmts, sizeof(int32_t));
-   j->cover_mem[JIT_COVER_BRANCH] =
-      xcalloc_array(n_branches, sizeof(int32_t));
-   j->cover_mem[JIT_COVER_TOGGLE] =
-      xcalloc_array(n_toggles, sizeof(int32_t));
-   j->cover_mem[JIT_COVER_EXPRESSION] =
-      xcalloc_array(n_expressions, sizeof(int32_t));
+                         int n_expressions, int32_t *mem)
+{
+   // The caller may provide zeroed memory for the counters laid out in
+   // the order of jit_cover_mem_t
+   if (mem == NULL) {
+      const int total = n_stmts + n_branches + n_toggles + n_expressions;
+      mem = j->cover_owned = xcalloc_array(total, sizeof(int32_t));
+   }
+
+   j->cover_mem[JIT_COVER_STMT] = mem;
+   j->cover_mem[JIT_COVER_BRANCH] = (mem += n_stmts);
+   j->cover_mem[JIT_COVER_TOGGLE] = (mem += n_branches);
+   j->cover_mem[JIT_COVER_EXPRESSION] = (mem += n_toggles);
 }
 
 int32_t *jit_get_cover_mem(jit_t *j, jit_cover_mem_t kind)
@@ -74,6 +74,8 @@ const char *jit_exit_name(jit_exit_t exit)
       "DISCONNECT", "ELAB_ORDER_FAIL", "FORCE", "RELEASE", "PUSH_SCOPE",
       "POP_SCOPE", "IMPLICIT_SIGNAL", "DRIVING", "DRIVING_VALUE",
       "CLAIM_TLAB", "COVER_TOGGLE", "PROCESS_INIT", "CLEAR_EVENT",
+      "NUMERIC_ADD", "NUMERIC_RESIZE", "NUMERIC_TO_UNSIGNED", "RISING_EDGE",
+      "FALLING_EDGE",
    };
    assert(exit < ARRAY_LEN(names));
    return names[exit];
@@ -23,6 +23,7 @@
 #include "jit/jit.h"
 #include "lib.h"
 #include "object.h"
+#include "option.h"
 #include "rt/mspace.h"
 #include "rt/rt.h"
 #include "type.h"
@@ -573,6 +574,17 @@ void __nvc_test_event(jit_anchor_t *anchor, jit_scalar_t *args, tlab_t *tlab)
    thread->anchor = NULL;
 }
 
+static bool intrinsic_disabled(jit_scalar_t *args)
+{
+   // Checked here rather than only when generating IR as the prologue
+   // which calls the intrinsic is also compiled into the AOT libraries
+   if (likely(opt_get_int(OPT_JIT_INTRINSICS)))
+      return false;
+
+   args[0].integer = 0;   // Fall back to the VHDL implementation
+   return true;
+}
+
 DLLEXPORT
 void __nvc_do_exit(jit_exit_t which, jit_anchor_t *anchor, jit_scalar_t *args,
                    tlab_t *tlab)
@@ -580,6 +592,9 @@ void __nvc_do_exit(jit_exit_t which, jit_anchor_t *anchor, jit_scalar_t *args,
    jit_thread_local_t *thread = jit_thread_local();
    thread->anchor = anchor;
 
+   if (unlikely(anchor->func->counters != NULL))
+      jit_count_exit(anchor->func, anchor->irpos, which);
+
    switch (which) {
    case JIT_EXIT_ASSERT_FAIL:
       {
@@ -1102,6 +1117,98 @@ void __nvc_do_exit(jit_exit_t which, jit_anchor_t *anchor, jit_scalar_t *args,
       }
       break;
 
+   case JIT_EXIT_NUMERIC_ADD:
+      {
+         if (intrinsic_disabled(args))
+            break;
+
+         // Argument zero is the context pointer and the first result
+         // indicates whether to fall back to the VHDL implementation
+         uint8_t *left  = args[1].pointer;
+         int32_t  llen  = ffi_unbias_length(args[3].integer);
+         uint8_t *right = args[4].pointer;
+         int32_t  rlen  = ffi_unbias_length(args[6].integer);
+
+         if (llen < 1 || rlen < 1) {
+            args[0].integer = 0;
+            break;
+         }
+
+         const int32_t size = MAX(llen, rlen);
+         uint8_t *result = tlab_alloc(tlab, size);
+         x_numeric_add_unsigned(left, llen, right, rlen, result, size);
+
+         args[0].integer = 1;
+         args[1].pointer = result;
+         args[2].integer = size - 1;
+         args[3].integer = ~size;
+      }
+      break;
+
+   case JIT_EXIT_NUMERIC_RESIZE:
+      {
+         if (intrinsic_disabled(args))
+            break;
+
+         uint8_t *arg  = args[1].pointer;
+         int32_t  len  = ffi_unbias_length(args[3].integer);
+         int64_t  size = args[4].integer;
+
+         if (size < 1 || size > INT32_MAX) {
+            args[0].integer = 0;
+            break;
+         }
+
+         uint8_t *result = tlab_alloc(tlab, size);
+         x_numeric_resize_unsigned(arg, len, result, size);
+
+         args[0].integer = 1;
+         args[1].pointer = result;
+         args[2].integer = size - 1;
+         args[3].integer = ~size;
+      }
+      break;
+
+   case JIT_EXIT_NUMERIC_TO_UNSIGNED:
+      {
+         if (intrinsic_disabled(args))
+            break;
+
+         int64_t value = args[1].integer;
+         int64_t size  = args[2].integer;
+
+         // The VHDL implementation reports truncation
+         if (size < 1 || size > INT32_MAX || (size < 64 && (value >> size))) {
+            args[0].integer = 0;
+            break;
+         }
+
+         uint8_t *result = tlab_alloc(tlab, size);
+         x_numeric_to_unsigned(value, result, size);
+
+         args[0].integer = 1;
+         args[1].pointer = result;
+         args[2].integer = size - 1;
+         args[3].integer = ~size;
+      }
+      break;
+
+   case JIT_EXIT_RISING_EDGE:
+   case JIT_EXIT_FALLING_EDGE:
+      {
+         if (intrinsic_disabled(args))
+            break;
+
+         sig_shared_t *shared = args[1].pointer;
+         int32_t       offset = args[2].integer;
+
+         const bool rising = (which == JIT_EXIT_RISING_EDGE);
+
+         args[0].integer = 1;
+         args[1].integer = x_logic_edge(shared, offset, rising);
+      }
+      break;
+
    default:
       fatal_trace("unhandled exit %s", jit_exit_name(which));
    }
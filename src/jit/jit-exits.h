@@ -97,5 +97,12 @@ void *x_mspace_alloc(size_t size);
 void x_cover_setup_toggle_cb(sig_shared_t *ss, int32_t *toggle_mask);
 void x_process_init(jit_handle_t handle, tree_t where);
 void x_clear_event(sig_shared_t *ss, uint32_t offset, int32_t count);
+void x_numeric_add_unsigned(const uint8_t *left, int32_t llen,
+                            const uint8_t *right, int32_t rlen,
+                            uint8_t *result, int32_t size);
+void x_numeric_resize_unsigned(const uint8_t *arg, int32_t len,
+                               uint8_t *result, int32_t size);
+void x_numeric_to_unsigned(uint64_t value, uint8_t *result, int32_t size);
+int8_t x_logic_edge(sig_shared_t *ss, uint32_t offset, bool rising);
 
 #endif  // _JIT_EXITS_H
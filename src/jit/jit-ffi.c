@@ -243,14 +243,16 @@ static jit_dll_t *ffi_load_exe(void)
    return (dlls = dll);
 }
 
-jit_dll_t *ffi_load_dll(const char *path)
+static jit_dll_t *ffi_do_load_dll(const char *path, bool fail)
 {
    if (path == NULL)
       return ffi_load_exe();
 
    char *abs = realpath(path, NULL);
-   if (abs == NULL)
+   if (abs == NULL && fail)
       fatal_errno("%s", path);
+   else if (abs == NULL)
+      return NULL;
 
    for (jit_dll_t *it = dlls; it; it = it->next) {
       if (strcmp(it->path, abs) == 0) {
@@ -264,14 +266,19 @@ jit_dll_t *ffi_load_dll(const char *path)
 
 #ifdef __MINGW32__
    HMODULE handle = LoadLibrary(path);
-   if (handle == NULL)
+   if (handle == NULL && fail)
       fatal("failed to load %s", path);
 #else
    void *handle = dlopen(path, RTLD_LAZY | RTLD_GLOBAL /* XXXX */);
-   if (handle == NULL)
+   if (handle == NULL && fail)
       fatal("%s", dlerror());
 #endif
 
+   if (handle == NULL) {
+      free(abs);
+      return NULL;
+   }
+
    if (dlls == NULL)
       ffi_load_exe();  // First time initialisation
 
@@ -283,6 +290,16 @@ jit_dll_t *ffi_load_dll(const char *path)
    return (dlls = dll);
 }
 
+jit_dll_t *ffi_load_dll(const char *path)
+{
+   return ffi_do_load_dll(path, true);
+}
+
+jit_dll_t *ffi_try_load_dll(const char *path)
+{
+   return ffi_do_load_dll(path, false);
+}
+
 void ffi_unload_dll(jit_dll_t *dll)
 {
 #ifdef __MINGW32__
@@ -341,7 +358,7 @@ ffi_spec_t ffi_spec_new(const ffi_type_t *types, size_t count)
 #endif
 
    ffi_spec_t spec = {};
-   if (count < 7) {
+   if (count <= ARRAY_LEN(spec.embed)) {
       memcpy(spec.embed, types, count);
       spec.count = count;
    }
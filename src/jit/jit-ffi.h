@@ -88,6 +88,7 @@ void ffi_store_int(ffi_type_t type, uint64_t value, void *output);
 typedef struct _jit_dll jit_dll_t;
 
 jit_dll_t *ffi_load_dll(const char *path);
+jit_dll_t *ffi_try_load_dll(const char *path);
 void ffi_unload_dll(jit_dll_t *dll);
 void *ffi_find_symbol(jit_dll_t *dll, const char *name);
 
@@ -44,6 +44,7 @@ typedef struct _jit_interp {
    unsigned       flags;
    mspace_t      *mspace;
    unsigned       backedge;
+   unsigned       hotloop;
    jit_anchor_t  *anchor;
    tlab_t        *tlab;
 } jit_interp_t;
@@ -549,24 +550,45 @@ static void interp_cneg(jit_interp_t *state, jit_ir_t *ir)
    state->regs[ir->result].integer = state->flags ? -value : value;
 }
 
-static void interp_branch_to(jit_interp_t *state, jit_value_t label)
+static void interp_backedge(jit_interp_t *state)
 {
-   const int target = interp_get_value(state, label).integer;
-   if (state->backedge > 0 && target < state->pc) {
-      // Limit the number of loop iterations in bounded mode
-      if (--(state->backedge) == 0) {
-         bool safe_to_abort = true;
-         for (jit_anchor_t *a = state->anchor; a; a = a->caller) {
-            if (a->func->privdata != MPTR_INVALID) {
-               // We might be in the middle of initialising a package so
-               // cannot abandon execution here
-               safe_to_abort = false;
-            }
+   // Limit the number of loop iterations in bounded mode
+   if (--(state->backedge) == 0) {
+      bool safe_to_abort = true;
+      for (jit_anchor_t *a = state->anchor; a; a = a->caller) {
+         if (a->func->privdata != MPTR_INVALID) {
+            // We might be in the middle of initialising a package so
+            // cannot abandon execution here
+            safe_to_abort = false;
          }
-
-         if (safe_to_abort)
-            jit_msg(NULL, DIAG_FATAL, "maximum iteration limit reached");
       }
+
+      if (safe_to_abort)
+         jit_msg(NULL, DIAG_FATAL, "maximum iteration limit reached");
+   }
+}
+
+static void interp_hot_loop(jit_interp_t *state)
+{
+   // Long running loops make a function hot even if it is only called
+   // once but the compiled code is only used from the next call
+   jit_func_t *f = state->func;
+   f->backedges += JIT_LOOP_WEIGHT;
+
+   if (f->next_tier && --(f->hotness) <= 0)
+      jit_tier_up(f);
+
+   state->hotloop = JIT_LOOP_WEIGHT;
+}
+
+static void interp_branch_to(jit_interp_t *state, jit_value_t label)
+{
+   const int target = interp_get_value(state, label).integer;
+   if (target < state->pc) {
+      if (state->backedge > 0)
+         interp_backedge(state);
+      if (--(state->hotloop) == 0)
+         interp_hot_loop(state);
    }
 
    state->pc = target;
@@ -813,171 +835,794 @@ static void interp_trim(jit_interp_t *state, jit_ir_t *ir)
    state->tlab->alloc = state->anchor->watermark;
 }
 
-static void interp_loop(jit_interp_t *state)
+static void interp_one(jit_interp_t *state, jit_ir_t *ir)
 {
-   for (;;) {
-      JIT_ASSERT(state->pc < state->func->nirs);
-      jit_ir_t *ir = &(state->func->irbuf[state->pc++]);
-      switch (ir->op) {
-      case J_RECV:
-         interp_recv(state, ir);
-         break;
-      case J_SEND:
-         interp_send(state, ir);
-         break;
-      case J_AND:
-         interp_and(state, ir);
-         break;
-      case J_OR:
-         interp_or(state, ir);
-         break;
-      case J_XOR:
-         interp_xor(state, ir);
-         break;
-      case J_SUB:
-         interp_sub(state, ir);
-         break;
-      case J_FSUB:
-         interp_fsub(state, ir);
-         break;
-      case J_ADD:
-         interp_add(state, ir);
-         break;
-      case J_FADD:
-         interp_fadd(state, ir);
-         break;
-      case J_MUL:
-         interp_mul(state, ir);
-         break;
-      case J_FMUL:
-         interp_fmul(state, ir);
-         break;
-      case J_DIV:
-         interp_div(state, ir);
-         break;
-      case J_FDIV:
-         interp_fdiv(state, ir);
-         break;
-      case J_SHL:
-         interp_shl(state, ir);
-         break;
-      case J_ASR:
-         interp_asr(state, ir);
-         break;
-      case J_RET:
-         return;
-      case J_STORE:
-         interp_store(state, ir);
-         break;
-      case J_ULOAD:
-         interp_uload(state, ir);
-         break;
-      case J_LOAD:
-         interp_load(state, ir);
-         break;
-      case J_CMP:
-         interp_cmp(state, ir);
-         break;
-      case J_FCMP:
-         interp_fcmp(state, ir);
-         break;
-      case J_CSET:
-         interp_cset(state, ir);
-         break;
-      case J_CNEG:
-         interp_cneg(state, ir);
-         break;
-      case J_JUMP:
-         interp_jump(state, ir);
-         break;
-      case J_TRAP:
-         interp_trap(state, ir);
-         break;
-      case J_CALL:
-         interp_call(state, ir);
-         break;
-      case J_MOV:
-         interp_mov(state, ir);
-         break;
-      case J_CSEL:
-         interp_csel(state, ir);
-         break;
-      case J_NEG:
-         interp_neg(state, ir);
-         break;
-      case J_FNEG:
-         interp_fneg(state, ir);
-         break;
-      case J_NOT:
-         interp_not(state, ir);
-         break;
-      case J_SCVTF:
-         interp_scvtf(state, ir);
-         break;
-      case J_FCVTNS:
-         interp_fcvtns(state, ir);
-         break;
-      case J_LEA:
-         interp_lea(state, ir);
-         break;
-      case J_REM:
-         interp_rem(state, ir);
-         break;
-      case J_CLAMP:
-         interp_clamp(state, ir);
-         break;
-      case J_DEBUG:
-      case J_NOP:
-         break;
-      case MACRO_COPY:
-         interp_copy(state, ir);
-         break;
-      case MACRO_BZERO:
-         interp_bzero(state, ir);
-         break;
-      case MACRO_GALLOC:
-         interp_galloc(state, ir);
-         break;
-      case MACRO_LALLOC:
-         interp_lalloc(state, ir);
-         break;
-      case MACRO_SALLOC:
-         interp_salloc(state, ir);
-         break;
-      case MACRO_EXIT:
-         interp_exit(state, ir);
-         break;
-      case MACRO_FEXP:
-         interp_fexp(state, ir);
-         break;
-      case MACRO_EXP:
-         interp_exp(state, ir);
-         break;
-      case MACRO_FFICALL:
-         interp_fficall(state, ir);
-         break;
-      case MACRO_GETPRIV:
-         interp_getpriv(state, ir);
-         break;
-      case MACRO_PUTPRIV:
-         interp_putpriv(state, ir);
+   switch (ir->op) {
+   case J_RECV:
+      interp_recv(state, ir);
+      break;
+   case J_SEND:
+      interp_send(state, ir);
+      break;
+   case J_AND:
+      interp_and(state, ir);
+      break;
+   case J_OR:
+      interp_or(state, ir);
+      break;
+   case J_XOR:
+      interp_xor(state, ir);
+      break;
+   case J_SUB:
+      interp_sub(state, ir);
+      break;
+   case J_FSUB:
+      interp_fsub(state, ir);
+      break;
+   case J_ADD:
+      interp_add(state, ir);
+      break;
+   case J_FADD:
+      interp_fadd(state, ir);
+      break;
+   case J_MUL:
+      interp_mul(state, ir);
+      break;
+   case J_FMUL:
+      interp_fmul(state, ir);
+      break;
+   case J_DIV:
+      interp_div(state, ir);
+      break;
+   case J_FDIV:
+      interp_fdiv(state, ir);
+      break;
+   case J_SHL:
+      interp_shl(state, ir);
+      break;
+   case J_ASR:
+      interp_asr(state, ir);
+      break;
+   case J_STORE:
+      interp_store(state, ir);
+      break;
+   case J_ULOAD:
+      interp_uload(state, ir);
+      break;
+   case J_LOAD:
+      interp_load(state, ir);
+      break;
+   case J_CMP:
+      interp_cmp(state, ir);
+      break;
+   case J_FCMP:
+      interp_fcmp(state, ir);
+      break;
+   case J_CSET:
+      interp_cset(state, ir);
+      break;
+   case J_CNEG:
+      interp_cneg(state, ir);
+      break;
+   case J_JUMP:
+      interp_jump(state, ir);
+      break;
+   case J_TRAP:
+      interp_trap(state, ir);
+      break;
+   case J_CALL:
+      interp_call(state, ir);
+      break;
+   case J_MOV:
+      interp_mov(state, ir);
+      break;
+   case J_CSEL:
+      interp_csel(state, ir);
+      break;
+   case J_NEG:
+      interp_neg(state, ir);
+      break;
+   case J_FNEG:
+      interp_fneg(state, ir);
+      break;
+   case J_NOT:
+      interp_not(state, ir);
+      break;
+   case J_SCVTF:
+      interp_scvtf(state, ir);
+      break;
+   case J_FCVTNS:
+      interp_fcvtns(state, ir);
+      break;
+   case J_LEA:
+      interp_lea(state, ir);
+      break;
+   case J_REM:
+      interp_rem(state, ir);
+      break;
+   case J_CLAMP:
+      interp_clamp(state, ir);
+      break;
+   case J_DEBUG:
+   case J_NOP:
+      break;
+   case MACRO_COPY:
+      interp_copy(state, ir);
+      break;
+   case MACRO_BZERO:
+      interp_bzero(state, ir);
+      break;
+   case MACRO_GALLOC:
+      interp_galloc(state, ir);
+      break;
+   case MACRO_LALLOC:
+      interp_lalloc(state, ir);
+      break;
+   case MACRO_SALLOC:
+      interp_salloc(state, ir);
+      break;
+   case MACRO_EXIT:
+      interp_exit(state, ir);
+      break;
+   case MACRO_FEXP:
+      interp_fexp(state, ir);
+      break;
+   case MACRO_EXP:
+      interp_exp(state, ir);
+      break;
+   case MACRO_FFICALL:
+      interp_fficall(state, ir);
+      break;
+   case MACRO_GETPRIV:
+      interp_getpriv(state, ir);
+      break;
+   case MACRO_PUTPRIV:
+      interp_putpriv(state, ir);
+      break;
+   case MACRO_CASE:
+      interp_case(state, ir);
+      break;
+   case MACRO_TRIM:
+      interp_trim(state, ir);
+      break;
+   default:
+      interp_dump(state);
+      fatal_trace("cannot interpret opcode %s", jit_op_name(ir->op));
+   }
+}
+
+// Instructions are translated once into a compact form where operands
+// are a register plus an immediate and branch targets are resolved to
+// pointers.  Registers are indexed with an extra always-zero register
+// so that an immediate operand needs no special handling.
+#define INTERP_HANDLERS(x)                                              \
+   x(SLOW) x(NOP) x(RET) x(RECV) x(SEND) x(MOV_R) x(MOV_G)              \
+   x(ADD_RR) x(ADD_RI) x(ADD_GG) x(ADD_O) x(ADD_C)                      \
+   x(SUB_RR) x(SUB_RI) x(SUB_GG) x(SUB_O) x(SUB_C)                      \
+   x(MUL_RR) x(MUL_RI) x(MUL_GG) x(MUL_O) x(MUL_C)                      \
+   x(AND_RR) x(AND_RI) x(AND_GG) x(OR_RR) x(OR_RI) x(OR_GG)             \
+   x(XOR_RR) x(XOR_RI) x(XOR_GG) x(SHL_RR) x(SHL_RI) x(SHL_GG)          \
+   x(ASR_RR) x(ASR_RI) x(ASR_GG) x(DIV_GG) x(REM_GG)                    \
+   x(FADD) x(FSUB) x(FMUL) x(FDIV) x(FNEG) x(SCVTF) x(FCVTNS)           \
+   x(CMP_EQ_RR) x(CMP_EQ_RI) x(CMP_EQ_GG)                               \
+   x(CMP_NE_RR) x(CMP_NE_RI) x(CMP_NE_GG)                               \
+   x(CMP_LT_RR) x(CMP_LT_RI) x(CMP_LT_GG)                               \
+   x(CMP_GT_RR) x(CMP_GT_RI) x(CMP_GT_GG)                               \
+   x(CMP_LE_RR) x(CMP_LE_RI) x(CMP_LE_GG)                               \
+   x(CMP_GE_RR) x(CMP_GE_RI) x(CMP_GE_GG)                               \
+   x(CSET) x(CSEL) x(CNEG) x(NEG) x(NOT) x(CLAMP) x(LEA)                \
+   x(LOAD8) x(LOAD16) x(LOAD32) x(LOAD64)                               \
+   x(ULOAD8) x(ULOAD16) x(ULOAD32) x(ULOAD64)                           \
+   x(STORE8) x(STORE16) x(STORE32) x(STORE64)                           \
+   x(JUMP) x(JUMP_T) x(JUMP_F) x(CASE) x(CALL) x(EXIT)                  \
+   x(COPY) x(BZERO) x(SALLOC)
+
+typedef enum {
+#define INTERP_ENUM(name) H_##name,
+   INTERP_HANDLERS(INTERP_ENUM)
+#undef INTERP_ENUM
+} interp_handler_t;
+
+typedef struct _interp_op {
+   const void   *handler;
+   jit_reg_t     result;
+   jit_size_t    size : 8;
+   jit_cc_t      cc : 8;
+   jit_reg_t     reg1;
+   jit_reg_t     reg2;
+   jit_scalar_t  imm1;
+   jit_scalar_t  imm2;
+} interp_op_t;
+
+STATIC_ASSERT(sizeof(interp_op_t) == 32);
+
+typedef enum {
+   OPERAND_REG, OPERAND_IMM, OPERAND_ADDR, OPERAND_SLOW
+} operand_kind_t;
+
+static operand_kind_t interp_decode_operand(jit_func_t *f, jit_value_t value,
+                                            jit_reg_t *reg, jit_scalar_t *imm)
+{
+   *reg = f->nregs;   // Always zero
+   imm->integer = 0;
+
+   switch (value.kind) {
+   case JIT_VALUE_REG:
+      *reg = value.reg;
+      return OPERAND_REG;
+   case JIT_ADDR_REG:
+      *reg = value.reg;
+      imm->integer = value.disp;
+      return value.disp == 0 ? OPERAND_REG : OPERAND_ADDR;
+   case JIT_VALUE_INVALID:
+   case JIT_VALUE_LOC:
+      return OPERAND_IMM;
+   case JIT_VALUE_INT64:
+      imm->integer = value.int64;
+      return OPERAND_IMM;
+   case JIT_VALUE_DOUBLE:
+      imm->real = value.dval;
+      return OPERAND_IMM;
+   case JIT_ADDR_CPOOL:
+      imm->pointer = f->cpool + value.int64;
+      return OPERAND_IMM;
+   case JIT_ADDR_ABS:
+      imm->pointer = (void *)(intptr_t)value.int64;
+      return OPERAND_IMM;
+   case JIT_VALUE_LABEL:
+      imm->integer = value.label;
+      return OPERAND_IMM;
+   case JIT_VALUE_HANDLE:
+      imm->integer = value.handle;
+      return OPERAND_IMM;
+   case JIT_VALUE_EXIT:
+      imm->integer = value.exit;
+      return OPERAND_IMM;
+   case JIT_VALUE_FOREIGN:
+      imm->pointer = value.foreign;
+      return OPERAND_IMM;
+   case JIT_VALUE_TREE:
+      imm->pointer = value.tree;
+      return OPERAND_IMM;
+   default:
+      // Coverage counters may not be allocated yet
+      return OPERAND_SLOW;
+   }
+}
+
+static interp_handler_t interp_select_binary(operand_kind_t kind1,
+                                             operand_kind_t kind2,
+                                             interp_handler_t rr)
+{
+   // The RI and GG forms always follow RR in the handler list
+   if (kind1 == OPERAND_REG && kind2 == OPERAND_REG)
+      return rr;
+   else if (kind1 == OPERAND_REG && kind2 == OPERAND_IMM)
+      return rr + 1;
+   else
+      return rr + 2;
+}
+
+static interp_handler_t interp_select(jit_func_t *f, jit_ir_t *ir,
+                                      operand_kind_t kind1,
+                                      operand_kind_t kind2)
+{
+   if (kind1 == OPERAND_SLOW || kind2 == OPERAND_SLOW)
+      return H_SLOW;
+
+   switch (ir->op) {
+   case J_NOP:
+   case J_DEBUG:
+      return H_NOP;
+   case J_RET:
+      return H_RET;
+   case J_RECV:
+      return H_RECV;
+   case J_SEND:
+      return H_SEND;
+   case J_MOV:
+      return kind1 == OPERAND_REG ? H_MOV_R : H_MOV_G;
+   case J_ADD:
+      switch (ir->cc) {
+      case JIT_CC_NONE: return interp_select_binary(kind1, kind2, H_ADD_RR);
+      case JIT_CC_O: return H_ADD_O;
+      case JIT_CC_C: return H_ADD_C;
+      default: return H_SLOW;
+      }
+   case J_SUB:
+      switch (ir->cc) {
+      case JIT_CC_NONE: return interp_select_binary(kind1, kind2, H_SUB_RR);
+      case JIT_CC_O: return H_SUB_O;
+      case JIT_CC_C: return H_SUB_C;
+      default: return H_SLOW;
+      }
+   case J_MUL:
+      switch (ir->cc) {
+      case JIT_CC_NONE: return interp_select_binary(kind1, kind2, H_MUL_RR);
+      case JIT_CC_O: return H_MUL_O;
+      case JIT_CC_C: return H_MUL_C;
+      default: return H_SLOW;
+      }
+   case J_AND:
+      return interp_select_binary(kind1, kind2, H_AND_RR);
+   case J_OR:
+      return interp_select_binary(kind1, kind2, H_OR_RR);
+   case J_XOR:
+      return interp_select_binary(kind1, kind2, H_XOR_RR);
+   case J_SHL:
+      return interp_select_binary(kind1, kind2, H_SHL_RR);
+   case J_ASR:
+      return interp_select_binary(kind1, kind2, H_ASR_RR);
+   case J_DIV:
+      return H_DIV_GG;
+   case J_REM:
+      return H_REM_GG;
+   case J_FADD:
+      return H_FADD;
+   case J_FSUB:
+      return H_FSUB;
+   case J_FMUL:
+      return H_FMUL;
+   case J_FDIV:
+      return H_FDIV;
+   case J_FNEG:
+      return H_FNEG;
+   case J_SCVTF:
+      return H_SCVTF;
+   case J_FCVTNS:
+      return H_FCVTNS;
+   case J_CMP:
+      switch (ir->cc) {
+      case JIT_CC_EQ: return interp_select_binary(kind1, kind2, H_CMP_EQ_RR);
+      case JIT_CC_NE: return interp_select_binary(kind1, kind2, H_CMP_NE_RR);
+      case JIT_CC_LT: return interp_select_binary(kind1, kind2, H_CMP_LT_RR);
+      case JIT_CC_GT: return interp_select_binary(kind1, kind2, H_CMP_GT_RR);
+      case JIT_CC_LE: return interp_select_binary(kind1, kind2, H_CMP_LE_RR);
+      case JIT_CC_GE: return interp_select_binary(kind1, kind2, H_CMP_GE_RR);
+      default: return H_SLOW;
+      }
+   case J_CSET:
+      return H_CSET;
+   case J_CSEL:
+      return H_CSEL;
+   case J_CNEG:
+      return H_CNEG;
+   case J_NEG:
+      return H_NEG;
+   case J_NOT:
+      return H_NOT;
+   case J_CLAMP:
+      return H_CLAMP;
+   case J_LEA:
+      return H_LEA;
+   case J_LOAD:
+   case J_ULOAD:
+   case J_STORE:
+      {
+         if (ir->size == JIT_SZ_UNSPEC)
+            return H_SLOW;
+
+         const interp_handler_t base = ir->op == J_LOAD ? H_LOAD8
+            : ir->op == J_ULOAD ? H_ULOAD8 : H_STORE8;
+         return base + ir->size;
+      }
+   case J_JUMP:
+      switch (ir->cc) {
+      case JIT_CC_NONE: return H_JUMP;
+      case JIT_CC_T: return H_JUMP_T;
+      case JIT_CC_F: return H_JUMP_F;
+      default: return H_SLOW;
+      }
+   case MACRO_CASE:
+      return H_CASE;
+   case J_CALL:
+      if (ir->arg1.handle == JIT_HANDLE_INVALID)
+         return H_SLOW;
+      else
+         return H_CALL;
+   case MACRO_EXIT:
+      return H_EXIT;
+   case MACRO_COPY:
+      return H_COPY;
+   case MACRO_BZERO:
+      return H_BZERO;
+   case MACRO_SALLOC:
+      return H_SALLOC;
+   default:
+      return H_SLOW;
+   }
+}
+
+static interp_op_t *interp_predecode(jit_func_t *f, const void *const *labels)
+{
+   interp_op_t *code = xcalloc_array(f->nirs, sizeof(interp_op_t));
+
+   for (int i = 0; i < f->nirs; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      interp_op_t *op = &(code[i]);
+
+      op->result = ir->result;
+      op->size   = ir->size;
+      op->cc     = ir->cc;
+
+      const operand_kind_t kind1 =
+         interp_decode_operand(f, ir->arg1, &op->reg1, &op->imm1);
+      const operand_kind_t kind2 =
+         interp_decode_operand(f, ir->arg2, &op->reg2, &op->imm2);
+
+      const interp_handler_t h = interp_select(f, ir, kind1, kind2);
+      op->handler = labels[h];
+
+      switch (h) {
+      case H_JUMP:
+      case H_JUMP_T:
+      case H_JUMP_F:
+         assert(ir->arg1.kind == JIT_VALUE_LABEL);
+         op->imm1.pointer = &(code[ir->arg1.label]);
          break;
-      case MACRO_CASE:
-         interp_case(state, ir);
+      case H_CASE:
+         assert(ir->arg2.kind == JIT_VALUE_LABEL);
+         op->imm2.pointer = &(code[ir->arg2.label]);
          break;
-      case MACRO_TRIM:
-         interp_trim(state, ir);
+      case H_CALL:
+         op->imm1.pointer = jit_get_func(f->jit, ir->arg1.handle);
          break;
       default:
-         interp_dump(state);
-         fatal_trace("cannot interpret opcode %s", jit_op_name(ir->op));
+         break;
       }
    }
+
+   return code;
+}
+
+static void interp_loop(jit_interp_t *state)
+{
+   static const void *const labels[] = {
+#define INTERP_LABEL(name) [H_##name] = &&name,
+      INTERP_HANDLERS(INTERP_LABEL)
+#undef INTERP_LABEL
+   };
+
+   jit_func_t *f = state->func;
+
+   interp_op_t *code = load_acquire(&f->predecode);
+   if (code == NULL) {
+      interp_op_t *new = interp_predecode(f, labels);
+      if (atomic_cas(&f->predecode, NULL, new))
+         code = new;
+      else {
+         // Another thread translated this function first
+         free(new);
+         code = load_acquire(&f->predecode);
+      }
+   }
+
+   jit_scalar_t *regs = state->regs;
+   const interp_op_t *ip = code;
+
+#define DISPATCH(next) do { ip = (next); goto *ip->handler; } while (0)
+#define NEXT() DISPATCH(ip + 1)
+#define RR1 (regs[ip->reg1].integer)
+#define RR2 (regs[ip->reg2].integer)
+#define OP1 (regs[ip->reg1].integer + ip->imm1.integer)
+#define OP2 (regs[ip->reg2].integer + ip->imm2.integer)
+#define RESULT (regs[ip->result])
+#define REAL(x) ((jit_scalar_t){ .integer = (x) }.real)
+#define PTR(x) ((void *)(intptr_t)(x))
+
+   DISPATCH(ip);
+
+ SLOW:
+   state->pc = ip - code + 1;
+   interp_one(state, &(f->irbuf[ip - code]));
+   DISPATCH(code + state->pc);
+
+ NOP:
+   NEXT();
+
+ RET:
+   return;
+
+ RECV:
+   RESULT = state->args[ip->imm1.integer];
+   state->nargs = MAX(state->nargs, ip->imm1.integer + 1);
+   NEXT();
+
+ SEND:
+   state->args[ip->imm1.integer].integer = OP2;
+   state->nargs = MAX(state->nargs, ip->imm1.integer + 1);
+   NEXT();
+
+ MOV_R:
+   RESULT = regs[ip->reg1];
+   NEXT();
+
+ MOV_G:
+   RESULT.integer = OP1;
+   NEXT();
+
+#define BINARY(name, op)                                                \
+   name##_RR:                                                           \
+   RESULT.integer = RR1 op RR2;                                         \
+   NEXT();                                                              \
+   name##_RI:                                                           \
+   RESULT.integer = RR1 op ip->imm2.integer;                            \
+   NEXT();                                                              \
+   name##_GG:                                                           \
+   RESULT.integer = OP1 op OP2;                                         \
+   NEXT();
+
+   BINARY(ADD, +);
+   BINARY(SUB, -);
+   BINARY(MUL, *);
+   BINARY(AND, &);
+   BINARY(OR, |);
+   BINARY(XOR, ^);
+   BINARY(SHL, <<);
+   BINARY(ASR, >>);
+
+#undef BINARY
+
+#define OVERFLOW(name, prefix, cc)                                      \
+   name: {                                                              \
+      const int64_t x = OP1, y = OP2;                                   \
+      int overflow = 0;                                                 \
+      FOR_EACH_SIZE(ip->size, prefix##OVERFLOW_TYPED);                  \
+      state->flags = overflow << cc;                                    \
+   }                                                                    \
+   NEXT();
+
+#define OVERFLOW_TYPED(type) do {                                       \
+      type i1 = x, i2 = y, i0;                                          \
+      overflow = BUILTIN(i1, i2, &i0);                                  \
+      RESULT.integer = i0;                                              \
+   } while (0)
+
+#define UOVERFLOW_TYPED(type) do {                                      \
+      u##type i1 = x, i2 = y, i0;                                       \
+      overflow = BUILTIN(i1, i2, &i0);                                  \
+      RESULT.integer = i0;                                              \
+   } while (0)
+
+#define BUILTIN __builtin_add_overflow
+   OVERFLOW(ADD_O, , JIT_CC_O);
+   OVERFLOW(ADD_C, U, JIT_CC_C);
+#undef BUILTIN
+#define BUILTIN __builtin_sub_overflow
+   OVERFLOW(SUB_O, , JIT_CC_O);
+   OVERFLOW(SUB_C, U, JIT_CC_C);
+#undef BUILTIN
+#define BUILTIN __builtin_mul_overflow
+   OVERFLOW(MUL_O, , JIT_CC_O);
+   OVERFLOW(MUL_C, U, JIT_CC_C);
+#undef BUILTIN
+
+#undef OVERFLOW
+#undef OVERFLOW_TYPED
+#undef UOVERFLOW_TYPED
+
+ DIV_GG:
+   RESULT.integer = OP1 / OP2;
+   NEXT();
+
+ REM_GG:
+   {
+      const int64_t x = OP1, y = OP2;
+      RESULT.integer = x - (x / y) * y;
+   }
+   NEXT();
+
+ FADD:
+   RESULT.real = REAL(OP1) + REAL(OP2);
+   NEXT();
+
+ FSUB:
+   RESULT.real = REAL(OP1) - REAL(OP2);
+   NEXT();
+
+ FMUL:
+   RESULT.real = REAL(OP1) * REAL(OP2);
+   NEXT();
+
+ FDIV:
+   RESULT.real = REAL(OP1) / REAL(OP2);
+   NEXT();
+
+ FNEG:
+   RESULT.real = -REAL(OP1);
+   NEXT();
+
+ SCVTF:
+   RESULT.real = OP1;
+   NEXT();
+
+ FCVTNS:
+   RESULT.integer = round(REAL(OP1));
+   NEXT();
+
+#define COMPARE(name, op)                                               \
+   CMP_##name##_RR:                                                     \
+   state->flags = (RR1 op RR2) << JIT_CC_##name;                        \
+   NEXT();                                                              \
+   CMP_##name##_RI:                                                     \
+   state->flags = (RR1 op ip->imm2.integer) << JIT_CC_##name;           \
+   NEXT();                                                              \
+   CMP_##name##_GG:                                                     \
+   state->flags = (OP1 op OP2) << JIT_CC_##name;                        \
+   NEXT();
+
+   COMPARE(EQ, ==);
+   COMPARE(NE, !=);
+   COMPARE(LT, <);
+   COMPARE(GT, >);
+   COMPARE(LE, <=);
+   COMPARE(GE, >=);
+
+#undef COMPARE
+
+ CSET:
+   RESULT.integer = !!(state->flags);
+   NEXT();
+
+ CSEL:
+   RESULT.integer = state->flags ? OP1 : OP2;
+   NEXT();
+
+ CNEG:
+   RESULT.integer = state->flags ? -OP1 : OP1;
+   NEXT();
+
+ NEG:
+   RESULT.integer = -OP1;
+   NEXT();
+
+ NOT:
+   RESULT.integer = !OP1;
+   NEXT();
+
+ CLAMP:
+   {
+      const int64_t value = OP1;
+      RESULT.integer = value < 0 ? 0 : value;
+   }
+   NEXT();
+
+ LEA:
+   RESULT.integer = OP1;
+   NEXT();
+
+#define LOAD(name, type)                                                \
+   name:                                                                \
+   JIT_ASSERT((uintptr_t)OP1 >= 4096);                                  \
+   RESULT.integer = *(type *)PTR(OP1);                                  \
+   NEXT();
+
+   LOAD(LOAD8, int8_t);
+   LOAD(LOAD16, int16_t);
+   LOAD(LOAD32, int32_t);
+   LOAD(LOAD64, int64_t);
+   LOAD(ULOAD8, uint8_t);
+   LOAD(ULOAD16, uint16_t);
+   LOAD(ULOAD32, uint32_t);
+   LOAD(ULOAD64, uint64_t);
+
+#undef LOAD
+
+#define STORE(name, type)                                               \
+   name:                                                                \
+   JIT_ASSERT((uintptr_t)OP2 >= 4096);                                  \
+   *(type *)PTR(OP2) = (type)OP1;                                       \
+   NEXT();
+
+   STORE(STORE8, uint8_t);
+   STORE(STORE16, uint16_t);
+   STORE(STORE32, uint32_t);
+   STORE(STORE64, uint64_t);
+
+#undef STORE
+
+#define BRANCH(target) do {                                             \
+      const interp_op_t *__dest = (target);                             \
+      if (__dest <= ip) {                                               \
+         if (unlikely(state->backedge > 0)) {                           \
+            state->pc = ip - code + 1;                                  \
+            interp_backedge(state);                                     \
+         }                                                              \
+         if (unlikely(--(state->hotloop) == 0))                         \
+            interp_hot_loop(state);                                     \
+      }                                                                 \
+      DISPATCH(__dest);                                                 \
+   } while (0)
+
+ JUMP:
+   BRANCH(ip->imm1.pointer);
+
+ JUMP_T:
+   if (state->flags)
+      BRANCH(ip->imm1.pointer);
+   NEXT();
+
+ JUMP_F:
+   if (!state->flags)
+      BRANCH(ip->imm1.pointer);
+   NEXT();
+
+ CASE:
+   if (RESULT.integer == OP1)
+      BRANCH(ip->imm2.pointer);
+   NEXT();
+
+#undef BRANCH
+
+ CALL:
+   {
+      state->anchor->irpos = ip - code;
+
+      jit_func_t *cf = ip->imm1.pointer;
+      jit_entry_fn_t entry = load_acquire(&cf->entry);
+      (*entry)(cf, state->anchor, state->args, state->tlab);
+   }
+   NEXT();
+
+ EXIT:
+   state->anchor->irpos = ip - code;
+   __nvc_do_exit(ip->imm1.integer, state->anchor, state->args, state->tlab);
+   NEXT();
+
+ COPY:
+   {
+      const size_t count = RESULT.integer;
+      void *dest = PTR(OP1);
+      const void *src = PTR(OP2);
+
+      JIT_ASSERT((uintptr_t)dest >= 4096 || count == 0);
+      JIT_ASSERT((uintptr_t)src >= 4096 || count == 0);
+
+      memmove(dest, src, count);
+   }
+   NEXT();
+
+ BZERO:
+   memset(PTR(OP1), '\0', RESULT.integer);
+   NEXT();
+
+ SALLOC:
+   assert(ip->imm1.integer + ip->imm2.integer <= f->framesz);
+   RESULT.pointer = state->frame + ip->imm1.integer;
+   NEXT();
+
+#undef DISPATCH
+#undef NEXT
+#undef RR1
+#undef RR2
+#undef OP1
+#undef OP2
+#undef RESULT
+#undef REAL
+#undef PTR
+}
+
+static void interp_counted_loop(jit_interp_t *state, uint64_t *counts)
+{
+   // Execute one instruction at a time so each can be counted
+   jit_func_t *f = state->func;
+   for (;;) {
+      JIT_ASSERT(state->pc < f->nirs);
+      jit_ir_t *ir = &(f->irbuf[state->pc]);
+      relaxed_add(&(counts[state->pc++]), 1);
+
+      if (ir->op == J_RET)
+         return;
+
+      interp_one(state, ir);
+   }
 }
 
 void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
                 tlab_t *tlab)
 {
+   jit_fill_irbuf(f);   // May also load compiled code from the cache
+
    jit_entry_fn_t entry = load_acquire(&f->entry);
    if (unlikely(entry != jit_interp)) {
       // Raced with a code generation thread installing a compiled
@@ -985,7 +1630,7 @@ void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
       return (*entry)(f, caller, args, tlab);
    }
 
-   jit_fill_irbuf(f);
+   f->calls++;
 
    if (f->next_tier && --(f->hotness) <= 0)
       jit_tier_up(f);
@@ -997,8 +1642,8 @@ void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
    };
 
    // Using VLAs here as we need these allocated on the stack so the
-   // mspace GC can scan them
-   jit_scalar_t regs[f->nregs];
+   // mspace GC can scan them: the extra register is always zero
+   jit_scalar_t regs[f->nregs + 1];
    unsigned char frame[f->framesz];
 
 #ifdef DEBUG
@@ -1006,6 +1651,8 @@ void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
    memset(frame, 0xde, f->framesz);
 #endif
 
+   regs[f->nregs].integer = 0;
+
    jit_interp_t state = {
       .args     = args,
       .regs     = regs,
@@ -1015,9 +1662,15 @@ void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
       .frame    = frame,
       .mspace   = jit_get_mspace(f->jit),
       .backedge = jit_backedge_limit(f->jit),
+      .hotloop  = JIT_LOOP_WEIGHT,
       .anchor   = &anchor,
       .tlab     = tlab,
    };
 
-   interp_loop(&state);
+   if (unlikely(f->counters != NULL))
+      interp_counted_loop(&state, jit_get_op_counters(f));
+   else
+      interp_loop(&state);
+
+   f->backedges += JIT_LOOP_WEIGHT - state.hotloop;
 }
@@ -3783,6 +3783,81 @@ static void irgen_params(jit_irgen_t *g, int first)
    g->func->spec = ffi_spec_new(types, ntypes);
 }
 
+static void irgen_intrinsic(jit_irgen_t *g)
+{
+   // Call a native implementation of some frequently used IEEE library
+   // functions which may decline and fall back to the VHDL body
+   static const struct {
+      const char *name;
+      jit_exit_t  exit;
+   } intrinsics[] = {
+      { "IEEE.NUMERIC_STD.\"+\"(25IEEE.NUMERIC_STD.UNSIGNED"
+        "25IEEE.NUMERIC_STD.UNSIGNED)25IEEE.NUMERIC_STD.UNSIGNED",
+        JIT_EXIT_NUMERIC_ADD },
+      { "IEEE.NUMERIC_STD.\"+\"(36IEEE.NUMERIC_STD.UNRESOLVED_UNSIGNED"
+        "36IEEE.NUMERIC_STD.UNRESOLVED_UNSIGNED)"
+        "36IEEE.NUMERIC_STD.UNRESOLVED_UNSIGNED",
+        JIT_EXIT_NUMERIC_ADD },
+      { "IEEE.NUMERIC_STD.RESIZE(25IEEE.NUMERIC_STD.UNSIGNED"
+        "7NATURAL)25IEEE.NUMERIC_STD.UNSIGNED",
+        JIT_EXIT_NUMERIC_RESIZE },
+      { "IEEE.NUMERIC_STD.RESIZE(36IEEE.NUMERIC_STD.UNRESOLVED_UNSIGNED"
+        "7NATURAL)36IEEE.NUMERIC_STD.UNRESOLVED_UNSIGNED",
+        JIT_EXIT_NUMERIC_RESIZE },
+      { "IEEE.NUMERIC_STD.TO_UNSIGNED(7NATURAL7NATURAL)"
+        "25IEEE.NUMERIC_STD.UNSIGNED",
+        JIT_EXIT_NUMERIC_TO_UNSIGNED },
+      { "IEEE.NUMERIC_STD.TO_UNSIGNED(7NATURAL7NATURAL)"
+        "36IEEE.NUMERIC_STD.UNRESOLVED_UNSIGNED",
+        JIT_EXIT_NUMERIC_TO_UNSIGNED },
+      { "IEEE.STD_LOGIC_1164.RISING_EDGE(sU)B", JIT_EXIT_RISING_EDGE },
+      { "IEEE.STD_LOGIC_1164.FALLING_EDGE(sU)B", JIT_EXIT_FALLING_EDGE },
+   };
+
+   if (g->func->name == NULL || !opt_get_int(OPT_JIT_INTRINSICS))
+      return;
+
+   const char *name = istr(g->func->name);
+   if (strncmp(name, "IEEE.", 5) != 0)
+      return;
+
+   int which = 0;
+   for (; which < ARRAY_LEN(intrinsics); which++) {
+      if (strcmp(name, intrinsics[which].name) == 0)
+         break;
+   }
+
+   if (which == ARRAY_LEN(intrinsics))
+      return;
+
+   const int nparams = vcode_count_params();
+   for (int i = 0, pslot = 0; i < nparams; i++) {
+      const jit_reg_t base = jit_value_as_reg(g->map[vcode_param_reg(i)]);
+      const int slots = irgen_slots_for_type(vcode_param_type(i));
+      for (int j = 0; j < slots; j++)
+         j_send(g, pslot++, jit_value_from_reg(base + j));
+   }
+
+   macro_exit(g, intrinsics[which].exit);
+
+   // The first slot is non-zero if the exit produced a result
+   const int nresults = irgen_slots_for_type(vcode_unit_result());
+   jit_value_t handled = j_recv(g, 0), results[nresults];
+   for (int i = 0; i < nresults; i++)
+      results[i] = j_recv(g, i + 1);
+
+   irgen_label_t *cont = irgen_alloc_label(g);
+   j_cmp(g, JIT_CC_EQ, handled, jit_value_from_int64(0));
+   j_jump(g, JIT_CC_T, cont);
+
+   for (int i = 0; i < nresults; i++)
+      j_send(g, i, results[i]);
+
+   j_ret(g);
+
+   irgen_bind_label(g, cont);
+}
+
 static void irgen_jump_table(jit_irgen_t *g)
 {
    irgen_label_t *cont = irgen_alloc_label(g);
@@ -3931,6 +4006,9 @@ void jit_irgen(jit_func_t *f)
       g->func->spec = ffi_spec_new(types, ARRAY_LEN(types));
    }
 
+   if (kind == VCODE_UNIT_FUNCTION)
+      irgen_intrinsic(g);
+
    const int nblocks = vcode_count_blocks();
    g->blocks = xmalloc_array(nblocks, sizeof(irgen_label_t *));
 
@@ -3979,9 +4057,15 @@ void jit_irgen(jit_func_t *f)
    }
    g->labels = NULL;
 
+   int nchecks = 0;
    if (kind != VCODE_UNIT_THUNK) {
+      jit_do_inline(f);
+      vcode_select_unit(f->unit);   // Compiling callees may change unit
+
       jit_do_lvn(f);
       jit_do_cprop(f);
+      nchecks = jit_do_vrp(f);
+      jit_do_licm(f);
       jit_do_dce(f);
       jit_delete_nops(f);
       jit_free_cfg(f);
@@ -4004,6 +4088,9 @@ void jit_irgen(jit_func_t *f)
       diag_printf(d, "%s: %d instructions", istr(f->name), f->nirs);
       if (f->cpoolsz > 0)
          diag_printf(d, "; %d cpool bytes", f->cpoolsz);
+      if (nchecks > 0)
+         diag_printf(d, "; %d check%s removed", nchecks,
+                     nchecks == 1 ? "" : "s");
       diag_printf(d, " [%d us]", ticks);
       diag_emit(d);
    }
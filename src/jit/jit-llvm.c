@@ -161,6 +161,7 @@ typedef struct _llvm_obj {
    LLVMMetadataRef       debugcu;
    shash_t              *string_pool;
    jit_pack_t           *jitpack;
+   bool                  open_world;
 } llvm_obj_t;
 
 typedef struct _cgen_block {
@@ -1761,8 +1762,10 @@ static void cgen_op_call(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
       fptr = LLVMBuildLoad2(obj->builder, obj->types[LLVM_PTR], ptr, "");
 
 #if CLOSED_WORLD
-      LOCAL_TEXT_BUF symbol = safe_symbol(callee->name);
-      entry = llvm_add_fn(obj, tb_get(symbol), obj->types[LLVM_ENTRY_FN]);
+      if (!obj->open_world) {
+         LOCAL_TEXT_BUF symbol = safe_symbol(callee->name);
+         entry = llvm_add_fn(obj, tb_get(symbol), obj->types[LLVM_ENTRY_FN]);
+      }
 #endif
    }
    else
@@ -3102,6 +3105,7 @@ static void jit_llvm_cleanup(void *context)
 }
 
 static const jit_plugin_t jit_llvm = {
+   .name    = "LLVM",
    .init    = jit_llvm_init,
    .cgen    = jit_llvm_cgen,
    .cleanup = jit_llvm_cleanup
@@ -3192,6 +3196,28 @@ void llvm_aot_compile(llvm_obj_t *obj, jit_t *j, jit_handle_t handle)
    free(func.name);
 }
 
+void llvm_cache_compile(llvm_obj_t *obj, jit_t *j, jit_handle_t handle)
+{
+   // Functions in the code cache are loaded individually so calls
+   // cannot bind directly to other functions in the same object
+   obj->open_world = true;
+
+   llvm_aot_compile(obj, j, handle);
+
+   jit_func_t *f = jit_get_func(j, handle);
+
+   LOCAL_TEXT_BUF tb = safe_symbol(f->name);
+   tb_cat(tb, ".hash");
+
+   LLVMValueRef hash =
+      LLVMAddGlobal(obj->module, obj->types[LLVM_INT64], tb_get(tb));
+   LLVMSetInitializer(hash, llvm_int64(obj, jit_pack_hash(f)));
+   LLVMSetGlobalConstant(hash, true);
+#ifdef IMPLIB_REQUIRED
+   LLVMSetDLLStorageClass(hash, LLVMDLLExportStorageClass);
+#endif
+}
+
 void llvm_obj_finalise(llvm_obj_t *obj, llvm_opt_level_t olevel)
 {
    if (obj->fns[LLVM_TLAB_ALLOC] != NULL)
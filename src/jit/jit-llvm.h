@@ -37,6 +37,7 @@ typedef enum {
 llvm_obj_t *llvm_obj_new(const char *name);
 void llvm_add_abi_version(llvm_obj_t *obj);
 void llvm_aot_compile(llvm_obj_t *obj, jit_t *j, jit_handle_t handle);
+void llvm_cache_compile(llvm_obj_t *obj, jit_t *j, jit_handle_t handle);
 void llvm_obj_finalise(llvm_obj_t *obj, llvm_opt_level_t level);
 void llvm_obj_emit(llvm_obj_t *obj, const char *path);
 
@@ -18,6 +18,7 @@
 #include "util.h"
 #include "array.h"
 #include "jit/jit-priv.h"
+#include "thread.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -152,11 +153,8 @@ static void cfg_liveness(jit_cfg_t *cfg, jit_func_t *f)
    mask_free(&tmp);
 }
 
-jit_cfg_t *jit_get_cfg(jit_func_t *f)
+static jit_cfg_t *cfg_build(jit_func_t *f)
 {
-   if (f->cfg != NULL)
-      return f->cfg;
-
    int nb = 1;
    for (int i = 0, first = 0; i < f->nirs; i++) {
       jit_ir_t *ir = &(f->irbuf[i]);
@@ -210,6 +208,30 @@ jit_cfg_t *jit_get_cfg(jit_func_t *f)
       }
    }
 
+   return cfg;
+}
+
+static void cfg_free(jit_cfg_t *cfg)
+{
+   for (int i = 0; i < cfg->nblocks; i++) {
+      jit_block_t *b = &(cfg->blocks[i]);
+      mask_free(&b->livein);
+      mask_free(&b->liveout);
+      mask_free(&b->varkill);
+
+      if (b->in.max > 4) free(b->in.u.external);
+      if (b->out.max > 4) free(b->out.u.external);
+   }
+
+   free(cfg);
+}
+
+jit_cfg_t *jit_get_cfg(jit_func_t *f)
+{
+   if (f->cfg != NULL)
+      return f->cfg;
+
+   jit_cfg_t *cfg = cfg_build(f);
    cfg_liveness(cfg, f);
 
    return (f->cfg = cfg);
@@ -218,17 +240,7 @@ jit_cfg_t *jit_get_cfg(jit_func_t *f)
 void jit_free_cfg(jit_func_t *f)
 {
    if (f->cfg != NULL) {
-      for (int i = 0; i < f->cfg->nblocks; i++) {
-         jit_block_t *b = &(f->cfg->blocks[i]);
-         mask_free(&b->livein);
-         mask_free(&b->liveout);
-         mask_free(&b->varkill);
-
-         if (b->in.max > 4) free(b->in.u.external);
-         if (b->out.max > 4) free(b->out.u.external);
-      }
-
-      free(f->cfg);
+      cfg_free(f->cfg);
       f->cfg = NULL;
    }
 }
@@ -259,6 +271,86 @@ int jit_get_edge(jit_edge_list_t *list, int nth)
       return list->u.external[nth];
 }
 
+static int cfg_intersect(const int *idom, const int *order, int a, int b)
+{
+   while (a != b) {
+      while (order[a] < order[b])
+         a = idom[a];
+      while (order[b] < order[a])
+         b = idom[b];
+   }
+
+   return a;
+}
+
+static void cfg_dominators(jit_cfg_t *cfg, int *idom)
+{
+   // Iterative algorithm from "A Simple, Fast Dominance Algorithm" by
+   // Cooper, Harvey, and Kennedy using a reverse postorder numbering;
+   // unreachable blocks have no immediate dominator
+   const int nblocks = cfg->nblocks;
+
+   int *order LOCAL = xmalloc_array(nblocks, sizeof(int));
+   int *rpo LOCAL = xmalloc_array(nblocks, sizeof(int));
+   int *stack LOCAL = xmalloc_array(nblocks, sizeof(int));
+   int *nextedge LOCAL = xcalloc_array(nblocks, sizeof(int));
+
+   for (int i = 0; i < nblocks; i++)
+      idom[i] = order[i] = -1;
+
+   int nstack = 0, npost = 0;
+   stack[nstack++] = 0;
+   order[0] = 0;
+
+   while (nstack > 0) {
+      const int top = stack[nstack - 1];
+      jit_block_t *b = &(cfg->blocks[top]);
+
+      if (nextedge[top] < b->out.count) {
+         const int succ = jit_get_edge(&b->out, nextedge[top]++);
+         if (order[succ] == -1) {
+            order[succ] = 0;
+            stack[nstack++] = succ;
+         }
+      }
+      else {
+         // Postorder numbers increase towards the entry block
+         order[top] = npost;
+         rpo[nblocks - 1 - npost++] = top;
+         nstack--;
+      }
+   }
+
+   const int *reached = rpo + nblocks - npost;
+   idom[0] = 0;
+
+   bool changed;
+   do {
+      changed = false;
+
+      for (int i = 1; i < npost; i++) {
+         const int block = reached[i];
+         jit_block_t *b = &(cfg->blocks[block]);
+
+         int dom = -1;
+         for (int j = 0; j < b->in.count; j++) {
+            const int pred = jit_get_edge(&b->in, j);
+            if (idom[pred] == -1)
+               continue;
+            else if (dom == -1)
+               dom = pred;
+            else
+               dom = cfg_intersect(idom, order, pred, dom);
+         }
+
+         if (dom != idom[block]) {
+            idom[block] = dom;
+            changed = true;
+         }
+      }
+   } while (changed);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Local value numbering and simple peepholes
 
@@ -895,33 +987,1718 @@ void jit_do_dce(jit_func_t *f)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-// NOP deletion
+// Value range propagation
 
-void jit_delete_nops(jit_func_t *f)
+typedef struct {
+   int64_t low;
+   int64_t high;
+} vrp_range_t;
+
+typedef enum {
+   FLAGS_UNKNOWN, FLAGS_FALSE, FLAGS_TRUE
+} vrp_flags_t;
+
+typedef struct {
+   int         slot;
+   vrp_range_t old;
+} vrp_undo_t;
+
+typedef struct {
+   int         *index;
+   vrp_range_t *regs;
+   vrp_flags_t  flags;
+   jit_ir_t    *cmp;
+   vrp_undo_t  *undo;
+   int          nundo;
+   int          maxundo;
+} vrp_state_t;
+
+typedef struct {
+   int          block;
+   int          mark;
+   vrp_flags_t  flags;
+   jit_ir_t    *cmp;
+   int          holds;
+   bool         reset;
+} vrp_pending_t;
+
+#define VRP_FULL ((vrp_range_t){ INT64_MIN, INT64_MAX })
+#define VRP_CONST(i) ((vrp_range_t){ (i), (i) })
+
+static vrp_range_t vrp_get_range(vrp_state_t *state, jit_value_t value)
+{
+   switch (value.kind) {
+   case JIT_VALUE_REG:
+      if (state->index[value.reg] < 0)
+         return VRP_FULL;
+      else
+         return state->regs[state->index[value.reg]];
+   case JIT_VALUE_INT64:
+      return VRP_CONST(value.int64);
+   default:
+      return VRP_FULL;
+   }
+}
+
+static void vrp_set_range(vrp_state_t *state, jit_reg_t reg, vrp_range_t r)
 {
-   jit_label_t *map LOCAL = xmalloc_array(f->nirs, sizeof(jit_label_t));
+   const int slot = state->index[reg];
+   if (slot < 0)
+      return;
 
-   int wptr = 0;
-   for (jit_ir_t *ir = f->irbuf; ir < f->irbuf + f->nirs; ir++) {
-      map[ir - f->irbuf] = wptr;
+   vrp_range_t *cur = &(state->regs[slot]);
+   if (cur->low == r.low && cur->high == r.high)
+      return;
 
-      if (ir->op != J_NOP) {
-         jit_ir_t *dest = f->irbuf + wptr++;
-         if (dest != ir)
-            *dest = *ir;
+   if (state->nundo == state->maxundo) {
+      state->maxundo = MAX(state->maxundo * 2, 64);
+      state->undo = xrealloc_array(state->undo, state->maxundo,
+                                   sizeof(vrp_undo_t));
+   }
+
+   state->undo[state->nundo++] = (vrp_undo_t){ slot, *cur };
+   *cur = r;
+}
+
+static void vrp_rewind(vrp_state_t *state, int mark)
+{
+   while (state->nundo > mark) {
+      const vrp_undo_t *u = &(state->undo[--state->nundo]);
+      state->regs[u->slot] = u->old;
+   }
+}
+
+static vrp_range_t vrp_sized(jit_size_t size, bool is_unsigned)
+{
+   switch (size) {
+   case JIT_SZ_8:
+      if (is_unsigned)
+         return (vrp_range_t){ 0, UINT8_MAX };
+      else
+         return (vrp_range_t){ INT8_MIN, INT8_MAX };
+   case JIT_SZ_16:
+      if (is_unsigned)
+         return (vrp_range_t){ 0, UINT16_MAX };
+      else
+         return (vrp_range_t){ INT16_MIN, INT16_MAX };
+   case JIT_SZ_32:
+      if (is_unsigned)
+         return (vrp_range_t){ 0, UINT32_MAX };
+      else
+         return (vrp_range_t){ INT32_MIN, INT32_MAX };
+   default:
+      return VRP_FULL;
+   }
+}
+
+static inline bool vrp_contains(vrp_range_t outer, vrp_range_t inner)
+{
+   return inner.low >= outer.low && inner.high <= outer.high;
+}
+
+static inline vrp_range_t vrp_hull(vrp_range_t a, vrp_range_t b)
+{
+   return (vrp_range_t){ MIN(a.low, b.low), MAX(a.high, b.high) };
+}
+
+static vrp_range_t vrp_add(vrp_range_t a, vrp_range_t b)
+{
+   vrp_range_t r;
+   if (__builtin_add_overflow(a.low, b.low, &r.low)
+       || __builtin_add_overflow(a.high, b.high, &r.high))
+      return VRP_FULL;
+   else
+      return r;
+}
+
+static vrp_range_t vrp_sub(vrp_range_t a, vrp_range_t b)
+{
+   vrp_range_t r;
+   if (__builtin_sub_overflow(a.low, b.high, &r.low)
+       || __builtin_sub_overflow(a.high, b.low, &r.high))
+      return VRP_FULL;
+   else
+      return r;
+}
+
+static vrp_range_t vrp_mul(vrp_range_t a, vrp_range_t b)
+{
+   const int64_t corners[4][2] = {
+      { a.low, b.low }, { a.low, b.high }, { a.high, b.low }, { a.high, b.high }
+   };
+
+   vrp_range_t r = { INT64_MAX, INT64_MIN };
+   for (int i = 0; i < 4; i++) {
+      int64_t p;
+      if (__builtin_mul_overflow(corners[i][0], corners[i][1], &p))
+         return VRP_FULL;
+
+      r.low = MIN(r.low, p);
+      r.high = MAX(r.high, p);
+   }
+
+   return r;
+}
+
+static vrp_range_t vrp_neg(vrp_range_t a)
+{
+   if (a.low == INT64_MIN)
+      return VRP_FULL;
+   else
+      return (vrp_range_t){ -a.high, -a.low };
+}
+
+static vrp_flags_t vrp_compare(jit_cc_t cc, vrp_range_t a, vrp_range_t b)
+{
+   bool always, never;
+   switch (cc) {
+   case JIT_CC_EQ:
+      always = a.low == a.high && b.low == b.high && a.low == b.low;
+      never = a.high < b.low || a.low > b.high;
+      break;
+   case JIT_CC_NE:
+      always = a.high < b.low || a.low > b.high;
+      never = a.low == a.high && b.low == b.high && a.low == b.low;
+      break;
+   case JIT_CC_LT:
+      always = a.high < b.low;
+      never = a.low >= b.high;
+      break;
+   case JIT_CC_LE:
+      always = a.high <= b.low;
+      never = a.low > b.high;
+      break;
+   case JIT_CC_GT:
+      always = a.low > b.high;
+      never = a.high <= b.low;
+      break;
+   case JIT_CC_GE:
+      always = a.low >= b.high;
+      never = a.high < b.low;
+      break;
+   default:
+      return FLAGS_UNKNOWN;
+   }
+
+   if (always)
+      return FLAGS_TRUE;
+   else if (never)
+      return FLAGS_FALSE;
+   else
+      return FLAGS_UNKNOWN;
+}
+
+static vrp_flags_t vrp_overflow(jit_ir_t *ir, vrp_range_t a, vrp_range_t b,
+                                vrp_range_t *result)
+{
+   // The result is truncated to the operation size and the flags are
+   // only known to be clear if the exact result fits in that size
+   const bool is_unsigned = (ir->cc == JIT_CC_C);
+   const vrp_range_t limit = vrp_sized(ir->size, is_unsigned);
+
+   *result = limit;
+
+   if (ir->cc != JIT_CC_O && ir->cc != JIT_CC_C)
+      return FLAGS_UNKNOWN;
+   else if (is_unsigned && (ir->size == JIT_SZ_64 || ir->size == JIT_SZ_UNSPEC))
+      return FLAGS_UNKNOWN;
+   else if (!vrp_contains(limit, a) || !vrp_contains(limit, b))
+      return FLAGS_UNKNOWN;
+
+   vrp_range_t exact;
+   switch (ir->op) {
+   case J_ADD: exact = vrp_add(a, b); break;
+   case J_SUB: exact = vrp_sub(a, b); break;
+   case J_MUL: exact = vrp_mul(a, b); break;
+   default: return FLAGS_UNKNOWN;
+   }
+
+   if (exact.low == INT64_MIN && exact.high == INT64_MAX)
+      return FLAGS_UNKNOWN;   // May have overflowed 64 bits
+   else if (!vrp_contains(limit, exact))
+      return FLAGS_UNKNOWN;
+
+   *result = exact;
+   return FLAGS_FALSE;
+}
+
+static vrp_range_t vrp_result(vrp_state_t *state, jit_ir_t *ir)
+{
+   const vrp_range_t a = vrp_get_range(state, ir->arg1);
+   const vrp_range_t b = vrp_get_range(state, ir->arg2);
+
+   switch (ir->op) {
+   case J_MOV:
+      return a;
+   case J_ADD:
+      return vrp_add(a, b);
+   case J_SUB:
+      return vrp_sub(a, b);
+   case J_MUL:
+      return vrp_mul(a, b);
+   case J_NEG:
+      return vrp_neg(a);
+   case J_NOT:
+      return (vrp_range_t){ 0, 1 };
+   case J_CSET:
+      if (state->flags != FLAGS_UNKNOWN)
+         return VRP_CONST(state->flags == FLAGS_TRUE);
+      else
+         return (vrp_range_t){ 0, 1 };
+   case J_CSEL:
+      if (state->flags == FLAGS_TRUE)
+         return a;
+      else if (state->flags == FLAGS_FALSE)
+         return b;
+      else
+         return vrp_hull(a, b);
+   case J_CNEG:
+      if (state->flags == FLAGS_TRUE)
+         return vrp_neg(a);
+      else if (state->flags == FLAGS_FALSE)
+         return a;
+      else
+         return vrp_hull(a, vrp_neg(a));
+   case J_CLAMP:
+      return (vrp_range_t){ MAX(a.low, 0), MAX(a.high, 0) };
+   case J_AND:
+      if (a.low >= 0 && b.low >= 0)
+         return (vrp_range_t){ 0, MIN(a.high, b.high) };
+      else if (a.low >= 0 || b.low >= 0)
+         return (vrp_range_t){ 0, a.low >= 0 ? a.high : b.high };
+      else
+         return VRP_FULL;
+   case J_REM:
+      if (b.low == b.high && b.low != 0 && b.low != INT64_MIN) {
+         const int64_t limit = llabs(b.low) - 1;
+         // The result has the sign of the dividend and may be zero
+         if (a.low >= 0)
+            return (vrp_range_t){ 0, MIN(a.high, limit) };
+         else
+            return (vrp_range_t){ MAX(a.low, -limit),
+                                  MIN(MAX(a.high, 0), limit) };
       }
+      else
+         return VRP_FULL;
+   case J_DIV:
+      if (b.low == b.high && b.low > 0)
+         return (vrp_range_t){ a.low / b.low, a.high / b.low };
+      else
+         return VRP_FULL;
+   case J_ASR:
+      if (b.low == b.high && b.low >= 0 && b.low < 64)
+         return (vrp_range_t){ a.low >> b.low, a.high >> b.low };
+      else
+         return VRP_FULL;
+   case J_LOAD:
+      return vrp_sized(ir->size, false);
+   case J_ULOAD:
+      return vrp_sized(ir->size, true);
+   default:
+      return VRP_FULL;
    }
+}
 
-   for (jit_ir_t *ir = f->irbuf; ir < f->irbuf + f->nirs; ir++) {
-      if (ir->arg1.kind == JIT_VALUE_LABEL) {
-         ir->arg1.label = map[ir->arg1.label];
-         f->irbuf[ir->arg1.label].target = 1;
+static bool vrp_is_operand(jit_ir_t *cmp, jit_reg_t reg)
+{
+   return (cmp->arg1.kind == JIT_VALUE_REG && cmp->arg1.reg == reg)
+      || (cmp->arg2.kind == JIT_VALUE_REG && cmp->arg2.reg == reg);
+}
+
+static void vrp_transfer(vrp_state_t *state, jit_ir_t *ir)
+{
+   // The operands of the last comparison are always tracked so writes
+   // to other registers cannot invalidate it
+   const bool writes_flags = jit_writes_flags(ir);
+   const bool tracked =
+      cfg_writes_result(ir) && state->index[ir->result] >= 0;
+
+   if (tracked || writes_flags) {
+      vrp_range_t result = VRP_FULL;
+      vrp_flags_t flags = FLAGS_UNKNOWN;
+
+      if (ir->op == J_CMP) {
+         const vrp_range_t a = vrp_get_range(state, ir->arg1);
+         const vrp_range_t b = vrp_get_range(state, ir->arg2);
+         flags = vrp_compare(ir->cc, a, b);
       }
-      if (ir->arg2.kind == JIT_VALUE_LABEL) {
-         ir->arg2.label = map[ir->arg2.label];
-         f->irbuf[ir->arg2.label].target = 1;
+      else if (writes_flags) {
+         const vrp_range_t a = vrp_get_range(state, ir->arg1);
+         const vrp_range_t b = vrp_get_range(state, ir->arg2);
+         if (ir->op != MACRO_EXP && ir->op != J_FCMP)
+            flags = vrp_overflow(ir, a, b, &result);
+      }
+      else
+         result = vrp_result(state, ir);
+
+      if (tracked) {
+         vrp_set_range(state, ir->result, result);
+
+         if (state->cmp != NULL && vrp_is_operand(state->cmp, ir->result))
+            state->cmp = NULL;
+      }
+
+      if (writes_flags) {
+         state->flags = flags;
+         state->cmp = (ir->op == J_CMP) ? ir : NULL;
+         return;
       }
    }
 
-   f->nirs = wptr;
+   if (ir->op >= __MACRO_BASE || ir->op == J_CALL) {
+      // Conservatively assume other macro operations clobber flags
+      state->flags = FLAGS_UNKNOWN;
+      state->cmp = NULL;
+   }
+}
+
+static inline int64_t vrp_succ(int64_t x)
+{
+   return x == INT64_MAX ? x : x + 1;
+}
+
+static inline int64_t vrp_pred(int64_t x)
+{
+   return x == INT64_MIN ? x : x - 1;
+}
+
+static void vrp_refine(vrp_state_t *state, bool holds)
+{
+   // Narrow the ranges of the operands of the last comparison given
+   // whether or not it holds on this edge
+   jit_ir_t *cmp = state->cmp;
+   vrp_range_t a = vrp_get_range(state, cmp->arg1);
+   vrp_range_t b = vrp_get_range(state, cmp->arg2);
+
+   static const jit_cc_t negate[] = {
+      [JIT_CC_EQ] = JIT_CC_NE, [JIT_CC_NE] = JIT_CC_EQ,
+      [JIT_CC_LT] = JIT_CC_GE, [JIT_CC_GE] = JIT_CC_LT,
+      [JIT_CC_GT] = JIT_CC_LE, [JIT_CC_LE] = JIT_CC_GT,
+   };
+
+   if (cmp->cc < JIT_CC_EQ || cmp->cc > JIT_CC_LE)
+      return;
+
+   switch (holds ? cmp->cc : negate[cmp->cc]) {
+   case JIT_CC_EQ:
+      a.low = b.low = MAX(a.low, b.low);
+      a.high = b.high = MIN(a.high, b.high);
+      break;
+   case JIT_CC_NE:
+      if (b.low == b.high && a.low == b.low)
+         a.low = vrp_succ(a.low);
+      else if (b.low == b.high && a.high == b.low)
+         a.high = vrp_pred(a.high);
+      if (a.low == a.high && b.low == a.low)
+         b.low = vrp_succ(b.low);
+      else if (a.low == a.high && b.high == a.low)
+         b.high = vrp_pred(b.high);
+      break;
+   case JIT_CC_LT:
+      a.high = MIN(a.high, vrp_pred(b.high));
+      b.low = MAX(b.low, vrp_succ(a.low));
+      break;
+   case JIT_CC_LE:
+      a.high = MIN(a.high, b.high);
+      b.low = MAX(b.low, a.low);
+      break;
+   case JIT_CC_GT:
+      a.low = MAX(a.low, vrp_succ(b.low));
+      b.high = MIN(b.high, vrp_pred(a.high));
+      break;
+   case JIT_CC_GE:
+      a.low = MAX(a.low, b.low);
+      b.high = MIN(b.high, a.high);
+      break;
+   default:
+      return;
+   }
+
+   // An empty range means the edge is never taken but keep the
+   // original ranges as the branch itself was not folded
+   if (cmp->arg1.kind == JIT_VALUE_REG && a.low <= a.high)
+      vrp_set_range(state, cmp->arg1.reg, a);
+   if (cmp->arg2.kind == JIT_VALUE_REG && b.low <= b.high)
+      vrp_set_range(state, cmp->arg2.reg, b);
+}
+
+static bool vrp_jump_taken(jit_ir_t *ir, vrp_flags_t flags, bool *taken)
+{
+   if (flags == FLAGS_UNKNOWN)
+      return false;
+   else if (ir->cc == JIT_CC_T)
+      *taken = (flags == FLAGS_TRUE);
+   else if (ir->cc == JIT_CC_F)
+      *taken = (flags == FLAGS_FALSE);
+   else
+      return false;
+
+   return true;
+}
+
+static void vrp_track_value(jit_value_t value, bool *tracked, bool *changed)
+{
+   if (value.kind == JIT_VALUE_REG && !tracked[value.reg])
+      tracked[value.reg] = *changed = true;
+}
+
+static int vrp_track_regs(jit_func_t *f, int *index)
+{
+   // Only registers that can flow into a comparison or an arithmetic
+   // operation with overflow check need a range
+   bool *tracked LOCAL = xcalloc_array(f->nregs, sizeof(bool));
+
+   bool changed;
+   do {
+      changed = false;
+
+      for (int i = f->nirs - 1; i >= 0; i--) {
+         jit_ir_t *ir = &(f->irbuf[i]);
+         bool uses_args;
+         switch (ir->op) {
+         case J_CMP:
+            uses_args = true;
+            break;
+         case J_ADD:
+         case J_SUB:
+         case J_MUL:
+            uses_args = ir->cc != JIT_CC_NONE || tracked[ir->result];
+            break;
+         case J_MOV:
+         case J_NEG:
+         case J_CSEL:
+         case J_CNEG:
+         case J_CLAMP:
+         case J_AND:
+         case J_REM:
+         case J_DIV:
+         case J_ASR:
+            uses_args = tracked[ir->result];
+            break;
+         default:
+            uses_args = false;
+            break;
+         }
+
+         if (uses_args) {
+            vrp_track_value(ir->arg1, tracked, &changed);
+            vrp_track_value(ir->arg2, tracked, &changed);
+         }
+      }
+   } while (changed);
+
+   int ntracked = 0;
+   for (int i = 0; i < f->nregs; i++)
+      index[i] = tracked[i] ? ntracked++ : -1;
+
+   return ntracked;
+}
+
+int jit_do_vrp(jit_func_t *f)
+{
+   int *index LOCAL = xmalloc_array(f->nregs, sizeof(int));
+   const int nregs = vrp_track_regs(f, index);
+
+   // Register liveness is not needed here so avoid jit_get_cfg
+   jit_cfg_t *cfg = cfg_build(f);
+
+   const int nblocks = cfg->nblocks;
+
+   vrp_range_t *regs LOCAL = xmalloc_array(nregs, sizeof(vrp_range_t));
+   for (int i = 0; i < nregs; i++)
+      regs[i] = VRP_FULL;
+
+   vrp_state_t state = {
+      .index = index,
+      .regs  = regs,
+   };
+
+   // Successor of each block made unreachable by folding its branch
+   int *removed LOCAL = xmalloc_array(nblocks, sizeof(int));
+   for (int i = 0; i < nblocks; i++)
+      removed[i] = -1;
+
+   // Only the ranges of registers with a single definition are known
+   // to still hold at a block reached along more than one path
+   int *ndefs LOCAL = xcalloc_array(f->nregs, sizeof(int));
+   for (int i = 0; i < f->nirs; i++) {
+      if (cfg_writes_result(&(f->irbuf[i])))
+         ndefs[f->irbuf[i].result]++;
+   }
+
+   jit_reg_t *multi LOCAL = xmalloc_array(nregs, sizeof(jit_reg_t));
+   int nmulti = 0;
+   for (int i = 0; i < f->nregs; i++) {
+      if (index[i] >= 0 && ndefs[i] > 1)
+         multi[nmulti++] = i;
+   }
+
+   int *idom LOCAL = xmalloc_array(nblocks, sizeof(int));
+   cfg_dominators(cfg, idom);
+
+   int *child LOCAL = xmalloc_array(nblocks, sizeof(int));
+   int *sibling LOCAL = xmalloc_array(nblocks, sizeof(int));
+   for (int i = 0; i < nblocks; i++)
+      child[i] = -1;
+   for (int i = nblocks - 1; i > 0; i--) {
+      if (idom[i] != -1) {
+         sibling[i] = child[idom[i]];
+         child[idom[i]] = i;
+      }
+   }
+
+   // Walk the dominator tree depth first so each block starts with the
+   // ranges at the end of its immediate dominator, refined by the
+   // branch condition if that is its only predecessor, and undo the
+   // changes when backtracking which keeps the analysis linear in the
+   // size of the function
+   vrp_pending_t *stack LOCAL = xmalloc_array(nblocks, sizeof(vrp_pending_t));
+   int nstack = 0;
+
+   stack[nstack++] = (vrp_pending_t){ .block = 0, .holds = -1 };
+
+   while (nstack > 0) {
+      const vrp_pending_t p = stack[--nstack];
+      jit_block_t *b = &(cfg->blocks[p.block]);
+
+      vrp_rewind(&state, p.mark);
+      state.flags = p.flags;
+      state.cmp = p.cmp;
+
+      if (p.holds != -1)
+         vrp_refine(&state, p.holds);
+      else if (p.reset) {
+         for (int i = 0; i < nmulti; i++)
+            vrp_set_range(&state, multi[i], VRP_FULL);
+      }
+
+      jit_ir_t *last = &(f->irbuf[b->last]);
+      const jit_cc_t cc = last->op == J_JUMP ? last->cc : JIT_CC_NONE;
+      const int next = p.block + 1 < nblocks ? p.block + 1 : -1;
+      const int target = cc != JIT_CC_NONE
+         ? jit_block_for(cfg, last->arg1.label) - cfg->blocks : -1;
+
+      // Fold branches and conditional moves whose outcome is known
+      for (int j = b->first; j <= b->last; j++) {
+         jit_ir_t *ir = &(f->irbuf[j]);
+         bool taken;
+
+         if (ir->op == J_JUMP && vrp_jump_taken(ir, state.flags, &taken)) {
+            if (taken)
+               ir->cc = JIT_CC_NONE;
+            else
+               lvn_convert_nop(ir);
+
+            if (target != next)
+               removed[p.block] = taken ? next : target;
+         }
+         else if (ir->op == J_CSEL && state.flags != FLAGS_UNKNOWN) {
+            ir->op = J_MOV;
+            if (state.flags == FLAGS_FALSE)
+               ir->arg1 = ir->arg2;
+            ir->arg2.kind = JIT_VALUE_INVALID;
+         }
+         else if (ir->op == J_CSET && state.flags != FLAGS_UNKNOWN) {
+            ir->op = J_MOV;
+            ir->arg1 = LVN_CONST(state.flags == FLAGS_TRUE);
+         }
+
+         vrp_transfer(&state, ir);
+      }
+
+      for (int c = child[p.block]; c != -1; c = sibling[c]) {
+         if (c == removed[p.block])
+            continue;
+
+         vrp_pending_t *pc = &(stack[nstack++]);
+         pc->block = c;
+         pc->mark  = state.nundo;
+         pc->holds = -1;
+
+         if (cfg->blocks[c].in.count == 1) {
+            // This block must be a successor so the flags are unchanged
+            // or known on each edge of a conditional branch
+            pc->flags = state.flags;
+            pc->cmp   = state.cmp;
+            pc->reset = false;
+
+            if (cc != JIT_CC_NONE && target != next) {
+               const bool holds = (c == target) == (cc == JIT_CC_T);
+               pc->flags = holds ? FLAGS_TRUE : FLAGS_FALSE;
+               if (state.cmp != NULL)
+                  pc->holds = holds;
+            }
+         }
+         else {
+            pc->flags = FLAGS_UNKNOWN;
+            pc->cmp   = NULL;
+            pc->reset = true;
+         }
+      }
+   }
+
+   free(state.undo);
+
+   // Delete code that can no longer be reached from the entry block
+   bool *reached LOCAL = xcalloc_array(nblocks, sizeof(bool));
+   int *work LOCAL = xmalloc_array(nblocks, sizeof(int));
+   int nwork = 0;
+
+   reached[0] = true;
+   work[nwork++] = 0;
+
+   while (nwork > 0) {
+      jit_block_t *b = &(cfg->blocks[work[--nwork]]);
+      for (int j = 0; j < b->out.count; j++) {
+         const int succ = jit_get_edge(&b->out, j);
+         if (succ != removed[b - cfg->blocks] && !reached[succ]) {
+            reached[succ] = true;
+            work[nwork++] = succ;
+         }
+      }
+   }
+
+   int nchecks = 0;
+   for (int i = 0; i < nblocks; i++) {
+      jit_block_t *b = &(cfg->blocks[i]);
+
+      if (!reached[i]) {
+         for (int j = b->first; j <= b->last; j++) {
+            lvn_convert_nop(&(f->irbuf[j]));
+            f->irbuf[j].result = JIT_REG_INVALID;
+         }
+      }
+      else if (removed[i] != -1 && cfg->blocks[removed[i]].aborts)
+         nchecks++;
+   }
+
+   cfg_free(cfg);
+   jit_free_cfg(f);
+
+   return nchecks;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Loop invariant code motion
+
+typedef struct {
+   int  header;
+   int  size;
+   int  before;
+   bool take_label;
+   bool flags_dead;
+} licm_loop_t;
+
+typedef struct {
+   int  from;
+   int  flags;
+   int  before;
+   int  seq;
+   bool take_label;
+} licm_hoist_t;
+
+typedef struct {
+   int64_t offset;
+   int64_t size;
+} licm_range_t;
+
+typedef A(licm_range_t) range_list_t;
+typedef A(licm_hoist_t) hoist_list_t;
+
+typedef struct {
+   jit_func_t   *func;
+   jit_cfg_t    *cfg;
+   int          *idom;
+   int          *stamp;
+   int          *defs;
+   int          *ndefs;
+   licm_range_t *slots;
+   bool         *moved;
+   range_list_t  unsafe;
+   range_list_t  stores;
+   hoist_list_t  hoist;
+} licm_state_t;
+
+static bool licm_dominates(const int *idom, int a, int b)
+{
+   for (; b != a; b = idom[b]) {
+      if (b == 0 || idom[b] == -1)
+         return false;
+   }
+
+   return true;
+}
+
+static int licm_body(licm_state_t *state, int header, int id, int *work)
+{
+   // The natural loop is the header and every block that can reach a
+   // back edge to the header without passing through it
+   jit_block_t *h = &(state->cfg->blocks[header]);
+
+   int size = 1, nwork = 0;
+   state->stamp[header] = id;
+
+   for (int i = 0; i < h->in.count; i++) {
+      const int pred = jit_get_edge(&h->in, i);
+      if (state->stamp[pred] != id
+          && licm_dominates(state->idom, header, pred)) {
+         state->stamp[pred] = id;
+         work[nwork++] = pred;
+         size++;
+      }
+   }
+
+   while (nwork > 0) {
+      jit_block_t *b = &(state->cfg->blocks[work[--nwork]]);
+      for (int i = 0; i < b->in.count; i++) {
+         const int pred = jit_get_edge(&b->in, i);
+         if (state->stamp[pred] != id && state->idom[pred] != -1) {
+            state->stamp[pred] = id;
+            work[nwork++] = pred;
+            size++;
+         }
+      }
+   }
+
+   return size;
+}
+
+static bool licm_flags_dead(jit_func_t *f, jit_block_t *b)
+{
+   // The flags may only be overwritten in the preheader if the loop
+   // header always sets them before reading
+   for (int i = b->first; i <= b->last; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_CSEL || ir->op == J_CSET || ir->op == J_CNEG)
+         return false;
+      else if (ir->op == J_JUMP && ir->cc != JIT_CC_NONE)
+         return false;
+      else if (jit_writes_flags(ir))
+         return true;
+      else if (ir->op >= __MACRO_BASE || ir->op == J_CALL)
+         return false;
+   }
+
+   return false;
+}
+
+static bool licm_preheader(licm_state_t *state, licm_loop_t *loop, int id)
+{
+   // Hoisted instructions are placed at the end of the only block
+   // entering the loop which must not have any other successor
+   jit_cfg_t *cfg = state->cfg;
+   jit_block_t *h = &(cfg->blocks[loop->header]);
+
+   int pre = -1;
+   for (int i = 0; i < h->in.count; i++) {
+      const int pred = jit_get_edge(&h->in, i);
+      if (state->stamp[pred] == id)
+         continue;
+      else if (pre != -1)
+         return false;
+      else
+         pre = pred;
+   }
+
+   if (pre == -1 || cfg->blocks[pre].out.count != 1)
+      return false;
+
+   loop->flags_dead = licm_flags_dead(state->func, h);
+
+   jit_ir_t *last = &(state->func->irbuf[cfg->blocks[pre].last]);
+   if (last->op == J_JUMP && last->cc == JIT_CC_NONE) {
+      loop->before = cfg->blocks[pre].last;
+      loop->take_label = true;
+      return true;
+   }
+   else if (pre + 1 == loop->header && last->op != J_JUMP
+            && last->op != J_RET && last->op != MACRO_CASE) {
+      loop->before = h->first;
+      loop->take_label = false;
+      return true;
+   }
+   else
+      return false;
+}
+
+static bool licm_is_invariant(licm_state_t *state, jit_value_t value, int id)
+{
+   switch (value.kind) {
+   case JIT_VALUE_REG:
+   case JIT_ADDR_REG:
+      return state->defs[value.reg] != id;
+   default:
+      return true;
+   }
+}
+
+static bool licm_overlaps(const licm_range_t *ranges, int count,
+                          licm_range_t r)
+{
+   for (int i = 0; i < count; i++) {
+      if (r.offset < ranges[i].offset + ranges[i].size
+          && ranges[i].offset < r.offset + r.size)
+         return true;
+   }
+
+   return false;
+}
+
+static bool licm_frame_range(licm_state_t *state, jit_ir_t *ir,
+                             jit_value_t addr, licm_range_t *r)
+{
+   if (addr.kind != JIT_ADDR_REG || state->slots[addr.reg].offset < 0)
+      return false;
+
+   r->offset = state->slots[addr.reg].offset + addr.disp;
+   r->size   = 1 << ir->size;
+   return true;
+}
+
+static bool licm_load_invariant(licm_state_t *state, jit_ir_t *ir)
+{
+   // A load from a stack slot whose address is never taken can only
+   // be changed by a store to the same slot inside the loop
+   licm_range_t r;
+   if (!licm_frame_range(state, ir, ir->arg1, &r))
+      return false;
+   else if (licm_overlaps(state->unsafe.items, state->unsafe.count, r))
+      return false;
+   else
+      return !licm_overlaps(state->stores.items, state->stores.count, r);
+}
+
+static int licm_flags_source(jit_func_t *f, jit_block_t *b, int pos)
+{
+   for (int i = pos - 1; i >= (int)b->first; i--) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_CMP)
+         return i;
+      else if (jit_writes_flags(ir))
+         return -1;
+      else if (ir->op >= __MACRO_BASE || ir->op == J_CALL)
+         return -1;
+   }
+
+   return -1;
+}
+
+static bool licm_can_hoist(licm_state_t *state, licm_loop_t *loop,
+                           jit_block_t *b, int pos, int id, int *flags)
+{
+   // Only operations that cannot fault may be executed speculatively
+   // in the preheader and those that read the flags take a copy of the
+   // comparison that sets them
+   jit_ir_t *ir = &(state->func->irbuf[pos]);
+
+   *flags = -1;
+
+   switch (ir->op) {
+   case J_ADD:
+   case J_SUB:
+   case J_MUL:
+      if (ir->cc != JIT_CC_NONE)
+         return false;
+      break;
+   case J_DIV:
+   case J_REM:
+      if (ir->arg2.kind != JIT_VALUE_INT64 || ir->arg2.int64 <= 0)
+         return false;
+      break;
+   case J_LOAD:
+   case J_ULOAD:
+      if (!licm_load_invariant(state, ir))
+         return false;
+      break;
+   case J_CSEL:
+   case J_CSET:
+   case J_CNEG:
+      {
+         if (!loop->flags_dead)
+            return false;
+
+         const int cmp = licm_flags_source(state->func, b, pos);
+         if (cmp == -1)
+            return false;
+
+         jit_ir_t *src = &(state->func->irbuf[cmp]);
+         if (!licm_is_invariant(state, src->arg1, id))
+            return false;
+         else if (!licm_is_invariant(state, src->arg2, id))
+            return false;
+
+         *flags = cmp;
+      }
+      break;
+   case J_MOV:
+   case J_NEG:
+   case J_NOT:
+   case J_AND:
+   case J_OR:
+   case J_XOR:
+   case J_SHL:
+   case J_ASR:
+   case J_LEA:
+   case J_CLAMP:
+   case J_FADD:
+   case J_FSUB:
+   case J_FMUL:
+   case J_FDIV:
+   case J_FNEG:
+   case J_SCVTF:
+      break;
+   default:
+      return false;
+   }
+
+   if (state->ndefs[ir->result] != 1 || state->defs[ir->result] != id)
+      return false;
+   else if (!licm_is_invariant(state, ir->arg1, id))
+      return false;
+   else
+      return licm_is_invariant(state, ir->arg2, id);
+}
+
+static void licm_find_slots(licm_state_t *state)
+{
+   // Stack slots are only tracked if every use of the address is as
+   // the base of a load or store
+   jit_func_t *f = state->func;
+
+   for (int i = 0; i < f->nregs; i++)
+      state->slots[i].offset = -1;
+
+   for (int i = 0; i < f->nirs; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == MACRO_SALLOC && state->ndefs[ir->result] == 1) {
+         state->slots[ir->result].offset = ir->arg1.int64;
+         state->slots[ir->result].size = ir->arg2.int64;
+      }
+   }
+
+   for (int i = 0; i < f->nirs; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      jit_value_t *uses[2] = { &(ir->arg1), &(ir->arg2) };
+
+      for (int j = 0; j < 2; j++) {
+         if (uses[j]->kind != JIT_VALUE_REG && uses[j]->kind != JIT_ADDR_REG)
+            continue;
+         else if (state->slots[uses[j]->reg].offset < 0)
+            continue;
+         else if (ir->op == J_LOAD && j == 0)
+            continue;
+         else if (ir->op == J_ULOAD && j == 0)
+            continue;
+         else if (ir->op == J_STORE && j == 1)
+            continue;
+
+         APUSH(state->unsafe, state->slots[uses[j]->reg]);
+      }
+   }
+}
+
+static int licm_cmp_loop(const void *a, const void *b)
+{
+   // Outer loops first so invariants move out of as many loops as
+   // possible in one pass
+   return ((const licm_loop_t *)b)->size - ((const licm_loop_t *)a)->size;
+}
+
+static int licm_cmp_hoist(const void *a, const void *b)
+{
+   const licm_hoist_t *ha = a, *hb = b;
+   if (ha->before != hb->before)
+      return ha->before - hb->before;
+   else
+      return ha->seq - hb->seq;
+}
+
+static void licm_hoist_loop(licm_state_t *state, licm_loop_t *loop, int id)
+{
+   jit_func_t *f = state->func;
+   jit_cfg_t *cfg = state->cfg;
+
+   ATRIM(state->stores, 0);
+
+   for (int i = 0; i < cfg->nblocks; i++) {
+      if (state->stamp[i] != id)
+         continue;
+
+      jit_block_t *b = &(cfg->blocks[i]);
+      for (int j = b->first; j <= b->last; j++) {
+         jit_ir_t *ir = &(f->irbuf[j]);
+         licm_range_t r;
+
+         if (state->moved[j])
+            continue;
+         else if (cfg_writes_result(ir))
+            state->defs[ir->result] = id;
+         else if (ir->op == J_STORE && licm_frame_range(state, ir, ir->arg2, &r))
+            APUSH(state->stores, r);
+      }
+   }
+
+   // Hoisting one instruction can make others that use its result
+   // invariant so repeat until nothing changes
+   bool changed;
+   do {
+      changed = false;
+
+      for (int i = 0; i < cfg->nblocks; i++) {
+         if (state->stamp[i] != id)
+            continue;
+
+         jit_block_t *b = &(cfg->blocks[i]);
+         for (int j = b->first; j <= b->last; j++) {
+            int flags;
+            if (state->moved[j])
+               continue;
+            else if (!licm_can_hoist(state, loop, b, j, id, &flags))
+               continue;
+
+            licm_hoist_t h = {
+               .from       = j,
+               .flags      = flags,
+               .before     = loop->before,
+               .seq        = state->hoist.count,
+               .take_label = loop->take_label,
+            };
+            APUSH(state->hoist, h);
+
+            state->moved[j] = true;
+            state->defs[f->irbuf[j].result] = -1;
+            changed = true;
+         }
+      }
+   } while (changed);
+}
+
+static void licm_rewrite(licm_state_t *state)
+{
+   jit_func_t *f = state->func;
+   const licm_hoist_t *hoist = state->hoist.items;
+   const unsigned nhoist = state->hoist.count;
+
+   qsort(state->hoist.items, nhoist, sizeof(licm_hoist_t), licm_cmp_hoist);
+
+   // Each hoisted instruction that reads the flags may need a copy of
+   // the comparison that sets them
+   jit_ir_t *irbuf = xcalloc_array(f->nirs + 2 * nhoist, sizeof(jit_ir_t));
+   jit_label_t *map LOCAL = xmalloc_array(f->nirs + 1, sizeof(jit_label_t));
+
+   unsigned wptr = 0;
+   for (unsigned i = 0, nth = 0; i < f->nirs; i++) {
+      // Branches to the final jump of the preheader must now execute
+      // the hoisted instructions but the back edges of a loop entered
+      // by falling through must not
+      const bool take_label = nth < nhoist
+         && hoist[nth].before == i && hoist[nth].take_label;
+
+      if (take_label)
+         map[i] = wptr;
+
+      for (int flags = -1; nth < nhoist && hoist[nth].before == i; nth++) {
+         if (hoist[nth].flags != -1 && hoist[nth].flags != flags) {
+            flags = hoist[nth].flags;
+            irbuf[wptr] = f->irbuf[flags];
+            irbuf[wptr++].target = 0;
+         }
+
+         irbuf[wptr] = f->irbuf[hoist[nth].from];
+         irbuf[wptr++].target = 0;
+      }
+
+      if (!take_label)
+         map[i] = wptr;
+
+      irbuf[wptr] = f->irbuf[i];
+
+      if (state->moved[i]) {
+         lvn_convert_nop(&(irbuf[wptr]));
+         irbuf[wptr].result = JIT_REG_INVALID;
+      }
+
+      wptr++;
+   }
+
+   map[f->nirs] = wptr;
+
+   for (unsigned i = 0; i < wptr; i++) {
+      jit_ir_t *ir = &(irbuf[i]);
+      if (ir->arg1.kind == JIT_VALUE_LABEL) {
+         ir->arg1.label = map[ir->arg1.label];
+         irbuf[ir->arg1.label].target = 1;
+      }
+      if (ir->arg2.kind == JIT_VALUE_LABEL) {
+         ir->arg2.label = map[ir->arg2.label];
+         irbuf[ir->arg2.label].target = 1;
+      }
+   }
+
+   for (int i = 0; i < f->ninlines; i++) {
+      jit_inline_t *in = &(f->inlines[i]);
+      in->last  = map[in->last + 1] - 1;
+      in->first = map[in->first];
+   }
+
+   free(f->irbuf);
+   f->irbuf = irbuf;
+   f->nirs  = wptr;
+}
+
+void jit_do_licm(jit_func_t *f)
+{
+   // Every loop needs at least one backwards branch
+   bool backwards = false;
+   for (int i = 0; i < f->nirs && !backwards; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_JUMP)
+         backwards = ir->arg1.label <= i;
+      else if (ir->op == MACRO_CASE)
+         backwards = ir->arg2.label <= i;
+   }
+
+   if (!backwards)
+      return;
+
+   // Register liveness is not needed here so avoid jit_get_cfg
+   jit_cfg_t *cfg = cfg_build(f);
+
+   const int nblocks = cfg->nblocks;
+
+   int *idom LOCAL = xmalloc_array(nblocks, sizeof(int));
+   cfg_dominators(cfg, idom);
+
+   int *stamp LOCAL = xmalloc_array(nblocks, sizeof(int));
+   int *work LOCAL = xmalloc_array(nblocks, sizeof(int));
+   for (int i = 0; i < nblocks; i++)
+      stamp[i] = -1;
+
+   licm_state_t state = {
+      .func  = f,
+      .cfg   = cfg,
+      .idom  = idom,
+      .stamp = stamp,
+   };
+
+   SCOPED_A(licm_loop_t) loops = AINIT;
+
+   for (int i = 1; i < nblocks; i++) {
+      jit_block_t *b = &(cfg->blocks[i]);
+      if (idom[i] == -1)
+         continue;
+
+      bool header = false;
+      for (int j = 0; j < b->in.count && !header; j++)
+         header = licm_dominates(idom, i, jit_get_edge(&b->in, j));
+
+      if (header) {
+         licm_loop_t loop = {
+            .header = i,
+            .size   = licm_body(&state, i, loops.count, work),
+         };
+         APUSH(loops, loop);
+      }
+   }
+
+   qsort(loops.items, loops.count, sizeof(licm_loop_t), licm_cmp_loop);
+
+   int *ndefs LOCAL = xcalloc_array(f->nregs, sizeof(int));
+   for (int i = 0; i < f->nirs; i++) {
+      if (cfg_writes_result(&(f->irbuf[i])))
+         ndefs[f->irbuf[i].result]++;
+   }
+
+   int *defs LOCAL = xmalloc_array(f->nregs, sizeof(int));
+   for (int i = 0; i < f->nregs; i++)
+      defs[i] = -1;
+
+   licm_range_t *slots LOCAL = xmalloc_array(f->nregs, sizeof(licm_range_t));
+   bool *moved LOCAL = xcalloc_array(f->nirs, sizeof(bool));
+
+   state.defs  = defs;
+   state.ndefs = ndefs;
+   state.slots = slots;
+   state.moved = moved;
+
+   licm_find_slots(&state);
+
+   for (int i = 0; i < nblocks; i++)
+      stamp[i] = -1;
+
+   for (int i = 0; i < loops.count; i++) {
+      licm_loop_t *loop = &(loops.items[i]);
+      licm_body(&state, loop->header, i, work);
+
+      if (licm_preheader(&state, loop, i))
+         licm_hoist_loop(&state, loop, i);
+   }
+
+   cfg_free(cfg);
+
+   if (state.hoist.count > 0) {
+      licm_rewrite(&state);
+      jit_free_cfg(f);
+   }
+
+   ACLEAR(state.unsafe);
+   ACLEAR(state.stores);
+   ACLEAR(state.hoist);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// NOP deletion
+
+void jit_delete_nops(jit_func_t *f)
+{
+   jit_label_t *map LOCAL = xmalloc_array(f->nirs + 1, sizeof(jit_label_t));
+
+   int wptr = 0;
+   for (jit_ir_t *ir = f->irbuf; ir < f->irbuf + f->nirs; ir++) {
+      map[ir - f->irbuf] = wptr;
+
+      if (ir->op != J_NOP) {
+         jit_ir_t *dest = f->irbuf + wptr++;
+         if (dest != ir)
+            *dest = *ir;
+      }
+   }
+
+   for (jit_ir_t *ir = f->irbuf; ir < f->irbuf + f->nirs; ir++) {
+      if (ir->arg1.kind == JIT_VALUE_LABEL) {
+         ir->arg1.label = map[ir->arg1.label];
+         f->irbuf[ir->arg1.label].target = 1;
+      }
+      if (ir->arg2.kind == JIT_VALUE_LABEL) {
+         ir->arg2.label = map[ir->arg2.label];
+         f->irbuf[ir->arg2.label].target = 1;
+      }
+   }
+
+   map[f->nirs] = wptr;
+
+   int nkeep = 0;
+   for (int i = 0; i < f->ninlines; i++) {
+      jit_inline_t *in = &(f->inlines[i]);
+      const unsigned first = map[in->first], end = map[in->last + 1];
+      if (first < end) {
+         f->inlines[nkeep].first  = first;
+         f->inlines[nkeep].last   = end - 1;
+         f->inlines[nkeep].handle = in->handle;
+         nkeep++;
+      }
+   }
+
+   f->ninlines = nkeep;
+   f->nirs = wptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Inlining
+
+#define INLINE_MAX_IRS    64
+#define INLINE_MAX_GROWTH 2048
+
+typedef enum {
+   SLOT_OTHER, SLOT_PARAM, SLOT_RESULT
+} slot_use_t;
+
+typedef struct {
+   jit_func_t *callee;
+   unsigned    first;
+   unsigned    call;
+   unsigned    last;
+   jit_reg_t   slotbase;
+   jit_reg_t   regbase;
+   unsigned    cpoolbase;
+} inline_site_t;
+
+static slot_use_t inline_slot_use(jit_func_t *callee, int pos)
+{
+   // Parameters are received on entry and results sent immediately
+   // before returning: other uses of the argument slots pass values to
+   // and from exits and are left unchanged
+   switch (callee->irbuf[pos].op) {
+   case J_RECV:
+      while (pos > 0 && callee->irbuf[pos - 1].op == J_RECV)
+         pos--;
+      if (pos > 0 && callee->irbuf[pos - 1].op == MACRO_EXIT)
+         return SLOT_OTHER;
+      else
+         return SLOT_PARAM;
+   case J_SEND:
+      while (pos + 1 < callee->nirs && callee->irbuf[pos + 1].op == J_SEND)
+         pos++;
+      if (pos + 1 < callee->nirs && callee->irbuf[pos + 1].op == J_RET)
+         return SLOT_RESULT;
+      else
+         return SLOT_OTHER;
+   default:
+      return SLOT_OTHER;
+   }
+}
+
+static bool inline_can_inline(jit_func_t *f, jit_func_t *callee)
+{
+   if (callee == f)
+      return false;
+
+   // Never wait for a function being compiled by this or another
+   // thread: this also breaks cycles of mutually recursive calls
+   const func_state_t state = load_acquire(&(callee->state));
+   if (state == JIT_FUNC_COMPILING)
+      return false;
+   else if (state == JIT_FUNC_PLACEHOLDER && callee->unit == NULL)
+      return false;
+
+   // Check the size before generating IR for the callee as that would
+   // in turn generate IR for its callees whether or not they are ever
+   // called: each vcode operation becomes at least one IR instruction
+   if (!jit_irbuf_available(callee, INLINE_MAX_IRS))
+      return false;
+
+   jit_fill_irbuf(callee);
+
+   if (callee->nirs > INLINE_MAX_IRS)
+      return false;
+
+   bool clobbered = false;
+   for (int i = 0; i < callee->nirs; i++) {
+      switch (callee->irbuf[i].op) {
+      case J_CALL:
+      case MACRO_FFICALL:
+      case MACRO_PUTPRIV:
+      case MACRO_TRIM:
+         // These use the argument slots or modify state belonging to
+         // the caller
+         return false;
+      case MACRO_EXIT:
+         clobbered = true;
+         break;
+      case J_SEND:
+         clobbered |= inline_slot_use(callee, i) == SLOT_OTHER;
+         break;
+      case J_RECV:
+         if (clobbered && inline_slot_use(callee, i) == SLOT_PARAM)
+            return false;
+         break;
+      default:
+         break;
+      }
+   }
+
+   return true;
+}
+
+static bool inline_find_site(jit_func_t *f, unsigned call, inline_site_t *site)
+{
+   jit_ir_t *ir = &(f->irbuf[call]);
+   if (ir->arg1.handle == JIT_HANDLE_INVALID || ir->target)
+      return false;
+   else if (call + 1 >= f->nirs)
+      return false;
+
+   jit_func_t *callee = jit_get_func(f->jit, ir->arg1.handle);
+   if (!inline_can_inline(f, callee))
+      return false;
+
+   // The arguments are sent immediately before the call and the
+   // results received immediately after in straight-line code
+   uint64_t sent = 0, written = 0;
+   unsigned first = call;
+   while (first > 0 && f->irbuf[first - 1].op == J_SEND) {
+      jit_ir_t *send = &(f->irbuf[--first]);
+      sent |= UINT64_C(1) << send->arg1.int64;
+      if (send->target)
+         break;
+   }
+
+   unsigned last = call;
+   for (; last + 1 < f->nirs && f->irbuf[last + 1].op == J_RECV
+           && !f->irbuf[last + 1].target; last++)
+      ;
+
+   for (int i = 0; i < callee->nirs; i++) {
+      jit_ir_t *cir = &(callee->irbuf[i]);
+      if (cir->op != J_RECV && cir->op != J_SEND)
+         continue;
+
+      const uint64_t bit = UINT64_C(1) << cir->arg1.int64;
+      switch (inline_slot_use(callee, i)) {
+      case SLOT_PARAM:
+         if (!(sent & bit))
+            return false;
+         break;
+      case SLOT_RESULT:
+         written |= bit;
+         break;
+      default:
+         break;
+      }
+   }
+
+   for (int i = call + 1; i <= last; i++) {
+      const uint64_t bit = UINT64_C(1) << f->irbuf[i].arg1.int64;
+      if (!(sent & bit) && !(written & bit))
+         return false;
+   }
+
+   site->callee = callee;
+   site->first  = first;
+   site->call   = call;
+   site->last   = last;
+
+   return true;
+}
+
+static inline jit_value_t inline_slot(inline_site_t *site, int64_t nth)
+{
+   return (jit_value_t){ .kind = JIT_VALUE_REG, .reg = site->slotbase + nth };
+}
+
+static void inline_convert_send(jit_ir_t *ir, jit_reg_t slotbase)
+{
+   // Arguments may be addresses which must be computed with LEA
+   switch (ir->arg2.kind) {
+   case JIT_ADDR_REG:
+   case JIT_ADDR_CPOOL:
+   case JIT_ADDR_ABS:
+      ir->op = J_LEA;
+      break;
+   default:
+      ir->op = J_MOV;
+      break;
+   }
+
+   ir->result    = slotbase + ir->arg1.int64;
+   ir->arg1      = ir->arg2;
+   ir->arg2.kind = JIT_VALUE_INVALID;
+}
+
+static void inline_remap(jit_value_t *value, jit_reg_t regbase,
+                         unsigned cpoolbase, unsigned labelbase)
+{
+   switch (value->kind) {
+   case JIT_VALUE_REG:
+   case JIT_ADDR_REG:
+      value->reg += regbase;
+      break;
+   case JIT_ADDR_CPOOL:
+      value->int64 += cpoolbase;
+      break;
+   case JIT_VALUE_LABEL:
+      value->label += labelbase;
+      break;
+   default:
+      break;
+   }
+}
+
+static void inline_body(inline_site_t *site, jit_ir_t *dest, unsigned start,
+                        unsigned cont, unsigned framebase)
+{
+   jit_func_t *callee = site->callee;
+
+   for (int i = 0; i < callee->nirs; i++, dest++) {
+      *dest = callee->irbuf[i];
+
+      if (dest->result != JIT_REG_INVALID)
+         dest->result += site->regbase;
+
+      inline_remap(&dest->arg1, site->regbase, site->cpoolbase, start);
+      inline_remap(&dest->arg2, site->regbase, site->cpoolbase, start);
+
+      switch (dest->op) {
+      case J_RECV:
+         if (inline_slot_use(callee, i) == SLOT_PARAM) {
+            dest->op   = J_MOV;
+            dest->arg1 = inline_slot(site, dest->arg1.int64);
+         }
+         break;
+      case J_SEND:
+         if (inline_slot_use(callee, i) == SLOT_RESULT)
+            inline_convert_send(dest, site->slotbase);
+         break;
+      case J_RET:
+         dest->op   = J_JUMP;
+         dest->cc   = JIT_CC_NONE;
+         dest->arg1 = (jit_value_t){ .kind = JIT_VALUE_LABEL, .label = cont };
+         break;
+      case MACRO_SALLOC:
+         dest->arg1.int64 += framebase;
+         break;
+      default:
+         break;
+      }
+   }
+}
+
+static unsigned inline_append_cpool(jit_func_t *f, jit_func_t *callee)
+{
+   if (callee->cpoolsz == 0)
+      return 0;
+
+   const unsigned base = ALIGN_UP(f->cpoolsz, 8);
+   unsigned char *cpool = xmalloc(base + callee->cpoolsz);
+   if (f->cpoolsz > 0)
+      memcpy(cpool, f->cpool, f->cpoolsz);
+   memset(cpool + f->cpoolsz, '\0', base - f->cpoolsz);
+   memcpy(cpool + base, callee->cpool, callee->cpoolsz);
+
+   if (f->owns_cpool)
+      free(f->cpool);
+
+   f->cpool      = cpool;
+   f->cpoolsz    = base + callee->cpoolsz;
+   f->owns_cpool = true;
+
+   return base;
+}
+
+static void inline_update_map(jit_func_t *f, const inline_site_t *sites,
+                              int nsites, const jit_label_t *map)
+{
+   // Record the range of each inlined call for stack traces with outer
+   // calls preceding any nested calls inlined into the callee
+   unsigned ninlines = f->ninlines;
+   for (int i = 0; i < nsites; i++)
+      ninlines += 1 + sites[i].callee->ninlines;
+
+   jit_inline_t *inlines = xmalloc_array(ninlines, sizeof(jit_inline_t));
+
+   unsigned wptr = 0;
+   for (int i = 0; i < f->ninlines; i++) {
+      inlines[wptr].first  = map[f->inlines[i].first];
+      inlines[wptr].last   = map[f->inlines[i].last + 1] - 1;
+      inlines[wptr].handle = f->inlines[i].handle;
+      wptr++;
+   }
+
+   for (int i = 0; i < nsites; i++) {
+      jit_func_t *callee = sites[i].callee;
+      const unsigned start = map[sites[i].call];
+
+      inlines[wptr].first  = start;
+      inlines[wptr].last   = start + callee->nirs - 1;
+      inlines[wptr].handle = callee->handle;
+      wptr++;
+
+      for (int j = 0; j < callee->ninlines; j++) {
+         inlines[wptr].first  = start + callee->inlines[j].first;
+         inlines[wptr].last   = start + callee->inlines[j].last;
+         inlines[wptr].handle = callee->inlines[j].handle;
+         wptr++;
+      }
+   }
+
+   assert(wptr == ninlines);
+
+   free(f->inlines);
+   f->inlines  = inlines;
+   f->ninlines = ninlines;
+}
+
+void jit_do_inline(jit_func_t *f)
+{
+   SCOPED_A(inline_site_t) sites = AINIT;
+
+   unsigned growth = 0, nregs = f->nregs, framesz = 0;
+   for (int i = 0; i < f->nirs; i++) {
+      if (f->irbuf[i].op != J_CALL)
+         continue;
+
+      inline_site_t site;
+      if (!inline_find_site(f, i, &site))
+         continue;
+      else if (growth + site.callee->nirs > INLINE_MAX_GROWTH)
+         break;
+      else if (nregs + JIT_MAX_ARGS + site.callee->nregs >= JIT_REG_INVALID)
+         break;
+
+      // Arguments and results are passed through a block of registers
+      // at each call site and the frames of inlined functions can
+      // overlap as they are never live at the same time
+      site.slotbase = nregs;
+      site.regbase  = nregs + JIT_MAX_ARGS;
+
+      nregs += JIT_MAX_ARGS + site.callee->nregs;
+      growth += site.callee->nirs - 1;
+      framesz = MAX(framesz, site.callee->framesz);
+
+      int prev = 0;
+      for (; prev < sites.count && sites.items[prev].callee != site.callee;
+           prev++)
+         ;
+
+      if (prev < sites.count)
+         site.cpoolbase = sites.items[prev].cpoolbase;
+      else
+         site.cpoolbase = inline_append_cpool(f, site.callee);
+
+      APUSH(sites, site);
+   }
+
+   if (sites.count == 0)
+      return;
+
+   jit_label_t *map LOCAL = xmalloc_array(f->nirs + 1, sizeof(jit_label_t));
+
+   for (int i = 0, wptr = 0, nth = 0; i <= f->nirs; i++) {
+      map[i] = wptr;
+      if (nth < sites.count && sites.items[nth].call == i)
+         wptr += sites.items[nth++].callee->nirs;
+      else
+         wptr++;
+   }
+
+   const unsigned nirs = map[f->nirs];
+   jit_ir_t *irbuf = xcalloc_array(nirs, sizeof(jit_ir_t));
+
+   for (int i = 0, nth = 0; i < f->nirs; i++) {
+      jit_ir_t *dest = &(irbuf[map[i]]);
+      inline_site_t *site = nth < sites.count ? &(sites.items[nth]) : NULL;
+
+      if (site != NULL && site->call == i) {
+         inline_body(site, dest, map[i], map[i + 1], f->framesz);
+
+         if (site->last == i)
+            nth++;
+         continue;
+      }
+
+      *dest = f->irbuf[i];
+
+      if (dest->arg1.kind == JIT_VALUE_LABEL)
+         dest->arg1.label = map[dest->arg1.label];
+      if (dest->arg2.kind == JIT_VALUE_LABEL)
+         dest->arg2.label = map[dest->arg2.label];
+
+      if (site == NULL || i < site->first)
+         continue;
+      else if (i < site->call) {
+         assert(dest->op == J_SEND);
+         inline_convert_send(dest, site->slotbase);
+      }
+      else {
+         assert(dest->op == J_RECV);
+         dest->op   = J_MOV;
+         dest->arg1 = inline_slot(site, dest->arg1.int64);
+
+         if (i == site->last)
+            nth++;
+      }
+   }
+
+   for (int i = 0; i < sites.count; i++)
+      irbuf[map[sites.items[i].call + 1]].target = 1;
+
+   inline_update_map(f, sites.items, sites.count, map);
+
+   free(f->irbuf);
+   f->irbuf    = irbuf;
+   f->nirs     = nirs;
+   f->nregs    = nregs;
+   f->framesz += framesz;
+
+   jit_free_cfg(f);
 }
@@ -200,7 +200,7 @@ static void pack_value(pack_func_t *pf, jit_t *j, jit_value_t value)
       pack_uint(pf, value.disp);
       break;
    case JIT_ADDR_CPOOL:
-      pack_uint(pf, value.disp);
+      pack_uint(pf, value.int64);
       break;
    case JIT_ADDR_ABS:
    case JIT_ADDR_COVER:
@@ -267,6 +267,14 @@ static void pack_func(pack_func_t *pf, jit_t *j, jit_func_t *f)
       pack_value(pf, j, ir->arg1);
       pack_value(pf, j, ir->arg2);
    }
+
+   pack_uint(pf, f->ninlines);
+
+   for (int i = 0; i < f->ninlines; i++) {
+      pack_uint(pf, f->inlines[i].first);
+      pack_uint(pf, f->inlines[i].last);
+      pack_handle(pf, j, f->inlines[i].handle);
+   }
 }
 
 void jit_pack_encode(jit_pack_t *jp, jit_t *j, jit_handle_t handle)
@@ -321,6 +329,33 @@ void jit_pack_encode(jit_pack_t *jp, jit_t *j, jit_handle_t handle)
    chash_put(jp->funcs, f->name, pf);
 }
 
+uint64_t jit_pack_hash(jit_func_t *f)
+{
+   assert(f->irbuf != NULL);
+
+   pack_func_t pf = {
+      .bufsz   = f->nirs * 10,
+      .strtab  = shash_new(128),
+      .nextstr = 1,
+   };
+   pf.buf = pf.wptr = xmalloc(pf.bufsz);
+
+   pack_func(&pf, f->jit, f);
+
+   // FNV-1a hash of the encoded IR and constant pool
+   uint64_t hash = UINT64_C(0xcbf29ce484222325);
+   for (const uint8_t *p = pf.buf; p < pf.wptr; p++)
+      hash = (hash ^ *p) * UINT64_C(0x100000001b3);
+   for (size_t i = 0; i < pf.cpoolsz; i++)
+      hash = (hash ^ pf.cpool[i]) * UINT64_C(0x100000001b3);
+
+   shash_free(pf.strtab);
+   free(pf.buf);
+   free(pf.cpool);
+
+   return hash;
+}
+
 void jit_pack_vcode(jit_pack_t *jp, jit_t *j, vcode_unit_t vu)
 {
    vcode_select_unit(vu);
@@ -395,7 +430,7 @@ static inline jit_reg_t unpack_reg(pack_func_t *pf)
 {
    const uint64_t enc = unpack_uint(pf);
    assert(enc < JIT_REG_INVALID - 1);
-   return enc == 0 ? JIT_REG_INVALID : enc + 1;
+   return enc == 0 ? JIT_REG_INVALID : enc - 1;
 }
 
 static inline double unpack_double(pack_func_t *pf)
@@ -469,7 +504,7 @@ static jit_value_t unpack_value(pack_func_t *pf, jit_t *j)
       value.disp = unpack_uint(pf);
       break;
    case JIT_ADDR_CPOOL:
-      value.disp = unpack_uint(pf);
+      value.int64 = unpack_uint(pf);
       break;
    case JIT_ADDR_ABS:
    case JIT_ADDR_COVER:
@@ -570,6 +605,18 @@ bool jit_pack_fill(jit_pack_t *jp, jit_t *j, jit_func_t *f)
       ir->arg2 = unpack_value(pf, j);
    }
 
+   f->ninlines = unpack_uint(pf);
+
+   if (f->ninlines > 0) {
+      f->inlines = xmalloc_array(f->ninlines, sizeof(jit_inline_t));
+
+      for (int i = 0; i < f->ninlines; i++) {
+         f->inlines[i].first  = unpack_uint(pf);
+         f->inlines[i].last   = unpack_uint(pf);
+         f->inlines[i].handle = unpack_handle(pf, j);
+      }
+   }
+
    f->cpool = pf->cpool;
 
    ACLEAR(pf->strings);
@@ -19,6 +19,7 @@
 #define _JIT_PRIV_H
 
 #include "util.h"
+#include "array.h"
 #include "jit/jit.h"
 #include "jit/jit-ffi.h"
 #include "mask.h"
@@ -158,6 +159,11 @@ typedef enum {
    JIT_EXIT_COVER_TOGGLE,
    JIT_EXIT_PROCESS_INIT,
    JIT_EXIT_CLEAR_EVENT,
+   JIT_EXIT_NUMERIC_ADD,
+   JIT_EXIT_NUMERIC_RESIZE,
+   JIT_EXIT_NUMERIC_TO_UNSIGNED,
+   JIT_EXIT_RISING_EDGE,
+   JIT_EXIT_FALLING_EDGE,
 } jit_exit_t;
 
 typedef uint16_t jit_reg_t;
@@ -217,6 +223,7 @@ typedef struct _jit_tier jit_tier_t;
 typedef struct _jit_func jit_func_t;
 typedef struct _jit_block jit_block_t;
 typedef struct _jit_anchor jit_anchor_t;
+typedef struct _interp_op interp_op_t;
 
 typedef void (*jit_entry_fn_t)(jit_func_t *, jit_anchor_t *,
                                jit_scalar_t *, tlab_t *);
@@ -267,6 +274,45 @@ typedef struct {
    unsigned offset;
 } link_tab_t;
 
+typedef struct {
+   unsigned     first;
+   unsigned     last;
+   jit_handle_t handle;
+} jit_inline_t;
+
+typedef struct {
+   uint32_t   irpos;
+   jit_exit_t which;
+   uint64_t   count;
+} jit_site_t;
+
+typedef struct {
+   nvc_lock_t  lock;
+   uint64_t   *ops;       // Interpreter execution count for each IR
+   ihash_t    *index;
+   jit_site_t *sites;
+   unsigned    nsites;
+   unsigned    maxsites;
+} jit_counters_t;
+
+typedef struct {
+   uint64_t          count;
+   struct _jit_func *func;
+   uint32_t          irpos;
+   unsigned          kind;    // Exit kind or opcode
+} counter_row_t;
+
+typedef A(counter_row_t) counter_row_list_t;
+
+typedef struct {
+   counter_row_list_t sites;    // Each exit site by count
+   counter_row_list_t kinds;    // Exits merged by kind
+   counter_row_list_t ops;      // Interpreted instructions by opcode
+   counter_row_list_t funcs;    // Most frequent opcode in each function
+   uint64_t           nexits;
+   uint64_t           nops;
+} jit_counter_summary_t;
+
 typedef struct _jit_func {
    jit_entry_fn_t  entry;    // Must be first
    func_state_t    state;
@@ -274,6 +320,7 @@ typedef struct _jit_func {
    vcode_unit_t    unit;
    ident_t         name;
    link_tab_t     *linktab;
+   jit_inline_t   *inlines;
    mptr_t          privdata;
    jit_ir_t       *irbuf;
    unsigned char  *cpool;
@@ -281,14 +328,20 @@ typedef struct _jit_func {
    unsigned        nirs;
    unsigned        nregs;
    unsigned        nvars;
+   unsigned        ninlines;
    unsigned        cpoolsz;
    bool            owns_cpool;
    jit_handle_t    handle;
    unsigned        hotness;
+   unsigned        calls;
+   unsigned        backedges;
+   bool            cached;
    jit_tier_t     *next_tier;
    jit_cfg_t      *cfg;
    ffi_spec_t      spec;
    object_t       *object;
+   interp_op_t    *predecode;
+   jit_counters_t *counters;
 } jit_func_t;
 
 // The code generator knows the layout of this struct
@@ -327,6 +380,9 @@ typedef struct {
 
 #define JIT_MAX_ARGS 64
 
+// Interpreted loop iterations equivalent to one call when tiering up
+#define JIT_LOOP_WEIGHT 64
+
 typedef struct _jit_interp jit_interp_t;
 
 void jit_irgen(jit_func_t *f);
@@ -344,8 +400,13 @@ void **jit_get_privdata_ptr(jit_t *j, jit_func_t *f);
 bool jit_has_runtime(jit_t *j);
 int jit_backedge_limit(jit_t *j);
 void jit_tier_up(jit_func_t *f);
+uint64_t *jit_get_op_counters(jit_func_t *f);
+void jit_count_exit(jit_func_t *f, uint32_t irpos, jit_exit_t which);
+void jit_summarise_counters(jit_t *j, jit_counter_summary_t *s);
+void jit_free_counter_summary(jit_counter_summary_t *s);
 jit_thread_local_t *jit_thread_local(void);
 void jit_fill_irbuf(jit_func_t *f);
+bool jit_irbuf_available(jit_func_t *f, int maxops);
 int32_t *jit_get_cover_ptr(jit_t *j, jit_value_t addr);
 
 jit_cfg_t *jit_get_cfg(jit_func_t *f);
@@ -359,7 +420,10 @@ bool jit_writes_flags(jit_ir_t *ir);
 void jit_do_lvn(jit_func_t *f);
 void jit_do_cprop(jit_func_t *f);
 void jit_do_dce(jit_func_t *f);
+int jit_do_vrp(jit_func_t *f);
+void jit_do_licm(jit_func_t *f);
 void jit_delete_nops(jit_func_t *f);
+void jit_do_inline(jit_func_t *f);
 
 code_cache_t *code_cache_new(void);
 void code_cache_free(code_cache_t *code);
@@ -374,6 +438,7 @@ void code_blob_mark(code_blob_t *blob, jit_label_t label);
 void code_blob_patch(code_blob_t *blob, jit_label_t label, code_patch_fn_t fn);
 
 bool jit_pack_fill(jit_pack_t *jp, jit_t *j, jit_func_t *f);
+uint64_t jit_pack_hash(jit_func_t *f);
 const uint8_t *jit_pack_get(jit_pack_t *jp, ident_t name, size_t *size);
 void jit_pack_put(jit_pack_t *jp, ident_t name, const uint8_t *cpool,
                   const uint8_t *buf);
@@ -1993,6 +1993,7 @@ static void jit_x86_cleanup(void *context)
 }
 
 static const jit_plugin_t jit_x86 = {
+   .name    = "x86",
    .init    = jit_x86_init,
    .cgen    = jit_x86_cgen,
    .cleanup = jit_x86_cleanup
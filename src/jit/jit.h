@@ -48,6 +48,7 @@ typedef struct {
 typedef vcode_unit_t (*jit_lower_fn_t)(ident_t, void *);
 
 typedef struct {
+   const char *name;
    void *(*init)(jit_t *);
    void (*cgen)(jit_t *, jit_handle_t, void *);
    void (*cleanup)(void *);
@@ -89,6 +90,11 @@ void jit_preload(jit_t *j);
 int jit_exit_status(jit_t *j);
 void jit_reset_exit_status(jit_t *j);
 void jit_add_tier(jit_t *j, int threshold, const jit_plugin_t *plugin);
+void jit_cgen_barrier(jit_t *j);
+void jit_load_profile(jit_t *j, const char *file);
+void jit_load_cache(jit_t *j, const char *path);
+void jit_sign_cache(const char *path);
+int jit_get_hot_funcs(jit_t *j, jit_handle_t **handles);
 ident_t jit_get_name(jit_t *j, jit_handle_t handle);
 void jit_register_native_plugin(jit_t *j);
 
@@ -96,7 +102,7 @@ void *jit_mspace_alloc(size_t size) RETURNS_NONNULL;
 jit_stack_trace_t *jit_stack_trace(void);
 
 void jit_alloc_cover_mem(jit_t *j, int n_stmts, int n_branches, int n_toggles,
-                         int n_expressions);
+                         int n_expressions, int32_t *mem);
 int32_t *jit_get_cover_mem(jit_t *j, jit_cover_mem_t kind);
 
 bool jit_try_call(jit_t *j, jit_handle_t handle, jit_scalar_t *result, ...);
@@ -46,17 +46,32 @@ typedef struct _lib_list    lib_list_t;
 typedef struct _lib_unit    lib_unit_t;
 
 #define INDEX_FILE_MAGIC 0x55225511
+#define UNIT_FILE_MAGIC  0x55225512
+
+// Each design unit file is split into sections which can be loaded
+// independently as they each have their own ident and location tables
+typedef enum {
+   SECTION_TREE  = (1 << 0),
+   SECTION_VCODE = (1 << 1),
+} section_mask_t;
+
+typedef struct {
+   uint8_t  tag;
+   uint32_t offset;
+   uint32_t size;
+} unit_section_t;
 
 struct _lib_unit {
-   object_t     *object;
-   ident_t       name;
-   tree_kind_t   kind;
-   bool          dirty;
-   bool          error;
-   lib_mtime_t   mtime;
-   vcode_unit_t  vcode;
-   jit_pack_t   *jitpack;
-   lib_unit_t   *next;
+   object_t      *object;
+   ident_t        name;
+   tree_kind_t    kind;
+   bool           dirty;
+   bool           error;
+   lib_mtime_t    mtime;
+   vcode_unit_t   vcode;
+   jit_pack_t    *jitpack;
+   section_mask_t pending;
+   lib_unit_t    *next;
 };
 
 struct _lib_index {
@@ -91,6 +106,7 @@ struct _search_path {
 static lib_t          work = NULL;
 static lib_list_t    *loaded = NULL;
 static search_path_t *search_paths = NULL;
+static unsigned       pending_vcode = 0;
 
 static text_buf_t *lib_file_path(lib_t lib, const char *name);
 static lib_mtime_t lib_stat_mtime(struct stat *st);
@@ -298,15 +314,20 @@ static lib_unit_t *lib_put_aux(lib_t lib, object_t *object, bool dirty,
          vcode_unit_unref(where->vcode);
          where->vcode = NULL;
       }
+
+      // Any sections not yet read from disk are now stale
+      if (where->pending & SECTION_VCODE)
+         pending_vcode--;
    }
 
-   where->object = object;
-   where->name   = name;
-   where->dirty  = dirty;
-   where->error  = error;
-   where->mtime  = mtime;
-   where->kind   = kind;
-   where->vcode  = vu;
+   where->object  = object;
+   where->name    = name;
+   where->dirty   = dirty;
+   where->error   = error;
+   where->mtime   = mtime;
+   where->kind    = kind;
+   where->vcode   = vu;
+   where->pending = 0;
 
    if (fresh) {
       lib_unit_t **it;
@@ -655,6 +676,8 @@ void lib_free(lib_t lib)
 
    for (lib_unit_t *lu = lib->units, *tmp; lu; lu = tmp) {
       tmp = lu->next;
+      if (lu->pending & SECTION_VCODE)
+         pending_vcode--;
       free(lu);
    }
    hash_free(lib->lookup);
@@ -774,7 +797,7 @@ void lib_put_vcode(lib_t lib, tree_t unit, vcode_unit_t vu)
 {
    lib_unit_t *where = lib_find_unit(lib, unit);
 
-   if (where->vcode != NULL)
+   if (where->vcode != NULL || (where->pending & SECTION_VCODE))
       fatal_trace("vcode already stored for %s", istr(tree_ident(unit)));
 
    where->vcode = vu;
@@ -785,6 +808,9 @@ vcode_unit_t lib_get_vcode(lib_t lib, tree_t unit)
 {
    lib_unit_t *where = lib_find_unit(lib, unit);
 
+   if (where->pending & SECTION_VCODE)
+      lib_load_vcode(where->name, false);
+
    if (where->vcode == NULL)
       fatal_trace("vcode not stored for %s", istr(tree_ident(unit)));
 
@@ -802,50 +828,209 @@ static lib_mtime_t lib_stat_mtime(struct stat *st)
    return mt;
 }
 
-static lib_unit_t *lib_read_unit(lib_t lib, const char *fname)
+static section_mask_t lib_section_mask(uint8_t tag)
+{
+   switch (tag) {
+   case 'T': return SECTION_TREE;
+   case 'V': return SECTION_VCODE;
+   default: return 0;
+   }
+}
+
+static int lib_read_section_table(fbuf_t *f, unit_section_t *table, int max)
+{
+   if (read_u32(f) != UNIT_FILE_MAGIC) {
+      diag_t *d = diag_new(DIAG_FATAL, NULL);
+      diag_printf(d, "%s was created with an incompatible version of "
+                  PACKAGE, fbuf_file_name(f));
+      diag_hint(d, NULL, "the design unit should be reanalysed");
+      diag_emit(d);
+      fatal_exit(EXIT_FAILURE);
+   }
+
+   // The offset of the section table is stored in the last four bytes
+   fbuf_seek(f, -4, SEEK_END);
+   fbuf_seek(f, read_u32(f), SEEK_SET);
+
+   int count = 0;
+   uint8_t tag;
+   while ((tag = read_u8(f))) {
+      if (count == max)
+         fatal_trace("too many sections in %s", fbuf_file_name(f));
+
+      table[count].tag    = tag;
+      table[count].offset = read_u32(f);
+      table[count].size   = read_u32(f);
+      count++;
+   }
+
+   return count;
+}
+
+static lib_unit_t *lib_read_unit(lib_t lib, ident_t name, section_mask_t want)
 {
+   lib_unit_t *lu = hash_get(lib->lookup, name);
+   if (lu != NULL && (want &= lu->pending) == 0)
+      return lu;
+
+   const char *fname = istr(name);
    fbuf_t *f = lib_fbuf_open(lib, fname, FBUF_IN, FBUF_CS_ADLER32);
+   if (f == NULL)
+      fatal("library %s corrupt: unit %s present in index but missing "
+            "on disk", istr(lib->name), fname);
 
-   ident_rd_ctx_t ident_ctx = ident_read_begin(f);
-   loc_rd_ctx_t *loc_ctx = loc_read_begin(f);
+   unit_section_t table[4];
+   const int nsections = lib_read_section_table(f, table, ARRAY_LEN(table));
+
+   LOCAL_TEXT_BUF path = lib_file_path(lib, fname);
+
+   struct stat st;
+   if (stat(tb_get(path), &st) < 0)
+      fatal_errno("%s", fname);
+
+   const lib_mtime_t mt = lib_stat_mtime(&st);
+
+   if (lu == NULL) {
+      lu = xcalloc(sizeof(lib_unit_t));
+      lu->name  = name;
+      lu->kind  = T_LAST_TREE_KIND;
+      lu->mtime = mt;
+
+      lib_index_t *idx = lib_find_in_index(lib, name);
+      if (idx != NULL)
+         lu->kind = idx->kind;
+
+      for (int i = 0; i < nsections; i++)
+         lu->pending |= lib_section_mask(table[i].tag);
+
+      if (lu->pending & SECTION_VCODE)
+         pending_vcode++;
+
+      lib_unit_t **it;
+      for (it = &(lib->units); *it; it = &(*it)->next)
+         assert((*it)->name != name);
+      *it = lu;
+
+      hash_put(lib->lookup, name, lu);
+   }
+   else if (lu->mtime != mt)
+      fatal("design unit %s was modified by another process while it was "
+            "in use", fname);
+
+   // Clear the pending flags first as reading vcode may recursively
+   // look up other units
+   lu->pending &= ~want;
 
-   vcode_unit_t vu = NULL;
    object_t *obj = NULL;
+   size_t nread = 0;
+   for (int i = 0; i < nsections; i++) {
+      const section_mask_t mask = lib_section_mask(table[i].tag);
+      if (!(want & mask))
+         continue;
 
-   char tag;
-   while ((tag = read_u8(f))) {
-      switch (tag) {
-      case 'T':
+      fbuf_seek(f, table[i].offset, SEEK_SET);
+
+      ident_rd_ctx_t ident_ctx = ident_read_begin(f);
+      loc_rd_ctx_t *loc_ctx = loc_read_begin(f);
+
+      switch (mask) {
+      case SECTION_TREE:
          obj = object_read(f, (object_load_fn_t)lib_get_qualified,
                            ident_ctx, loc_ctx);
          break;
-      case 'V':
-         vu = vcode_read(f, ident_ctx, loc_ctx);
+      case SECTION_VCODE:
+         lu->vcode = vcode_read(f, ident_ctx, loc_ctx);
+         pending_vcode--;
          break;
       default:
-         fatal_trace("unhandled tag %c in %s", tag, fname);
+         fatal_trace("unhandled tag %c in %s", table[i].tag, fname);
       }
-   }
 
-   loc_read_end(loc_ctx);
-   ident_read_end(ident_ctx);
+      loc_read_end(loc_ctx);
+      ident_read_end(ident_ctx);
+
+      nread += table[i].size;
+   }
 
    uint32_t checksum;
    fbuf_close(f, &checksum);
 
-   if (obj == NULL)
-      fatal_trace("%s did not HDL design unit", fname);
+   if (want & SECTION_TREE) {
+      if (obj == NULL)
+         fatal_trace("%s did not contain HDL design unit", fname);
 
-   arena_set_checksum(object_arena(obj), checksum);
+      tree_t tree = tree_from_object(obj);
+      if (tree == NULL)
+         fatal_trace("unexpected object class in %s", fname);
 
-   LOCAL_TEXT_BUF path = lib_file_path(lib, fname);
+      arena_set_checksum(object_arena(obj), checksum);
 
-   struct stat st;
-   if (stat(tb_get(path), &st) < 0)
-      fatal_errno("%s", fname);
+      lu->object = obj;
+      lu->kind   = tree_kind(tree);
+
+      lib_add_to_index(lib, name, lu->kind);
+      hash_put(lib->lookup, obj, lu);
+   }
+
+   if (opt_get_verbose(OPT_LIB_VERBOSE, fname)) {
+      size_t nskipped = 0;
+      for (int i = 0; i < nsections; i++) {
+         if (lu->pending & lib_section_mask(table[i].tag))
+            nskipped += table[i].size;
+      }
+
+      debugf("loaded%s%s from %s: read %zu bytes, skipped %zu bytes",
+             (want & SECTION_TREE) ? " tree" : "",
+             (want & SECTION_VCODE) ? " vcode" : "",
+             fname, nread, nskipped);
+   }
+
+   return lu;
+}
+
+bool lib_load_vcode(ident_t name, bool force)
+{
+   // Read the vcode section of the design unit which would contain the
+   // vcode unit NAME: packages keep their vcode with the body and
+   // elaborated designs in the ".elab" unit.  Unless FORCE is set only
+   // units whose tree has already been loaded are considered.
+
+   if (pending_vcode == 0 && !force)
+      return false;
+
+   ident_t it = name;
+   ident_t lname = ident_walk_selected(&it);
+   ident_t uname = ident_walk_selected(&it);
+   if (uname == NULL)
+      return false;
+
+   lib_t lib = force ? lib_find(lname) : lib_loaded(lname);
+   if (lib == NULL || lib->path == NULL)
+      return false;
+
+   ident_t unit_name = ident_prefix(lib->name, uname, '.');
+   ident_t candidates[] = {
+      unit_name,
+      ident_prefix(unit_name, well_known(W_BODY), '-'),
+      ident_prefix(unit_name, well_known(W_ELAB), '.'),
+   };
+
+   bool loaded = false;
+   for (int i = 0; i < ARRAY_LEN(candidates); i++) {
+      lib_unit_t *lu = hash_get(lib->lookup, candidates[i]);
+      if (lu != NULL && !(lu->pending & SECTION_VCODE))
+         continue;
+      else if (lu == NULL && (!force || !lib_find_in_index(lib, candidates[i])))
+         continue;
 
-   lib_mtime_t mt = lib_stat_mtime(&st);
-   return lib_put_aux(lib, obj, false, false, mt, vu);
+      file_read_lock(lib->lock_fd);
+      lu = lib_read_unit(lib, candidates[i], SECTION_VCODE);
+      file_unlock(lib->lock_fd);
+
+      loaded |= (lu->vcode != NULL);
+   }
+
+   return loaded;
 }
 
 static lib_unit_t *lib_get_aux(lib_t lib, ident_t ident)
@@ -860,7 +1045,7 @@ static lib_unit_t *lib_get_aux(lib_t lib, ident_t ident)
       ident = ident_prefix(lib->name, uname, '.');
 
    lib_unit_t *lu = hash_get(lib->lookup, ident);
-   if (lu != NULL)
+   if (lu != NULL && !(lu->pending & SECTION_TREE))
       return lu;
 
    if (lib->path == NULL)   // Temporary library
@@ -869,21 +1054,38 @@ static lib_unit_t *lib_get_aux(lib_t lib, ident_t ident)
    assert(lib->lock_fd != -1);   // Should not be called in unit tests
    file_read_lock(lib->lock_fd);
 
-   // Otherwise search in the filesystem
-   DIR *d = opendir(lib->path);
-   if (d == NULL)
-      fatal("%s: %s", lib->path, strerror(errno));
+   if (lu != NULL) {
+      // Only the vcode was loaded previously
+      lu = lib_read_unit(lib, ident, SECTION_TREE);
+   }
+   else {
+      // Otherwise search in the filesystem
+      const char *search = istr(ident);
+      LOCAL_TEXT_BUF path = lib_file_path(lib, search);
 
-   const char *search = istr(ident);
-   struct dirent *e;
-   while ((e = readdir(d))) {
-      if (strcmp(e->d_name, search) == 0) {
-         lu = lib_read_unit(lib, e->d_name);
-         break;
+      // The name resolver probes libraries for every identifier it
+      // cannot find elsewhere so avoid scanning the directory when the
+      // file clearly does not exist
+      struct stat st;
+      if (stat(tb_get(path), &st) == 0) {
+         // The file system may be case insensitive so check the name
+         // matches exactly
+         DIR *d = opendir(lib->path);
+         if (d == NULL)
+            fatal("%s: %s", lib->path, strerror(errno));
+
+         struct dirent *e;
+         while ((e = readdir(d))) {
+            if (strcmp(e->d_name, search) == 0) {
+               lu = lib_read_unit(lib, ident, SECTION_TREE);
+               break;
+            }
+         }
+
+         closedir(d);
       }
    }
 
-   closedir(d);
    file_unlock(lib->lock_fd);
 
    if (lu == NULL && lib_find_in_index(lib, ident) != NULL)
@@ -999,24 +1201,49 @@ static void lib_save_unit(lib_t lib, lib_unit_t *unit)
       fatal("failed to create %s in library %s", istr(unit->name),
             istr(lib->name));
 
-   write_u8('T', f);
+   assert(unit->pending == 0);
 
-   ident_wr_ctx_t ident_ctx = ident_write_begin(f);
-   loc_wr_ctx_t *loc_ctx = loc_write_begin(f);
+   write_u32(UNIT_FILE_MAGIC, f);
 
-   object_arena_t *arena = object_arena(unit->object);
+   unit_section_t table[2];
+   int nsections = 0;
 
-   object_write(unit->object, f, ident_ctx, loc_ctx);
+   for (int i = 0; i < ARRAY_LEN(table); i++) {
+      const uint8_t tag = "TV"[i];
+      if (tag == 'V' && unit->vcode == NULL)
+         continue;
 
-   if (unit->vcode != NULL) {
-      write_u8('V', f);
-      vcode_write(unit->vcode, f, ident_ctx, loc_ctx);
+      const size_t start = fbuf_tell(f);
+
+      ident_wr_ctx_t ident_ctx = ident_write_begin(f);
+      loc_wr_ctx_t *loc_ctx = loc_write_begin(f);
+
+      if (tag == 'T')
+         object_write(unit->object, f, ident_ctx, loc_ctx);
+      else
+         vcode_write(unit->vcode, f, ident_ctx, loc_ctx);
+
+      loc_write_end(loc_ctx);
+      ident_write_end(ident_ctx);
+
+      table[nsections].tag    = tag;
+      table[nsections].offset = start;
+      table[nsections].size   = fbuf_tell(f) - start;
+      nsections++;
+   }
+
+   const size_t table_offset = fbuf_tell(f);
+
+   for (int i = 0; i < nsections; i++) {
+      write_u8(table[i].tag, f);
+      write_u32(table[i].offset, f);
+      write_u32(table[i].size, f);
    }
 
    write_u8('\0', f);
+   write_u32(table_offset, f);
 
-   loc_write_end(loc_ctx);
-   ident_write_end(ident_ctx);
+   object_arena_t *arena = object_arena(unit->object);
 
    uint32_t checksum;
    fbuf_close(f, &checksum);
@@ -71,6 +71,7 @@ void lib_walk_index(lib_t lib, lib_index_fn_t fn, void *context);
 
 void lib_put_vcode(lib_t lib, tree_t unit, vcode_unit_t vu);
 vcode_unit_t lib_get_vcode(lib_t lib, tree_t unit);
+bool lib_load_vcode(ident_t name, bool force);
 
 void lib_put_jit(lib_t lib, tree_t unit, jit_pack_t *jp);
 
@@ -26,6 +26,7 @@
 #include "phase.h"
 #include "rt/cover.h"
 #include "rt/rt.h"
+#include "thread.h"
 #include "type.h"
 #include "vcode.h"
 
@@ -109,9 +110,21 @@ typedef void (*lower_field_fn_t)(tree_t, vcode_reg_t, vcode_reg_t, void *);
 
 typedef A(concat_param_t) concat_list_t;
 
-static lower_mode_t     mode = LOWER_NORMAL;
-static lower_scope_t   *top_scope = NULL;
-static cover_tagging_t *cover_tags = NULL;
+typedef struct {
+   tree_t         proc;
+   vcode_unit_t   unit;
+   lower_scope_t *scope;
+} process_job_t;
+
+typedef A(lower_scope_t *) scope_list_t;
+
+static __thread lower_mode_t     mode = LOWER_NORMAL;
+static __thread lower_scope_t   *top_scope = NULL;
+static __thread cover_tagging_t *cover_tags = NULL;
+static hash_t                   *process_templates = NULL;
+static workq_t                  *process_wq = NULL;
+static scope_list_t              process_scopes = AINIT;
+static nvc_lock_t                lib_lock = 0;
 
 static vcode_reg_t lower_expr(tree_t expr, expr_ctx_t ctx);
 static vcode_type_t lower_bounds(type_t type);
@@ -2401,6 +2414,20 @@ static vcode_cc_t lower_cc_for_call(tree_t call)
       return VCODE_CC_VHDL;
 }
 
+static vcode_unit_t lower_find_unit(ident_t name)
+{
+   // Process bodies may be lowered on worker threads and loading vcode
+   // from a library is not thread safe
+   SCOPED_LOCK(lib_lock);
+   return vcode_find_unit(name);
+}
+
+static tree_t lower_get_qualified(ident_t name)
+{
+   SCOPED_LOCK(lib_lock);
+   return lib_get_qualified(name);
+}
+
 static vcode_reg_t lower_context_for_call(ident_t unit_name)
 {
    vcode_unit_t caller = vcode_active_unit();
@@ -2408,11 +2435,11 @@ static vcode_reg_t lower_context_for_call(ident_t unit_name)
    vcode_state_t state;
    vcode_state_save(&state);
 
-   vcode_unit_t vu = vcode_find_unit(unit_name);
+   vcode_unit_t vu = lower_find_unit(unit_name);
 
    if (vu == NULL && vcode_unit_kind() == VCODE_UNIT_THUNK) {
       ident_t thunk_name = ident_prefix(unit_name, well_known(W_THUNK), '$');
-      vu = vcode_find_unit(thunk_name);
+      vu = lower_find_unit(thunk_name);
    }
 
    if (vu != NULL) {
@@ -2479,7 +2506,7 @@ static vcode_reg_t lower_context_for_call(ident_t unit_name)
    vcode_state_restore(&state);
 
    ident_t scope_name = ident_runtil(ident_until(unit_name, '('), '.');
-   tree_t pack = lib_get_qualified(scope_name);
+   tree_t pack = lower_get_qualified(scope_name);
    if (pack != NULL && is_package(pack)) {
       assert(!is_uninstantiated_package(pack));
       if (vcode_unit_kind() == VCODE_UNIT_THUNK)
@@ -2592,13 +2619,18 @@ static void lower_push_scope(tree_t container)
    top_scope = new;
 }
 
+static void lower_free_scope(lower_scope_t *scope)
+{
+   hash_free(scope->objects);
+   ACLEAR(scope->free_temps);
+   free(scope);
+}
+
 static void lower_pop_scope(void)
 {
    lower_scope_t *tmp = top_scope;
    top_scope = tmp->down;
-   hash_free(tmp->objects);
-   ACLEAR(tmp->free_temps);
-   free(tmp);
+   lower_free_scope(tmp);
 }
 
 static int lower_search_vcode_obj(void *key, lower_scope_t *scope, int *hops)
@@ -7569,7 +7601,7 @@ static void lower_image_helper(tree_t decl)
 
    ident_t func = ident_prefix(type_ident(type), ident_new("image"), '$');
 
-   vcode_unit_t vu = vcode_find_unit(func);
+   vcode_unit_t vu = lower_find_unit(func);
    if (vu != NULL)
       return;
 
@@ -7910,7 +7942,7 @@ static void lower_value_helper(tree_t decl)
 
    ident_t func = ident_prefix(type_ident(type), ident_new("value"), '$');
 
-   vcode_unit_t vu = vcode_find_unit(func);
+   vcode_unit_t vu = lower_find_unit(func);
    if (vu != NULL)
       return;
 
@@ -7963,7 +7995,7 @@ static void lower_resolved_helper(tree_t decl)
 
    ident_t func = ident_prefix(type_ident(type), ident_new("resolved"), '$');
 
-   vcode_unit_t vu = vcode_find_unit(func);
+   vcode_unit_t vu = lower_find_unit(func);
    if (vu != NULL)
       return;
 
@@ -9231,7 +9263,7 @@ static void lower_predef(tree_t decl, vcode_unit_t context)
       return;
 
    ident_t name = tree_ident2(decl);
-   if (vcode_find_unit(name) != NULL)
+   if (lower_find_unit(name) != NULL)
       return;
 
    type_t type = tree_type(decl);
@@ -9336,7 +9368,7 @@ static void lower_proc_body(tree_t body, vcode_unit_t context)
    vcode_select_unit(context);
 
    ident_t name = tree_ident2(body);
-   vcode_unit_t vu = vcode_find_unit(name);
+   vcode_unit_t vu = lower_find_unit(name);
    if (vu != NULL)
       return;
 
@@ -9385,7 +9417,7 @@ static void lower_func_body(tree_t body, vcode_unit_t context)
    vcode_select_unit(context);
 
    ident_t name = tree_ident2(body);
-   vcode_unit_t vu = vcode_find_unit(name);
+   vcode_unit_t vu = lower_find_unit(name);
    if (vu != NULL)
       return;
 
@@ -9502,14 +9534,39 @@ static void lower_driver_cb(tree_t t, void *__ctx)
    }
 }
 
-static void lower_process(tree_t proc, vcode_unit_t context)
+static void lower_path_attr_cb(tree_t t, void *ctx)
 {
-   vcode_select_unit(context);
-   ident_t label = tree_ident(proc);
-   ident_t name = ident_prefix(vcode_unit_name(), label, '.');
-   vcode_unit_t vu = emit_process(name, tree_to_object(proc), context);
-   emit_debug_info(tree_loc(proc));
+   const attr_kind_t which = tree_subkind(t);
+   if (which == ATTR_PATH_NAME || which == ATTR_INSTANCE_NAME)
+      *(bool *)ctx = true;
+}
+
+static bool lower_shared_process(tree_t proc, vcode_unit_t context)
+{
+   // The same process tree appears in every copy of a replicated
+   // instance or generate body and the code generated for the first
+   // copy can be reused if the enclosing frames have the same layout
+
+   if (process_templates == NULL || cover_tags != NULL)
+      return false;
+
+   vcode_unit_t template = hash_get(process_templates, proc);
+   if (template == NULL || template == (void *)-1)
+      return false;
+
+   bool uses_path = false;
+   tree_visit_only(proc, lower_path_attr_cb, &uses_path, T_ATTR_REF);
+   if (uses_path) {
+      hash_put(process_templates, proc, (void *)-1);
+      return false;
+   }
+
+   vcode_select_unit(template);
+   return vcode_unit_same_layout(vcode_unit_context(), context);
+}
 
+static void lower_process_body(tree_t proc, vcode_unit_t vu)
+{
    // The code generator assumes the first state starts at block number
    // one. Allocate it here in case lowering the declarations generates
    // additional basic blocks.
@@ -9551,6 +9608,54 @@ static void lower_process(tree_t proc, vcode_unit_t context)
    cover_pop_scope(cover_tags);
 }
 
+static void lower_process_async(void *context, void *arg)
+{
+   process_job_t *job = arg;
+
+   mode = LOWER_NORMAL;
+   top_scope = job->scope;
+
+   vcode_select_unit(job->unit);
+   vcode_select_block(0);
+
+   lower_process_body(job->proc, job->unit);
+
+   assert(top_scope == job->scope);
+   top_scope = NULL;
+
+   vcode_close();
+   free(job);
+}
+
+static void lower_process(tree_t proc, vcode_unit_t context)
+{
+   if (lower_shared_process(proc, context))
+      return;
+
+   vcode_select_unit(context);
+   ident_t label = tree_ident(proc);
+   ident_t name = ident_prefix(vcode_unit_name(), label, '.');
+   vcode_unit_t vu = emit_process(name, tree_to_object(proc), context);
+   emit_debug_info(tree_loc(proc));
+
+   if (process_templates != NULL && hash_get(process_templates, proc) == NULL)
+      hash_put(process_templates, proc, vu);
+
+   if (process_wq != NULL) {
+      // The unit has already been added to the registry and the list of
+      // children of the enclosing instance so the body can be lowered
+      // later on a worker thread without affecting the output
+      process_job_t *job = xcalloc(sizeof(process_job_t));
+      job->proc  = proc;
+      job->unit  = vu;
+      job->scope = top_scope;
+
+      workq_do(process_wq, lower_process_async, job);
+   }
+   else
+      lower_process_body(proc, vu);
+}
+
 static bool lower_is_signal_ref(tree_t expr)
 {
    switch (tree_kind(expr)) {
@@ -9608,7 +9713,7 @@ static ident_t lower_converter(tree_t expr, type_t atype, type_t rtype,
    }
    ident_t name = ident_new(tb_get(tb));
 
-   vcode_unit_t vu = vcode_find_unit(name);
+   vcode_unit_t vu = lower_find_unit(name);
    if (vu != NULL)
       return name;
 
@@ -10409,7 +10514,13 @@ static vcode_unit_t lower_concurrent_block(tree_t block, vcode_unit_t context)
       }
    }
 
-   lower_pop_scope();
+   if (process_wq != NULL) {
+      // Processes in this block may still reference the scope
+      APUSH(process_scopes, top_scope);
+      top_scope = top_scope->down;
+   }
+   else
+      lower_pop_scope();
 
    if (cover_enabled(cover_tags, COVER_MASK_ALL)) {
       cover_add_tag(block, NULL, cover_tags, TAG_HIER, COV_FLAG_HIER_UP);
@@ -10426,7 +10537,41 @@ static vcode_unit_t lower_elab(tree_t unit)
 
    tree_t top = tree_stmt(unit, 0);
    assert(tree_kind(top) == T_BLOCK);
-   return lower_concurrent_block(top, NULL);
+
+   process_templates = hash_new(256);
+
+   if (cover_tags == NULL) {
+      // Process bodies are independent of each other once the unit for
+      // each process has been created so can be lowered in parallel
+      process_wq = workq_new(NULL);
+
+      if (opt_get_verbose(OPT_DUMP_VCODE, NULL))
+         workq_not_thread_safe(process_wq);
+
+      // Make sure the cached standard types are loaded before starting
+      // any worker threads
+      (void)std_type(NULL, STD_BIT);
+      (void)std_type(NULL, STD_BOOLEAN);
+      (void)std_type(NULL, STD_STRING);
+   }
+
+   vcode_unit_t root = lower_concurrent_block(top, NULL);
+
+   if (process_wq != NULL) {
+      workq_start(process_wq);
+      workq_drain(process_wq);
+      workq_free(process_wq);
+      process_wq = NULL;
+
+      for (int i = 0; i < process_scopes.count; i++)
+         lower_free_scope(process_scopes.items[i]);
+      ACLEAR(process_scopes);
+   }
+
+   hash_free(process_templates);
+   process_templates = NULL;
+
+   return root;
 }
 
 static vcode_unit_t lower_pack_body(tree_t unit)
@@ -10508,7 +10653,7 @@ static void lower_subprogram_for_thunk(tree_t body, vcode_unit_t context)
 
    ident_t name = ident_prefix(tree_ident2(body), well_known(W_THUNK), '$');
 
-   vcode_unit_t vu = vcode_find_unit(name);
+   vcode_unit_t vu = lower_find_unit(name);
    if (vu != NULL)
       return;
 
@@ -10632,7 +10777,7 @@ vcode_unit_t lower_thunk(tree_t t)
    if (is_subprogram(t)) {
       lower_subprogram_for_thunk(t, NULL);
       ident_t thunk_i = well_known(W_THUNK);
-      return vcode_find_unit(ident_prefix(tree_ident2(t), thunk_i, '$'));
+      return lower_find_unit(ident_prefix(tree_ident2(t), thunk_i, '$'));
    }
    else if (tree_kind(t) == T_CASE_GENERATE)
       return lower_case_generate_thunk(t);
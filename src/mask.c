@@ -59,6 +59,39 @@ static inline uint64_t mask_for_range(int low, int high)
    return mask;
 }
 
+void mask_resize(bit_mask_t *m, size_t size)
+{
+   // Bits beyond the old size are clear after resizing
+   assert(size >= m->size);
+
+   if (m->size % 64 != 0) {
+      // Clear any stale bits above the old size in the last word
+      uint64_t *last = m->size > 64 ? &(m->ptr[m->size / 64]) : &(m->bits);
+      *last &= mask_for_range(0, (m->size % 64) - 1);
+   }
+
+   if (size <= 64) {
+      m->size = size;
+      return;
+   }
+
+   const int oldwords = m->size > 64 ? (m->size + 63) / 64 : 0;
+   const int newwords = (size + 63) / 64;
+
+   if (m->size <= 64) {
+      const uint64_t bits = m->bits;
+      m->ptr = xcalloc_array(newwords, sizeof(uint64_t));
+      m->ptr[0] = bits;
+   }
+   else if (newwords > oldwords) {
+      m->ptr = xrealloc_array(m->ptr, newwords, sizeof(uint64_t));
+      memset(m->ptr + oldwords, '\0',
+             (newwords - oldwords) * sizeof(uint64_t));
+   }
+
+   m->size = size;
+}
+
 void mask_clear_range(bit_mask_t *m, int start, int count)
 {
    if (m->size <= 64) {
@@ -206,6 +239,42 @@ int mask_count_clear(bit_mask_t *m, int bit)
    return count + m->size - bit;
 }
 
+int mask_count_set(bit_mask_t *m, int bit)
+{
+   assert(bit < m->size);
+
+   const int limit = m->size - bit;
+
+   if (m->size <= 64) {
+      const int fs = __builtin_ffsll(~m->bits & mask_for_range(bit, 63));
+      return MIN(fs > 0 ? fs - 1 - bit : 64 - bit, limit);
+   }
+
+   int count = 0;
+
+   const int modbits = bit % 64;
+   if (modbits > 0) {
+      const uint64_t word0 = ~m->ptr[bit / 64] & mask_for_range(modbits, 63);
+
+      const int fs = __builtin_ffsll(word0);
+      if (fs > 0)
+         return MIN(fs - 1 - modbits, limit);
+
+      count = 64 - modbits;
+      bit += count;
+   }
+
+   const int nwords = (m->size + 63) / 64;
+   for (; bit / 64 < nwords && m->ptr[bit / 64] == ~UINT64_C(0);
+        bit += 64, count += 64)
+      ;
+
+   if (bit / 64 < nwords)
+      count += __builtin_ffsll(~m->ptr[bit / 64]) - 1;
+
+   return MIN(count, limit);
+}
+
 void mask_subtract(bit_mask_t *m, const bit_mask_t *m2)
 {
    assert(m->size == m2->size);
@@ -58,6 +58,7 @@ typedef struct {
 
 void mask_init(bit_mask_t *m, size_t size);
 void mask_free(bit_mask_t *m);
+void mask_resize(bit_mask_t *m, size_t size);
 void mask_clear_range(bit_mask_t *m, int start, int count);
 void mask_set_range(bit_mask_t *m, int start, int count);
 int mask_popcount(bit_mask_t *m);
@@ -65,6 +66,7 @@ void mask_setall(bit_mask_t *m);
 void mask_clearall(bit_mask_t *m);
 int mask_scan_backwards(bit_mask_t *m, int bit);
 int mask_count_clear(bit_mask_t *m, int bit);
+int mask_count_set(bit_mask_t *m, int bit);
 void mask_subtract(bit_mask_t *m, const bit_mask_t *m2);
 void mask_union(bit_mask_t *m, const bit_mask_t *m2);
 void mask_copy(bit_mask_t *m, const bit_mask_t *m2);
@@ -130,6 +130,7 @@ struct scope {
    tree_t         container;
    bool           suppress;
    lazy_sym_t    *lazy;
+   hash_t        *misses;
    tree_list_t    imported;
    scope_t       *chain;
    label_cnts_t   lbl_cnts;
@@ -395,6 +396,9 @@ static void free_scope(scope_t *s)
       free(it);
    }
 
+   if (s->misses != NULL)
+      hash_free(s->misses);
+
    hash_free(s->gmap);
    ACLEAR(s->imported);
 
@@ -539,18 +543,34 @@ formal_kind_t scope_formal_kind(nametab_t *tab)
    return tab->top_scope->formal_kind;
 }
 
+static symbol_t *lazy_symbol_for(scope_t *s, ident_t name)
+{
+   // Searching a library for a unit that does not exist is expensive
+   // so remember names that no lazy callback in this scope provides
+   if (s->misses != NULL && hash_get(s->misses, name) != NULL)
+      return NULL;
+
+   for (lazy_sym_t *it = s->lazy; it; it = it->next) {
+      symbol_t *sym = (*it->fn)(s, name, it->ctx);
+      if (sym != NULL)
+         return sym;
+   }
+
+   if (s->misses == NULL)
+      s->misses = hash_new(128);
+
+   hash_put(s->misses, name, s);
+   return NULL;
+}
+
 static const symbol_t *symbol_for(scope_t *s, ident_t name)
 {
    do {
       symbol_t *sym = hash_get(s->lookup, name);
       if (sym != NULL)
          return sym;
-      else {
-         for (lazy_sym_t *it = s->lazy; it; it = it->next) {
-            if ((sym = (*it->fn)(s, name, it->ctx)))
-               return sym;
-         }
-      }
+      else if (s->lazy != NULL && (sym = lazy_symbol_for(s, name)))
+         return sym;
    } while (s->formal_kind != F_RECORD && (s = s->parent));
 
    return NULL;
@@ -730,6 +750,9 @@ static symbol_t *make_visible(scope_t *s, ident_t name, tree_t decl,
    const name_mask_t mask = name_mask_for(decl);
    type_t type = get_type_or_null(decl);
 
+   if (s->misses != NULL)
+      hash_delete(s->misses, name);
+
    assert(origin == s || kind != DIRECT);
 
    if (tkind == T_ATTR_SPEC)
@@ -920,6 +943,12 @@ static void make_library_visible(scope_t *s, lib_t lib)
    l->ctx  = lib;
 
    s->lazy = l;
+
+   if (s->misses != NULL) {
+      // Names cached as missing may now be found in this library
+      hash_free(s->misses);
+      s->misses = NULL;
+   }
 }
 
 static void make_visible_slow(scope_t *s, ident_t name, tree_t decl)
@@ -380,6 +380,7 @@ static int elaborate(int argc, char **argv)
       fbuf_t *covdb =  cover_open_lib_file(top, FBUF_OUT, true);
       cover_dump_tags(cover, covdb, COV_DUMP_ELAB, NULL, NULL, NULL, NULL);
       fbuf_close(covdb, NULL);
+      cover_remove_live(top);
       progress("dumping coverage data");
    }
 
@@ -619,6 +620,21 @@ static int run(int argc, char **argv)
    jit_register_native_plugin(jit);
 #endif
 
+   const char *jit_profile = opt_get_str(OPT_JIT_PROFILE);
+   if (jit_profile != NULL && *jit_profile != '\0')
+      jit_load_profile(jit, jit_profile);
+
+   char *jit_cache LOCAL = NULL;
+#ifdef LLVM_HAS_LLJIT
+   const char *cache_dir = opt_get_str(OPT_JIT_CACHE);
+   if (cache_dir != NULL && *cache_dir != '\0') {
+      make_dir(cache_dir);
+      jit_cache = xasprintf("%s" DIR_SEP "_%s." DLL_EXT, cache_dir,
+                            istr(tree_ident(top)));
+      jit_load_cache(jit, jit_cache);
+   }
+#endif
+
    _std_standard_init();
    _std_env_init();
    _nvc_sim_pkg_init();
@@ -639,6 +655,11 @@ static int run(int argc, char **argv)
 
    set_ctrl_c_handler(NULL, NULL);
 
+#ifdef LLVM_HAS_LLJIT
+   if (jit_cache != NULL)
+      cgen_jit_cache(jit, jit_cache);
+#endif
+
    const int rc = jit_exit_status(jit);
 
    if (dumper != NULL)
@@ -1130,24 +1151,23 @@ static int coverage(int argc, char **argv)
    if (optind == argc)
       fatal("No input coverage database FILE specified");
 
-   cover_tagging_t *cover = NULL;
+   // Rest of inputs are coverage input files which are loaded and
+   // merged in parallel
+   const int ninputs = argc - optind;
 
-   // Rest of inputs are coverage input files
-   for (int i = optind; i < argc; i++) {
-      fbuf_t *f = fbuf_open(argv[i], FBUF_IN, FBUF_CS_NONE);
+   if (ninputs == 1 && rpt_file && !out_db && !exclude_file) {
+      // A single database can be reported on while it is read rather
+      // than loading all of its tags into memory first
+      progress("Generating code coverage report.");
+      cover_report_file(rpt_file, argv[optind], rpt_mask, item_limit);
+      return 0;
+   }
 
-      if (f != NULL) {
-         progress("Loading input coverage database: %s", argv[i]);
-         if (i == optind)
-            cover = cover_read_tags(f, rpt_mask);
-         else
-            cover_merge_tags(f, cover);
-      }
-      else
-         fatal("Could not open coverage database: %s", argv[i]);
+   cover_tagging_t *cover =
+      cover_merge_files((const char **)argv + optind, ninputs, rpt_mask);
 
-      fbuf_close(f, NULL);
-   }
+   progress("Loaded %d input coverage database%s", ninputs,
+            ninputs > 1 ? "s" : "");
 
    if (out_db) {
       progress("Saving merged coverage database to: %s", out_db);
@@ -1188,7 +1208,8 @@ static void usage(void)
           "\n"
           "Global options may be placed before COMMAND:\n"
           " -h, --help\t\tDisplay this message and exit\n"
-          " -H SIZE\t\tSet the maximum heap size to SIZE bytes\n"
+          " -H SIZE\t\tSet the initial heap size to SIZE bytes\n"
+          "     --heap-limit=SIZE\tLet the heap grow up to SIZE bytes\n"
           "     --ignore-time\tSkip source file timestamp check\n"
           " -L PATH\t\tAdd PATH to library search paths\n"
           " -M SIZE\t\tLimit design unit heap space to SIZE bytes\n"
@@ -1417,6 +1438,7 @@ int main(int argc, char **argv)
       { "ignore-time", no_argument,       0, 'i' },
       { "force-init",  no_argument,       0, 'f' },   // DEPRECATED 1.7
       { "stderr",      required_argument, 0, 'E' },
+      { "heap-limit",  required_argument, 0, 'X' },
       { 0, 0, 0, 0 }
    };
 
@@ -1473,6 +1495,9 @@ int main(int argc, char **argv)
       case 'H':
          opt_set_size(OPT_HEAP_SIZE, parse_size(optarg));
          break;
+      case 'X':
+         opt_set_size(OPT_HEAP_LIMIT, parse_size(optarg));
+         break;
       case 'E':
          set_stderr_severity(parse_severity(optarg));
          break;
@@ -23,6 +23,7 @@
 #include "lib.h"
 #include "object.h"
 #include "option.h"
+#include "thread.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -36,14 +37,18 @@ typedef A(object_t **) object_ptr_array_t;
 
 typedef enum { OBJ_DISK, OBJ_FRESH } obj_src_t;
 
+typedef struct {
+   mark_mask_t  *bits;
+   size_t        size;
+   generation_t  generation;
+} arena_marks_t;
+
 typedef struct _object_arena {
    void           *base;
    void           *alloc;
    void           *limit;
    bool            frozen;
-   mark_mask_t    *mark_bits;
-   size_t          mark_sz;
-   generation_t    generation;
+   arena_marks_t  *marks;
    arena_key_t     key;
    arena_array_t   deps;
    object_t       *root;
@@ -130,23 +135,38 @@ static bool object_marked_p(object_t *object, generation_t generation)
 {
    object_arena_t *arena = __object_arena(object);
 
-   if (arena->mark_bits == NULL) {
+   // Each thread has its own set of mark bits so that objects can be
+   // visited concurrently from several threads
+   arena_marks_t *all = load_acquire(&arena->marks);
+   if (all == NULL) {
+      arena_marks_t *new = xcalloc_array(MAX_THREADS, sizeof(arena_marks_t));
+      if (atomic_cas(&arena->marks, NULL, new))
+         all = new;
+      else {
+         free(new);
+         all = load_acquire(&arena->marks);
+      }
+   }
+
+   arena_marks_t *marks = &(all[thread_id()]);
+
+   if (marks->bits == NULL) {
       const size_t nbits = (arena->limit - arena->base) / OBJECT_ALIGN;
-      arena->mark_sz = ALIGN_UP(nbits, 64) / 8;
-      arena->mark_bits = xcalloc(arena->mark_sz);
-      arena->generation = generation;
+      marks->size = ALIGN_UP(nbits, 64) / 8;
+      marks->bits = xcalloc(marks->size);
+      marks->generation = generation;
    }
-   else if (arena->generation != generation) {
-      memset(arena->mark_bits, '\0', arena->mark_sz);
-      arena->generation = generation;
+   else if (marks->generation != generation) {
+      memset(marks->bits, '\0', marks->size);
+      marks->generation = generation;
    }
 
    uintptr_t bit = ((void *)object - arena->base) >> OBJECT_ALIGN_BITS;
    uintptr_t word = bit / 64;
    uint64_t mask = UINT64_C(1) << (bit & 63);
 
-   const bool marked = !!(arena->mark_bits[word] & mask);
-   arena->mark_bits[word] |= mask;
+   const bool marked = !!(marks->bits[word] & mask);
+   marks->bits[word] |= mask;
 
    return marked;
 }
@@ -1025,7 +1045,7 @@ object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
 
 unsigned object_next_generation(void)
 {
-   return next_generation++;
+   return atomic_fetch_add(&next_generation, 1);
 }
 
 static bool object_copy_mark(object_t *object, object_copy_ctx_t *ctx)
@@ -1193,8 +1213,12 @@ size_t object_arena_default_size(void)
 
 object_arena_t *object_arena_new(size_t size, unsigned std)
 {
-   if (all_arenas.count == 0)
+   if (all_arenas.count == 0) {
+      // Reserve space for every possible arena up front as other
+      // threads may read this array while a library is being loaded
+      ARESERVE(all_arenas, UINT16_MAX);
       APUSH(all_arenas, NULL);   // Dummy null arena
+   }
 
    object_arena_t *arena = xcalloc(sizeof(object_arena_t));
    arena->base   = nvc_memalign(OBJECT_PAGE_SZ, size);
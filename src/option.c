@@ -149,6 +149,8 @@ void set_default_options(void)
    opt_set_str(OPT_EVAL_VERBOSE, getenv("NVC_EVAL_VERBOSE"));
    opt_set_str(OPT_ELAB_VERBOSE, getenv("NVC_ELAB_VERBOSE"));
    opt_set_size(OPT_HEAP_SIZE, 16 * 1024 * 1024);
+   opt_set_size(OPT_HEAP_LIMIT, (size_t)(sizeof(void *) == 8 ? 8192 : 1024)
+                << 20);
    opt_set_int(OPT_ERROR_LIMIT, 20);
    opt_set_int(OPT_GC_STRESS, 0 DEBUG_ONLY(|| get_int_env("NVC_GC_STRESS", 0)));
    opt_set_int(OPT_RELAXED, 0);
@@ -162,4 +164,10 @@ void set_default_options(void)
    opt_set_int(OPT_JIT_ASYNC, get_int_env("NVC_JIT_ASYNC", 1));
    opt_set_int(OPT_PERF_MAP, get_int_env("NVC_PERF_MAP", 0));
    opt_set_str(OPT_LIB_VERBOSE, getenv("NVC_LIB_VERBOSE"));
+   opt_set_str(OPT_JIT_PROFILE, getenv("NVC_JIT_PROFILE"));
+   opt_set_str(OPT_JIT_CACHE, getenv("NVC_JIT_CACHE"));
+   opt_set_int(OPT_JIT_THREADS, get_int_env("NVC_JIT_THREADS",
+                                            MAX(1, nvc_nprocs() / 4)));
+   opt_set_int(OPT_JIT_INTRINSICS, get_int_env("NVC_JIT_INTRINSICS", 1));
+   opt_set_int(OPT_JIT_COUNTERS, get_int_env("NVC_JIT_COUNTERS", 0));
 }
@@ -58,6 +58,12 @@ typedef enum {
    OPT_JIT_ASYNC,
    OPT_PERF_MAP,
    OPT_LIB_VERBOSE,
+   OPT_HEAP_LIMIT,
+   OPT_JIT_PROFILE,
+   OPT_JIT_CACHE,
+   OPT_JIT_THREADS,
+   OPT_JIT_INTRINSICS,
+   OPT_JIT_COUNTERS,
 
    OPT_LAST_NAME
 } opt_name_t;
@@ -48,6 +48,9 @@ void cgen(tree_t top, vcode_unit_t vu, cover_tagging_t *cover);
 // Generate ahead-of-time preload library
 void aotgen(const char *outfile, char **argv, int argc);
 
+// Save native code for functions compiled by the JIT
+void cgen_jit_cache(jit_t *jit, const char *so_path);
+
 // Dump out a VHDL representation of the given unit
 void dump(tree_t top);
 
@@ -19,11 +19,13 @@
 #include "array.h"
 #include "common.h"
 #include "cover.h"
+#include "hash.h"
 #include "lib.h"
 #include "option.h"
 #include "rt/model.h"
 #include "rt/rt.h"
 #include "rt/structs.h"
+#include "thread.h"
 #include "type.h"
 
 #include <assert.h>
@@ -33,6 +35,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <time.h>
 
 //#define COVER_DEBUG
@@ -46,6 +49,7 @@ typedef struct {
 } line_range_t;
 
 typedef A(cover_tag_t) tag_array_t;
+typedef A(cover_tag_t *) tag_ptr_array_t;
 typedef A(line_range_t) range_array_t;
 
 typedef struct _cover_report_ctx    cover_report_ctx_t;
@@ -76,8 +80,39 @@ struct _cover_tagging {
    int            array_depth;
    int            report_item_limit;
    cover_scope_t *top_scope;
+   hash_t        *index;
+   void          *live_map;
+   size_t         live_size;
+   int            live_fd;
 };
 
+// Header of the file holding the counters of a running simulation
+// which is followed by the statement, branch, toggle, and expression
+// counters in that order
+typedef struct {
+   uint32_t magic;
+   uint32_t n_stmts;
+   uint32_t n_branches;
+   uint32_t n_toggles;
+   uint32_t n_expressions;
+   uint32_t pad[3];
+} cover_live_hdr_t;
+
+#define COVER_LIVE_MAGIC 0x4c564f43
+
+typedef struct {
+   int32_t  *toggle_mask;
+   unsigned  remaining;   // Bits not yet toggled in both directions
+} cover_toggle_t;
+
+typedef struct {
+   const char      *file;
+   fbuf_t          *fbuf;
+   uint32_t         pre_mask;
+   cover_tagging_t *tagging;
+   bool             loaded;
+} cover_input_t;
+
 typedef struct {
    unsigned    total_stmts;
    unsigned    hit_stmts;
@@ -121,8 +156,24 @@ struct _cover_file {
    cover_file_t *next;
 };
 
+// Tags for the report are either held in memory or read one at a
+// time from a database file so that large designs can be reported
+// without loading every tag
+typedef struct {
+   cover_tagging_t        *tagging;
+   int                     next;
+   fbuf_t                 *fbuf;
+   loc_rd_ctx_t           *loc_rd;
+   ident_rd_ctx_t          ident_rd;
+   const cover_live_hdr_t *live;
+   size_t                  live_size;
+} cover_tag_src_t;
+
 struct _cover_report_ctx {
    cover_tagging_t      *tagging;
+   cover_tag_src_t      *src;
+   tag_ptr_array_t       owned;
+   cover_file_t         *src_file;
    cover_stats_t        flat_stats;
    cover_stats_t        nested_stats;
    cover_report_ctx_t   *parent;
@@ -264,6 +315,11 @@ bool cover_skip_array_toggle(cover_tagging_t *tagging, int a_size)
    return false;
 }
 
+static char *cover_live_name(tree_t top)
+{
+   return xasprintf("_%s.covdb.live", istr(tree_ident(top)));
+}
+
 fbuf_t *cover_open_lib_file(tree_t top, fbuf_mode_t mode, bool check_null)
 {
    char *dbname LOCAL = xasprintf("_%s.covdb", istr(tree_ident(top)));
@@ -630,64 +686,230 @@ cover_tagging_t *cover_read_tags(fbuf_t *f, uint32_t pre_mask)
    }
 
    loc_read_end(loc_rd);
+   ident_read_end(ident_ctx);
    return tagging;
 }
 
-void cover_merge_tags(fbuf_t *f, cover_tagging_t *tagging)
+static cover_tag_t *cover_find_tag(cover_tagging_t *tagging, ident_t hier)
 {
-   assert (tagging != NULL);
-
-   cover_read_header(f, tagging);
-
-   loc_rd_ctx_t *loc_rd = loc_read_begin(f);
-   ident_rd_ctx_t ident_ctx = ident_read_begin(f);
+   // Each statement / branch / signal has a unique hierarchical name
+   // so index the tags by name the first time they are searched
+   if (tagging->index == NULL) {
+      tagging->index = hash_new(tagging->tags.count * 2);
 
-   for (;;) {
-      cover_tag_t new;
-      cover_read_one_tag(f, loc_rd, ident_ctx, &new);
+      for (int i = 0; i < tagging->tags.count; i++) {
+         ident_t name = tagging->tags.items[i].hier;
+         if (hash_get(tagging->index, name) == NULL)
+            hash_put(tagging->index, name, (void *)(uintptr_t)(i + 1));
+      }
+   }
 
-      if (new.kind == TAG_LAST)
-         break;
+   const uintptr_t pos = (uintptr_t)hash_get(tagging->index, hier);
+   return pos == 0 ? NULL : AREF(tagging->tags, pos - 1);
+}
 
-      // TODO: Could merging be done more efficiently?
-      bool found = false;
-      for (int i = 0; i < tagging->tags.count; i++) {
-         cover_tag_t *old = AREF(tagging->tags, i);
+static void cover_merge_one_tag(cover_tagging_t *tagging, cover_tag_t *new)
+{
+   cover_tag_t *old = cover_find_tag(tagging, new->hier);
+
+   // TODO: Append the new tag just before popping hierarchy tag
+   //       with longest common prefix of new tag. That will allow to
+   //       merge coverage of IPs from different configurations of
+   //       generics which form hierarchy differently!
+   if (old == NULL) {
+      warnf("Dropping coverage tag: %s\n", istr(new->hier));
+      return;
+   }
 
-         // Compare based on hierarchical path, each
-         // statement / branch / signal has unique hierarchical name
-         if (new.hier == old->hier) {
-            assert(new.kind == old->kind);
+   assert(new->kind == old->kind);
 #ifdef COVER_DEBUG
-            printf("Merging coverage tag: %s\n", istr(old->hier));
+   printf("Merging coverage tag: %s\n", istr(old->hier));
 #endif
-            switch (new.kind) {
-            case TAG_STMT:
-               old->data += new.data;
-               break;
-            case TAG_TOGGLE:
-            case TAG_BRANCH:
-            case TAG_EXPRESSION:
-               old->data |= new.data;
-               break;
-            default:
-               break;
-            }
 
-            found = true;
-            break;
-         }
-      }
+   switch (new->kind) {
+   case TAG_STMT:
+      old->data += new->data;
+      break;
+   case TAG_TOGGLE:
+   case TAG_BRANCH:
+   case TAG_EXPRESSION:
+      old->data |= new->data;
+      break;
+   default:
+      break;
+   }
+}
 
-      // TODO: Append the new tag just before popping hierarchy tag
-      //       with longest common prefix of new tag. That will allow to
-      //       merge coverage of IPs from different configurations of
-      //       generics which form hierarchy differently!
-      if (!found)
-         warnf("Dropping coverage tag: %s\n", istr(new.hier));
+static void cover_free_tags(cover_tagging_t *tagging)
+{
+   assert(tagging->top_scope == NULL);
+
+   hash_free(tagging->index);
+   ACLEAR(tagging->tags);
+   free(tagging);
+}
+
+static const cover_live_hdr_t *cover_open_live(cover_tagging_t *tagging,
+                                               const char *file,
+                                               size_t *size)
+{
+   // If the simulation is still running or did not finish cleanly the
+   // counters it collected are only in the live file
+   char *path LOCAL = xasprintf("%s.live", file);
+   int fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return NULL;
+
+   struct stat st;
+   if (fstat(fd, &st) != 0)
+      fatal_errno("%s", path);
+
+   const size_t ncounts = tagging->next_stmt_tag + tagging->next_branch_tag
+      + tagging->next_toggle_tag + tagging->next_expression_tag;
+   *size = sizeof(cover_live_hdr_t) + ncounts * sizeof(int32_t);
+
+   if (st.st_size != *size) {
+      warnf("ignoring %s which does not match the coverage database", path);
+      close(fd);
+      return NULL;
+   }
+
+   const cover_live_hdr_t *hdr = map_file(fd, *size);
+   close(fd);
+
+   if (hdr->magic != COVER_LIVE_MAGIC
+       || hdr->n_stmts != tagging->next_stmt_tag
+       || hdr->n_branches != tagging->next_branch_tag
+       || hdr->n_toggles != tagging->next_toggle_tag
+       || hdr->n_expressions != tagging->next_expression_tag) {
+      warnf("ignoring %s which does not match the coverage database", path);
+      unmap_file((void *)hdr, *size);
+      return NULL;
+   }
+
+   notef("using counters from %s as the simulation is still running "
+         "or did not complete", path);
+
+   return hdr;
+}
+
+static void cover_apply_live(const cover_live_hdr_t *hdr, cover_tag_t *tag)
+{
+   const int32_t *stmts = (const int32_t *)(hdr + 1);
+   const int32_t *branches = stmts + hdr->n_stmts;
+   const int32_t *toggles = branches + hdr->n_branches;
+   const int32_t *expressions = toggles + hdr->n_toggles;
+
+   switch (tag->kind) {
+   case TAG_STMT:       tag->data = stmts[tag->tag];       break;
+   case TAG_BRANCH:     tag->data = branches[tag->tag];    break;
+   case TAG_TOGGLE:     tag->data = toggles[tag->tag];     break;
+   case TAG_EXPRESSION: tag->data = expressions[tag->tag]; break;
+   default: break;
    }
 }
 
+static void cover_read_live(cover_tagging_t *tagging, const char *file)
+{
+   size_t size;
+   const cover_live_hdr_t *hdr = cover_open_live(tagging, file, &size);
+   if (hdr == NULL)
+      return;
+
+   for (int i = 0; i < tagging->tags.count; i++)
+      cover_apply_live(hdr, &(tagging->tags.items[i]));
+
+   unmap_file((void *)hdr, size);
+}
+
+static void cover_load_task(void *context, void *arg)
+{
+   cover_input_t *input = arg;
+
+   input->tagging = cover_read_tags(input->fbuf, input->pre_mask);
+
+   fbuf_close(input->fbuf, NULL);
+   input->fbuf = NULL;
+
+   store_release(&(input->loaded), true);
+   thread_notify(input);
+}
+
+static bool cover_load_pending(void *arg)
+{
+   cover_input_t *input = arg;
+   return !load_acquire(&(input->loaded));
+}
+
+static void cover_start_load(cover_input_t *input)
+{
+   input->fbuf = fbuf_open(input->file, FBUF_IN, FBUF_CS_NONE);
+   if (input->fbuf == NULL)
+      fatal("Could not open coverage database: %s", input->file);
+
+   async_do(cover_load_task, NULL, input);
+}
+
+static void cover_merge_one_file(cover_tagging_t *dst, cover_input_t *src)
+{
+   // Same as reading the source database after the destination
+   dst->mask                = src->tagging->mask;
+   dst->array_limit         = src->tagging->array_limit;
+   dst->next_stmt_tag       = src->tagging->next_stmt_tag;
+   dst->next_branch_tag     = src->tagging->next_branch_tag;
+   dst->next_toggle_tag     = src->tagging->next_toggle_tag;
+   dst->next_expression_tag = src->tagging->next_expression_tag;
+   dst->next_hier_tag       = src->tagging->next_hier_tag;
+
+   for (int i = 0; i < src->tagging->tags.count; i++)
+      cover_merge_one_tag(dst, &(src->tagging->tags.items[i]));
+
+   cover_free_tags(src->tagging);
+   src->tagging = NULL;
+}
+
+cover_tagging_t *cover_merge_files(const char **files, int nfiles,
+                                   uint32_t pre_mask)
+{
+   assert(nfiles > 0);
+
+   cover_input_t *inputs LOCAL =
+      xcalloc_array(nfiles, sizeof(cover_input_t));
+
+   // Only the first database is read with the extra mask bits as the
+   // header of each later one replaces it when merged
+   for (int i = 0; i < nfiles; i++) {
+      inputs[i].file = files[i];
+      inputs[i].pre_mask = (i == 0) ? pre_mask : 0;
+   }
+
+   // Keep at most about one database per processor loaded ahead of the
+   // fold so memory does not grow with the number of inputs
+   const int window = MAX(1, nvc_nprocs());
+   int next = 0;
+   while (next < MIN(window, nfiles))
+      cover_start_load(&(inputs[next++]));
+
+   // Tags missing from the first database are dropped so the merge is
+   // not associative and must fold the inputs in order
+   cover_tagging_t *result = NULL;
+   for (int i = 0; i < nfiles; i++) {
+      thread_wait(&(inputs[i]), cover_load_pending);
+
+      if (next < nfiles)
+         cover_start_load(&(inputs[next++]));
+
+      cover_read_live(inputs[i].tagging, inputs[i].file);
+
+      if (i == 0)
+         result = inputs[i].tagging;
+      else
+         cover_merge_one_file(result, &(inputs[i]));
+   }
+
+   return result;
+}
+
 void cover_count_tags(cover_tagging_t *tagging, int32_t *n_stmts,
                       int32_t *n_branches, int32_t *n_toggles,
                       int32_t *n_expressions)
@@ -710,6 +932,82 @@ void cover_count_tags(cover_tagging_t *tagging, int32_t *n_stmts,
 // Runtime handling
 ///////////////////////////////////////////////////////////////////////////////
 
+int32_t *cover_map_live(cover_tagging_t *tagging, tree_t top)
+{
+   // Keep the counters in a file mapped into memory so they are not
+   // lost if the simulation crashes or is killed and so they can be
+   // read with "nvc -c" while it is still running
+   const char *dir = lib_path(lib_work());
+   if (dir == NULL)
+      return NULL;   // Temporary library for unit test
+
+   char *name LOCAL = cover_live_name(top);
+   char *path LOCAL = xasprintf("%s" DIR_SEP "%s", dir, name);
+
+   int32_t n_stmts, n_branches, n_toggles, n_expressions;
+   cover_count_tags(tagging, &n_stmts, &n_branches, &n_toggles,
+                    &n_expressions);
+
+   const size_t ncounts = n_stmts + n_branches + n_toggles + n_expressions;
+   const size_t size = sizeof(cover_live_hdr_t) + ncounts * sizeof(int32_t);
+
+   int fd = open(path, O_RDWR | O_CREAT, 0666);
+   if (fd < 0) {
+      warnf("cannot create %s: %s", path, last_os_error());
+      return NULL;
+   }
+
+   // Another simulation of the same design may already be using the
+   // file in which case the counters are only kept in memory
+   if (!file_try_write_lock(fd)) {
+      warnf("%s is in use by another simulation of the same design: "
+            "coverage counters will only be saved when this simulation "
+            "completes", path);
+      close(fd);
+      return NULL;
+   }
+
+   // Truncate first to discard the counters from an earlier run
+   if (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0)
+      fatal_errno("ftruncate: %s", path);
+
+   cover_live_hdr_t *hdr = map_file_shared(fd, size);
+
+   hdr->n_stmts       = n_stmts;
+   hdr->n_branches    = n_branches;
+   hdr->n_toggles     = n_toggles;
+   hdr->n_expressions = n_expressions;
+   hdr->magic         = COVER_LIVE_MAGIC;
+
+   tagging->live_map  = hdr;
+   tagging->live_size = size;
+   tagging->live_fd   = fd;   // Holds the lock until unmapped
+
+   return (int32_t *)(hdr + 1);
+}
+
+void cover_unmap_live(cover_tagging_t *tagging, tree_t top)
+{
+   // Called once the complete database has been written
+   if (tagging->live_map == NULL)
+      return;
+
+   unmap_file(tagging->live_map, tagging->live_size);
+   tagging->live_map = NULL;
+
+   cover_remove_live(top);
+
+   file_unlock(tagging->live_fd);
+   close(tagging->live_fd);
+   tagging->live_fd = -1;
+}
+
+void cover_remove_live(tree_t top)
+{
+   char *name LOCAL = cover_live_name(top);
+   lib_delete(lib_work(), name);
+}
+
 static inline void cover_toggle_check_0_1(uint8_t old, uint8_t new,
                                           int32_t *toggle_mask)
 {
@@ -789,19 +1087,44 @@ static inline void cover_toggle_check_0_1_u_z(uint8_t old, uint8_t new,
 #endif
 
 
+#define COVER_TGL_BOTH (COV_FLAG_TOGGLE_TO_0 | COV_FLAG_TOGGLE_TO_1)
+
+// Only the bytes of the signal that changed since the last callback are
+// examined and eight bytes at a time are skipped when they have not
+// changed.  Once every bit has toggled in both directions the callback
+// removes itself.
 #define DEFINE_COVER_TOGGLE_CB(name, check_fnc)                               \
    static void name(uint64_t now, rt_signal_t *s, rt_watch_t *w, void *user)  \
    {                                                                          \
-      uint32_t s_size = s->shared.size;                                       \
-      int32_t *toggle_mask = ((int32_t *)user);                               \
+      cover_toggle_t *ct = user;                                              \
+      const uint8_t *new = signal_value(s);                                   \
+      const uint8_t *old = signal_last_value(s);                              \
+      const uint32_t hi = MIN(w->dirty_hi, s->shared.size);                   \
       COVER_TGL_CB_MSG(s)                                                     \
-      for (int i = 0; i < s_size; i++) {                                      \
-         uint8_t new = ((uint8_t*)signal_value(s))[i];                        \
-         uint8_t old = ((uint8_t*)signal_last_value(s))[i];                   \
-         check_fnc(old, new, toggle_mask);                                    \
-         toggle_mask++;                                                       \
+      for (uint32_t i = w->dirty_lo; i < hi;) {                               \
+         if (i + 8 <= hi) {                                                   \
+            uint64_t new8, old8;                                              \
+            memcpy(&new8, new + i, sizeof(uint64_t));                         \
+            memcpy(&old8, old + i, sizeof(uint64_t));                         \
+            if (new8 == old8) {                                               \
+               i += 8;                                                        \
+               continue;                                                      \
+            }                                                                 \
+         }                                                                    \
+         if (new[i] != old[i]) {                                              \
+            int32_t *mask = ct->toggle_mask + i;                              \
+            const bool done = (*mask & COVER_TGL_BOTH) == COVER_TGL_BOTH;     \
+            check_fnc(old[i], new[i], mask);                                  \
+            if (!done && (*mask & COVER_TGL_BOTH) == COVER_TGL_BOTH)          \
+               ct->remaining--;                                               \
+         }                                                                    \
+         i++;                                                                 \
+      }                                                                       \
+      COVER_TGL_SIGNAL_DETAILS(s, s->shared.size)                             \
+      if (ct->remaining == 0) {                                               \
+         model_clear_event_cb(get_model(), w);                                \
+         free(ct);                                                            \
       }                                                                       \
-      COVER_TGL_SIGNAL_DETAILS(s, s_size)                                     \
    }                                                                          \
 
 
@@ -864,7 +1187,19 @@ void x_cover_setup_toggle_cb(sig_shared_t *ss, int32_t *toggle_mask)
    else if (op_mask & COVER_MASK_TOGGLE_COUNT_FROM_TO_Z)
       fn = &cover_toggle_cb_0_1_z;
 
-   model_set_event_cb(m, s, fn, toggle_mask, false);
+   cover_toggle_t *ct = xmalloc(sizeof(cover_toggle_t));
+   ct->toggle_mask = toggle_mask;
+   ct->remaining   = 0;
+
+   for (int i = 0; i < s->shared.size; i++) {
+      if ((toggle_mask[i] & COVER_TGL_BOTH) != COVER_TGL_BOTH)
+         ct->remaining++;
+   }
+
+   if (ct->remaining == 0)
+      free(ct);
+   else
+      model_set_event_cb(m, s, fn, ct, false);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1215,8 +1550,8 @@ static void cover_print_html_header(FILE *f, cover_report_ctx_t *ctx, bool top,
    fprintf(f, "  </h2>\n");
 
    // start_tag has still loc corresponding to a file where hierarchy
-   // is instantiated.
-   cover_file_t *src = cover_file(&((ctx->start_tag + 1)->loc));
+   // is instantiated so this is the file of the tag following it
+   cover_file_t *src = ctx->src_file;
    fprintf(f, "  <h2 style=\"margin-left: " MARGIN_LEFT ";\">\n");
    if (!top)
       fprintf(f, "     File:&nbsp; <a href=\"../../%s\">../../%s</a>\n",
@@ -1773,11 +2108,50 @@ static void cover_tag_to_chain(cover_report_ctx_t *ctx, cover_tag_t *tag,
 
 }
 
+static cover_tag_t *cover_next_tag(cover_report_ctx_t *ctx)
+{
+   cover_tag_src_t *src = ctx->src;
+   if (src->fbuf == NULL) {
+      cover_tag_t *tag = AREF(src->tagging->tags, src->next);
+      src->next++;
+      return tag;
+   }
+
+   // Each tag read from the file is owned by the hierarchy that read
+   // it and freed once the report for that hierarchy is written
+   cover_tag_t *tag = xmalloc(sizeof(cover_tag_t));
+   cover_read_one_tag(src->fbuf, src->loc_rd, src->ident_rd, tag);
+
+   if (tag->kind == TAG_LAST)
+      fatal("coverage database ends before the top-level hierarchy");
+   else if (src->live != NULL)
+      cover_apply_live(src->live, tag);
+
+   APUSH(ctx->owned, tag);
+   return tag;
+}
+
+static void cover_release_tags(cover_report_ctx_t *ctx)
+{
+   for (int i = 0; i < ctx->owned.count; i++)
+      free(ctx->owned.items[i]);
+
+   ACLEAR(ctx->owned);
+}
+
+static void cover_free_chain(cover_chain_t *chain)
+{
+   free(chain->hits);
+   free(chain->miss);
+   free(chain->excl);
+}
+
 static cover_tag_t* cover_report_hierarchy(cover_report_ctx_t *ctx,
                                            const char *dir)
 {
    char *hier LOCAL = xasprintf("%s/%s.html", dir, istr(ctx->start_tag->hier));
-   cover_tag_t *tag = ctx->start_tag;
+   cover_tag_t *tag = cover_next_tag(ctx);
+   ctx->src_file = cover_file(&(tag->loc));
 
    // TODO: Handle escaped identifiers in hierarchy path!
    FILE *f = fopen(hier, "w");
@@ -1819,9 +2193,7 @@ static cover_tag_t* cover_report_hierarchy(cover_report_ctx_t *ctx,
 
    int skipped = 0;
 
-   for(;;) {
-      tag++;
-
+   for (;; tag = cover_next_tag(ctx)) {
       if (tag->kind == TAG_HIER) {
          if (tag->flags & COV_FLAG_HIER_DOWN) {
 
@@ -1830,9 +2202,11 @@ static cover_tag_t* cover_report_hierarchy(cover_report_ctx_t *ctx,
             sub_ctx.start_tag = tag;
             sub_ctx.parent = ctx;
             sub_ctx.tagging = ctx->tagging;
+            sub_ctx.src = ctx->src;
             tag = cover_report_hierarchy(&sub_ctx, dir);
             cover_print_hierarchy_summary(f, &(sub_ctx.nested_stats),
                                           tag->hier, false, false);
+            cover_release_tags(&sub_ctx);
 
             // Add coverage from sub-hierarchies
             ctx->nested_stats.hit_stmts += sub_ctx.nested_stats.hit_stmts;
@@ -1953,12 +2327,21 @@ static cover_tag_t* cover_report_hierarchy(cover_report_ctx_t *ctx,
    cover_print_timestamp(f);
 
    fclose(f);
+
+   cover_free_chain(&(ctx->ch_stmt));
+   cover_free_chain(&(ctx->ch_branch));
+   cover_free_chain(&(ctx->ch_toggle));
+   cover_free_chain(&(ctx->ch_expression));
+
    return tag;
 }
 
 
-void cover_report(const char *path, cover_tagging_t *tagging, int item_limit)
+static void cover_report_tags(const char *path, cover_tag_src_t *src,
+                              int item_limit)
 {
+   cover_tagging_t *tagging = src->tagging;
+
    char *subdir LOCAL = xasprintf("%s/hier", path);
    make_dir(path);
    make_dir(subdir);
@@ -1989,11 +2372,13 @@ void cover_report(const char *path, cover_tagging_t *tagging, int item_limit)
    notef("Code coverage report folder: %s.", path);
    notef("%s", tb_get(tb));
 
-   assert(tagging->tags.items[0].kind == TAG_HIER);
-
    cover_report_ctx_t top_ctx = {0};
-   top_ctx.start_tag = AREF(tagging->tags, 0);
+   top_ctx.src = src;
+   top_ctx.start_tag = cover_next_tag(&top_ctx);
    top_ctx.tagging = tagging;
+
+   assert(top_ctx.start_tag->kind == TAG_HIER);
+
    tagging->report_item_limit = item_limit;
    cover_report_hierarchy(&top_ctx, subdir);
 
@@ -2008,4 +2393,44 @@ void cover_report(const char *path, cover_tagging_t *tagging, int item_limit)
    cover_print_timestamp(f);
 
    fclose(f);
+
+   cover_release_tags(&top_ctx);
+}
+
+void cover_report(const char *path, cover_tagging_t *tagging, int item_limit)
+{
+   cover_tag_src_t src = {
+      .tagging = tagging,
+   };
+   cover_report_tags(path, &src, item_limit);
+}
+
+void cover_report_file(const char *path, const char *file, uint32_t pre_mask,
+                       int item_limit)
+{
+   fbuf_t *f = fbuf_open(file, FBUF_IN, FBUF_CS_NONE);
+   if (f == NULL)
+      fatal("Could not open coverage database: %s", file);
+
+   cover_tagging_t *tagging = xcalloc(sizeof(cover_tagging_t));
+   cover_read_header(f, tagging);
+   tagging->mask |= pre_mask;
+
+   cover_tag_src_t src = {
+      .tagging  = tagging,
+      .fbuf     = f,
+      .loc_rd   = loc_read_begin(f),
+      .ident_rd = ident_read_begin(f),
+   };
+   src.live = cover_open_live(tagging, file, &(src.live_size));
+
+   cover_report_tags(path, &src, item_limit);
+
+   if (src.live != NULL)
+      unmap_file((void *)src.live, src.live_size);
+
+   loc_read_end(src.loc_rd);
+   ident_read_end(src.ident_rd);
+   fbuf_close(f, NULL);
+   free(tagging);
 }
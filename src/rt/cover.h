@@ -184,6 +184,8 @@ cover_tag_t *cover_add_tag(tree_t t, ident_t suffix, cover_tagging_t *ctx,
 
 void cover_load_exclude_file(const char *path, cover_tagging_t *tagging);
 void cover_report(const char *path, cover_tagging_t *tagging, int item_limit);
+void cover_report_file(const char *path, const char *file, uint32_t pre_mask,
+                       int item_limit);
 
 void cover_count_tags(cover_tagging_t *tagging, int32_t *n_stmts,
                       int32_t *n_branches, int32_t *n_toggles,
@@ -195,6 +197,11 @@ void cover_dump_tags(cover_tagging_t *ctx, fbuf_t *f, cover_dump_t dt,
 
 cover_tagging_t *cover_read_tags(fbuf_t *f, uint32_t pre_mask);
 
-void cover_merge_tags(fbuf_t *f, cover_tagging_t *tagging);
+cover_tagging_t *cover_merge_files(const char **files, int nfiles,
+                                   uint32_t pre_mask);
+
+int32_t *cover_map_live(cover_tagging_t *tagging, tree_t top);
+void cover_unmap_live(cover_tagging_t *tagging, tree_t top);
+void cover_remove_live(tree_t top);
 
 #endif  // _COVER_H
@@ -0,0 +1,177 @@
+//
+//  Copyright (C) 2023  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "jit/jit-exits.h"
+#include "rt/structs.h"
+
+#include <assert.h>
+#include <string.h>
+
+// Native implementations of hot IEEE library functions called from the
+// start of the corresponding VHDL subprogram body
+
+// Encoding of STD_ULOGIC enumeration literals
+#define SL_X 1
+#define SL_0 2
+#define SL_1 3
+
+#define BYTES(b) (UINT64_C(0x0101010101010101) * (b))
+
+static inline uint64_t load_msb_first(const uint8_t *p)
+{
+   uint64_t w;
+   memcpy(&w, p, sizeof(w));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+   return __builtin_bswap64(w);
+#else
+   return w;
+#endif
+}
+
+static inline void store_little_endian(uint8_t *p, uint64_t w)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+   w = __builtin_bswap64(w);
+#endif
+   memcpy(p, &w, sizeof(w));
+}
+
+static bool ieee_to_bits(const uint8_t *p, int n, uint64_t *result)
+{
+   // Convert up to 64 elements stored most significant first to an
+   // integer or return false if any element is not '0', '1', 'L', or
+   // 'H' which are exactly the values matching 0b0000_0x1x
+   assert(n <= 64);
+
+   uint64_t bits = 0;
+   int i = 0;
+   for (; i + 8 <= n; i += 8) {
+      const uint64_t w = load_msb_first(p + i);
+      if ((w & BYTES(0xfa)) != BYTES(0x02))
+         return false;
+
+      // Gather the low bit of each byte into the top byte
+      const uint64_t gather = (w & BYTES(0x01)) * UINT64_C(0x0102040810204080);
+      bits = (bits << 8) | (gather >> 56);
+   }
+
+   for (; i < n; i++) {
+      if ((p[i] & 0xfa) != 0x02)
+         return false;
+      bits = (bits << 1) | (p[i] & 1);
+   }
+
+   *result = bits;
+   return true;
+}
+
+static void ieee_from_bits(uint64_t bits, int n, uint8_t *p)
+{
+   // Inverse of ieee_to_bits for values known to contain no metavalues
+   assert(n <= 64);
+
+   for (; n >= 8; n -= 8, bits >>= 8) {
+      // Spread the low eight bits out to one per byte with the most
+      // significant bit in the least significant byte
+      const uint64_t spread =
+         (((bits & 0xff) * UINT64_C(0x8040201008040201)) >> 7) & BYTES(0x01);
+      store_little_endian(p + n - 8, spread | BYTES(SL_0));
+   }
+
+   for (; n > 0; n--, bits >>= 1)
+      p[n - 1] = SL_0 | (bits & 1);
+}
+
+static bool ieee_chunk(const uint8_t *p, int len, int size, int lo, int hi,
+                       uint64_t *bits)
+{
+   // Extract elements [lo, hi) of an operand zero extended to size
+   const int skip = size - len;
+   const int from = MAX(lo - skip, 0), to = hi - skip;
+
+   if (to <= 0) {
+      *bits = 0;
+      return true;
+   }
+
+   return ieee_to_bits(p + from, to - from, bits);
+}
+
+void x_numeric_add_unsigned(const uint8_t *left, int32_t llen,
+                            const uint8_t *right, int32_t rlen,
+                            uint8_t *result, int32_t size)
+{
+   assert(size == MAX(llen, rlen));
+
+   // Add 64 bits at a time starting from the least significant end
+   unsigned carry = 0;
+   for (int hi = size; hi > 0; hi -= 64) {
+      const int lo = MAX(hi - 64, 0);
+
+      uint64_t a, b;
+      if (!ieee_chunk(left, llen, size, lo, hi, &a)
+          || !ieee_chunk(right, rlen, size, lo, hi, &b)) {
+         // Any metavalue in either argument makes the result all 'X'
+         memset(result, SL_X, size);
+         return;
+      }
+
+      uint64_t sum;
+      const unsigned c1 = __builtin_add_overflow(a, b, &sum);
+      const unsigned c2 = __builtin_add_overflow(sum, carry, &sum);
+      carry = c1 | c2;
+
+      // The carry out of a partial chunk is discarded with the
+      // unused high bits
+      ieee_from_bits(sum, hi - lo, result + lo);
+   }
+}
+
+void x_numeric_resize_unsigned(const uint8_t *arg, int32_t len,
+                               uint8_t *result, int32_t size)
+{
+   // Keep the least significant bits and pad with '0'
+   if (size <= len)
+      memcpy(result, arg + len - size, size);
+   else {
+      memset(result, SL_0, size - len);
+      memcpy(result + size - len, arg, len);
+   }
+}
+
+void x_numeric_to_unsigned(uint64_t value, uint8_t *result, int32_t size)
+{
+   const int nbits = MIN(size, 64);
+   memset(result, SL_0, size - nbits);
+   ieee_from_bits(value, nbits, result + size - nbits);
+}
+
+int8_t x_logic_edge(sig_shared_t *ss, uint32_t offset, bool rising)
+{
+   if (!x_test_net_event(ss, offset, 1))
+      return 0;
+
+   // Equivalent to TO_X01 applied to the current and last values
+   const uint8_t value = ss->data[offset] & ~4;
+   const uint8_t last = ss->data[ss->size + offset] & ~4;
+
+   if (rising)
+      return value == SL_1 && last == SL_0;
+   else
+      return value == SL_0 && last == SL_1;
+}
@@ -67,11 +67,14 @@ typedef struct {
    waveform_t *free_waveforms;
    tlab_t      tlab;
    tlab_t      spare_tlab;
+   uint64_t    events;
+   uint64_t    activations;
 } __attribute__((aligned(64))) model_thread_t;
 
 typedef struct _rt_model {
    tree_t             top;
    hash_t            *scopes;
+   hash_t            *procs;
    rt_scope_t        *root;
    mspace_t          *mspace;
    jit_t             *jit;
@@ -417,6 +420,15 @@ static rt_scope_t *scope_for_block(rt_model_t *m, tree_t block, ident_t prefix)
             p->name      = ident_prefix(path, ident_downcase(name), ':');
             p->handle    = jit_lazy_compile(m->jit, sym);
             p->scope     = s;
+
+            rt_proc_t *first = hash_get(m->procs, t);
+            if (first == NULL)
+               hash_put(m->procs, t, p);
+            else if (p->handle == JIT_HANDLE_INVALID) {
+               // Code for processes in replicated instances is only
+               // generated once and called with each instance's context
+               p->handle = first->handle;
+            }
             p->privdata  = mptr_new(m->mspace, "process privdata");
 
             p->wakeable.kind      = W_PROC;
@@ -442,6 +454,7 @@ rt_model_t *model_new(tree_t top, jit_t *jit)
    rt_model_t *m = xcalloc(sizeof(rt_model_t));
    m->top         = top;
    m->scopes      = hash_new(256);
+   m->procs       = hash_new(256);
    m->mspace      = jit_get_mspace(jit);
    m->jit         = jit;
    m->nexus_tail  = &(m->nexuses);
@@ -589,8 +602,26 @@ void model_free(rt_model_t *m)
       for (memblock_t *mb = m->memblocks; mb; mb = mb->chain)
          mem += mb->pagesz - (MEMBLOCK_LINE_SZ * mb->free);
 
-      notef("setup:%ums run:%ums user:%ums sys:%ums maxrss:%ukB static:%ukB",
-            m->ready_rusage.ms, ru.ms, ru.user, ru.sys, ru.rss, mem / 1024);
+      mspace_stats_t ms;
+      mspace_get_stats(m->mspace, &ms);
+
+      uint64_t events = 0, activations = 0;
+      for (int i = 0; i < MAX_THREADS; i++) {
+         if (m->threads[i] != NULL) {
+            events += m->threads[i]->events;
+            activations += m->threads[i]->activations;
+         }
+      }
+
+      char tmbuf[64];
+      fmt_time_r(tmbuf, sizeof(tmbuf), m->now);
+
+      notef("setup:%ums run:%ums user:%ums sys:%ums maxrss:%ukB static:%ukB "
+            "heap:%zukB peak:%zukB grown:%u gc:%u gctime:%ums time:%s "
+            "events:%"PRIu64" activations:%"PRIu64, m->ready_rusage.ms,
+            ru.ms, ru.user, ru.sys, ru.rss, mem / 1024, ms.heap_size / 1024,
+            ms.peak_size / 1024, ms.growths, ms.collections, ms.gc_us / 1000,
+            tmbuf, events, activations);
    }
 
    while (heap_size(m->eventq_heap) > 0) {
@@ -639,6 +670,7 @@ void model_free(rt_model_t *m)
 
    heap_free(m->eventq_heap);
    hash_free(m->scopes);
+   hash_free(m->procs);
    ihash_free(m->res_memo);
    free(m);
 }
@@ -695,7 +727,7 @@ const void *signal_last_value(rt_signal_t *s)
 
 size_t signal_expand(rt_signal_t *s, uint64_t *buf, size_t max)
 {
-   const size_t total = s->shared.size / s->nexus.size;
+   const size_t total = signal_width(s);
 
 #define SIGNAL_READ_EXPAND_U64(type) do {                               \
       const type *sp = (type *)s->shared.data;                          \
@@ -708,6 +740,65 @@ size_t signal_expand(rt_signal_t *s, uint64_t *buf, size_t max)
    return total;
 }
 
+static inline uint64_t load_elem(const void *buf, size_t elemsz, size_t i,
+                                 bool sign)
+{
+   if (sign) {
+      switch (elemsz) {
+      case 1: return ((const int8_t *)buf)[i];
+      case 2: return ((const int16_t *)buf)[i];
+      case 4: return ((const int32_t *)buf)[i];
+      default: return ((const int64_t *)buf)[i];
+      }
+   }
+   else {
+      switch (elemsz) {
+      case 1: return ((const uint8_t *)buf)[i];
+      case 2: return ((const uint16_t *)buf)[i];
+      case 4: return ((const uint32_t *)buf)[i];
+      default: return ((const uint64_t *)buf)[i];
+      }
+   }
+}
+
+static inline void store_elem(void *buf, size_t elemsz, size_t i, uint64_t v)
+{
+   switch (elemsz) {
+   case 1: ((uint8_t *)buf)[i] = v; break;
+   case 2: ((uint16_t *)buf)[i] = v; break;
+   case 4: ((uint32_t *)buf)[i] = v; break;
+   default: ((uint64_t *)buf)[i] = v; break;
+   }
+}
+
+size_t signal_width(rt_signal_t *s)
+{
+   return s->shared.size / s->nexus.size;
+}
+
+size_t signal_read_elems(rt_signal_t *s, void *buf, size_t elemsz,
+                         size_t max, bool sign)
+{
+   // Like signal_expand but the caller chooses the element size which
+   // allows a direct copy when it matches the signal representation
+   const size_t total = signal_width(s);
+   const size_t count = MIN(total, max);
+
+   if (count == 0)
+      return total;
+   else if (elemsz == s->nexus.size)
+      memcpy(buf, s->shared.data, count * elemsz);
+   else {
+      for (size_t i = 0; i < count; i++) {
+         const uint64_t value = load_elem(s->shared.data, s->nexus.size,
+                                          i, sign);
+         store_elem(buf, elemsz, i, value);
+      }
+   }
+
+   return total;
+}
+
 size_t signal_string(rt_signal_t *s, const char *map, char *buf, size_t max)
 {
    char *endp = buf + max;
@@ -812,6 +903,7 @@ static void run_process(rt_model_t *m, rt_proc_t *proc)
          istr(proc->name));
 
    model_thread_t *thread = model_thread(m);
+   thread->activations++;
 
    assert(!tlab_valid(thread->spare_tlab));
 
@@ -1849,7 +1941,9 @@ static void reset_coverage(rt_model_t *m)
    cover_count_tags(m->cover, &n_stmts, &n_branches, &n_toggles,
                     &n_expressions);
 
-   jit_alloc_cover_mem(m->jit, n_stmts, n_branches, n_toggles, n_expressions);
+   int32_t *mem = cover_map_live(m->cover, m->top);
+   jit_alloc_cover_mem(m->jit, n_stmts, n_branches, n_toggles,
+                       n_expressions, mem);
 
    fbuf_close(f, NULL);
 }
@@ -1870,6 +1964,8 @@ static void emit_coverage(rt_model_t *m)
       cover_dump_tags(m->cover, covdb, COV_DUMP_RUNTIME, cover_stmts,
                       cover_branches, cover_toggles, cover_expressions);
       fbuf_close(covdb, NULL);
+
+      cover_unmap_live(m->cover, m->top);
    }
 }
 
@@ -2272,6 +2368,9 @@ static void async_watch_callback(void *context, void *arg)
 
    MODEL_ENTRY(m);
    (*w->fn)(m->now, w->signal, w, w->user_data);
+
+   w->dirty_lo = UINT32_MAX;
+   w->dirty_hi = 0;
 }
 
 static void async_timeout_callback(void *context, void *arg)
@@ -2363,19 +2462,75 @@ static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj)
    set_pending(obj);
 }
 
+static inline bool watch_value_match(uint64_t mask, uint64_t value)
+{
+   return mask == 0 || (value < 64 && (mask & (UINT64_C(1) << value)));
+}
+
+static bool watch_filter_match(rt_watch_t *w, rt_nexus_t *n)
+{
+   // Evaluate the filter here rather than in the callback to avoid
+   // calling into foreign code for events the user is not interested in
+   const rt_watch_filter_t *f = &(w->filter);
+
+   const uint32_t base = n->offset / n->size;
+   const uint32_t lo = MAX(f->first, base);
+   const uint32_t hi = f->count == 0
+      ? base + n->width : MIN(f->first + f->count, base + n->width);
+
+   if (lo >= hi)
+      return false;
+   else if (f->from == 0 && f->to == 0)
+      return true;
+
+   const void *new = nexus_effective(n);
+   const void *old = nexus_last_value(n);
+
+#define WATCH_FILTER_EDGE(type) do {                                    \
+      const type *np = new, *op = old;                                  \
+      for (uint32_t i = lo - base; i < hi - base; i++) {                \
+         if (np[i] != op[i] && watch_value_match(f->to, np[i])          \
+             && watch_value_match(f->from, op[i]))                      \
+            return true;                                                \
+      }                                                                 \
+   } while (0)
+
+   FOR_ALL_SIZES(n->size, WATCH_FILTER_EDGE);
+
+   return false;
+}
+
+static void wakeup_nexus(rt_model_t *m, rt_nexus_t *n, rt_wakeable_t *obj)
+{
+   if (obj->kind == W_WATCH) {
+      // Value change callbacks only need to examine the part of the
+      // signal that changed which may accumulate over several deltas
+      // for postponed callbacks
+      rt_watch_t *w = container_of(obj, rt_watch_t, wakeable);
+      if (w->filtered && !watch_filter_match(w, n))
+         return;
+
+      w->dirty_lo = MIN(w->dirty_lo, n->offset);
+      w->dirty_hi = MAX(w->dirty_hi, n->offset + n->width * n->size);
+   }
+
+   wakeup_one(m, obj);
+}
+
 static void notify_event(rt_model_t *m, rt_nexus_t *nexus)
 {
    nexus->last_event = m->now;
+   model_thread(m)->events++;
 
    if (pointer_tag(nexus->pending) == 1) {
       rt_wakeable_t *wake = untag_pointer(nexus->pending, rt_wakeable_t);
-      wakeup_one(m, wake);
+      wakeup_nexus(m, nexus, wake);
    }
    else if (nexus->pending != NULL) {
       rt_pending_t *p = untag_pointer(nexus->pending, rt_pending_t);
       for (int i = 0; i < p->count; i++) {
          if (p->wake[i] != NULL)
-            wakeup_one(m, p->wake[i]);
+            wakeup_nexus(m, nexus, p->wake[i]);
       }
    }
 }
@@ -2765,38 +2920,46 @@ static inline void check_reject_limit(rt_signal_t *s, uint64_t after,
               trace_time(reject), trace_time(after));
 }
 
-bool force_signal(rt_signal_t *s, const uint64_t *buf, size_t count)
+bool force_signal_elems(rt_signal_t *s, const void *buf, size_t elemsz,
+                        size_t count, bool sign)
 {
    RT_LOCK(s->lock);
 
-   TRACE("force signal %s to %"PRIu64"%s",
-         istr(tree_ident(s->where)), buf[0], count > 1 ? "..." : "");
+   TRACE("force signal %s to %"PRIu64"%s", istr(tree_ident(s->where)),
+         load_elem(buf, elemsz, 0, sign), count > 1 ? "..." : "");
 
    rt_model_t *m = get_model();
    assert(m->can_create_delta);
 
-   int offset = 0;
+   size_t offset = 0;
    rt_nexus_t *n = split_nexus(m, s, offset, count);
-   for (; count > 0; n = n->chain) {
+   for (; offset < count; n = n->chain) {
       n->flags |= NET_F_FORCED;
 
       rt_source_t *src = get_forcing_source(m, n);
+      void *dp = value_ptr(n, &(src->u.forcing));
 
-#define SIGNAL_FORCE_EXPAND_U64(type) do {                              \
-         type *dp = (type *)value_ptr(n, &(src->u.forcing));            \
-         for (int i = 0; (i < n->width) && (offset + i < count); i++)   \
-            dp[i] = buf[offset + i];                                    \
-      } while (0)
-
-      FOR_ALL_SIZES(n->size, SIGNAL_FORCE_EXPAND_U64);
+      const size_t width = MIN(n->width, count - offset);
+      if (elemsz == n->size)
+         memcpy(dp, (const uint8_t *)buf + offset * elemsz, width * elemsz);
+      else {
+         for (size_t i = 0; i < width; i++) {
+            const uint64_t value = load_elem(buf, elemsz, offset + i, sign);
+            store_elem(dp, n->size, i, value);
+         }
+      }
 
       deltaq_insert_force_release(m, n);
 
       offset += n->width;
-      count -= n->width;
    }
 
-   return (offset == count);
+   return true;
+}
+
+bool force_signal(rt_signal_t *s, const uint64_t *buf, size_t count)
+{
+   return force_signal_elems(s, buf, sizeof(uint64_t), count, false);
 }
 
 bool model_can_create_delta(rt_model_t *m)
@@ -2844,6 +3007,55 @@ void model_set_timeout_cb(rt_model_t *m, uint64_t when, rt_event_fn_t fn,
    heap_insert(m->eventq_heap, m->now + when, e);
 }
 
+static rt_watch_t *new_watch(rt_model_t *m, rt_signal_t *s, sig_event_fn_t fn,
+                             void *user, bool postponed,
+                             const rt_watch_filter_t *filter)
+{
+   rt_watch_t *w = xcalloc(sizeof(rt_watch_t));
+   w->signal    = s;
+   w->fn        = fn;
+   w->chain_all = m->watches;
+   w->user_data = user;
+   w->dirty_lo  = UINT32_MAX;
+   w->dirty_hi  = 0;
+
+   if (filter != NULL) {
+      w->filtered = true;
+      w->filter   = *filter;
+   }
+
+   w->wakeable.kind      = W_WATCH;
+   w->wakeable.postponed = postponed;
+   w->wakeable.pending   = false;
+   w->wakeable.delayed   = false;
+
+   m->watches = w;
+
+   rt_nexus_t *n = &(w->signal->nexus);
+   for (int i = 0; i < s->n_nexus; i++, n = n->chain) {
+      if (filter != NULL && filter->count > 0) {
+         // Only nexuses overlapping the watched range need an event
+         const uint32_t base = n->offset / n->size;
+         if (base >= filter->first + filter->count
+             || base + n->width <= filter->first)
+            continue;
+      }
+
+      sched_event(m, n, &(w->wakeable));
+   }
+
+   return w;
+}
+
+rt_watch_t *model_set_filtered_event_cb(rt_model_t *m, rt_signal_t *s,
+                                        sig_event_fn_t fn, void *user,
+                                        bool postponed,
+                                        const rt_watch_filter_t *filter)
+{
+   assert(fn != NULL);
+   return new_watch(m, s, fn, user, postponed, filter);
+}
+
 rt_watch_t *model_set_event_cb(rt_model_t *m, rt_signal_t *s, sig_event_fn_t fn,
                                void *user, bool postponed)
 {
@@ -2858,26 +3070,17 @@ rt_watch_t *model_set_event_cb(rt_model_t *m, rt_signal_t *s, sig_event_fn_t fn,
 
       return NULL;
    }
-   else {
-      rt_watch_t *w = xcalloc(sizeof(rt_watch_t));
-      w->signal    = s;
-      w->fn        = fn;
-      w->chain_all = m->watches;
-      w->user_data = user;
-
-      w->wakeable.kind      = W_WATCH;
-      w->wakeable.postponed = postponed;
-      w->wakeable.pending   = false;
-      w->wakeable.delayed   = false;
-
-      m->watches = w;
-
-      rt_nexus_t *n = &(w->signal->nexus);
-      for (int i = 0; i < s->n_nexus; i++, n = n->chain)
-         sched_event(m, n, &(w->wakeable));
+   else
+      return new_watch(m, s, fn, user, postponed, NULL);
+}
 
-      return w;
-   }
+void model_clear_event_cb(rt_model_t *m, rt_watch_t *w)
+{
+   // Stop the callback being scheduled again: this may be called from
+   // inside the callback itself
+   rt_nexus_t *n = &(w->signal->nexus);
+   for (int i = 0; i < w->signal->n_nexus; i++, n = n->chain)
+      clear_event(m, n, &(w->wakeable));
 }
 
 void model_interrupt(rt_model_t *m)
@@ -35,6 +35,11 @@ void model_set_global_cb(rt_model_t *m, rt_event_t event, rt_event_fn_t fn,
                          void *user);
 rt_watch_t *model_set_event_cb(rt_model_t *m, rt_signal_t *s, sig_event_fn_t fn,
                                void *user, bool postponed);
+rt_watch_t *model_set_filtered_event_cb(rt_model_t *m, rt_signal_t *s,
+                                        sig_event_fn_t fn, void *user,
+                                        bool postponed,
+                                        const rt_watch_filter_t *filter);
+void model_clear_event_cb(rt_model_t *m, rt_watch_t *w);
 void model_set_timeout_cb(rt_model_t *m, uint64_t when, rt_event_fn_t fn,
                           void *user);
 
@@ -51,7 +56,12 @@ rt_proc_t *find_proc(rt_scope_t *scope, tree_t proc);
 const void *signal_value(rt_signal_t *s);
 const void *signal_last_value(rt_signal_t *s);
 size_t signal_expand(rt_signal_t *s, uint64_t *buf, size_t max);
+size_t signal_width(rt_signal_t *s);
+size_t signal_read_elems(rt_signal_t *s, void *buf, size_t elemsz,
+                         size_t max, bool sign);
 size_t signal_string(rt_signal_t *s, const char *map, char *buf, size_t max);
 bool force_signal(rt_signal_t *s, const uint64_t *buf, size_t count);
+bool force_signal_elems(rt_signal_t *s, const void *buf, size_t elemsz,
+                        size_t count, bool sign);
 
 #endif  // _RT_MODEL_H
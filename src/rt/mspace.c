@@ -25,6 +25,8 @@
 #include "thread.h"
 
 #include <assert.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -39,9 +41,34 @@
 #define MSPACE_UNPOISON(addr, size)
 #endif
 
-#define LINE_SIZE  32
+#define LINE_SIZE  ((size_t)32)
 #define LINE_WORDS (LINE_SIZE / sizeof(intptr_t))
 
+// Use the helper threads for marking if the heap has at least this
+// many lines
+#define PARALLEL_MARK_LINES 32768
+
+#define MAX_STEAL  256
+#define MARK_SPINS 32
+
+// Free chunks of up to this many lines are kept in a list per exact
+// size and larger chunks in a list per power of two
+#define EXACT_BINS 31
+#define NUM_BINS   (EXACT_BINS + 27)
+
+// Objects of up to this many lines are allocated from a per-thread
+// cache which is refilled in batches under the lock
+#define CACHE_CLASSES 8
+#define CACHE_BATCH   16
+
+// Grow the heap if it is more than this percent occupied after a
+// collection, in steps that are a multiple of GROW_ALIGN bytes
+#define GROW_OCCUPANCY 50
+#define GROW_ALIGN     (2 * 1024 * 1024)
+
+// Never reserve more lines than can be addressed with an int
+#define MAX_LINES (1 << 30)
+
 typedef A(uint64_t)     work_list_t;
 
 struct _mptr {
@@ -53,9 +80,20 @@ struct _mptr {
 #endif
 };
 
+// The mark queues use plain mutexes rather than nvc_lock_t as a waiter
+// on the latter may park itself using a parking bay mutex which could
+// be held by one of the suspended mutator threads
 typedef struct {
-   bit_mask_t  markmask;
-   work_list_t worklist;
+   pthread_mutex_t mutex;
+   work_list_t     worklist;
+} mark_queue_t;
+
+typedef struct {
+   mspace_t     *mspace;
+   bit_mask_t    markmask;
+   int           nqueues;
+   int           idle;
+   mark_queue_t  queues[0];
 } gc_state_t;
 
 typedef struct _free_list free_list_t;
@@ -66,18 +104,33 @@ struct _free_list {
    size_t       size;
 };
 
+typedef struct {
+   int   busy;
+   int   count[CACHE_CLASSES];
+   char *chunks[CACHE_CLASSES][CACHE_BATCH];
+} alloc_cache_t;
+
 struct _mspace {
    nvc_lock_t       lock;
    size_t           maxsize;
    unsigned         maxlines;
+   size_t           softlimit;
+   size_t           reserved;
+   bool             growable;
+   bool             limited;
+   unsigned         highwater;
+   unsigned         growths;
    char            *space;
    bit_mask_t       headmask;
    mptr_t           roots;
    mptr_t           free_mptrs;
    mspace_oom_fn_t  oomfn;
-   free_list_t     *free_list;
+   free_list_t     *bins[NUM_BINS];
+   uint64_t         binmask;
+   alloc_cache_t   *caches[MAX_THREADS];
    uint64_t         create_us;
    unsigned         total_gc;
+   unsigned         max_pause;
    unsigned         num_cycles;
 #ifdef DEBUG
    bool             stress;
@@ -86,18 +139,66 @@ struct _mspace {
 
 static intptr_t *stack_limit[MAX_THREADS];
 
-static void mspace_gc(mspace_t *m);
+static void mspace_gc(mspace_t *m, size_t request, bool force);
 static bool is_mspace_ptr(mspace_t *m, char *p);
 
-mspace_t *mspace_new(size_t size)
+static inline int mspace_bin(int nlines)
+{
+   if (nlines <= EXACT_BINS)
+      return nlines - 1;
+   else
+      return EXACT_BINS + (63 - __builtin_clzll(nlines)) - 5;
+}
+
+static void mspace_add_free(mspace_t *m, free_list_t *f)
+{
+   assert(f->size % LINE_SIZE == 0);
+
+   const int bin = mspace_bin(f->size / LINE_SIZE);
+   assert(bin < NUM_BINS);
+
+   f->next = m->bins[bin];
+   m->bins[bin] = f;
+   m->binmask |= UINT64_C(1) << bin;
+}
+
+static mspace_t *mspace_create(size_t initial, size_t limit, size_t reserve)
 {
    mspace_t *m = xcalloc(sizeof(mspace_t));
-   m->maxsize  = ALIGN_UP(size, LINE_SIZE);
-   m->maxlines = m->maxsize / LINE_SIZE;
+   m->maxsize   = ALIGN_UP(initial, LINE_SIZE);
+   m->maxlines  = m->maxsize / LINE_SIZE;
+   m->softlimit = MAX(ALIGN_UP(limit, LINE_SIZE), m->maxsize);
+   m->reserved  = MIN(MAX(ALIGN_UP(reserve, LINE_SIZE), m->softlimit),
+                      (size_t)MAX_LINES * LINE_SIZE);
 
    DEBUG_ONLY(m->stress = opt_get_int(OPT_GC_STRESS));
 
-   m->space = map_huge_pages(LINE_SIZE, m->maxsize);
+   if (m->reserved > m->maxsize) {
+      // The reservation only takes address space but that may be
+      // restricted with ulimit -v so try successively smaller sizes
+      // which also lowers the hard limit
+      while (!(m->space = nvc_try_reserve(LINE_SIZE, m->reserved))) {
+         const size_t half = ALIGN_UP(m->reserved / 2, LINE_SIZE);
+         if (half <= m->maxsize)
+            break;
+
+         m->reserved = half;
+         m->limited  = true;
+      }
+
+      if (m->space != NULL) {
+         nvc_commit(m->space, m->maxsize);
+         m->growable  = true;
+         m->softlimit = MIN(m->softlimit, m->reserved);
+      }
+      else {
+         m->reserved = m->maxsize;
+         m->limited  = true;
+      }
+   }
+
+   if (m->space == NULL)
+      m->space = map_huge_pages(LINE_SIZE, m->maxsize);
 
    MSPACE_POISON(m->space, m->maxsize);
 
@@ -105,16 +206,29 @@ mspace_t *mspace_new(size_t size)
    mask_setall(&(m->headmask));
 
    free_list_t *f = xmalloc(sizeof(free_list_t));
-   f->next = NULL;
    f->ptr  = m->space;
    f->size = m->maxsize;
 
-   m->free_list = f;
+   mspace_add_free(m, f);
 
    m->create_us = get_timestamp_us();
    return m;
 }
 
+mspace_t *mspace_new(size_t size)
+{
+   return mspace_create(size, size, size);
+}
+
+mspace_t *mspace_new_growable(size_t initial, size_t limit)
+{
+   // The heap can grow past the soft limit if an allocation cannot be
+   // satisfied after a full collection, up to the reserved size
+   const size_t reserve = sizeof(void *) == 8 ? limit * 4 : limit;
+
+   return mspace_create(initial, limit, reserve);
+}
+
 void mspace_destroy(mspace_t *m)
 {
 #ifdef DEBUG
@@ -130,22 +244,32 @@ void mspace_destroy(mspace_t *m)
    if (opt_get_verbose(OPT_GC_VERBOSE, NULL) && m->num_cycles > 0) {
       const uint64_t destroy_us = get_timestamp_us();
       const double gc_frac = m->total_gc / (double)(destroy_us - m->create_us);
-      debugf("GC: %d collection cycles; %d us total; %.1f%% of overall "
-             "run time", m->num_cycles, m->total_gc, gc_frac * 100.0);
+      debugf("GC: %d collection cycles; %d us total; %d us longest pause; "
+             "%.1f%% of overall run time", m->num_cycles, m->total_gc,
+             m->max_pause, gc_frac * 100.0);
    }
 
-   for (free_list_t *it = m->free_list, *tmp; it; it = tmp) {
-      tmp = it->next;
-      free(it);
+   for (int i = 0; i < NUM_BINS; i++) {
+      for (free_list_t *it = m->bins[i], *tmp; it; it = tmp) {
+         tmp = it->next;
+         free(it);
+      }
    }
 
+   for (int i = 0; i < MAX_THREADS; i++)
+      free(m->caches[i]);
+
    for (mptr_t p = m->free_mptrs, tmp; p; p = tmp) {
       tmp = p->next;
       free(p);
    }
 
    mask_free(&(m->headmask));
-   nvc_munmap(m->space, m->maxsize);
+   if (m->growable)
+      nvc_release(m->space, m->reserved);
+   else
+      nvc_munmap(m->space, m->maxsize);
+
    free(m);
 }
 
@@ -155,47 +279,132 @@ void mspace_stack_limit(void *limit)
    atomic_store(&(stack_limit[thread_id()]), limit);
 }
 
-static void *mspace_try_alloc(mspace_t *m, size_t size)
+static char *mspace_take(mspace_t *m, int nlines)
 {
-   // Add one to size before rounding up to LINE_SIZE to allow a valid
-   // pointer to point at one element past the end of an array
-   const int nlines = (size + LINE_SIZE) / LINE_SIZE;
+   // Must be called with the lock held
    const size_t asize = nlines * LINE_SIZE;
 
-   SCOPED_LOCK(m->lock);
+   int bin = mspace_bin(nlines);
+   free_list_t **it = NULL;
+   if (bin >= EXACT_BINS) {
+      // Chunks in the same power-of-two bin may still be too small
+      for (it = &(m->bins[bin]); *it; it = &((*it)->next)) {
+         if ((*it)->size >= asize)
+            break;
+      }
+
+      if (*it == NULL) {
+         it = NULL;
+         bin++;
+      }
+   }
+
+   if (it == NULL) {
+      // Any chunk in a larger bin is big enough
+      const uint64_t avail = m->binmask & ~((UINT64_C(1) << bin) - 1);
+      if (avail == 0)
+         return NULL;
+
+      bin = __builtin_ctzll(avail);
+      it = &(m->bins[bin]);
+   }
+
+   free_list_t *f = *it;
+   *it = f->next;
 
-   for (free_list_t **it = &(m->free_list); *it; it = &((*it)->next)) {
-      assert((*it)->size % LINE_SIZE == 0);
-      if ((*it)->size >= asize) {
-         char *base = (*it)->ptr;
-         assert((uintptr_t)base % LINE_SIZE == 0);
+   if (m->bins[bin] == NULL)
+      m->binmask &= ~(UINT64_C(1) << bin);
 
-         MSPACE_UNPOISON(base, size);
+   char *base = f->ptr;
+   assert((uintptr_t)base % LINE_SIZE == 0);
 
+   if (f->size == asize)
+      free(f);
+   else {
+      f->size -= asize;
+      f->ptr += asize;
+      mspace_add_free(m, f);
+   }
+
+   const int line = (base - m->space) / LINE_SIZE;
+   mask_set(&(m->headmask), line);
+   if (nlines > 1)
+      mask_clear_range(&(m->headmask), line + 1, nlines - 1);
+
+   m->highwater = MAX(m->highwater, line + nlines);
+
+   return base;
+}
+
+static char *mspace_cache_alloc(mspace_t *m, int nlines)
+{
+   alloc_cache_t *c = m->caches[thread_id()];
+   if (unlikely(c == NULL)) {
+      c = xcalloc(sizeof(alloc_cache_t));
+      atomic_store(&(m->caches[thread_id()]), c);
+   }
+
+   // The garbage collector treats the cached chunks as roots while
+   // this flag is set and otherwise discards them
+   relaxed_store(&(c->busy), 1);
+   __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+   const int cls = nlines - 1;
+   if (c->count[cls] == 0) {
+      SCOPED_LOCK(m->lock);
+
+      for (int n = CACHE_BATCH; n > 0; n /= 2) {
+         char *base = mspace_take(m, n * nlines);
+         if (base == NULL)
+            continue;
+
+         // Split the block into individual objects
          const int line = (base - m->space) / LINE_SIZE;
-         mask_set(&(m->headmask), line);
-         if (nlines > 1)
-            mask_clear_range(&(m->headmask), line + 1, nlines - 1);
-
-         if ((*it)->size == asize) {
-            free_list_t *next = (*it)->next;
-            free(*it);
-            *it = next;
-         }
-         else {
-            (*it)->size -= asize;
-            (*it)->ptr += asize;
+         for (int i = n - 1; i >= 0; i--) {
+            mask_set(&(m->headmask), line + i * nlines);
+            c->chunks[cls][c->count[cls]++] = base + i * nlines * LINE_SIZE;
          }
+         break;
+      }
+   }
 
-         // Make sure the first fault to the page is a write to
-         // allocate THP on Linux
-         *(volatile char *)base = 0;
+   char *base = NULL;
+   if (c->count[cls] > 0) {
+      base = c->chunks[cls][c->count[cls] - 1];
+      __atomic_signal_fence(__ATOMIC_SEQ_CST);
+      c->count[cls]--;
+   }
 
-         return base;
-      }
+   __atomic_signal_fence(__ATOMIC_SEQ_CST);
+   relaxed_store(&(c->busy), 0);
+
+   return base;
+}
+
+static void *mspace_try_alloc(mspace_t *m, size_t size)
+{
+   // Add one to size before rounding up to LINE_SIZE to allow a valid
+   // pointer to point at one element past the end of an array
+   const int nlines = (size + LINE_SIZE) / LINE_SIZE;
+
+   char *base;
+   if (nlines <= CACHE_CLASSES)
+      base = mspace_cache_alloc(m, nlines);
+   else {
+      SCOPED_LOCK(m->lock);
+      base = mspace_take(m, nlines);
    }
 
-   return NULL;
+   if (base == NULL)
+      return NULL;
+
+   MSPACE_UNPOISON(base, size);
+
+   // Make sure the first fault to the page is a write to allocate THP
+   // on Linux
+   *(volatile char *)base = 0;
+
+   return base;
 }
 
 void *mspace_alloc(mspace_t *m, size_t size)
@@ -207,7 +416,7 @@ void *mspace_alloc(mspace_t *m, size_t size)
    if (stack_limit[thread_id()] == NULL)
       fatal_trace("cannot allocate without setting stack limit");
    else if (m->stress)
-      mspace_gc(m);
+      mspace_gc(m, 0, false);
 #endif
 
    int retry = 1;
@@ -216,9 +425,14 @@ void *mspace_alloc(mspace_t *m, size_t size)
       if (ptr != NULL)
          return ptr;
 
-      mspace_gc(m);
+      // The second collection may grow the heap beyond the soft limit
+      mspace_gc(m, size, retry == 0);
    } while (retry--);
 
+   void *ptr = mspace_try_alloc(m, size);
+   if (ptr != NULL)
+      return ptr;
+
    if (m->oomfn) {
       (*m->oomfn)(m, size);
       return NULL;
@@ -234,33 +448,17 @@ static void mspace_return_memory(mspace_t *m, char *ptr, size_t size)
 
    // Same rounding-up as mspace_alloc
    const int nlines = (size + LINE_SIZE) / LINE_SIZE;
-   const size_t asize = nlines * LINE_SIZE;
 
-   free_list_t **tail;
-   for (tail = &(m->free_list); *tail; tail = &((*tail)->next)) {
-      if ((*tail)->ptr + (*tail)->size == ptr) {
-         // Coalese after this block
-         (*tail)->size += asize;
-         break;
-      }
-      else if (ptr + asize == (*tail)->ptr) {
-         // Coalese before this block
-         (*tail)->ptr = ptr;
-         (*tail)->size += asize;
-         break;
-      }
-   }
+   MSPACE_POISON(ptr, nlines * LINE_SIZE);
 
-   if (*tail == NULL) {
-      free_list_t *f = xmalloc(sizeof(free_list_t));
-      f->next = NULL;
-      f->size = asize;
-      f->ptr  = ptr;
+   SCOPED_LOCK(m->lock);
 
-      *tail = f;
-   }
+   // Adjacent free chunks are coalesced by the next GC
+   free_list_t *f = xmalloc(sizeof(free_list_t));
+   f->ptr  = ptr;
+   f->size = nlines * LINE_SIZE;
 
-   MSPACE_POISON(ptr, asize);
+   mspace_add_free(m, f);
 
    int line = (ptr - m->space) / LINE_SIZE;
    mask_set_range(&(m->headmask), line, nlines);
@@ -281,6 +479,21 @@ void mspace_set_oom_handler(mspace_t *m, mspace_oom_fn_t fn)
    m->oomfn = fn;
 }
 
+void mspace_get_stats(mspace_t *m, mspace_stats_t *stats)
+{
+   SCOPED_LOCK(m->lock);
+
+   stats->heap_size   = m->maxsize;
+   stats->peak_size   = (size_t)m->highwater * LINE_SIZE;
+   stats->soft_limit  = m->softlimit;
+   stats->reserved    = MAX(m->reserved, m->maxsize);
+   stats->limited     = m->limited;
+   stats->growths     = m->growths;
+   stats->collections = m->num_cycles;
+   stats->gc_us       = m->total_gc;
+   stats->max_pause   = m->max_pause;
+}
+
 mptr_t mptr_new(mspace_t *m, const char *name)
 {
    SCOPED_LOCK(m->lock);
@@ -385,7 +598,46 @@ static bool is_mspace_ptr(mspace_t *m, char *p)
    return p >= m->space && p < m->space + m->maxsize;
 }
 
-static void mspace_mark_root(mspace_t *m, intptr_t p, gc_state_t *state)
+static bool mspace_mark_claim(bit_mask_t *mask, int line, int objlen)
+{
+   // Atomically set the mark bit for the first line of the object and
+   // fail if another thread has already done so: the remaining bits
+   // belong only to this object but may share a word with others
+
+   uint64_t *words = mask->size > 64 ? mask->ptr : &(mask->bits);
+
+   const uint64_t head = UINT64_C(1) << (line % 64);
+   if (relaxed_load(&(words[line / 64])) & head)
+      return false;
+   else if (__atomic_fetch_or(&(words[line / 64]), head, __ATOMIC_RELAXED)
+            & head)
+      return false;
+
+   for (int i = line + 1; i < line + objlen;) {
+      const int first = i % 64;
+      const int n = MIN(64 - first, line + objlen - i);
+      const uint64_t bits = (n == 64 ? ~UINT64_C(0) : (UINT64_C(1) << n) - 1);
+      __atomic_fetch_or(&(words[i / 64]), bits << first, __ATOMIC_RELAXED);
+      i += n;
+   }
+
+   return true;
+}
+
+static void mark_queue_lock(mark_queue_t *queue)
+{
+   if (unlikely(pthread_mutex_lock(&(queue->mutex)) != 0))
+      fatal_errno("pthread_mutex_lock");
+}
+
+static void mark_queue_unlock(mark_queue_t *queue)
+{
+   if (unlikely(pthread_mutex_unlock(&(queue->mutex)) != 0))
+      fatal_errno("pthread_mutex_unlock");
+}
+
+static void mspace_mark_root(mspace_t *m, intptr_t p, gc_state_t *state,
+                             mark_queue_t *queue)
 {
    if (is_mspace_ptr(m, (char *)p)) {
       int line = ((char *)p - m->space) / LINE_SIZE;
@@ -398,11 +650,16 @@ static void mspace_mark_root(mspace_t *m, intptr_t p, gc_state_t *state)
       if (line + 1 < m->maxlines)
          objlen += mask_count_clear(&(m->headmask), line + 1);
 
-      if (!mask_test(&(state->markmask), line)) {
-         mask_set_range(&(state->markmask), line, objlen);
-
+      if (mspace_mark_claim(&(state->markmask), line, objlen)) {
          uint64_t enc = ((uint64_t)line << 32) | objlen;
-         APUSH(state->worklist, enc);
+
+         if (state->nqueues == 1)
+            APUSH(queue->worklist, enc);
+         else {
+            mark_queue_lock(queue);
+            APUSH(queue->worklist, enc);
+            mark_queue_unlock(queue);
+         }
       }
    }
 }
@@ -414,7 +671,95 @@ static void mspace_mark_mptr(mspace_t *m, mptr_t ptr, gc_state_t *state)
       fatal_trace("mptr %s points to unknown address %p", ptr->name, ptr->ptr);
 #endif
 
-   mspace_mark_root(m, (intptr_t)ptr->ptr, state);
+   mspace_mark_root(m, (intptr_t)ptr->ptr, state, &(state->queues[0]));
+}
+
+static bool mspace_mark_pop(gc_state_t *state, mark_queue_t *queue,
+                            uint64_t *enc)
+{
+   if (state->nqueues > 1)
+      mark_queue_lock(queue);
+
+   const bool found = queue->worklist.count > 0;
+   if (found)
+      *enc = APOP(queue->worklist);
+
+   if (state->nqueues > 1)
+      mark_queue_unlock(queue);
+
+   return found;
+}
+
+static bool mspace_mark_steal(gc_state_t *state, int thief)
+{
+   for (int i = 1; i < state->nqueues; i++) {
+      mark_queue_t *victim = &(state->queues[(thief + i) % state->nqueues]);
+
+      if (relaxed_load(&(victim->worklist.count)) == 0)
+         continue;
+
+      uint64_t stolen[MAX_STEAL];
+      mark_queue_lock(victim);
+
+      const int nstolen = MIN((victim->worklist.count + 1) / 2, MAX_STEAL);
+      victim->worklist.count -= nstolen;
+      memcpy(stolen, victim->worklist.items + victim->worklist.count,
+             nstolen * sizeof(uint64_t));
+
+      mark_queue_unlock(victim);
+
+      if (nstolen > 0) {
+         mark_queue_t *queue = &(state->queues[thief]);
+
+         mark_queue_lock(queue);
+         for (int j = 0; j < nstolen; j++)
+            APUSH(queue->worklist, stolen[j]);
+         mark_queue_unlock(queue);
+
+         return true;
+      }
+   }
+
+   return false;
+}
+
+__attribute__((no_sanitize_address))
+static void mspace_mark_task(int index, void *arg)
+{
+   gc_state_t *state = arg;
+   mspace_t *m = state->mspace;
+   mark_queue_t *queue = &(state->queues[index]);
+
+   for (;;) {
+      uint64_t enc;
+      while (mspace_mark_pop(state, queue, &enc)) {
+         const int line = enc >> 32;
+         const int objlen = enc & 0xffffffff;
+
+         for (int i = 0; i < objlen; i++) {
+            intptr_t *words = (intptr_t *)(m->space + (line + i) * LINE_SIZE);
+            for (int j = 0; j < LINE_WORDS; j++)
+               mspace_mark_root(m, words[j], state, queue);
+         }
+      }
+
+      // Marking is complete once every thread is idle as work is only
+      // ever added by a thread that is not idle
+      atomic_add(&(state->idle), 1);
+
+      for (int spins = 0;; spins++) {
+         if (mspace_mark_steal(state, index)) {
+            atomic_add(&(state->idle), -1);
+            break;
+         }
+         else if (atomic_load(&(state->idle)) == state->nqueues)
+            return;
+         else if (spins < MARK_SPINS)
+            spin_wait();
+         else
+            sched_yield();
+      }
+   }
 }
 
 static void mspace_suspend_cb(int thread_id, struct cpu_state *cpu, void *arg)
@@ -424,8 +769,47 @@ static void mspace_suspend_cb(int thread_id, struct cpu_state *cpu, void *arg)
    array[thread_id] = *cpu;
 }
 
+static void mspace_grow(mspace_t *m, gc_state_t *state, size_t request,
+                        bool force)
+{
+   if (!m->growable || m->reserved <= m->maxsize)
+      return;
+
+   const size_t live = mask_popcount(&(state->markmask));
+   const size_t reqlines = request > 0 ? (request + LINE_SIZE) / LINE_SIZE : 0;
+   const size_t need = (live + reqlines) * LINE_SIZE;
+
+   size_t newsize = m->maxsize;
+   while (newsize < m->softlimit && need * 100 > newsize * GROW_OCCUPANCY)
+      newsize *= 2;
+
+   newsize = MIN(newsize, m->softlimit);
+
+   if (force) {
+      // Ensure the request fits in the newly committed space even if
+      // the rest of the heap is fragmented
+      newsize = MAX(newsize, m->maxsize + reqlines * LINE_SIZE);
+   }
+
+   if (newsize <= m->maxsize)
+      return;
+
+   newsize = MIN(ALIGN_UP(newsize, GROW_ALIGN), m->reserved);
+
+   nvc_commit(m->space + m->maxsize, newsize - m->maxsize);
+   MSPACE_POISON(m->space + m->maxsize, newsize - m->maxsize);
+
+   m->maxsize  = newsize;
+   m->maxlines = newsize / LINE_SIZE;
+   m->growths++;
+
+   // New lines are unmarked and so become free in the sweep
+   mask_resize(&(m->headmask), m->maxlines);
+   mask_resize(&(state->markmask), m->maxlines);
+}
+
 __attribute__((no_sanitize_address, noinline))
-static void mspace_gc(mspace_t *m)
+static void mspace_gc(mspace_t *m, size_t request, bool force)
 {
    const uint64_t start_ticks = get_timestamp_us();
 
@@ -438,9 +822,6 @@ static void mspace_gc(mspace_t *m)
    return;   // Cannot reliably suspend threads with tsan
 #endif
 
-   gc_state_t state = {};
-   mask_init(&(state.markmask), m->maxlines);
-
    struct cpu_state *cpu LOCAL =
       xcalloc_array(MAX_THREADS, sizeof(struct cpu_state));
 
@@ -448,6 +829,21 @@ static void mspace_gc(mspace_t *m)
 
    stop_world(mspace_suspend_cb, cpu);
 
+   const int nqueues =
+      m->maxlines >= PARALLEL_MARK_LINES ? stop_world_concurrency() : 1;
+
+   gc_state_t *state LOCAL =
+      xcalloc_flex(sizeof(gc_state_t), nqueues, sizeof(mark_queue_t));
+   state->mspace  = m;
+   state->nqueues = nqueues;
+
+   for (int i = 0; i < nqueues; i++) {
+      if (pthread_mutex_init(&(state->queues[i].mutex), NULL) != 0)
+         fatal_errno("pthread_mutex_init");
+   }
+
+   mask_init(&(state->markmask), m->maxlines);
+
    for (int i = 0; i < MAX_THREADS; i++) {
       if (get_thread(i) == NULL)
          continue;
@@ -457,57 +853,84 @@ static void mspace_gc(mspace_t *m)
          continue;
 
       for (int j = 0; j < MAX_CPU_REGS; j++)
-         mspace_mark_root(m, cpu[i].regs[j], &state);
+         mspace_mark_root(m, cpu[i].regs[j], state, &(state->queues[0]));
 
       intptr_t *stack_top = (intptr_t *)cpu[i].sp;
       assert(stack_top <= limit);   // Stack must grow down
 
       for (intptr_t *p = stack_top; p < limit; p++)
-         mspace_mark_root(m, *p, &state);
+         mspace_mark_root(m, *p, state, &(state->queues[0]));
    }
 
    for (mptr_t p = m->roots; p; p = p->next)
-      mspace_mark_mptr(m, p, &state);
+      mspace_mark_mptr(m, p, state);
 
-   while (state.worklist.count > 0) {
-      const uint64_t enc = APOP(state.worklist);
-      const int line = enc >> 32;
-      const int objlen = enc & 0xffffffff;
-
-      for (int i = 0; i < objlen; i++) {
-         intptr_t *words = (intptr_t *)(m->space + (line + i) * LINE_SIZE);
-         for (int j = 0; j < LINE_WORDS; j++)
-            mspace_mark_root(m, words[j], &state);
+   for (int i = 0; i < MAX_THREADS; i++) {
+      alloc_cache_t *c = m->caches[i];
+      if (c == NULL)
+         continue;
+      else if (relaxed_load(&(c->busy))) {
+         // Interrupted while taking an object from the cache
+         for (int j = 0; j < CACHE_CLASSES; j++) {
+            for (int k = 0; k < c->count[j]; k++)
+               mspace_mark_root(m, (intptr_t)c->chunks[j][k], state,
+                                &(state->queues[0]));
+         }
+      }
+      else {
+         for (int j = 0; j < CACHE_CLASSES; j++)
+            c->count[j] = 0;
       }
    }
 
+   const uint64_t mark_start = get_timestamp_us();
+
+   if (nqueues > 1)
+      stop_world_run(mspace_mark_task, state);
+   else
+      mspace_mark_task(0, state);
+
+   const uint64_t mark_end = get_timestamp_us();
+
+   const size_t oldsize = m->maxsize;
+   mspace_grow(m, state, request, force);
+
 #if __SANITIZE_ADDRESS__
    for (int i = 0; i < m->maxlines; i++) {
-      if (!mask_test(&(state.markmask), i))
+      if (!mask_test(&(state->markmask), i))
          MSPACE_POISON(m->space + i * LINE_SIZE, LINE_SIZE);
    }
 #endif
 
-   for (free_list_t *it = m->free_list, *tmp; it; it = tmp) {
-      tmp = it->next;
-      free(it);
+   for (int i = 0; i < NUM_BINS; i++) {
+      for (free_list_t *it = m->bins[i], *tmp; it; it = tmp) {
+         tmp = it->next;
+         free(it);
+      }
+      m->bins[i] = NULL;
    }
-   m->free_list = NULL;
+   m->binmask = 0;
+
+   // Rebuild each bin in address order which reduces fragmentation
+   free_list_t **tails[NUM_BINS];
+   for (int i = 0; i < NUM_BINS; i++)
+      tails[i] = &(m->bins[i]);
 
    int freefrags = 0, freelines = 0;
-   free_list_t **tail = &(m->free_list);
    for (int line = 0; line < m->maxlines;) {
-      const int clear = mask_count_clear(&(state.markmask), line);
+      const int clear = mask_count_clear(&(state->markmask), line);
       if (clear == 0)
-         line++;
+         line += mask_count_set(&(state->markmask), line);
       else {
          free_list_t *f = xmalloc(sizeof(free_list_t));
          f->next = NULL;
          f->ptr  = m->space + line * LINE_SIZE;
          f->size = clear * LINE_SIZE;
 
-         *tail = f;
-         tail = &(f->next);
+         const int bin = mspace_bin(clear);
+         *tails[bin] = f;
+         tails[bin] = &(f->next);
+         m->binmask |= UINT64_C(1) << bin;
 
          mask_set_range(&(m->headmask), line, clear);
 
@@ -520,20 +943,33 @@ static void mspace_gc(mspace_t *m)
 
    start_world();
 
-   if (opt_get_verbose(OPT_GC_VERBOSE, NULL)) {
-      const int ticks = get_timestamp_us() - start_ticks;
-      debugf("GC: allocated %d/%zu; fragmentation %.2g%% [%d us]",
-             mask_popcount(&(state.markmask)) * LINE_SIZE, m->maxsize,
-             ((double)(freefrags - 1) / (double)freelines) * 100.0, ticks);
+   const int ticks = get_timestamp_us() - start_ticks;
+   m->total_gc += ticks;
+   m->max_pause = MAX(m->max_pause, ticks);
 
-      m->total_gc += ticks;
-      m->num_cycles++;
+   if (opt_get_verbose(OPT_GC_VERBOSE, NULL)) {
+      if (m->maxsize != oldsize)
+         debugf("GC: heap grown from %zu to %zu bytes%s", oldsize,
+                m->maxsize, m->maxsize > m->softlimit
+                ? " which exceeds the soft limit" : "");
+
+      debugf("GC: allocated %zu/%zu; fragmentation %.2g%%; marked in %d us "
+             "with %d thread%s [%d us]",
+             mask_popcount(&(state->markmask)) * LINE_SIZE, m->maxsize,
+             ((double)(freefrags - 1) / (double)freelines) * 100.0,
+             (int)(mark_end - mark_start), nqueues, nqueues > 1 ? "s" : "",
+             ticks);
    }
 
-   mask_free(&(state.markmask));
+   m->num_cycles++;
 
-   assert(state.worklist.count == 0);
-   ACLEAR(state.worklist);
+   mask_free(&(state->markmask));
+
+   for (int i = 0; i < nqueues; i++) {
+      assert(state->queues[i].worklist.count == 0);
+      ACLEAR(state->queues[i].worklist);
+      pthread_mutex_destroy(&(state->queues[i].mutex));
+   }
 }
 
 void *mspace_find(mspace_t *m, void *ptr, size_t *size)
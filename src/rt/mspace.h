@@ -25,6 +25,18 @@ typedef struct _mptr *mptr_t;
 
 typedef void (*mspace_oom_fn_t)(mspace_t *, size_t);
 
+typedef struct {
+   size_t   heap_size;
+   size_t   peak_size;
+   size_t   soft_limit;
+   size_t   reserved;
+   bool     limited;
+   unsigned growths;
+   unsigned collections;
+   unsigned gc_us;
+   unsigned max_pause;
+} mspace_stats_t;
+
 #define TLAB_SIZE (64 * 1024)
 
 // The code generator knows the layout of this struct
@@ -50,12 +62,14 @@ typedef struct _tlab {
    } while (0)
 
 mspace_t *mspace_new(size_t size);
+mspace_t *mspace_new_growable(size_t initial, size_t limit);
 void mspace_destroy(mspace_t *m);
 void *mspace_alloc(mspace_t *m, size_t size);
 void *mspace_alloc_array(mspace_t *m, int nelems, size_t size);
 void *mspace_alloc_flex(mspace_t *m, size_t fixed, int nelems, size_t size);
 void mspace_set_oom_handler(mspace_t *m, mspace_oom_fn_t fn);
 void *mspace_find(mspace_t *m, void *ptr, size_t *size);
+void mspace_get_stats(mspace_t *m, mspace_stats_t *stats);
 
 void tlab_acquire(mspace_t *m, tlab_t *t);
 void tlab_release(tlab_t *t);
@@ -41,6 +41,13 @@ typedef void (*sig_event_fn_t)(uint64_t now, rt_signal_t *signal,
                                rt_watch_t *watch, void *user);
 typedef void (*rt_event_fn_t)(rt_model_t *m, void *user);
 
+typedef struct {
+   uint64_t from;    // Mask of old values to match or zero for any
+   uint64_t to;      // Mask of new values to match or zero for any
+   uint32_t first;   // First element of the signal to watch
+   uint32_t count;   // Number of elements or zero for all
+} rt_watch_filter_t;
+
 typedef enum {
    OPEN_OK      = 0,
    STATUS_ERROR = 1,
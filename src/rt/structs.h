@@ -211,6 +211,10 @@ typedef struct _rt_watch {
    sig_event_fn_t  fn;
    rt_watch_t     *chain_all;
    void           *user_data;
+   uint32_t        dirty_lo;   // Byte range of the signal which changed
+   uint32_t        dirty_hi;   // since the last callback
+   bool            filtered;
+   rt_watch_filter_t filter;
 } rt_watch_t;
 
 
@@ -58,6 +58,7 @@ typedef struct {
    unsigned  count;
    unsigned  size;
    char     *strings;
+   unsigned *lengths;
 } fst_enum_t;
 
 typedef struct {
@@ -102,6 +103,7 @@ typedef struct _wave_dumper {
 
 static glob_array_t incl;
 static glob_array_t excl;
+static char         bit_strings[256][8];
 
 static void fst_process_signal(wave_dumper_t *wd, rt_scope_t *scope, tree_t d,
                                tree_t cons, text_buf_t *tb);
@@ -147,18 +149,57 @@ static void fst_close(rt_model_t *m, void *arg)
    wd->model   = NULL;
 }
 
+static void fst_dirty_range(rt_watch_t *w, unsigned stride, unsigned count,
+                            unsigned *lo, unsigned *hi)
+{
+   // Only the elements which changed since the last callback need to
+   // be emitted: the range is empty when dumping the initial value
+   if (w->dirty_lo >= w->dirty_hi) {
+      *lo = 0;
+      *hi = count;
+   }
+   else {
+      *lo = w->dirty_lo / stride;
+      *hi = MIN(count, (w->dirty_hi + stride - 1) / stride);
+   }
+}
+
+static void fst_init_bit_strings(void)
+{
+   if (bit_strings[0][0] != '\0')
+      return;
+
+   for (int i = 0; i < 256; i++) {
+      for (int j = 0; j < 8; j++)
+         bit_strings[i][7 - j] = (i & (1 << j)) ? '1' : '0';
+   }
+}
+
 static void fst_fmt_int(rt_watch_t *w, fst_data_t *data)
 {
-   uint64_t val[data->count];
-   signal_expand(data->signal, val, data->count);
+   const uint8_t *value = signal_value(data->signal);
+   const unsigned elemsz = data->signal->nexus.size;
+   const unsigned bits = data->type->size;
+   const unsigned nbytes = (bits + 7) / 8;
+
+   unsigned lo, hi;
+   fst_dirty_range(w, elemsz, data->count, &lo, &hi);
+
+   for (unsigned i = lo; i < hi; i++) {
+      uint64_t val;
+      switch (elemsz) {
+      case 1: val = value[i]; break;
+      case 2: val = ((const uint16_t *)value)[i]; break;
+      case 4: val = ((const uint32_t *)value)[i]; break;
+      default: val = ((const uint64_t *)value)[i]; break;
+      }
 
-   for (int i = 0; i < data->count; i++) {
-      char buf[data->type->size + 1];
-      for (size_t j = 0; j < data->type->size; j++)
-         buf[data->type->size - 1 - j] = (val[i] & (1 << j)) ? '1' : '0';
-      buf[data->type->size] = '\0';
+      char buf[64];
+      for (unsigned j = 0; j < nbytes; j++, val >>= 8)
+         memcpy(buf + (nbytes - 1 - j) * 8, bit_strings[val & 0xff], 8);
 
-      fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i], buf);
+      fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i],
+                               buf + nbytes * 8 - bits);
    }
 }
 
@@ -185,19 +226,93 @@ static void fst_fmt_physical(rt_watch_t *w, fst_data_t *data)
       data->dumper->fst_ctx, data->handle[0], buf, strlen(buf));
 }
 
+static void fst_fmt_bits(rt_watch_t *w, fst_data_t *data)
+{
+   const uint8_t *value = signal_value(data->signal);
+
+   unsigned lo, hi;
+   fst_dirty_range(w, data->size, data->count, &lo, &hi);
+
+   char buf[data->size];
+   for (unsigned i = lo; i < hi; i++) {
+      const uint8_t *p = value + i * data->size;
+
+      // Bit values are zero or one so eight can be converted to
+      // characters at once
+      unsigned j = 0;
+      for (; j + 8 <= data->size; j += 8) {
+         uint64_t word;
+         memcpy(&word, p + j, 8);
+         word += UINT64_C(0x3030303030303030);
+         memcpy(buf + j, &word, 8);
+      }
+
+      for (; j < data->size; j++)
+         buf[j] = '0' + p[j];
+
+      fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i], buf);
+   }
+}
+
 static void fst_fmt_chars(rt_watch_t *w, fst_data_t *data)
 {
-   const uint8_t *p = signal_value(data->signal);
-   for (int i = 0; i < data->count; i++, p += data->size) {
-      if (likely(data->type->u.map != NULL)) {
-         char buf[data->size];
-         for (int j = 0; j < data->size; j++)
-            buf[j] = data->type->u.map[p[j]];
+   const uint8_t *value = signal_value(data->signal);
+   const char *map = data->type->u.map;
+
+   unsigned lo, hi;
+   fst_dirty_range(w, data->size, data->count, &lo, &hi);
+
+   if (map == NULL) {
+      for (unsigned i = lo; i < hi; i++)
+         fstWriterEmitVariableLengthValueChange(
+            data->dumper->fst_ctx, data->handle[i],
+            value + i * data->size, data->size);
+   }
+   else {
+      char buf[data->size];
+      for (unsigned i = lo; i < hi; i++) {
+         const uint8_t *p = value + i * data->size;
+         for (unsigned j = 0; j < data->size; j++)
+            buf[j] = map[p[j]];
          fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i], buf);
       }
-      else
-         fstWriterEmitVariableLengthValueChange(
-            data->dumper->fst_ctx, data->handle[i], p, data->size);
+   }
+}
+
+static void fst_fmt_logic(rt_watch_t *w, fst_data_t *data)
+{
+   const uint8_t *value = signal_value(data->signal);
+   const char *map = data->type->u.map;
+
+   unsigned lo, hi;
+   fst_dirty_range(w, data->size, data->count, &lo, &hi);
+
+   char buf[data->size];
+   for (unsigned i = lo; i < hi; i++) {
+      const uint8_t *p = value + i * data->size;
+
+      // Most values are '0' or '1' which are positions two and three in
+      // the std_ulogic map so eight of those can be converted at once
+      // and only words containing any other value use the table
+      unsigned j = 0;
+      for (; j + 8 <= data->size; j += 8) {
+         uint64_t word;
+         memcpy(&word, p + j, 8);
+         if ((word & ~UINT64_C(0x0101010101010101))
+             == UINT64_C(0x0202020202020202)) {
+            word += UINT64_C(0x2e2e2e2e2e2e2e2e);
+            memcpy(buf + j, &word, 8);
+         }
+         else {
+            for (unsigned k = j; k < j + 8; k++)
+               buf[k] = map[p[k]];
+         }
+      }
+
+      for (; j < data->size; j++)
+         buf[j] = map[p[j]];
+
+      fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i], buf);
    }
 }
 
@@ -209,11 +324,10 @@ static void fst_fmt_enum(rt_watch_t *w, fst_data_t *data)
    fst_enum_t *e = &(data->type->u.literals);
    assert(val < e->count);
 
-   const char *literal = e->strings + val * e->size;
    fstWriterEmitVariableLengthValueChange(data->dumper->fst_ctx,
                                           data->handle[0],
-                                          literal,
-                                          strnlen(literal, e->size));
+                                          e->strings + val * e->size,
+                                          e->lengths[val]);
 }
 
 static void fst_event_cb(uint64_t now, rt_signal_t *s, rt_watch_t *w,
@@ -289,6 +403,8 @@ static fst_type_t *fst_type_for(type_t type, const loc_t *loc)
          ft->fn      = fst_fmt_int;
          ft->size    = bits_for_range(low, high);
          ft->sdt     = FST_SDT_VHDL_INTEGER;
+
+         fst_init_bit_strings();
       }
       break;
 
@@ -304,7 +420,7 @@ static fst_type_t *fst_type_for(type_t type, const loc_t *loc)
          case W_IEEE_ULOGIC:
             ft->sdt     = FST_SDT_VHDL_STD_ULOGIC;
             ft->vartype = FST_VT_SV_LOGIC;
-            ft->fn      = fst_fmt_chars;
+            ft->fn      = fst_fmt_logic;
             ft->u.map   = "UX01ZWLH-";
             ft->size    = 1;
             break;
@@ -312,8 +428,7 @@ static fst_type_t *fst_type_for(type_t type, const loc_t *loc)
          case W_STD_BIT:
             ft->sdt     = FST_SDT_VHDL_BIT;
             ft->vartype = FST_VT_SV_LOGIC;
-            ft->fn      = fst_fmt_chars;
-            ft->u.map   = "01";
+            ft->fn      = fst_fmt_bits;
             ft->size    = 1;
             break;
 
@@ -339,11 +454,14 @@ static fst_type_t *fst_type_for(type_t type, const loc_t *loc)
          ft->u.literals.size  = maxsize;
 
          ft->u.literals.strings = xmalloc(maxsize * nlits);
+         ft->u.literals.lengths = xmalloc_array(nlits, sizeof(unsigned));
          for (int i = 0; i < nlits; i++) {
             char *p = ft->u.literals.strings + i*maxsize;
-            strncpy(p, istr(tree_ident(type_enum_literal(type, i))), maxsize);
+            ident_t id = tree_ident(type_enum_literal(type, i));
+            strncpy(p, istr(id), maxsize);
             for (; *p; p++)
                *p = tolower((int)*p);
+            ft->u.literals.lengths[i] = ident_len(id);
          }
       }
       break;
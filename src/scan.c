@@ -22,6 +22,7 @@
 #include "scan.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -41,6 +42,7 @@ typedef A(cond_state_t) cond_stack_t;
 static const char     *file_start;
 static size_t          file_sz;
 static const char     *read_ptr;
+static int             stream_fd = -1;
 static hdl_kind_t      src_kind;
 static loc_file_ref_t  file_ref = FILE_INVALID;
 static int             colno;
@@ -55,8 +57,21 @@ extern loc_t yylloc;
 
 static bool pp_cond_analysis_expr(void);
 
+static void close_stream(void)
+{
+   if (stream_fd != -1 && stream_fd != STDIN_FILENO)
+      close(stream_fd);
+
+   stream_fd = -1;
+}
+
 void input_from_file(const char *file)
 {
+   close_stream();
+
+   file_start = NULL;
+   file_sz    = 0;
+
    int fd;
    if (strcmp(file, "-") == 0)
       fd = STDIN_FILENO;
@@ -71,37 +86,22 @@ void input_from_file(const char *file)
       fatal_errno("fstat");
 
    if (S_ISFIFO(buf.st_mode)) {
-      // Read all the data from the pipe into a buffer
-      size_t bufsz = 16384;
-      char *buf = xmalloc(bufsz);
-      int nbytes;
-      do {
-         if (bufsz - 1 - file_sz == 0)
-            buf = xrealloc(buf, bufsz *= 2);
-
-         nbytes = read(fd, buf + file_sz, bufsz - 1 - file_sz);
-         if (nbytes < 0)
-            fatal_errno("read");
-
-         file_sz += nbytes;
-         buf[file_sz] = '\0';
-      } while (nbytes > 0);
-
-      file_start = buf;
+      // Read from the pipe on demand into the scanner's own buffer so
+      // memory use does not depend on the size of the input: source
+      // lines are not available for diagnostics in this case
+      stream_fd = fd;
    }
    else if (S_ISREG(buf.st_mode)) {
       file_sz = buf.st_size;
 
       if (file_sz > 0)
          file_start = map_file(fd, file_sz);
-      else
-         file_start = NULL;
+
+      close(fd);
    }
    else
       fatal("opening %s: not a regular file", file);
 
-   close(fd);
-
    size_t len = strlen(file);
    if (len > 2 && file[len - 2] == '.' && file[len - 1] == 'v') {
       src_kind = SOURCE_VERILOG;
@@ -128,6 +128,20 @@ hdl_kind_t source_kind(void)
 
 int get_next_char(char *b, int max_buffer)
 {
+   if (stream_fd != -1) {
+      ssize_t nbytes;
+      do {
+         nbytes = read(stream_fd, b, max_buffer);
+      } while (nbytes < 0 && errno == EINTR);
+
+      if (nbytes < 0)
+         fatal_errno("read");
+      else if (nbytes == 0)
+         close_stream();
+
+      return nbytes;
+   }
+
    const ptrdiff_t navail = file_start + file_sz - read_ptr;
    assert(navail >= 0);
 
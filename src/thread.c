@@ -54,6 +54,7 @@
 #define MIN_TAKE        8
 #define PARKING_BAYS    64
 #define SUSPEND_TIMEOUT 1
+#define MAX_HELPERS     16
 
 #if !defined __MINGW32__ && !defined __APPLE__
 #define POSIX_SUSPEND 1
@@ -202,6 +203,20 @@ typedef enum {
    WORKER_THREAD,
 } thread_kind_t;
 
+// Helper threads are not registered in the thread table so they keep
+// running when the world is stopped and can do work on behalf of the
+// thread that stopped it
+typedef struct {
+   pthread_mutex_t    mutex;
+   pthread_cond_t     wake;
+   pthread_cond_t     done;
+   unsigned           count;
+   unsigned           epoch;
+   unsigned           running;
+   stop_world_task_t  fn;
+   void              *arg;
+} helper_pool_t;
+
 struct _nvc_thread {
    unsigned        id;
    thread_kind_t   kind;
@@ -245,6 +260,11 @@ static stop_world_fn_t  stop_callback = NULL;
 static void            *stop_arg = NULL;
 static pthread_cond_t   wake_workers = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t  wakelock = PTHREAD_MUTEX_INITIALIZER;
+static helper_pool_t    helpers = {
+   .mutex = PTHREAD_MUTEX_INITIALIZER,
+   .wake  = PTHREAD_COND_INITIALIZER,
+   .done  = PTHREAD_COND_INITIALIZER,
+};
 #ifdef POSIX_SUSPEND
 static sem_t            stop_sem;
 #endif
@@ -547,6 +567,30 @@ static void thread_unpark(void *cookie, unpark_fn_t fn)
    PTHREAD_CHECK(pthread_cond_broadcast, &(bay->cond));
 }
 
+static void notify_unpark_cb(parking_bay_t *bay, void *cookie)
+{
+   // Taking the parking bay mutex orders this with the condition check
+   // in thread_wait so the notification cannot be lost
+}
+
+void thread_wait(void *cookie, wait_fn_t fn)
+{
+   parking_bay_t *bay = parking_bay_for(cookie);
+
+   PTHREAD_CHECK(pthread_mutex_lock, &(bay->mutex));
+   {
+      // Other cookies may share this bay so wakeups can be spurious
+      while ((*fn)(cookie))
+         PTHREAD_CHECK(pthread_cond_wait, &(bay->cond), &(bay->mutex));
+   }
+   PTHREAD_CHECK(pthread_mutex_unlock, &(bay->mutex));
+}
+
+void thread_notify(void *cookie)
+{
+   thread_unpark(cookie, notify_unpark_cb);
+}
+
 void spin_wait(void)
 {
 #ifdef __x86_64__
@@ -954,7 +998,10 @@ static void *worker_thread(void *arg)
       else {
          PTHREAD_CHECK(pthread_mutex_lock, &wakelock);
          {
-            if (!relaxed_load(&should_stop))
+            // Check the queue again with the wake mutex held as a task
+            // may have been added since it was last polled
+            if (!relaxed_load(&should_stop)
+                && globalq_unlocked_empty(&globalq))
                PTHREAD_CHECK(pthread_cond_wait, &wake_workers, &wakelock);
          }
          PTHREAD_CHECK(pthread_mutex_unlock, &wakelock);
@@ -985,7 +1032,11 @@ static void create_workers(int needed)
 #endif
    }
 
-   PTHREAD_CHECK(pthread_cond_broadcast, &wake_workers);
+   PTHREAD_CHECK(pthread_mutex_lock, &wakelock);
+   {
+      PTHREAD_CHECK(pthread_cond_broadcast, &wake_workers);
+   }
+   PTHREAD_CHECK(pthread_mutex_unlock, &wakelock);
 }
 
 void workq_start(workq_t *wq)
@@ -1089,13 +1140,17 @@ void async_do(task_fn_t fn, void *context, void *arg)
       (*fn)(context, arg);   // Single CPU
    else {
       const int npending = atomic_add(&async_pending, 1);
-      create_workers(npending + 1 /* Do not count main thread */);
 
       task_t tasks[1] = {
          { fn, context, arg, NULL }
       };
-      SCOPED_LOCK(globalq.lock);
+      nvc_lock(&globalq.lock);
       globalq_put(&globalq, tasks, 1);
+      nvc_unlock(&globalq.lock);
+
+      // Wake the workers after the task is queued so one that is about
+      // to sleep cannot miss it
+      create_workers(npending + 1 /* Do not count main thread */);
    }
 }
 
@@ -1313,3 +1368,84 @@ void start_world(void)
 
    nvc_unlock(&stop_lock);
 }
+
+static void *helper_thread(void *arg)
+{
+   const int index = (uintptr_t)arg;
+   unsigned epoch = 0;
+
+   for (;;) {
+      PTHREAD_CHECK(pthread_mutex_lock, &helpers.mutex);
+
+      while (helpers.epoch == epoch)
+         PTHREAD_CHECK(pthread_cond_wait, &helpers.wake, &helpers.mutex);
+
+      epoch = helpers.epoch;
+      stop_world_task_t fn = helpers.fn;
+      void *fnarg = helpers.arg;
+
+      PTHREAD_CHECK(pthread_mutex_unlock, &helpers.mutex);
+
+      (*fn)(index, fnarg);
+
+      PTHREAD_CHECK(pthread_mutex_lock, &helpers.mutex);
+
+      if (--helpers.running == 0)
+         PTHREAD_CHECK(pthread_cond_signal, &helpers.done);
+
+      PTHREAD_CHECK(pthread_mutex_unlock, &helpers.mutex);
+   }
+
+   return NULL;
+}
+
+int stop_world_concurrency(void)
+{
+#ifdef __SANITIZE_THREAD__
+   return 1;
+#else
+   return MIN(max_workers, MAX_HELPERS + 1);
+#endif
+}
+
+void stop_world_run(stop_world_task_t fn, void *arg)
+{
+   // Run FN on the calling thread with index zero and on each helper
+   // thread with a unique index less than stop_world_concurrency
+
+   assert_lock_held(&stop_lock);
+
+   const int nhelpers = stop_world_concurrency() - 1;
+
+   if (nhelpers > 0) {
+      PTHREAD_CHECK(pthread_mutex_lock, &helpers.mutex);
+
+      // No registered thread can be inside pthread_create while the
+      // world is stopped as thread_create holds the stop lock
+      for (; helpers.count < nhelpers; helpers.count++) {
+         pthread_t handle;
+         PTHREAD_CHECK(pthread_create, &handle, NULL, helper_thread,
+                       (void *)(uintptr_t)(helpers.count + 1));
+         PTHREAD_CHECK(pthread_detach, handle);
+      }
+
+      helpers.fn      = fn;
+      helpers.arg     = arg;
+      helpers.running = nhelpers;
+      helpers.epoch++;
+
+      PTHREAD_CHECK(pthread_cond_broadcast, &helpers.wake);
+      PTHREAD_CHECK(pthread_mutex_unlock, &helpers.mutex);
+   }
+
+   (*fn)(0, arg);
+
+   if (nhelpers > 0) {
+      PTHREAD_CHECK(pthread_mutex_lock, &helpers.mutex);
+
+      while (helpers.running > 0)
+         PTHREAD_CHECK(pthread_cond_wait, &helpers.done, &helpers.mutex);
+
+      PTHREAD_CHECK(pthread_mutex_unlock, &helpers.mutex);
+   }
+}
@@ -65,6 +65,11 @@ nvc_thread_t *get_thread(int id);
 
 void spin_wait(void);
 
+typedef bool (*wait_fn_t)(void *);
+
+void thread_wait(void *cookie, wait_fn_t fn);
+void thread_notify(void *cookie);
+
 typedef int8_t nvc_lock_t;
 
 void nvc_lock(nvc_lock_t *lock);
@@ -102,8 +107,11 @@ void async_free(void *ptr);
 
 struct cpu_state;
 typedef void (*stop_world_fn_t)(int, struct cpu_state *, void *);
+typedef void (*stop_world_task_t)(int, void *);
 
 void stop_world(stop_world_fn_t callback, void *arg);
 void start_world(void);
+int stop_world_concurrency(void);
+void stop_world_run(stop_world_task_t fn, void *arg);
 
 #endif  // _THREAD_H
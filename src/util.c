@@ -1169,6 +1169,92 @@ void *map_huge_pages(size_t align, size_t sz)
    return nvc_memalign(align, sz);
 }
 
+void *nvc_try_reserve(size_t align, size_t sz)
+{
+   assert(is_power_of_2(align));
+   const size_t mapalign = MAX(align, nvc_page_size());
+   const size_t mapsz = ALIGN_UP(sz + mapalign - 1, mapalign);
+
+#if defined __MINGW32__
+   void *ptr = VirtualAlloc(NULL, mapsz, MEM_RESERVE, PAGE_NOACCESS);
+   if (ptr == NULL)
+      return NULL;
+#else
+#if __SANITIZE_ADDRESS__
+   // The address sanitiser cannot track accesses to PROT_NONE pages
+   // which are later made accessible so map the whole range read-write
+   // up front: the pages are still only backed by memory when touched
+   const int prot = PROT_READ | PROT_WRITE;
+#else
+   // Reserved pages are not counted against the commit limit until
+   // they are made accessible by nvc_commit
+   const int prot = PROT_NONE;
+#endif
+   void *ptr = mmap(NULL, mapsz, prot,
+                    MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+   if (ptr == MAP_FAILED)
+      return NULL;
+#endif
+
+   void *aligned = ALIGN_UP(ptr, align);
+
+#ifndef __MINGW32__
+   void *limit = aligned + sz;
+
+   if (align > nvc_page_size()) {
+      const size_t low_waste = aligned - ptr;
+      const size_t high_waste = ptr + mapsz - limit;
+
+      if (low_waste > 0) nvc_release(ptr, low_waste);
+      if (high_waste > 0) nvc_release(limit, high_waste);
+   }
+#endif
+
+#ifdef __linux__
+   if (sz >= HUGE_PAGE_SIZE && madvise(aligned, sz, MADV_HUGEPAGE) < 0)
+      warnf("madvise: MADV_HUGEPAGE: %s", last_os_error());
+#endif
+
+   return aligned;
+}
+
+void *nvc_reserve(size_t align, size_t sz)
+{
+   void *ptr = nvc_try_reserve(align, sz);
+   if (ptr == NULL)
+      fatal_errno("cannot reserve %zu bytes of address space", sz);
+
+   return ptr;
+}
+
+void nvc_release(void *ptr, size_t sz)
+{
+#if defined __MINGW32__
+   if (!VirtualFree(ptr, 0, MEM_RELEASE))
+      fatal_errno("VirtualFree");
+#else
+   if (munmap(ptr, sz) != 0)
+      fatal_errno("munmap");
+#endif
+}
+
+void nvc_commit(void *ptr, size_t sz)
+{
+#if !__SANITIZE_ADDRESS__
+   const long pagesz = nvc_page_size();
+   void *start = (void *)((uintptr_t)ptr & ~(pagesz - 1));
+   const size_t length = ALIGN_UP(ptr + sz, pagesz) - start;
+
+#if defined __MINGW32__
+   if (VirtualAlloc(start, length, MEM_COMMIT, PAGE_READWRITE) == NULL)
+      fatal_errno("VirtualAlloc");
+#else
+   if (mprotect(start, length, PROT_READ | PROT_WRITE) < 0)
+      fatal_errno("mprotect");
+#endif
+#endif
+}
+
 int checked_sprintf(char *buf, int len, const char *fmt, ...)
 {
    assert(len > 0);
@@ -1517,6 +1603,27 @@ void file_write_lock(int fd)
 #endif
 }
 
+bool file_try_write_lock(int fd)
+{
+#ifdef __MINGW32__
+   HANDLE hf = (HANDLE)_get_osfhandle(fd);
+
+   OVERLAPPED ovlp;
+   memset(&ovlp, 0, sizeof ovlp);
+
+   // Lock the whole range as the file may be empty or about to grow
+   return LockFileEx(hf, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY,
+                     0, MAXDWORD, MAXDWORD, &ovlp);
+#else
+   if (flock(fd, LOCK_EX | LOCK_NB) == 0)
+      return true;
+   else if (errno == EWOULDBLOCK)
+      return false;
+   else
+      fatal_errno("flock");
+#endif
+}
+
 void file_unlock(int fd)
 {
 #ifdef __MINGW32__
@@ -1553,6 +1660,27 @@ void *map_file(int fd, size_t size)
    return ptr;
 }
 
+void *map_file_shared(int fd, size_t size)
+{
+#ifdef __MINGW32__
+   HANDLE handle = CreateFileMapping((HANDLE) _get_osfhandle(fd), NULL,
+                                     PAGE_READWRITE, 0, size, NULL);
+   if (!handle)
+      fatal_errno("CreateFileMapping");
+
+   void *ptr = MapViewOfFileEx(handle, FILE_MAP_WRITE, 0,
+                               0, (SIZE_T) size, (LPVOID) NULL);
+   CloseHandle(handle);
+   if (ptr == NULL)
+      fatal_errno("MapViewOfFileEx");
+#else
+   void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (ptr == MAP_FAILED)
+      fatal_errno("mmap");
+#endif
+   return ptr;
+}
+
 void unmap_file(void *ptr, size_t size)
 {
 #ifdef __MINGW32__
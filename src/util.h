@@ -241,6 +241,10 @@ void *nvc_memalign(size_t align, size_t sz);
 void nvc_munmap(void *ptr, size_t length);
 void nvc_memprotect(void *ptr, size_t length, mem_access_t prot);
 void *map_huge_pages(size_t align, size_t sz);
+void *nvc_reserve(size_t align, size_t sz);
+void *nvc_try_reserve(size_t align, size_t sz);
+void nvc_commit(void *ptr, size_t sz);
+void nvc_release(void *ptr, size_t sz);
 
 void run_program(const char *const *args);
 char *nvc_temp_file(void);
@@ -305,9 +309,11 @@ void progress(const char *fmt, ...)
 
 void file_read_lock(int fd);
 void file_write_lock(int fd);
+bool file_try_write_lock(int fd);
 void file_unlock(int fd);
 
 void *map_file(int fd, size_t size);
+void *map_file_shared(int fd, size_t size);
 void unmap_file(void *ptr, size_t size);
 void make_dir(const char *path);
 char *search_path(const char *name);
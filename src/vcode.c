@@ -22,6 +22,7 @@
 #include "hash.h"
 #include "lib.h"
 #include "object.h"
+#include "thread.h"
 #include "tree.h"
 #include "vcode.h"
 
@@ -183,6 +184,8 @@ struct _vcode_unit {
    vcode_unit_t   children;
    vcode_unit_t   next;
    object_t      *object;
+   ident_t        locus_unit;
+   ptrdiff_t      locus_offset;
 };
 
 #define MASK_CONTEXT(x)   ((x) >> 24)
@@ -213,6 +216,7 @@ static __thread vcode_unit_t  active_unit = NULL;
 static __thread vcode_block_t active_block = VCODE_INVALID_BLOCK;
 
 static hash_t         *registry = NULL;
+static nvc_lock_t      registry_lock = 0;
 static vcode_dump_fn_t dump_callback = NULL;
 static void           *dump_arg = NULL;
 
@@ -322,11 +326,10 @@ static reg_t *vcode_reg_data(vcode_reg_t reg)
    return reg_array_nth_ptr(&(active_unit->regs), reg);
 }
 
-static vtype_t *vcode_type_data(vcode_type_t type)
+static vtype_t *vcode_unit_type_data(vcode_unit_t unit, vcode_type_t type)
 {
    assert(type != VCODE_INVALID_TYPE);
-   assert(active_unit != NULL);
-   vcode_unit_t unit = active_unit;
+   assert(unit != NULL);
 
    int depth = MASK_CONTEXT(type);
    assert(depth <= unit->depth);
@@ -336,6 +339,11 @@ static vtype_t *vcode_type_data(vcode_type_t type)
    return vtype_array_nth_ptr(&(unit->types), MASK_INDEX(type));
 }
 
+static vtype_t *vcode_type_data(vcode_type_t type)
+{
+   return vcode_unit_type_data(active_unit, type);
+}
+
 static var_t *vcode_var_data(vcode_var_t var)
 {
    assert(active_unit != NULL);
@@ -526,8 +534,10 @@ void vcode_unit_unref(vcode_unit_t unit)
       *it = (*it)->next;
    }
 
-   if (unit->name != NULL)
+   if (unit->name != NULL) {
+      SCOPED_LOCK(registry_lock);
       hash_delete(registry, unit->name);
+   }
 
    for (unsigned i = 0; i < unit->blocks.count; i++) {
       block_t *b = &(unit->blocks.items[i]);
@@ -2272,6 +2282,76 @@ bool vtype_eq(vcode_type_t a, vcode_type_t b)
    }
 }
 
+static bool vtype_eq_across(vcode_unit_t ua, vcode_type_t a,
+                            vcode_unit_t ub, vcode_type_t b)
+{
+   if (a == VCODE_INVALID_TYPE || b == VCODE_INVALID_TYPE)
+      return a == b;
+
+   const vtype_t *at = vcode_unit_type_data(ua, a);
+   const vtype_t *bt = vcode_unit_type_data(ub, b);
+
+   if (at->kind != bt->kind)
+      return false;
+
+   switch (at->kind) {
+   case VCODE_TYPE_INT:
+      return (at->low == bt->low) && (at->high == bt->high);
+   case VCODE_TYPE_REAL:
+      return (at->rlow == bt->rlow) && (at->rhigh == bt->rhigh);
+   case VCODE_TYPE_CARRAY:
+      return at->size == bt->size
+         && vtype_eq_across(ua, at->elem, ub, bt->elem);
+   case VCODE_TYPE_UARRAY:
+      return at->dims == bt->dims
+         && vtype_eq_across(ua, at->elem, ub, bt->elem);
+   case VCODE_TYPE_POINTER:
+   case VCODE_TYPE_ACCESS:
+      return vtype_eq_across(ua, at->pointed, ub, bt->pointed);
+   case VCODE_TYPE_OFFSET:
+   case VCODE_TYPE_OPAQUE:
+   case VCODE_TYPE_DEBUG_LOCUS:
+      return true;
+   case VCODE_TYPE_RESOLUTION:
+   case VCODE_TYPE_CLOSURE:
+   case VCODE_TYPE_SIGNAL:
+   case VCODE_TYPE_FILE:
+      return vtype_eq_across(ua, at->base, ub, bt->base);
+   case VCODE_TYPE_RECORD:
+   case VCODE_TYPE_CONTEXT:
+      return at->name == bt->name;
+   }
+
+   return false;
+}
+
+bool vcode_unit_same_layout(vcode_unit_t a, vcode_unit_t b)
+{
+   // True if code compiled against the variables of A and its
+   // enclosing units can be run with frames for B and its ancestors
+
+   for (; a != b; a = a->context, b = b->context) {
+      if (a == NULL || b == NULL)
+         return false;
+      else if (a->kind != b->kind || a->vars.count != b->vars.count)
+         return false;
+
+      for (int i = 0; i < a->vars.count; i++) {
+         const var_t *va = &(a->vars.items[i]);
+         const var_t *vb = &(b->vars.items[i]);
+
+         if (va->name != vb->name || va->flags != vb->flags)
+            return false;
+         else if (!vtype_eq_across(a, va->type, b, vb->type))
+            return false;
+         else if (!vtype_eq_across(a, va->bounds, b, vb->bounds))
+            return false;
+      }
+   }
+
+   return true;
+}
+
 bool vtype_includes(vcode_type_t type, vcode_type_t bounds)
 {
    const vtype_t *tt = vcode_type_data(type);
@@ -2920,6 +3000,14 @@ vcode_unit_t vcode_unit_context(void)
 object_t *vcode_unit_object(vcode_unit_t vu)
 {
    assert(vu != NULL);
+
+   if (vu->object == NULL && vu->locus_unit != NULL) {
+      // Units read from a library resolve their tree lazily as the
+      // library may not have loaded it yet
+      vu->object = object_from_locus(vu->locus_unit, vu->locus_offset,
+                                     (object_load_fn_t)lib_get_qualified);
+   }
+
    return vu->object;
 }
 
@@ -2933,20 +3021,35 @@ static unsigned vcode_unit_calc_depth(vcode_unit_t unit)
 
 static void vcode_registry_add(vcode_unit_t vu)
 {
+   SCOPED_LOCK(registry_lock);
+
    if (registry == NULL)
       registry = hash_new(512);
 
    hash_put(registry, vu->name, vu);
 }
 
-vcode_unit_t vcode_find_unit(ident_t name)
+static vcode_unit_t vcode_registry_get(ident_t name)
 {
+   SCOPED_LOCK(registry_lock);
+
    if (registry == NULL)
       return NULL;
    else
       return hash_get(registry, name);
 }
 
+vcode_unit_t vcode_find_unit(ident_t name)
+{
+   vcode_unit_t vu = vcode_registry_get(name);
+   if (vu != NULL)
+      return vu;
+   else if (lib_load_vcode(name, false))
+      return vcode_registry_get(name);
+   else
+      return NULL;
+}
+
 static void vcode_add_child(vcode_unit_t context, vcode_unit_t child)
 {
    if (context->kind == VCODE_UNIT_THUNK && child->kind != VCODE_UNIT_THUNK)
@@ -5745,9 +5848,10 @@ static void vcode_write_unit(vcode_unit_t unit, fbuf_t *f,
    fbuf_put_int(f, unit->flags);
    fbuf_put_int(f, unit->depth);
 
-   ident_t unit_name;
-   ptrdiff_t offset;
-   object_locus(unit->object, &unit_name, &offset);
+   ident_t unit_name = unit->locus_unit;
+   ptrdiff_t offset = unit->locus_offset;
+   if (unit->object != NULL)
+      object_locus(unit->object, &unit_name, &offset);
 
    ident_write(unit_name, ident_wr_ctx);
    fbuf_put_uint(f, offset);
@@ -5921,11 +6025,8 @@ static vcode_unit_t vcode_read_unit(fbuf_t *f, ident_rd_ctx_t ident_rd_ctx,
    unit->flags    = fbuf_get_int(f);
    unit->depth    = fbuf_get_int(f);
 
-   ident_t unit_name = ident_read(ident_rd_ctx);
-   ptrdiff_t offset = fbuf_get_uint(f);
-
-   unit->object = object_from_locus(unit_name, offset,
-                                    (object_load_fn_t)lib_get_qualified);
+   unit->locus_unit   = ident_read(ident_rd_ctx);
+   unit->locus_offset = fbuf_get_uint(f);
 
    ident_t context_name = ident_read(ident_rd_ctx);
    if (context_name != NULL) {
@@ -27,9 +27,11 @@
 #include "tree.h"
 #include "type.h"
 #include "vhpi/vhpi-macros.h"
+#include "vhpi/vhpi_ext_nvc.h"
 #include "vhpi/vhpi-util.h"
 
 #include <assert.h>
+#include <ctype.h>
 #include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
@@ -51,7 +53,9 @@ typedef struct tag_abstractRegion {
    c_vhpiObject      object;
    tree_t            tree;
    rt_scope_t       *scope;
+   shash_t          *names;
    vhpiObjectListT   decls;
+   vhpiObjectListT   ports;
    vhpiObjectListT   InternalRegions;
    c_abstractRegion *UpperRegion;
    vhpiIntT          LineOffset;
@@ -69,6 +73,7 @@ typedef struct {
    type_t            type;
    tree_t            tree;
    rt_signal_t      *signal;
+   vhpiFormatT       format;
    c_abstractRegion *ImmRegion;
    vhpiIntT          LineOffset;
    vhpiIntT          LineNo;
@@ -203,10 +208,27 @@ typedef struct {
 
 typedef struct {
    c_designInstUnit designInstUnit;
-   vhpiObjectListT  ports;
 } c_rootInst;
 
-DEF_CLASS(rootInst, vhpiRootInstK, designInstUnit.region.object);
+typedef struct {
+   c_designInstUnit designInstUnit;
+} c_compInstStmt;
+
+typedef struct {
+   c_abstractRegion region;
+} c_blockStmt;
+
+typedef struct {
+   c_abstractRegion region;
+} c_generateStmt;
+
+typedef struct {
+   c_vhpiObject    object;
+   vhpiObjectListT list;
+   int             pos;
+} c_iterator;
+
+DEF_CLASS(iterator, vhpiIteratorK, object);
 
 typedef struct {
    c_vhpiObject object;
@@ -221,6 +243,8 @@ static c_rootInst *rootInst = NULL;
 static shash_t    *strtab = NULL;
 static rt_model_t *model = NULL;
 
+static void vhpi_build_region(c_abstractRegion *r);
+
 static vhpiHandleT handle_for(c_vhpiObject *obj)
 {
    return (vhpiHandleT)obj;
@@ -234,31 +258,49 @@ static c_vhpiObject *from_handle(vhpiHandleT handle)
    return (c_vhpiObject *)handle;
 }
 
-static c_abstractRegion *cast_abstractRegion(c_vhpiObject *obj)
+static c_abstractRegion *is_abstractRegion(c_vhpiObject *obj)
 {
    switch (obj->kind) {
    case vhpiRootInstK:
+   case vhpiCompInstStmtK:
+   case vhpiBlockStmtK:
+   case vhpiForGenerateK:
+   case vhpiIfGenerateK:
       return container_of(obj, c_abstractRegion, object);
    default:
-      vhpi_error(vhpiError, NULL, "class kind %s is not a region",
-                 vhpi_class_str(obj->kind));
       return NULL;
    }
 }
 
-static c_abstractDecl *cast_abstractDecl(c_vhpiObject *obj)
+static c_abstractRegion *cast_abstractRegion(c_vhpiObject *obj)
+{
+   c_abstractRegion *r = is_abstractRegion(obj);
+   if (r == NULL)
+      vhpi_error(vhpiError, NULL, "class kind %s is not a region",
+                 vhpi_class_str(obj->kind));
+   return r;
+}
+
+static c_abstractDecl *is_abstractDecl(c_vhpiObject *obj)
 {
    switch (obj->kind) {
    case vhpiSigDeclK:
    case vhpiPortDeclK:
       return container_of(obj, c_abstractDecl, object);
    default:
-      vhpi_error(vhpiError, NULL, "class kind %s is not a declaration",
-                 vhpi_class_str(obj->kind));
       return NULL;
    }
 }
 
+static c_abstractDecl *cast_abstractDecl(c_vhpiObject *obj)
+{
+   c_abstractDecl *d = is_abstractDecl(obj);
+   if (d == NULL)
+      vhpi_error(vhpiError, NULL, "class kind %s is not a declaration",
+                 vhpi_class_str(obj->kind));
+   return d;
+}
+
 static c_objDecl *cast_objDecl(c_vhpiObject *obj)
 {
    switch (obj->kind) {
@@ -301,13 +343,12 @@ static const char *handle_pp(vhpiHandleT handle)
    c_vhpiObject *obj = from_handle(handle);
    tb_cat(tb, vhpi_class_str(obj->kind));
 
-   switch (obj->kind) {
-   case vhpiPortDeclK:
-      tb_printf(tb, " Name=%s", cast_abstractDecl(obj)->Name);
-      break;
-   default:
-      break;
-   }
+   c_abstractRegion *r;
+   c_abstractDecl *d;
+   if ((d = is_abstractDecl(obj)))
+      tb_printf(tb, " Name=%s", d->Name);
+   else if ((r = is_abstractRegion(obj)))
+      tb_printf(tb, " Name=%s", r->Name);
 
    tb_append(tb, '}');
 
@@ -338,6 +379,15 @@ static vhpiCharT *new_string(const char *s)
    return p;
 }
 
+static vhpiCharT *full_name(c_abstractRegion *upper, vhpiStringT name)
+{
+   LOCAL_TEXT_BUF tb = tb_new();
+   if (upper != NULL)
+      tb_cat(tb, (char *)upper->FullName);
+   tb_printf(tb, ":%s", name);
+   return new_string(tb_get(tb));
+}
+
 static void init_abstractRegion(c_abstractRegion *r, tree_t t)
 {
    const loc_t *loc = tree_loc(t);
@@ -361,6 +411,9 @@ static void init_abstractDecl(c_abstractDecl *d, tree_t t, c_abstractRegion *r)
 
    d->Name = d->CaseName = new_string(istr(tree_ident(t)));
 
+   if (r != NULL)
+      d->FullName = d->FullCaseName = full_name(r, d->Name);
+
    d->ImmRegion = r;
 
    d->type = tree_type(t);
@@ -477,6 +530,83 @@ static rt_signal_t *vhpi_get_signal(c_abstractDecl *decl)
    return signal;
 }
 
+static bool vhpi_edge_masks(c_abstractDecl *decl, vhpiEdgeT edge,
+                            rt_watch_filter_t *filter)
+{
+   type_t type = decl->type;
+   if (type_is_array(type))
+      type = type_elem(type);
+
+   uint64_t zero, one;
+   switch (is_well_known(type_ident(type_base_recur(type)))) {
+   case W_IEEE_ULOGIC:
+      zero = (1 << vhpi0) | (1 << vhpiL);
+      one  = (1 << vhpi1) | (1 << vhpiH);
+      break;
+   case W_STD_BIT:
+      zero = (1 << vhpibit0);
+      one  = (1 << vhpibit1);
+      break;
+   default:
+      vhpi_error(vhpiError, &(decl->object.loc), "edge filter requires "
+                 "object %s to have type BIT or STD_ULOGIC", decl->Name);
+      return false;
+   }
+
+   switch (edge) {
+   case vhpiRisingEdge:
+      filter->from = zero;
+      filter->to   = one;
+      return true;
+   case vhpiFallingEdge:
+      filter->from = one;
+      filter->to   = zero;
+      return true;
+   default:
+      return true;
+   }
+}
+
+static bool vhpi_watch_signal(c_callback *cb, const vhpiCbFilterT *filter)
+{
+   c_vhpiObject *obj = from_handle(cb->data.obj);
+   if (obj == NULL)
+      return false;
+
+   c_abstractDecl *decl = cast_abstractDecl(obj);
+   if (decl == NULL)
+      return false;
+
+   rt_signal_t *signal = vhpi_get_signal(decl);
+   if (signal == NULL)
+      return false;
+
+   if (filter == NULL) {
+      model_set_event_cb(model, signal, vhpi_signal_event_cb, cb, false);
+      return true;
+   }
+
+   if (filter->offset < 0 || filter->count < 0) {
+      vhpi_error(vhpiError, &(obj->loc), "invalid element range in "
+                 "callback filter");
+      return false;
+   }
+
+   rt_watch_filter_t wf = {
+      .first = filter->offset,
+      .count = filter->count,
+   };
+
+   if (filter->edge != vhpiAnyEdge && !vhpi_edge_masks(decl, filter->edge, &wf))
+      return false;
+
+   // Postponed callbacks run once at the end of the time step with
+   // the changes from all delta cycles merged
+   model_set_filtered_event_cb(model, signal, vhpi_signal_event_cb, cb,
+                               filter->once, &wf);
+   return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Public API
 
@@ -486,6 +616,12 @@ int vhpi_release_handle(vhpiHandleT handle)
 
    VHPI_TRACE("handle=%s", handle_pp(handle));
 
+   c_iterator *it;
+   if (handle != NULL && (it = is_iterator(from_handle(handle)))) {
+      ACLEAR(it->list);
+      free(it);
+   }
+
    return 0;
 }
 
@@ -524,21 +660,8 @@ vhpiHandleT vhpi_register_cb(vhpiCbDataT *cb_data_p, int32_t flags)
       break;
 
    case vhpiCbValueChange:
-      {
-         c_vhpiObject *obj = from_handle(cb_data_p->obj);
-         if (obj == NULL)
-            goto failed;
-
-         c_abstractDecl *decl = cast_abstractDecl(obj);
-         if (decl == NULL)
-            goto failed;
-
-         rt_signal_t *signal = vhpi_get_signal(decl);
-         if (signal == NULL)
-            goto failed;
-
-         model_set_event_cb(model, signal, vhpi_signal_event_cb, cb, false);
-      }
+      if (!vhpi_watch_signal(cb, NULL))
+         goto failed;
       break;
 
    default:
@@ -552,6 +675,34 @@ vhpiHandleT vhpi_register_cb(vhpiCbDataT *cb_data_p, int32_t flags)
    return NULL;
 }
 
+vhpiHandleT vhpi_register_filtered_cb(vhpiCbDataT *cb_data_p,
+                                      const vhpiCbFilterT *filter,
+                                      int32_t flags)
+{
+   vhpi_clear_error();
+
+   VHPI_TRACE("cb_datap_p=%s filter=%p flags=%x", cb_data_pp(cb_data_p),
+              filter, flags);
+
+   if (cb_data_p->reason != vhpiCbValueChange) {
+      vhpi_error(vhpiError, NULL, "filtered callbacks are only supported "
+                 "for vhpiCbValueChange");
+      return NULL;
+   }
+
+   c_callback *cb = new_object(sizeof(c_callback), vhpiCallbackK);
+   cb->Reason = cb_data_p->reason;
+   cb->State  = (flags & vhpiDisableCb) ? vhpiDisable : vhpiEnable;
+   cb->data   = *cb_data_p;
+
+   if (!vhpi_watch_signal(cb, filter)) {
+      free(cb);
+      return NULL;
+   }
+
+   return (flags & vhpiReturnCb) ? handle_for(&(cb->object)) : NULL;
+}
+
 int vhpi_remove_cb(vhpiHandleT handle)
 {
    vhpi_clear_error();
@@ -650,21 +801,45 @@ vhpiHandleT vhpi_handle(vhpiOneToOneT type, vhpiHandleT referenceHandle)
             return handle_for(&(d->Type->decl.object));
       }
 
+   case vhpiUpperRegion:
+      {
+         c_abstractRegion *r = cast_abstractRegion(obj);
+         if (r == NULL || r->UpperRegion == NULL)
+            return NULL;
+
+         return handle_for(&(r->UpperRegion->object));
+      }
+
+   case vhpiImmRegion:
+      {
+         c_abstractDecl *d = cast_abstractDecl(obj);
+         if (d == NULL || d->ImmRegion == NULL)
+            return NULL;
+
+         return handle_for(&(d->ImmRegion->object));
+      }
+
    default:
       fatal_trace("relationship %s not supported in vhpi_handle",
                   vhpi_one_to_one_str(type));
    }
 }
 
+static c_vhpiObject *vhpi_lookup(c_abstractRegion *region, const char *name)
+{
+   vhpi_build_region(region);
+   return shash_get(region->names, name);
+}
+
 vhpiHandleT vhpi_handle_by_name(const char *name, vhpiHandleT scope)
 {
    vhpi_clear_error();
 
    VHPI_TRACE("name=%s scope=%p", name, scope);
 
-   c_abstractRegion *region;
-   if (scope == NULL)
-      region = &(rootInst->designInstUnit.region);
+   c_abstractRegion *root = &(rootInst->designInstUnit.region), *region;
+   if (scope == NULL || name[0] == ':')
+      region = root;
    else {
       c_vhpiObject *obj = from_handle(scope);
       if (obj == NULL)
@@ -675,25 +850,35 @@ vhpiHandleT vhpi_handle_by_name(const char *name, vhpiHandleT scope)
          return NULL;
    }
 
-   char *copy LOCAL = xstrdup(name), *saveptr;
-   char *elem = strtok_r(copy, ":", &saveptr);
-
-   for (int i = 0; i < region->decls.count; i++) {
-      c_abstractDecl *d = cast_abstractDecl(region->decls.items[i]);
-      if (strcasecmp((char *)d->Name, elem) == 0)
-         return handle_for(&(d->object));
+   // Basic identifiers are case insensitive and stored in upper case
+   // whereas extended identifiers must match exactly
+   char *copy LOCAL = xstrdup(name);
+   bool extended = false;
+   for (char *p = copy; *p; p++) {
+      if (*p == '\\')
+         extended = !extended;
+      else if (!extended)
+         *p = toupper((int)*p);
    }
 
-   c_rootInst *rootInst;
-   if ((rootInst = is_rootInst(&(region->object)))) {
-      for (int i = 0; i < rootInst->ports.count; i++) {
-         c_abstractDecl *d = cast_abstractDecl(rootInst->ports.items[i]);
-         if (strcasecmp((char *)d->Name, elem) == 0)
-            return handle_for(&(d->object));
-      }
-   }
+   char *saveptr, *elem = strtok_r(copy, ":", &saveptr);
 
-   return NULL;
+   if (elem == NULL)
+      return handle_for(&(region->object));
+
+   for (;;) {
+      c_vhpiObject *obj = vhpi_lookup(region, elem);
+      if (obj == NULL && region == root && (scope == NULL || name[0] == ':')
+          && strcmp(elem, (char *)root->Name) == 0)
+         obj = &(root->object);   // Full path including the root name
+
+      if (obj == NULL)
+         return NULL;
+      else if ((elem = strtok_r(NULL, ":", &saveptr)) == NULL)
+         return handle_for(obj);
+      else if ((region = is_abstractRegion(obj)) == NULL)
+         return NULL;
+   }
 }
 
 vhpiHandleT vhpi_handle_by_index(vhpiOneToManyT itRel,
@@ -728,17 +913,84 @@ vhpiHandleT vhpi_handle_by_index(vhpiOneToManyT itRel,
    }
 }
 
+static void iterator_add(c_iterator *it, vhpiObjectListT *list,
+                         vhpiClassKindT kind)
+{
+   for (int i = 0; i < list->count; i++) {
+      if (kind == 0 || list->items[i]->kind == kind)
+         APUSH(it->list, list->items[i]);
+   }
+}
+
 vhpiHandleT vhpi_iterator(vhpiOneToManyT type, vhpiHandleT handle)
 {
+   vhpi_clear_error();
+
    VHPI_TRACE("type=%s handle=%s", vhpi_one_to_many_str(type),
               handle_pp(handle));
 
-   VHPI_MISSING;
+   c_vhpiObject *obj = from_handle(handle);
+   if (obj == NULL)
+      return NULL;
+
+   c_abstractRegion *region = cast_abstractRegion(obj);
+   if (region == NULL)
+      return NULL;
+
+   vhpi_build_region(region);
+
+   c_iterator *it = new_object(sizeof(c_iterator), vhpiIteratorK);
+
+   switch (type) {
+   case vhpiInternalRegions:
+      iterator_add(it, &(region->InternalRegions), 0);
+      break;
+   case vhpiSigDecls:
+      iterator_add(it, &(region->decls), vhpiSigDeclK);
+      break;
+   case vhpiPortDecls:
+      iterator_add(it, &(region->ports), 0);
+      break;
+   case vhpiDecls:
+      iterator_add(it, &(region->ports), 0);
+      iterator_add(it, &(region->decls), 0);
+      break;
+   default:
+      free(it);
+      vhpi_error(vhpiError, &(obj->loc), "relation %s not supported in "
+                 "vhpi_iterator", vhpi_one_to_many_str(type));
+      return NULL;
+   }
+
+   if (it->list.count == 0) {
+      free(it);
+      return NULL;
+   }
+
+   return handle_for(&(it->object));
 }
 
 vhpiHandleT vhpi_scan(vhpiHandleT iterator)
 {
-   VHPI_MISSING;
+   vhpi_clear_error();
+
+   VHPI_TRACE("iterator=%s", handle_pp(iterator));
+
+   c_vhpiObject *obj = from_handle(iterator);
+   if (obj == NULL)
+      return NULL;
+
+   c_iterator *it = cast_iterator(obj);
+   if (it == NULL)
+      return NULL;
+
+   if (it->pos < it->list.count)
+      return handle_for(it->list.items[it->pos++]);
+
+   // The iterator is released automatically once it is exhausted
+   ACLEAR(it->list);
+   free(it);
+   return NULL;
 }
 
 vhpiIntT vhpi_get(vhpiIntPropertyT property, vhpiHandleT handle)
@@ -802,14 +1054,51 @@ const vhpiCharT *vhpi_get_str(vhpiStrPropertyT property, vhpiHandleT handle)
 
    case vhpiNameP:
    case vhpiCaseNameP:
-      if (handle == NULL)
-         return (vhpiCharT *)PACKAGE_NAME;
-
-      return NULL;
-
    case vhpiFullNameP:
    case vhpiFullCaseNameP:
+      {
+         if (handle == NULL
+             && (property == vhpiNameP || property == vhpiCaseNameP))
+            return (vhpiCharT *)PACKAGE_NAME;
+
+         c_vhpiObject *obj = from_handle(handle);
+         if (obj == NULL)
+            return NULL;
+
+         c_abstractRegion *r;
+         c_abstractDecl *d;
+         if ((r = is_abstractRegion(obj))) {
+            switch (property) {
+            case vhpiNameP:         return r->Name;
+            case vhpiCaseNameP:     return r->CaseName;
+            case vhpiFullNameP:     return r->FullName;
+            default:                return r->FullCaseName;
+            }
+         }
+         else if ((d = is_abstractDecl(obj))) {
+            switch (property) {
+            case vhpiNameP:         return d->Name;
+            case vhpiCaseNameP:     return d->CaseName;
+            case vhpiFullNameP:     return d->FullName;
+            default:                return d->FullCaseName;
+            }
+         }
+
+         vhpi_error(vhpiError, &(obj->loc), "invalid property %s for "
+                    "class kind %s", vhpi_property_str(property),
+                    vhpi_class_str(obj->kind));
+         return NULL;
+      }
+
    case vhpiKindStrP:
+      {
+         c_vhpiObject *obj = from_handle(handle);
+         if (obj == NULL)
+            return NULL;
+
+         return (vhpiCharT *)vhpi_class_str(obj->kind);
+      }
+
    default:
       fatal_trace("unsupported property %s in vhpi_get_str",
                   vhpi_property_str(property));
@@ -881,25 +1170,11 @@ vhpiPhysT vhpi_get_phys(vhpiPhysPropertyT property,
    return invalid;
 }
 
-int vhpi_get_value(vhpiHandleT expr, vhpiValueT *value_p)
+static vhpiFormatT vhpi_native_format(c_abstractDecl *decl)
 {
-   vhpi_clear_error();
-
-   VHPI_TRACE("expr=%s value_p=%p", handle_pp(expr), value_p);
-
-   c_vhpiObject *obj = from_handle(expr);
-   if (obj == NULL)
-      return -1;
-
-   if (obj->kind != vhpiPortDeclK && obj->kind != vhpiSigDeclK) {
-      vhpi_error(vhpiInternal, &(obj->loc), "vhpi_get_value is only "
-                 "supported for signal and port objects");
-      return -1;
-   }
-
-   c_abstractDecl *decl = cast_abstractDecl(obj);
-   if (decl == NULL)
-      return -1;
+   // The natural format depends only on the type so is computed once
+   if (decl->format != 0)
+      return decl->format;
 
    type_t base = type_base_recur(decl->type);
    ident_t type_name = type_ident(decl->type);
@@ -911,10 +1186,7 @@ int vhpi_get_value(vhpiHandleT expr, vhpiValueT *value_p)
       case W_IEEE_LOGIC:
       case W_IEEE_ULOGIC:
       case W_STD_BIT:
-         if (value_p->format == vhpiBinStrVal)
-            format = value_p->format;
-         else
-            format = vhpiLogicVal;
+         format = vhpiLogicVal;
          break;
       default:
          if (type_enum_literals(base) <= 256)
@@ -932,20 +1204,18 @@ int vhpi_get_value(vhpiHandleT expr, vhpiValueT *value_p)
    case T_ARRAY:
       {
          type_t elem = type_elem(base);
-         switch (type_kind(elem)) {
+         type_t elem_base = type_base_recur(elem);
+         switch (type_kind(elem_base)) {
          case T_ENUM:
             {
-               switch (is_well_known(type_ident(elem))) {
+               switch (is_well_known(type_ident(elem_base))) {
                case W_IEEE_LOGIC:
                case W_IEEE_ULOGIC:
                case W_STD_BIT:
-                  if (value_p->format == vhpiBinStrVal)
-                     format = value_p->format;
-                  else
-                     format = vhpiLogicVecVal;
+                  format = vhpiLogicVecVal;
                   break;
                default:
-                  if (type_enum_literals(elem) <= 256)
+                  if (type_enum_literals(elem_base) <= 256)
                      format = vhpiSmallEnumVecVal;
                   else
                      format = vhpiEnumVecVal;
@@ -954,20 +1224,61 @@ int vhpi_get_value(vhpiHandleT expr, vhpiValueT *value_p)
                break;
             }
 
+         case T_INTEGER:
+            format = vhpiIntVecVal;
+            break;
+
          default:
-            vhpi_error(vhpiInternal, &(obj->loc), "arrays of type %s "
+            vhpi_error(vhpiInternal, &(decl->object.loc), "arrays of type %s "
                        "not supported in vhpi_get_value", type_pp(elem));
-            return -1;
+            return 0;
          }
       }
       break;
 
    default:
-      vhpi_error(vhpiInternal, &(obj->loc), "type %s not supported in "
-                 "vhpi_get_value", type_pp(decl->type));
+      vhpi_error(vhpiInternal, &(decl->object.loc), "type %s not supported "
+                 "in vhpi_get_value", type_pp(decl->type));
+      return 0;
+   }
+
+   return (decl->format = format);
+}
+
+static size_t vhpi_vec_elemsz(vhpiFormatT format)
+{
+   switch (format) {
+   case vhpiLogicVecVal:
+   case vhpiEnumVecVal:
+      return sizeof(vhpiEnumT);
+   case vhpiSmallEnumVecVal:
+      return sizeof(vhpiSmallEnumT);
+   case vhpiIntVecVal:
+      return sizeof(vhpiIntT);
+   default:
+      return 0;
+   }
+}
+
+static int vhpi_get_value_one(c_vhpiObject *obj, vhpiValueT *value_p)
+{
+   if (obj->kind != vhpiPortDeclK && obj->kind != vhpiSigDeclK) {
+      vhpi_error(vhpiInternal, &(obj->loc), "vhpi_get_value is only "
+                 "supported for signal and port objects");
       return -1;
    }
 
+   c_abstractDecl *decl = cast_abstractDecl(obj);
+   if (decl == NULL)
+      return -1;
+
+   vhpiFormatT format = vhpi_native_format(decl);
+   if (format == 0)
+      return -1;
+   else if (value_p->format == vhpiBinStrVal
+            && (format == vhpiLogicVal || format == vhpiLogicVecVal))
+      format = vhpiBinStrVal;
+
    if (value_p->format == vhpiObjTypeVal)
       value_p->format = format;
    else if (value_p->format != format) {
@@ -1016,58 +1327,50 @@ int vhpi_get_value(vhpiHandleT expr, vhpiValueT *value_p)
       }
    }
    else {
-      size_t elemsz = 0;
-      switch (format) {
-      case vhpiLogicVecVal:
-      case vhpiEnumVecVal:
-         elemsz = sizeof(vhpiEnumT);
-         break;
-      case vhpiSmallEnumVal:
-         elemsz = sizeof(vhpiSmallEnumT);
-         break;
-      default:
-         assert(false);
-      }
+      // Copy directly from the signal into the user's buffer
+      const size_t elemsz = vhpi_vec_elemsz(format);
+      assert(elemsz > 0);
+
+      const size_t max = value_p->bufSize / elemsz;
+      const bool sign = (format == vhpiIntVecVal);
+      value_p->numElems = signal_read_elems(signal, value_p->value.ptr,
+                                            elemsz, max, sign);
+      return 0;
+   }
+}
 
-      const int max = value_p->bufSize / elemsz;
-      uint64_t *values LOCAL = xmalloc_array(max, sizeof(uint64_t));
-      value_p->numElems = signal_expand(signal, values, max);
+int vhpi_get_value(vhpiHandleT expr, vhpiValueT *value_p)
+{
+   vhpi_clear_error();
 
-      const int copy = MIN(value_p->numElems, max);
+   VHPI_TRACE("expr=%s value_p=%p", handle_pp(expr), value_p);
 
-      for (int i = 0; i < copy; i++) {
-         switch (format) {
-         case vhpiLogicVecVal:
-         case vhpiEnumVecVal:
-            value_p->value.enumvs[i] = values[i];
-            break;
-         case vhpiSmallEnumVal:
-            value_p->value.smallenumvs[i] = values[i];
-            break;
-         default:
-            vhpi_error(vhpiError, &(obj->loc), "unsupported format %d", format);
-         }
-      }
+   c_vhpiObject *obj = from_handle(expr);
+   if (obj == NULL)
+      return -1;
 
-      return 0;
-   }
+   return vhpi_get_value_one(obj, value_p);
 }
 
-int vhpi_put_value(vhpiHandleT handle,
-                   vhpiValueT *value_p,
-                   vhpiPutValueModeT mode)
+int vhpi_get_values(const vhpiHandleT *exprs, vhpiValueT *values,
+                    int count)
 {
-   // See LRM 2008 section 22.5.3 for discussion of semantics
-
    vhpi_clear_error();
 
-   VHPI_TRACE("handle=%s value_p=%p mode=%s", handle_pp(handle), value_p,
-              vhpi_put_value_mode_str(mode));
+   VHPI_TRACE("exprs=%p values=%p count=%d", exprs, values, count);
 
-   c_vhpiObject *obj = from_handle(handle);
-   if (obj == NULL)
-      return 1;
+   for (int i = 0; i < count; i++) {
+      c_vhpiObject *obj = from_handle(exprs[i]);
+      if (obj == NULL || vhpi_get_value_one(obj, &(values[i])) != 0)
+         return -1;
+   }
 
+   return 0;
+}
+
+static int vhpi_put_value_one(c_vhpiObject *obj, vhpiValueT *value_p,
+                              vhpiPutValueModeT mode)
+{
    c_abstractDecl *decl = cast_abstractDecl(obj);
    if (decl == NULL)
       return 1;
@@ -1079,6 +1382,12 @@ int vhpi_put_value(vhpiHandleT handle,
    switch (mode) {
    case vhpiForcePropagate:
       {
+         if (!model_can_create_delta(model)) {
+            vhpi_error(vhpiError, &(obj->loc), "cannot force "
+                       "propagate signal during current simulation phase");
+            return 1;
+         }
+
          if (type_is_scalar(decl->type)) {
             uint64_t expanded;
             switch (value_p->format) {
@@ -1102,43 +1411,23 @@ int vhpi_put_value(vhpiHandleT handle,
                return 1;
             }
 
-            if (model_can_create_delta(model))
-               force_signal(signal, &expanded, 1);
-            else {
-               vhpi_error(vhpiError, &(obj->loc), "cannot force "
-                          "propagate signal during current simulation phase");
-               return 1;
-            }
+            force_signal(signal, &expanded, 1);
          }
          else {
-            uint64_t *expanded = NULL;
-            int num_elems = 0;
-
-            switch (value_p->format) {
-            case vhpiLogicVecVal:
-            case vhpiEnumVecVal:
-               num_elems = value_p->bufSize / sizeof(vhpiEnumT);
-               expanded = xmalloc_array(num_elems, sizeof(uint64_t));
-               for (int i = 0; i < num_elems; i++)
-                  expanded[i] = value_p->value.enumvs[i];
-               break;
-
-            case vhpiSmallEnumVecVal:
-               num_elems = value_p->bufSize / sizeof(vhpiSmallEnumT);
-               expanded = xmalloc_array(num_elems, sizeof(uint64_t));
-               for (int i = 0; i < num_elems; i++)
-                  expanded[i] = value_p->value.smallenumvs[i];
-               break;
-
-            default:
-               vhpi_error(vhpiFailure, &(obj->loc), " value format "
+            const size_t elemsz = vhpi_vec_elemsz(value_p->format);
+            if (elemsz == 0) {
+               vhpi_error(vhpiFailure, &(obj->loc), "value format "
                           "%d not supported in vhpi_put_value",
                           value_p->format);
                return 1;
             }
 
-            force_signal(signal, expanded, num_elems);
-            free(expanded);
+            const size_t width = signal_width(signal);
+            const size_t num_elems = MIN(value_p->bufSize / elemsz, width);
+            const bool sign = (value_p->format == vhpiIntVecVal);
+
+            force_signal_elems(signal, value_p->value.ptr, elemsz,
+                               num_elems, sign);
          }
          return 0;
       }
@@ -1150,6 +1439,41 @@ int vhpi_put_value(vhpiHandleT handle,
    }
 }
 
+int vhpi_put_value(vhpiHandleT handle,
+                   vhpiValueT *value_p,
+                   vhpiPutValueModeT mode)
+{
+   // See LRM 2008 section 22.5.3 for discussion of semantics
+
+   vhpi_clear_error();
+
+   VHPI_TRACE("handle=%s value_p=%p mode=%s", handle_pp(handle), value_p,
+              vhpi_put_value_mode_str(mode));
+
+   c_vhpiObject *obj = from_handle(handle);
+   if (obj == NULL)
+      return 1;
+
+   return vhpi_put_value_one(obj, value_p, mode);
+}
+
+int vhpi_put_values(const vhpiHandleT *handles, vhpiValueT *values,
+                    int count, vhpiPutValueModeT mode)
+{
+   vhpi_clear_error();
+
+   VHPI_TRACE("handles=%p values=%p count=%d mode=%s", handles, values,
+              count, vhpi_put_value_mode_str(mode));
+
+   for (int i = 0; i < count; i++) {
+      c_vhpiObject *obj = from_handle(handles[i]);
+      if (obj == NULL || vhpi_put_value_one(obj, &(values[i]), mode) != 0)
+         return 1;
+   }
+
+   return 0;
+}
+
 int vhpi_protected_call(vhpiHandleT varHdl,
                         vhpiUserFctT userFct,
                         void *userData)
@@ -1402,14 +1726,95 @@ static c_vhpiObject *vhpi_build_port_decl(tree_t port, int pos,
    return &(p->interface.objDecl.decl.object);
 }
 
-static void vhpi_build_ports(tree_t unit, c_rootInst *where)
+static void vhpi_build_ports(tree_t unit, c_abstractRegion *region)
 {
-   c_abstractRegion *region = &(where->designInstUnit.region);
-
    const int nports = tree_ports(unit);
    for (int i = 0; i < nports; i++) {
       tree_t p = tree_port(unit, i);
-      APUSH(where->ports, vhpi_build_port_decl(p, i, region));
+      APUSH(region->ports, vhpi_build_port_decl(p, i, region));
+   }
+}
+
+static c_abstractRegion *vhpi_build_block(tree_t block, c_abstractRegion *upper)
+{
+   // The first declaration in each elaborated block records the kind
+   // of statement that created it
+   tree_t hier = tree_decl(block, 0);
+   assert(tree_kind(hier) == T_HIER);
+
+   c_abstractRegion *r;
+   switch (tree_subkind(hier)) {
+   case T_ARCH:
+      {
+         c_compInstStmt *c =
+            new_object(sizeof(c_compInstStmt), vhpiCompInstStmtK);
+         r = &(c->designInstUnit.region);
+      }
+      break;
+   case T_FOR_GENERATE:
+      {
+         c_generateStmt *g =
+            new_object(sizeof(c_generateStmt), vhpiForGenerateK);
+         r = &(g->region);
+      }
+      break;
+   case T_IF_GENERATE:
+      {
+         c_generateStmt *g =
+            new_object(sizeof(c_generateStmt), vhpiIfGenerateK);
+         r = &(g->region);
+      }
+      break;
+   default:
+      {
+         c_blockStmt *b = new_object(sizeof(c_blockStmt), vhpiBlockStmtK);
+         r = &(b->region);
+      }
+      break;
+   }
+
+   init_abstractRegion(r, block);
+
+   r->UpperRegion = upper;
+   r->FullName = r->FullCaseName = full_name(upper, r->Name);
+
+   return r;
+}
+
+static void vhpi_build_region(c_abstractRegion *r)
+{
+   // Regions other than the root are only populated when they are
+   // first searched or iterated over
+   if (r->names != NULL)
+      return;
+
+   vhpi_build_ports(r->tree, r);
+   vhpi_build_decls(r->tree, r);
+
+   const int nstmts = tree_stmts(r->tree);
+   for (int i = 0; i < nstmts; i++) {
+      tree_t s = tree_stmt(r->tree, i);
+      if (tree_kind(s) == T_BLOCK)
+         APUSH(r->InternalRegions, &(vhpi_build_block(s, r)->object));
+   }
+
+   const int nnames =
+      r->ports.count + r->decls.count + r->InternalRegions.count;
+   r->names = shash_new(MAX(nnames * 2, 16));
+
+   for (int i = 0; i < r->ports.count; i++) {
+      c_abstractDecl *d = cast_abstractDecl(r->ports.items[i]);
+      shash_put(r->names, (char *)d->Name, &(d->object));
+   }
+
+   for (int i = 0; i < r->decls.count; i++) {
+      c_abstractDecl *d = cast_abstractDecl(r->decls.items[i]);
+      shash_put(r->names, (char *)d->Name, &(d->object));
+   }
+
+   for (int i = 0; i < r->InternalRegions.count; i++) {
+      c_abstractRegion *sub = cast_abstractRegion(r->InternalRegions.items[i]);
+      shash_put(r->names, (char *)sub->Name, &(sub->object));
    }
 }
 
@@ -1428,10 +1833,12 @@ void vhpi_build_design_model(tree_t top, rt_model_t *m)
    model = m;
 
    rootInst = new_object(sizeof(c_rootInst), vhpiRootInstK);
-   init_abstractRegion(&(rootInst->designInstUnit.region), b0);
 
-   vhpi_build_decls(b0, &(rootInst->designInstUnit.region));
-   vhpi_build_ports(b0, rootInst);
+   c_abstractRegion *region = &(rootInst->designInstUnit.region);
+   init_abstractRegion(region, b0);
+   region->FullName = region->FullCaseName = full_name(NULL, region->Name);
+
+   vhpi_build_region(region);
 
    VHPI_TRACE("building model for %s took %"PRIu64" ms",
               istr(ident_runtil(tree_ident(b0), '.')),
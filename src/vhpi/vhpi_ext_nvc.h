@@ -0,0 +1,68 @@
+//
+//  Copyright (C) 2023  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _VHPI_EXT_NVC_H
+#define _VHPI_EXT_NVC_H
+
+// NVC specific extensions to the VHPI interface which are not part of
+// IEEE 1076 and should not be used by portable applications
+
+#include "vhpi_user.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+// Equivalent to calling vhpi_get_value for each element of HANDLES in
+// turn but avoids the per-call overhead for large numbers of signals.
+// Returns zero on success or -1 at the first handle that fails.
+extern int vhpi_get_values(const vhpiHandleT *handles,
+                           vhpiValueT *values,
+                           int count);
+
+// Batched version of vhpi_put_value.  Returns zero on success or
+// non-zero at the first handle that fails.
+extern int vhpi_put_values(const vhpiHandleT *handles,
+                           vhpiValueT *values,
+                           int count,
+                           vhpiPutValueModeT mode);
+
+typedef enum {
+   vhpiAnyEdge,
+   vhpiRisingEdge,
+   vhpiFallingEdge
+} vhpiEdgeT;
+
+typedef struct {
+   vhpiEdgeT edge;     // Edge of BIT or STD_ULOGIC elements to report
+   int32_t   offset;   // Index of first element to watch from the left
+   int32_t   count;    // Number of elements to watch or zero for all
+   int32_t   once;     // Deliver at most once per time step
+} vhpiCbFilterT;
+
+// Register a vhpiCbValueChange callback which is only delivered when
+// the change matches FILTER.  The filter is evaluated by the simulator
+// without calling into the application.
+extern vhpiHandleT vhpi_register_filtered_cb(vhpiCbDataT *cb_data_p,
+                                             const vhpiCbFilterT *filter,
+                                             int32_t flags);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  // _VHPI_EXT_NVC_H
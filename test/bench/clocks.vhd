@@ -0,0 +1,96 @@
+-- Clock dominated design: many free running clock generators each
+-- driving a divider chain and a small counter
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity divider is
+    generic ( STAGES : positive );
+    port (
+        clk  : in std_logic;
+        outs : out std_logic_vector(1 to STAGES) );
+end entity;
+
+architecture rtl of divider is
+    signal chain : std_logic_vector(0 to STAGES) := (others => '0');
+begin
+
+    chain(0) <= clk;
+
+    stages: for i in 1 to STAGES generate
+        process (chain(i - 1)) is
+        begin
+            if falling_edge(chain(i - 1)) then
+                chain(i) <= not chain(i);
+            end if;
+        end process;
+    end generate;
+
+    outs <= chain(1 to STAGES);
+
+end architecture;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity clocks_tb is
+end entity;
+
+architecture test of clocks_tb is
+    constant CLOCKS : positive := 32;
+    constant STAGES : positive := 8;
+    constant RUNTIME : delay_length := 50 us;
+
+    type count_array_t is array (1 to CLOCKS) of natural;
+
+    signal clks   : std_logic_vector(1 to CLOCKS) := (others => '0');
+    signal counts : count_array_t;
+    signal done   : boolean := false;
+begin
+
+    gen: for i in 1 to CLOCKS generate
+        -- Periods between 2 ns and 9 ns so edges rarely coincide
+        constant HALF : delay_length := (1000 + (i * 37) mod 3500) * 1 ps;
+        signal divided : std_logic_vector(1 to STAGES);
+    begin
+
+        clks(i) <= not clks(i) after HALF when not done;
+
+        div: entity work.divider
+            generic map ( STAGES )
+            port map ( clks(i), divided );
+
+        process (clks(i)) is
+            variable count : unsigned(15 downto 0) := (others => '0');
+        begin
+            if rising_edge(clks(i)) then
+                count := count + 1;
+                counts(i) <= to_integer(count);
+            end if;
+        end process;
+
+    end generate;
+
+    check: process is
+        variable expect : natural;
+        variable half   : delay_length;
+    begin
+        wait for RUNTIME;
+        done <= true;
+        wait for 10 ns;
+        for i in 1 to CLOCKS loop
+            half := (1000 + (i * 37) mod 3500) * 1 ps;
+            expect := (RUNTIME / (2 * half)) mod 65536;
+            assert abs (counts(i) - expect) <= 1
+                report "clock " & integer'image(i) & " counted "
+                & integer'image(counts(i)) & " expected "
+                & integer'image(expect);
+        end loop;
+        wait;
+    end process;
+
+end architecture;
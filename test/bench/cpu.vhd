@@ -0,0 +1,250 @@
+-- Small multi-cycle RISC processor running a memory checksum loop
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+package cpu_pkg is
+
+    subtype word_t is unsigned(31 downto 0);
+    type word_array_t is array (natural range <>) of word_t;
+
+    constant OP_LI   : natural := 1;
+    constant OP_ADD  : natural := 2;
+    constant OP_SUB  : natural := 3;
+    constant OP_ADDI : natural := 4;
+    constant OP_LD   : natural := 5;
+    constant OP_ST   : natural := 6;
+    constant OP_BNZ  : natural := 7;
+    constant OP_XOR  : natural := 8;
+    constant OP_HALT : natural := 15;
+
+    function encode (op, rd, ra, rb : natural; imm : integer) return word_t;
+
+    constant DATA_WORDS : natural := 256;
+    constant OUTER      : natural := 50;
+
+    function data_init return word_array_t;
+
+end package;
+
+package body cpu_pkg is
+
+    function encode (op, rd, ra, rb : natural; imm : integer) return word_t is
+    begin
+        return to_unsigned(op, 4) & to_unsigned(rd, 4) & to_unsigned(ra, 4)
+            & to_unsigned(rb, 4) & unsigned(to_signed(imm, 16));
+    end function;
+
+    function data_init return word_array_t is
+        variable result : word_array_t(0 to DATA_WORDS - 1);
+    begin
+        for i in result'range loop
+            result(i) := to_unsigned((i * 7919 + 13) mod 65536, 32);
+        end loop;
+        return result;
+    end function;
+
+end package body;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use work.cpu_pkg.all;
+
+entity ram is
+    generic ( WORDS : natural );
+    port (
+        clk   : in std_logic;
+        we    : in std_logic;
+        addr  : in unsigned(15 downto 0);
+        wdata : in word_t;
+        rdata : out word_t );
+end entity;
+
+architecture rtl of ram is
+    signal mem : word_array_t(0 to WORDS - 1) := data_init;
+begin
+
+    process (clk) is
+        variable index : natural;
+    begin
+        if rising_edge(clk) then
+            index := to_integer(addr) mod WORDS;
+            if we = '1' then
+                mem(index) <= wdata;
+            end if;
+            rdata <= mem(index);
+        end if;
+    end process;
+
+end architecture;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use work.cpu_pkg.all;
+
+entity cpu is
+    port (
+        clk    : in std_logic;
+        reset  : in std_logic;
+        halted : out std_logic;
+        result : out word_t );
+end entity;
+
+architecture rtl of cpu is
+
+    constant program : word_array_t := (
+        0  => encode(OP_LI, 5, 0, 0, OUTER),
+        1  => encode(OP_LI, 3, 0, 0, 0),
+        2  => encode(OP_LI, 1, 0, 0, 0),          -- Outer loop
+        3  => encode(OP_LI, 2, 0, 0, DATA_WORDS),
+        4  => encode(OP_LD, 4, 1, 0, 0),          -- Inner loop
+        5  => encode(OP_ADD, 3, 3, 4, 0),
+        6  => encode(OP_XOR, 4, 4, 3, 0),
+        7  => encode(OP_ST, 0, 1, 4, 0),
+        8  => encode(OP_ADDI, 1, 1, 0, 1),
+        9  => encode(OP_ADDI, 2, 2, 0, -1),
+        10 => encode(OP_BNZ, 0, 2, 0, 4),
+        11 => encode(OP_ADDI, 5, 5, 0, -1),
+        12 => encode(OP_BNZ, 0, 5, 0, 2),
+        13 => encode(OP_HALT, 0, 0, 0, 0) );
+
+    type state_t is (FETCH, EXECUTE, MEMORY, WRITEBACK, STOPPED);
+
+    signal state  : state_t;
+    signal pc     : unsigned(7 downto 0);
+    signal ir     : word_t := (others => '0');
+    signal regs   : word_array_t(0 to 15);
+    signal we     : std_logic;
+    signal addr   : unsigned(15 downto 0) := (others => '0');
+    signal wdata  : word_t := (others => '0');
+    signal rdata  : word_t;
+
+    alias opcode : unsigned(3 downto 0) is ir(31 downto 28);
+    alias rd     : unsigned(3 downto 0) is ir(27 downto 24);
+    alias ra     : unsigned(3 downto 0) is ir(23 downto 20);
+    alias rb     : unsigned(3 downto 0) is ir(19 downto 16);
+    alias imm    : unsigned(15 downto 0) is ir(15 downto 0);
+
+begin
+
+    dmem: entity work.ram
+        generic map ( DATA_WORDS )
+        port map ( clk, we, addr, wdata, rdata );
+
+    process (clk) is
+        variable a, b, simm : word_t;
+    begin
+        if rising_edge(clk) then
+            we <= '0';
+
+            if reset = '1' then
+                state <= FETCH;
+                pc <= (others => '0');
+                regs <= (others => (others => '0'));
+            else
+                a := regs(to_integer(ra));
+                b := regs(to_integer(rb));
+                simm := unsigned(resize(signed(imm), 32));
+
+                case state is
+                    when FETCH =>
+                        ir <= program(to_integer(pc));
+                        pc <= pc + 1;
+                        state <= EXECUTE;
+                    when EXECUTE =>
+                        state <= FETCH;
+                        case to_integer(opcode) is
+                            when OP_LI =>
+                                regs(to_integer(rd)) <= simm;
+                            when OP_ADD =>
+                                regs(to_integer(rd)) <= a + b;
+                            when OP_SUB =>
+                                regs(to_integer(rd)) <= a - b;
+                            when OP_XOR =>
+                                regs(to_integer(rd)) <= a xor b;
+                            when OP_ADDI =>
+                                regs(to_integer(rd)) <= a + simm;
+                            when OP_LD =>
+                                addr <= resize(a + simm, 16);
+                                state <= MEMORY;
+                            when OP_ST =>
+                                addr <= resize(a + simm, 16);
+                                wdata <= b;
+                                we <= '1';
+                            when OP_BNZ =>
+                                if a /= 0 then
+                                    pc <= resize(imm, 8);
+                                end if;
+                            when OP_HALT =>
+                                state <= STOPPED;
+                            when others =>
+                                null;
+                        end case;
+                    when MEMORY =>
+                        state <= WRITEBACK;
+                    when WRITEBACK =>
+                        regs(to_integer(rd)) <= rdata;
+                        state <= FETCH;
+                    when STOPPED =>
+                        null;
+                end case;
+            end if;
+        end if;
+    end process;
+
+    halted <= '1' when state = STOPPED else '0';
+    result <= regs(3);
+
+end architecture;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use work.cpu_pkg.all;
+
+entity cpu_tb is
+end entity;
+
+architecture test of cpu_tb is
+    signal clk    : std_logic := '0';
+    signal reset  : std_logic := '1';
+    signal halted : std_logic;
+    signal result : word_t;
+    signal done   : boolean := false;
+begin
+
+    uut: entity work.cpu
+        port map ( clk, reset, halted, result );
+
+    clk <= not clk after 5 ns when not done;
+    reset <= '0' after 20 ns;
+
+    check: process is
+        variable mem : word_array_t(0 to DATA_WORDS - 1) := data_init;
+        variable acc : word_t := (others => '0');
+    begin
+        for i in 1 to OUTER loop
+            for j in mem'range loop
+                acc := acc + mem(j);
+                mem(j) := mem(j) xor acc;
+            end loop;
+        end loop;
+
+        wait until halted = '1';
+        assert result = acc
+            report "result " & to_hstring(result) & " /= " & to_hstring(acc)
+            severity failure;
+        done <= true;
+        wait;
+    end process;
+
+end architecture;
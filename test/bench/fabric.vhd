@@ -0,0 +1,223 @@
+-- Crossbar connecting several masters to several slaves over a wide
+-- data bus with round-robin arbitration
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+package fabric_pkg is
+
+    constant MASTERS : natural := 8;
+    constant SLAVES  : natural := 8;
+    constant WIDTH   : natural := 256;
+    constant CYCLES  : natural := 20000;
+
+    subtype data_t is std_logic_vector(WIDTH - 1 downto 0);
+    type data_array_t is array (natural range <>) of data_t;
+    type dest_array_t is array (natural range <>) of natural range 0 to SLAVES - 1;
+    type count_array_t is array (natural range <>) of natural;
+
+    function xorshift (x : unsigned(31 downto 0)) return unsigned;
+
+end package;
+
+package body fabric_pkg is
+
+    function xorshift (x : unsigned(31 downto 0)) return unsigned is
+        variable y : unsigned(31 downto 0) := x;
+    begin
+        y := y xor shift_left(y, 13);
+        y := y xor shift_right(y, 17);
+        y := y xor shift_left(y, 5);
+        return y;
+    end function;
+
+end package body;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use work.fabric_pkg.all;
+
+entity crossbar is
+    port (
+        clk     : in std_logic;
+        reset   : in std_logic;
+        m_req   : in std_logic_vector(0 to MASTERS - 1);
+        m_dest  : in dest_array_t(0 to MASTERS - 1);
+        m_data  : in data_array_t(0 to MASTERS - 1);
+        m_gnt   : out std_logic_vector(0 to MASTERS - 1);
+        s_valid : out std_logic_vector(0 to SLAVES - 1);
+        s_data  : out data_array_t(0 to SLAVES - 1) );
+end entity;
+
+architecture rtl of crossbar is
+    type grant_array_t is array (0 to SLAVES - 1) of
+        std_logic_vector(0 to MASTERS - 1);
+
+    signal grants : grant_array_t;
+begin
+
+    arbiters: for s in 0 to SLAVES - 1 generate
+        process (clk) is
+            variable last : natural range 0 to MASTERS - 1 := 0;
+            variable m    : natural range 0 to MASTERS - 1;
+        begin
+            if rising_edge(clk) then
+                grants(s) <= (others => '0');
+                s_valid(s) <= '0';
+
+                if reset = '1' then
+                    last := 0;
+                else
+                    for i in 1 to MASTERS loop
+                        m := (last + i) mod MASTERS;
+                        if m_req(m) = '1' and m_dest(m) = s
+                            and m_gnt(m) = '0'
+                        then
+                            grants(s)(m) <= '1';
+                            s_valid(s) <= '1';
+                            s_data(s) <= m_data(m);
+                            last := m;
+                            exit;
+                        end if;
+                    end loop;
+                end if;
+            end if;
+        end process;
+    end generate;
+
+    process (grants) is
+        variable any : std_logic_vector(0 to MASTERS - 1);
+    begin
+        any := (others => '0');
+        for s in grants'range loop
+            any := any or grants(s);
+        end loop;
+        m_gnt <= any;
+    end process;
+
+end architecture;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use work.fabric_pkg.all;
+
+entity fabric_tb is
+end entity;
+
+architecture test of fabric_tb is
+    signal clk     : std_logic := '0';
+    signal reset   : std_logic := '1';
+    signal stop    : boolean := false;
+    signal done    : boolean := false;
+    signal m_req   : std_logic_vector(0 to MASTERS - 1);
+    signal m_dest  : dest_array_t(0 to MASTERS - 1);
+    signal m_data  : data_array_t(0 to MASTERS - 1);
+    signal m_gnt   : std_logic_vector(0 to MASTERS - 1);
+    signal s_valid : std_logic_vector(0 to SLAVES - 1);
+    signal s_data  : data_array_t(0 to SLAVES - 1);
+    signal sent    : count_array_t(0 to MASTERS - 1);
+    signal recv    : count_array_t(0 to SLAVES - 1);
+    signal m_sum   : data_array_t(0 to MASTERS - 1);
+    signal s_sum   : data_array_t(0 to SLAVES - 1);
+begin
+
+    uut: entity work.crossbar
+        port map ( clk, reset, m_req, m_dest, m_data, m_gnt, s_valid, s_data );
+
+    clk <= not clk after 5 ns when not done;
+    reset <= '0' after 20 ns;
+
+    masters: for m in 0 to MASTERS - 1 generate
+        process (clk) is
+            variable state : unsigned(31 downto 0) := to_unsigned(m + 1, 32);
+            variable data  : data_t;
+            variable count : natural := 0;
+            variable sum   : data_t := (others => '0');
+            variable advance : boolean;
+        begin
+            if rising_edge(clk) then
+                advance := false;
+                if reset = '1' then
+                    advance := true;
+                elsif m_gnt(m) = '1' then
+                    count := count + 1;
+                    sum := sum xor m_data(m);
+                    advance := not stop;
+                    m_req(m) <= '0';
+                elsif stop then
+                    m_req(m) <= '0';
+                elsif m_req(m) = '0' then
+                    advance := true;
+                end if;
+                if advance then
+                    for i in 0 to WIDTH / 32 - 1 loop
+                        state := xorshift(state);
+                        data(i * 32 + 31 downto i * 32) :=
+                            std_logic_vector(state);
+                    end loop;
+                    m_data(m) <= data;
+                    m_dest(m) <= to_integer(state(7 downto 0)) mod SLAVES;
+                    m_req(m) <= '1' when state(9 downto 8) /= "00" else '0';
+                end if;
+                sent(m) <= count;
+                m_sum(m) <= sum;
+            end if;
+        end process;
+    end generate;
+
+    slaves: for s in 0 to SLAVES - 1 generate
+        process (clk) is
+            variable count : natural := 0;
+            variable sum   : data_t := (others => '0');
+        begin
+            if rising_edge(clk) then
+                if s_valid(s) = '1' then
+                    count := count + 1;
+                    sum := sum xor s_data(s);
+                end if;
+                recv(s) <= count;
+                s_sum(s) <= sum;
+            end if;
+        end process;
+    end generate;
+
+    check: process is
+        variable nsent, nrecv : natural := 0;
+        variable xsent, xrecv : data_t := (others => '0');
+    begin
+        wait until reset = '0';
+        for i in 1 to CYCLES loop
+            wait until rising_edge(clk);
+        end loop;
+        stop <= true;
+        for i in 1 to 5 loop
+            wait until rising_edge(clk);
+        end loop;
+
+        for m in sent'range loop
+            nsent := nsent + sent(m);
+            xsent := xsent xor m_sum(m);
+        end loop;
+
+        for s in recv'range loop
+            nrecv := nrecv + recv(s);
+            xrecv := xrecv xor s_sum(s);
+        end loop;
+
+        assert nsent = nrecv;
+        assert xsent = xrecv;
+        assert nsent > CYCLES * 2
+            report "only " & integer'image(nsent) & " transfers";
+
+        done <= true;
+        wait;
+    end process;
+
+end architecture;
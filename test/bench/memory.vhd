@@ -0,0 +1,156 @@
+-- Large memories: a sparse behavioural model that allocates pages on
+-- demand from the heap alongside a march test over a big signal array
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+package memory_pkg is
+
+    constant PAGE_BITS : natural := 8;
+    constant PAGES     : natural := 4096;
+    constant RAM_WORDS : natural := 65536;
+
+    subtype word_t is std_logic_vector(31 downto 0);
+    type word_array_t is array (natural range <>) of word_t;
+
+    type memory_t is protected
+        procedure write (addr : natural; data : word_t);
+        impure function read (addr : natural) return word_t;
+        procedure clear;
+        impure function get_pages return natural;
+    end protected;
+
+end package;
+
+package body memory_pkg is
+
+    type memory_t is protected body
+        type page_t is array (0 to 2 ** PAGE_BITS - 1) of word_t;
+        type page_ptr_t is access page_t;
+        type page_table_t is array (0 to PAGES - 1) of page_ptr_t;
+
+        variable table : page_table_t;
+        variable count : natural := 0;
+
+        procedure write (addr : natural; data : word_t) is
+            constant page : natural := addr / 2 ** PAGE_BITS;
+        begin
+            if table(page) = null then
+                table(page) := new page_t'(others => (others => 'U'));
+                count := count + 1;
+            end if;
+            table(page)(addr mod 2 ** PAGE_BITS) := data;
+        end procedure;
+
+        impure function read (addr : natural) return word_t is
+            constant page : natural := addr / 2 ** PAGE_BITS;
+        begin
+            if table(page) = null then
+                return (word_t'range => 'U');
+            else
+                return table(page)(addr mod 2 ** PAGE_BITS);
+            end if;
+        end function;
+
+        procedure clear is
+        begin
+            for i in table'range loop
+                deallocate(table(i));
+            end loop;
+            count := 0;
+        end procedure;
+
+        impure function get_pages return natural is
+        begin
+            return count;
+        end function;
+    end protected body;
+
+end package body;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use work.memory_pkg.all;
+
+entity memory_tb is
+end entity;
+
+architecture test of memory_tb is
+    signal ram  : word_array_t(0 to RAM_WORDS - 1);
+    signal done : boolean := false;
+
+    shared variable model : memory_t;
+begin
+
+    -- Fill scattered pages of the sparse model, read them back and free
+    -- everything several times over so the heap turns over
+    sparse: process is
+        variable addr  : unsigned(19 downto 0) := (others => '1');
+        variable start : unsigned(19 downto 0);
+    begin
+        for round in 1 to 4 loop
+            start := addr;
+            for i in 1 to 50000 loop
+                addr := resize(addr * 69069 + 1, addr'length);
+                model.write(to_integer(addr), std_logic_vector(resize(addr, 32)));
+            end loop;
+
+            addr := start;
+            for i in 1 to 50000 loop
+                addr := resize(addr * 69069 + 1, addr'length);
+                assert model.read(to_integer(addr))
+                    = std_logic_vector(resize(addr, 32));
+            end loop;
+
+            assert model.get_pages = PAGES;
+            model.clear;
+            wait for 1 ns;
+        end loop;
+        wait;
+    end process;
+
+    -- March C- over a signal array one word per delta cycle
+    march: process is
+        constant ZERO : word_t := (others => '0');
+        constant ONES : word_t := (others => '1');
+
+        procedure up (expect, value : word_t) is
+        begin
+            for i in ram'range loop
+                assert ram(i) = expect;
+                ram(i) <= value;
+                if i mod 256 = 255 then
+                    wait for 0 ns;
+                end if;
+            end loop;
+            wait for 0 ns;
+        end procedure;
+
+        procedure down (expect, value : word_t) is
+        begin
+            for i in ram'reverse_range loop
+                assert ram(i) = expect;
+                ram(i) <= value;
+                if i mod 256 = 0 then
+                    wait for 0 ns;
+                end if;
+            end loop;
+            wait for 0 ns;
+        end procedure;
+    begin
+        ram <= (others => ZERO);
+        wait for 1 ns;
+        up(ZERO, ONES);
+        up(ONES, ZERO);
+        down(ZERO, ONES);
+        down(ONES, ZERO);
+        up(ZERO, ZERO);
+        done <= true;
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,309 @@
+-- Transaction level testbench in the style of OSVVM: a test sequencer
+-- drives a bus functional model through a record of resolved signals
+-- and checks the results against a protected type scoreboard
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+package txn_pkg is
+
+    constant TRANSACTIONS : natural := 20000;
+
+    type operation_t is (OP_NONE, OP_WRITE, OP_READ);
+    type operation_vector is array (natural range <>) of operation_t;
+
+    function resolved_max (v : operation_vector) return operation_t;
+    function resolved_max (v : integer_vector) return integer;
+
+    subtype resolved_operation_t is resolved_max operation_t;
+    subtype resolved_natural is resolved_max natural;
+
+    type rec_t is record
+        rdy     : resolved_natural;
+        ack     : resolved_natural;
+        op      : resolved_operation_t;
+        addr    : std_logic_vector(31 downto 0);
+        data_in : std_logic_vector(31 downto 0);
+        data_out: std_logic_vector(31 downto 0);
+    end record;
+
+    constant REC_INIT : rec_t := (0, 0, OP_NONE, (others => 'Z'),
+                                  (others => 'Z'), (others => 'Z'));
+
+    procedure request (signal rec : inout rec_t);
+
+    procedure bus_write (signal rec : inout rec_t;
+                         addr, data : in std_logic_vector(31 downto 0));
+
+    procedure bus_read (signal rec : inout rec_t;
+                        addr : in std_logic_vector(31 downto 0);
+                        data : out std_logic_vector(31 downto 0));
+
+    type scoreboard_t is protected
+        procedure push (value : std_logic_vector);
+        impure function check (value : std_logic_vector) return boolean;
+        impure function is_empty return boolean;
+        impure function get_checks return natural;
+        impure function get_errors return natural;
+    end protected;
+
+end package;
+
+package body txn_pkg is
+
+    function resolved_max (v : operation_vector) return operation_t is
+        variable result : operation_t := OP_NONE;
+    begin
+        for i in v'range loop
+            if v(i) > result then
+                result := v(i);
+            end if;
+        end loop;
+        return result;
+    end function;
+
+    function resolved_max (v : integer_vector) return integer is
+        variable result : integer := 0;
+    begin
+        for i in v'range loop
+            if v(i) > result then
+                result := v(i);
+            end if;
+        end loop;
+        return result;
+    end function;
+
+    procedure request (signal rec : inout rec_t) is
+    begin
+        rec.rdy <= rec.rdy + 1;
+        wait until rec.ack = rec.rdy;
+    end procedure;
+
+    procedure bus_write (signal rec : inout rec_t;
+                         addr, data : in std_logic_vector(31 downto 0)) is
+    begin
+        rec.op <= OP_WRITE;
+        rec.addr <= addr;
+        rec.data_in <= data;
+        request(rec);
+        rec.op <= OP_NONE;
+    end procedure;
+
+    procedure bus_read (signal rec : inout rec_t;
+                        addr : in std_logic_vector(31 downto 0);
+                        data : out std_logic_vector(31 downto 0)) is
+    begin
+        rec.op <= OP_READ;
+        rec.addr <= addr;
+        request(rec);
+        data := rec.data_out;
+        rec.op <= OP_NONE;
+    end procedure;
+
+    type scoreboard_t is protected body
+        type item_t;
+        type item_ptr_t is access item_t;
+        type item_t is record
+            value : std_logic_vector(31 downto 0);
+            link  : item_ptr_t;
+        end record;
+
+        variable head, tail : item_ptr_t;
+        variable checks, errors : natural := 0;
+
+        procedure push (value : std_logic_vector) is
+            variable item : item_ptr_t;
+        begin
+            item := new item_t'(value, null);
+            if tail = null then
+                head := item;
+            else
+                tail.link := item;
+            end if;
+            tail := item;
+        end procedure;
+
+        impure function check (value : std_logic_vector) return boolean is
+            variable item : item_ptr_t := head;
+            variable match : boolean;
+        begin
+            assert item /= null report "scoreboard empty" severity failure;
+            match := item.value = value;
+            head := item.link;
+            if head = null then
+                tail := null;
+            end if;
+            deallocate(item);
+            checks := checks + 1;
+            if not match then
+                errors := errors + 1;
+            end if;
+            return match;
+        end function;
+
+        impure function is_empty return boolean is
+        begin
+            return head = null;
+        end function;
+
+        impure function get_checks return natural is
+        begin
+            return checks;
+        end function;
+
+        impure function get_errors return natural is
+        begin
+            return errors;
+        end function;
+    end protected body;
+
+end package body;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use work.txn_pkg.all;
+
+entity bus_slave is
+    port (
+        clk   : in std_logic;
+        valid : in std_logic;
+        write : in std_logic;
+        addr  : in std_logic_vector(31 downto 0);
+        wdata : in std_logic_vector(31 downto 0);
+        ready : out std_logic;
+        rdata : out std_logic_vector(31 downto 0) );
+end entity;
+
+architecture rtl of bus_slave is
+    type mem_t is array (0 to 1023) of std_logic_vector(31 downto 0);
+    signal mem : mem_t := (others => (others => '0'));
+begin
+
+    process (clk) is
+        variable index : natural;
+    begin
+        if rising_edge(clk) then
+            ready <= '0';
+            if valid = '1' and ready = '0' then
+                index := to_integer(unsigned(addr(11 downto 2)));
+                if write = '1' then
+                    mem(index) <= wdata;
+                end if;
+                rdata <= mem(index);
+                ready <= '1';
+            end if;
+        end if;
+    end process;
+
+end architecture;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use work.txn_pkg.all;
+
+entity bus_master_bfm is
+    port (
+        clk   : in std_logic;
+        rec   : inout rec_t := REC_INIT;
+        valid : out std_logic;
+        write : out std_logic;
+        addr  : out std_logic_vector(31 downto 0);
+        wdata : out std_logic_vector(31 downto 0);
+        ready : in std_logic;
+        rdata : in std_logic_vector(31 downto 0) );
+end entity;
+
+architecture bfm of bus_master_bfm is
+begin
+
+    process is
+    begin
+        valid <= '0';
+        write <= '0';
+        loop
+            wait until rec.rdy /= rec.ack;
+            wait until rising_edge(clk);
+            valid <= '1';
+            write <= '1' when rec.op = OP_WRITE else '0';
+            addr <= rec.addr;
+            wdata <= rec.data_in;
+            wait until rising_edge(clk) and ready = '1';
+            valid <= '0';
+            rec.data_out <= rdata;
+            rec.ack <= rec.ack + 1;
+        end loop;
+    end process;
+
+end architecture;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use work.txn_pkg.all;
+
+entity txn_tb is
+end entity;
+
+architecture test of txn_tb is
+    signal clk   : std_logic := '0';
+    signal done  : boolean := false;
+    signal rec   : rec_t := REC_INIT;
+    signal valid : std_logic;
+    signal write : std_logic;
+    signal addr  : std_logic_vector(31 downto 0);
+    signal wdata : std_logic_vector(31 downto 0);
+    signal ready : std_logic;
+    signal rdata : std_logic_vector(31 downto 0);
+
+    shared variable sb : scoreboard_t;
+begin
+
+    clk <= not clk after 5 ns when not done;
+
+    bfm: entity work.bus_master_bfm
+        port map ( clk, rec, valid, write, addr, wdata, ready, rdata );
+
+    slave: entity work.bus_slave
+        port map ( clk, valid, write, addr, wdata, ready, rdata );
+
+    sequencer: process is
+        type shadow_t is array (0 to 1023) of std_logic_vector(31 downto 0);
+        variable shadow : shadow_t := (others => (others => '0'));
+        variable seed   : unsigned(31 downto 0) := X"1234abcd";
+        variable index  : natural;
+        variable a, d   : std_logic_vector(31 downto 0);
+    begin
+        for i in 1 to TRANSACTIONS loop
+            seed := seed xor shift_left(seed, 13);
+            seed := seed xor shift_right(seed, 17);
+            seed := seed xor shift_left(seed, 5);
+            index := to_integer(seed(11 downto 2));
+            a := X"00000" & std_logic_vector(seed(11 downto 2)) & "00";
+            if seed(31) = '1' then
+                d := std_logic_vector(seed);
+                shadow(index) := d;
+                bus_write(rec, a, d);
+            else
+                sb.push(shadow(index));
+                bus_read(rec, a, d);
+                assert sb.check(d) report "mismatch at " & to_hstring(a);
+            end if;
+        end loop;
+
+        assert sb.is_empty;
+        assert sb.get_errors = 0;
+        report "checked " & integer'image(sb.get_checks) & " reads";
+        done <= true;
+        wait;
+    end process;
+
+end architecture;
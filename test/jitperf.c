@@ -35,6 +35,8 @@
 
 #define ITERATIONS 5
 
+static bool preload = true;
+
 static double mean(double *arr, int len)
 {
    double r = 0.0;
@@ -58,7 +60,8 @@ static void run_benchmark(tree_t pack, tree_t proc)
    ident_t name = tree_ident2(proc);
 
    jit_t *j = jit_new();
-   jit_preload(j);
+   if (preload)
+      jit_preload(j);
 
 #if defined LLVM_HAS_LLJIT && 1
    jit_register_llvm_plugin(j);
@@ -131,6 +134,8 @@ static void usage(void)
           "\n"
           " -f PATTERN\t\t Only run tests matching PATTERN\n"
           " -L PATH\t\tAdd PATH to library search paths\n"
+          " -n\t\t\tDisable native IEEE library intrinsics\n"
+          " -P\t\t\tDo not load precompiled IEEE libraries\n"
           "\n");
 
    LOCAL_TEXT_BUF tb = tb_new();
@@ -163,7 +168,7 @@ int main(int argc, char **argv)
 
    const char *filter = NULL;
    int c, index = 0;
-   const char *spec = "L:hf:i";
+   const char *spec = "L:hf:inP";
    while ((c = getopt_long(argc, argv, spec, long_options, &index)) != -1) {
       switch (c) {
       case 0:
@@ -181,6 +186,12 @@ int main(int argc, char **argv)
       case 'i':
          opt_set_int(OPT_JIT_THRESHOLD, 0);
          break;
+      case 'n':
+         opt_set_int(OPT_JIT_INTRINSICS, 0);
+         break;
+      case 'P':
+         preload = false;
+         break;
       default:
          if (optopt == 0)
             fatal("unrecognised option $bold$%s$$", argv[optind - 1]);
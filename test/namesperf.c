@@ -0,0 +1,214 @@
+//
+//  Copyright (C) 2023  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "common.h"
+#include "diag.h"
+#include "ident.h"
+#include "lib.h"
+#include "option.h"
+#include "phase.h"
+#include "scan.h"
+#include "thread.h"
+
+#include <getopt.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ITERATIONS 5
+
+static double mean(double *arr, int len)
+{
+   double r = 0.0;
+   for (int i = 0; i < len; i++)
+      r += arr[i];
+   return r / len;
+}
+
+static void generate_library(const char *file, int nunits)
+{
+   // Unrelated design units so that probing the library for a name
+   // that does not exist is realistically expensive
+
+   FILE *f = fopen(file, "w");
+   if (f == NULL)
+      fatal_errno("%s", file);
+
+   for (int i = 0; i < nunits; i++)
+      fprintf(f, "package other_%d is\n"
+              "  constant C : integer := %d;\n"
+              "end package;\n", i, i);
+
+   fclose(f);
+}
+
+static void generate_regmap(const char *file, int nconsts)
+{
+   // Models a generated register map: a large package of constants
+   // each of which refers to an earlier declaration by name
+
+   FILE *f = fopen(file, "w");
+   if (f == NULL)
+      fatal_errno("%s", file);
+
+   fprintf(f, "library ieee;\n"
+           "use ieee.std_logic_1164.all;\n"
+           "use work.all;\n"
+           "package regmap is\n"
+           "  constant BASE : natural := 16#1000#;\n");
+
+   for (int i = 0; i < nconsts; i++) {
+      fprintf(f, "  constant REG_%d_ADDR : natural := BASE + %d;\n", i, i * 4);
+      fprintf(f, "  constant REG_%d_RESET : std_logic_vector(31 downto 0) "
+              ":= (others => '0');\n", i);
+   }
+
+   for (int i = 0; i < nconsts / 10; i++)
+      fprintf(f, "  function is_reg_%d (addr : natural) return boolean;\n", i);
+
+   fprintf(f, "end package;\n"
+           "package body regmap is\n");
+
+   for (int i = 0; i < nconsts / 10; i++)
+      fprintf(f, "  function is_reg_%d (addr : natural) return boolean is\n"
+              "    variable result : boolean;\n"
+              "  begin\n"
+              "    result := addr = REG_%d_ADDR;\n"
+              "    return result;\n"
+              "  end function;\n", i, i);
+
+   fprintf(f, "end package body;\n");
+
+   fclose(f);
+}
+
+static void analyse_file(const char *file, lib_t work)
+{
+   input_from_file(file);
+
+   tree_t unit;
+   while ((unit = parse())) {
+      if (error_count() > 0)
+         exit(EXIT_FAILURE);
+
+      lib_put(work, unit);
+   }
+}
+
+static void usage(void)
+{
+   printf("Usage: namesperf [OPTION]...\n"
+          "\n"
+          " -L PATH\t\tAdd PATH to library search paths\n"
+          " -n COUNT\t\tNumber of registers in generated package\n"
+          "\n");
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   lib_print_search_paths(tb);
+   printf("Library search paths:%s\n", tb_get(tb));
+
+   printf("\nReport bugs to %s\n", PACKAGE_BUGREPORT);
+}
+
+int main(int argc, char **argv)
+{
+   term_init();
+   set_default_options();
+   thread_init();
+   register_signal_handlers();
+   intern_strings();
+
+   opt_set_size(OPT_ARENA_SIZE, 1 << 30);
+
+   static struct option long_options[] = {
+      { 0, 0, 0, 0 }
+   };
+
+   opterr = 0;
+
+   int nconsts = 10000;
+   int c, index = 0;
+   const char *spec = "L:hn:";
+   while ((c = getopt_long(argc, argv, spec, long_options, &index)) != -1) {
+      switch (c) {
+      case 0:
+         // Set a flag
+         break;
+      case 'L':
+         lib_add_search_path(optarg);
+         break;
+      case 'h':
+         usage();
+         return 0;
+      case 'n':
+         nconsts = atoi(optarg);
+         break;
+      default:
+         if (optopt == 0)
+            fatal("unrecognised option $bold$%s$$", argv[optind - 1]);
+         else
+            fatal("unrecognised option $bold$-%c$$", optopt);
+      }
+   }
+
+   if (nconsts <= 0)
+      fatal("register count must be positive");
+
+   char *dir = nvc_temp_file();
+   remove(dir);
+
+   char *libspec LOCAL = xasprintf("perf:%s", dir);
+   lib_t work = lib_new(libspec);
+   lib_set_work(work);
+
+   char *file = nvc_temp_file();
+   generate_library(file, 500);
+   analyse_file(file, work);
+   lib_save(work);
+
+   generate_regmap(file, nconsts);
+
+   double msec[ITERATIONS + 1];
+   for (int trial = 0; trial < ITERATIONS + 1; trial++) {
+      const uint64_t start_us = get_timestamp_us();
+
+      analyse_file(file, work);
+
+      msec[trial] = (get_timestamp_us() - start_us) / 1000.0;
+
+      if (trial == 0)
+         printf("warmup: ");
+      else
+         printf("trial %d: ", trial);
+
+      printf("%.1f ms; %.2f us/register\n", msec[trial],
+             msec[trial] * 1000.0 / nconsts);
+      fflush(stdout);
+   }
+
+   color_printf("\n$!green$--> %.1f ms$$\n", mean(msec + 1, ITERATIONS));
+
+   lib_destroy(work);
+
+   remove(file);
+   free(file);
+   free(dir);
+
+   return 0;
+}
@@ -0,0 +1,216 @@
+//
+//  Copyright (C) 2023  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "common.h"
+#include "diag.h"
+#include "ident.h"
+#include "lib.h"
+#include "option.h"
+#include "phase.h"
+#include "scan.h"
+#include "thread.h"
+
+#include <getopt.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define ITERATIONS 3
+
+static size_t generate(const char *file, size_t target)
+{
+   // Models the output of a ROM initialisation generator: one large
+   // package per chunk containing a constant array of literals
+
+   FILE *f = fopen(file, "w");
+   if (f == NULL)
+      fatal_errno("%s", file);
+
+   for (int unit = 0; ftell(f) < target; unit++) {
+      fprintf(f, "library ieee;\n"
+              "use ieee.std_logic_1164.all;\n"
+              "package rom_%d is\n"
+              "  type rom_t is array (0 to 4096) of "
+              "std_logic_vector(31 downto 0);\n"
+              "  constant ROM : rom_t := (\n", unit);
+
+      for (int i = 0; i < 4096; i++)
+         fprintf(f, "    %d => X\"%08x\",  -- word %d\n", i,
+                 (unsigned)(i * 2654435761u), i);
+
+      fprintf(f, "    others => (others => '0'));\n"
+              "end package;\n\n");
+   }
+
+   const size_t size = ftell(f);
+   fclose(f);
+   return size;
+}
+
+static void report(const char *what, double msec, size_t bytes)
+{
+   nvc_rusage_t ru;
+   nvc_rusage(&ru);
+
+   printf("%s: %.1f ms; ", what, msec);
+   if (bytes > 0)
+      printf("%.1f MB/s; ", (bytes / (1024.0 * 1024.0)) / (msec / 1000.0));
+   printf("max RSS %u kB\n", ru.rss);
+   fflush(stdout);
+}
+
+static void lex_file(const char *file, size_t bytes)
+{
+   input_from_file(file);
+
+   const uint64_t start_us = get_timestamp_us();
+
+   extern yylval_t yylval;
+
+   unsigned ntokens = 0;
+   for (int tok; (tok = processed_yylex()) != tEOF; ntokens++) {
+      // The parser normally takes ownership of these strings
+      if (tok == tID || tok == tSTRING || tok == tBITSTRING)
+         free(yylval.s);
+   }
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   tb_printf(tb, "lex %u tokens", ntokens);
+
+   report(tb_get(tb), (get_timestamp_us() - start_us) / 1000.0, bytes);
+}
+
+static void parse_file(const char *file, size_t bytes)
+{
+   input_from_file(file);
+
+   const uint64_t start_us = get_timestamp_us();
+
+   while (parse()) {
+      if (error_count() > 0)
+         exit(EXIT_FAILURE);
+   }
+
+   report("parse", (get_timestamp_us() - start_us) / 1000.0, bytes);
+}
+
+static void usage(void)
+{
+   printf("Usage: parseperf [OPTION]... [FILE]\n"
+          "\n"
+          "Measure lexer and parser throughput on FILE or a generated\n"
+          "source file if FILE is omitted.  Use - to stream from standard\n"
+          "input which is only lexed once.\n"
+          "\n"
+          " -L PATH\t\tAdd PATH to library search paths\n"
+          " -p\t\tAlso parse the input\n"
+          " -s SIZE\t\tSize of generated source file in megabytes\n"
+          "\n");
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   lib_print_search_paths(tb);
+   printf("Library search paths:%s\n", tb_get(tb));
+
+   printf("\nReport bugs to %s\n", PACKAGE_BUGREPORT);
+}
+
+int main(int argc, char **argv)
+{
+   term_init();
+   set_default_options();
+   thread_init();
+   register_signal_handlers();
+   intern_strings();
+
+   opt_set_size(OPT_ARENA_SIZE, 1 << 30);
+
+   static struct option long_options[] = {
+      { 0, 0, 0, 0 }
+   };
+
+   opterr = 0;
+
+   size_t size_mb = 64;
+   bool do_parse = false;
+   int c, index = 0;
+   const char *spec = "L:hps:";
+   while ((c = getopt_long(argc, argv, spec, long_options, &index)) != -1) {
+      switch (c) {
+      case 0:
+         // Set a flag
+         break;
+      case 'L':
+         lib_add_search_path(optarg);
+         break;
+      case 'h':
+         usage();
+         return 0;
+      case 'p':
+         do_parse = true;
+         break;
+      case 's':
+         size_mb = atoi(optarg);
+         break;
+      default:
+         if (optopt == 0)
+            fatal("unrecognised option $bold$%s$$", argv[optind - 1]);
+         else
+            fatal("unrecognised option $bold$-%c$$", optopt);
+      }
+   }
+
+   lib_t work = lib_tmp("PERF");
+   lib_set_work(work);
+
+   if (optind < argc && strcmp(argv[optind], "-") == 0) {
+      // Standard input can only be read once
+      lex_file("-", 0);
+      return 0;
+   }
+
+   char *tmp = NULL;
+   const char *file;
+   size_t bytes;
+   if (optind < argc) {
+      file = argv[optind];
+
+      struct stat st;
+      if (stat(file, &st) != 0)
+         fatal_errno("%s", file);
+
+      bytes = st.st_size;
+   }
+   else {
+      file = tmp = nvc_temp_file();
+      bytes = generate(file, size_mb * 1024 * 1024);
+   }
+
+   for (int trial = 0; trial < ITERATIONS; trial++)
+      lex_file(file, bytes);
+
+   if (do_parse)
+      parse_file(file, bytes);
+
+   if (tmp != NULL) {
+      remove(tmp);
+      free(tmp);
+   }
+
+   return 0;
+}
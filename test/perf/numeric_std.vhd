@@ -1,5 +1,16 @@
+-- Compare the native IEEE library intrinsics against the VHDL
+-- implementations with
+--
+--   jitperf -P -L lib/ test/perf/numeric_std.vhd
+--   jitperf -P -n -L lib/ test/perf/numeric_std.vhd
+
 package numeric_std_perf is
     procedure test_to_unsigned;
+    procedure test_to_unsigned_wide;
+    procedure test_add_unsigned;
+    procedure test_add_unsigned_wide;
+    procedure test_resize;
+    procedure test_counter;
 end package;
 
 library ieee;
@@ -20,4 +31,50 @@ package body numeric_std_perf is
         end loop;
     end procedure;
 
+    procedure test_to_unsigned_wide is
+        constant WIDTH : integer := 64;
+        variable s     : unsigned(WIDTH - 1 downto 0);
+    begin
+        for j in 0 to 255 loop
+            s := to_unsigned(j * 12345, WIDTH);
+        end loop;
+    end procedure;
+
+    procedure test_add_unsigned is
+        constant WIDTH : integer := 16;
+        variable a, b  : unsigned(WIDTH - 1 downto 0) := X"1234";
+    begin
+        for j in 1 to 256 loop
+            a := a + b;
+        end loop;
+    end procedure;
+
+    procedure test_add_unsigned_wide is
+        constant WIDTH : integer := 128;
+        variable a, b  : unsigned(WIDTH - 1 downto 0) := (others => '1');
+    begin
+        for j in 1 to 256 loop
+            a := a + b;
+        end loop;
+    end procedure;
+
+    procedure test_resize is
+        variable a : unsigned(31 downto 0) := X"deadbeef";
+        variable b : unsigned(47 downto 0);
+    begin
+        for j in 1 to 256 loop
+            b := resize(a, 48);
+            a := resize(b, 32);
+        end loop;
+    end procedure;
+
+    procedure test_counter is
+        -- Typical RTL counter with increment and wrap
+        variable count : unsigned(11 downto 0) := (others => '0');
+    begin
+        for j in 1 to 256 loop
+            count := resize(count + to_unsigned(1, count'length), 12);
+        end loop;
+    end procedure;
+
 end package body;
@@ -0,0 +1,23 @@
+set -xe
+
+pwd
+which nvc
+
+nvc -a $TESTDIR/regress/cover13.vhd
+
+for i in 1 2 3 4; do
+  nvc -e -gG_VAL=$i --cover=statement,branch cover13 -r
+  mv work/_WORK.COVER13.elab.covdb DB$i.covdb
+done
+
+# Merging all the databases at once must give the same result as
+# merging them one at a time in order
+nvc -c --merge DB12.covdb DB1.covdb DB2.covdb
+nvc -c --merge DB123.covdb DB12.covdb DB3.covdb
+nvc -c --merge DB1234.covdb --report html1 DB123.covdb DB4.covdb \
+    2>&1 | tee out.txt
+
+nvc -c --merge DB_MERGED.covdb --report html2 DB1.covdb DB2.covdb \
+    DB3.covdb DB4.covdb 2>&1 | tee -a out.txt
+
+diff -u $TESTDIR/regress/gold/cover13.txt out.txt
@@ -0,0 +1,28 @@
+entity cover13 is
+    generic ( G_VAL : integer );
+end entity;
+
+architecture test of cover13 is
+    signal cnt : integer := G_VAL;
+begin
+
+    -- Not present in the database for G_VAL = 3
+    g: if G_VAL /= 3 generate
+        process (cnt) is
+        begin
+            if cnt = 4 then
+                report "cnt = 4";
+            else
+                report "cnt /= 4";
+            end if;
+        end process;
+    end generate;
+
+    process (cnt) is
+    begin
+        if cnt = 2 then
+            report "cnt = 2";
+        end if;
+    end process;
+
+end architecture;
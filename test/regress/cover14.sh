@@ -0,0 +1,25 @@
+set -xe
+
+pwd
+which nvc
+
+nvc -a $TESTDIR/regress/cover14.vhd -e --cover=statement,branch cover14
+
+# Kill the simulation once it is in the endless loop so the counters
+# are only in the live file
+nvc -r cover14 > sim.txt 2>&1 &
+pid=$!
+while ! grep -q looping sim.txt; do sleep 0.1; done
+sleep 0.5
+kill -9 $pid
+wait $pid || true
+
+test -f work/_WORK.COVER14.elab.covdb.live
+
+# A single database is reported on without loading every tag
+nvc -c --report html1 work/_WORK.COVER14.elab.covdb 2>&1 | tee out.txt
+
+nvc -c --merge merged.covdb --report html2 work/_WORK.COVER14.elab.covdb \
+    2>&1 | tee -a out.txt
+
+diff -u $TESTDIR/regress/gold/cover14.txt out.txt
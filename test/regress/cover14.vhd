@@ -0,0 +1,38 @@
+entity sub is
+    port ( x : in integer );
+end entity;
+
+architecture test of sub is
+begin
+
+    process (x) is
+    begin
+        if x > 2 then
+            report "big";
+        end if;
+    end process;
+
+end architecture;
+
+entity cover14 is
+end entity;
+
+architecture test of cover14 is
+    signal s : integer := 0;
+begin
+
+    u: entity work.sub port map ( s );
+
+    process is
+    begin
+        for i in 1 to 3 loop
+            s <= i;
+            wait for 1 ns;
+        end loop;
+        report "looping";
+        loop                            -- Runs until killed
+            wait for 1 ns;
+        end loop;
+    end process;
+
+end architecture;
@@ -0,0 +1,93 @@
+entity sub is
+    generic ( N : integer );
+    port ( i : in integer; o : out integer );
+end entity;
+
+architecture test of sub is
+    signal t : integer := 0;
+begin
+
+    t <= i + N;
+
+    process (t) is
+    begin
+        o <= t - 1;
+    end process;
+
+end architecture;
+
+-------------------------------------------------------------------------------
+
+entity named is
+    generic ( N : integer );
+end entity;
+
+architecture test of named is
+    signal s : integer := N;
+begin
+
+    process is
+    begin
+        wait for 1 ns;
+        report s'path_name & " = " & integer'image(s);
+        wait;
+    end process;
+
+end architecture;
+
+-------------------------------------------------------------------------------
+
+entity elab36 is
+end entity;
+
+architecture test of elab36 is
+    type int_vector is array (natural range <>) of integer;
+    signal x, y : int_vector(0 to 3) := (others => 0);
+    signal z    : int_vector(0 to 1) := (others => 0);
+    signal c    : integer := 5;
+begin
+
+    -- Instances with identical generics share an elaborated copy
+    g: for n in 0 to 3 generate
+        u: entity work.sub generic map (1) port map (x(n), y(n));
+    end generate;
+
+    -- Port map expressions change the layout of the instance
+    u1: entity work.sub generic map (2) port map (c, z(0));
+    u2: entity work.sub generic map (2) port map (c + 1, z(1));
+
+    n1: entity work.named generic map (1);
+    n2: entity work.named generic map (1);
+    n3: entity work.named generic map (3);
+
+    -- Calls a function elaborated separately for each iteration
+    g2: for i in 1 to 2 generate
+        signal s : integer;
+        impure function name return string is
+        begin
+            return s'path_name;
+        end function;
+    begin
+        p: process is
+        begin
+            wait for 2 ns;
+            report name;
+            wait;
+        end process;
+    end generate;
+
+    check: process is
+    begin
+        for k in 0 to 3 loop
+            x(k) <= k * 10;
+        end loop;
+        wait for 1 ns;
+        for k in 0 to 3 loop
+            assert y(k) = k * 10;
+        end loop;
+        assert z(0) = 6;
+        assert z(1) = 7;
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,165 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity ieee11 is
+end entity;
+
+architecture test of ieee11 is
+
+    -- Check native implementations of numeric_std and std_logic_1164
+    -- functions against straightforward VHDL
+
+    function ref_add (l, r : unsigned) return unsigned is
+        constant size  : natural := maximum(l'length, r'length);
+        alias la       : unsigned(l'length - 1 downto 0) is l;
+        alias ra       : unsigned(r'length - 1 downto 0) is r;
+        variable result : unsigned(size - 1 downto 0) := (others => '0');
+        variable carry  : natural := 0;
+        variable sum    : natural;
+    begin
+        for i in 0 to size - 1 loop
+            sum := carry;
+            if i < l'length then
+                case la(i) is
+                    when '1' | 'H' => sum := sum + 1;
+                    when '0' | 'L' => null;
+                    when others => return (size - 1 downto 0 => 'X');
+                end case;
+            end if;
+            if i < r'length then
+                case ra(i) is
+                    when '1' | 'H' => sum := sum + 1;
+                    when '0' | 'L' => null;
+                    when others => return (size - 1 downto 0 => 'X');
+                end case;
+            end if;
+            if sum mod 2 = 1 then
+                result(i) := '1';
+            end if;
+            carry := sum / 2;
+        end loop;
+        return result;
+    end function;
+
+    function ref_resize (arg : unsigned; size : natural) return unsigned is
+        alias xarg : unsigned(arg'length - 1 downto 0) is arg;
+        variable result : unsigned(size - 1 downto 0) := (others => '0');
+    begin
+        for i in 0 to minimum(size, arg'length) - 1 loop
+            result(i) := xarg(i);
+        end loop;
+        return result;
+    end function;
+
+    function same (l, r : unsigned) return boolean is
+    begin
+        -- Predefined equality rather than numeric_std "="
+        return std_ulogic_vector(l) = std_ulogic_vector(r);
+    end function;
+
+    signal clk : std_logic := 'U';
+    signal rising, falling : natural := 0;
+
+begin
+
+    numeric: process is
+        variable a, b : unsigned(1 to 200);
+        variable la, lb : natural;
+        variable u : unsigned(7 downto 0);
+        variable v : unsigned(1 to 3);
+
+        variable seed : natural := 12345;
+
+        impure function random (n : natural) return natural is
+        begin
+            seed := (seed * 1103 + 12345) mod 1048573;
+            return seed mod n;
+        end function;
+
+        impure function random_vector (n : natural; meta : boolean)
+            return unsigned
+        is
+            constant values : std_ulogic_vector := "01LH01UXZW-";
+            variable result : unsigned(n - 1 downto 0);
+        begin
+            for i in result'range loop
+                if meta and random(8) = 0 then
+                    result(i) := values(values'left + random(values'length));
+                else
+                    result(i) := values(values'left + random(4));
+                end if;
+            end loop;
+            return result;
+        end function;
+
+    begin
+        for i in 1 to 2000 loop
+            la := 1 + random(150);
+            lb := 1 + random(150);
+            a(1 to la) := random_vector(la, i mod 3 = 0);
+            b(1 to lb) := random_vector(lb, i mod 5 = 0);
+
+            assert same(a(1 to la) + b(1 to lb), ref_add(a(1 to la), b(1 to lb)))
+                report "add " & to_string(a(1 to la)) & " + "
+                & to_string(b(1 to lb));
+
+            assert same(resize(a(1 to la), lb), ref_resize(a(1 to la), lb))
+                report "resize " & to_string(a(1 to la)) & " to "
+                & integer'image(lb);
+
+            assert to_integer(to_unsigned(i * 1009, 22)) = i * 1009;
+            assert same(to_unsigned(i, lb + 10),
+                        ref_resize(to_unsigned(i, 11), lb + 10));
+        end loop;
+
+        u := "11111111";
+        assert same(u + "1", "00000000");
+        assert same(u + u, "11111110");
+        assert same(resize(u, 4), "1111");
+        assert same(resize(u, 10), "0011111111");
+        v := "0H1";
+        assert same(v + "01", "100");
+        assert same(v + "1", "100");
+        assert same(v + "0X", "XXX");
+        assert same(resize(v, 2), "H1");
+        assert same(to_unsigned(5, 3), "101");
+        assert same(to_unsigned(0, 70), (1 to 70 => '0'));
+        assert same(to_unsigned(natural'high, 100),
+                    resize(unsigned'(x"7fffffff"), 100));
+
+        report "numeric done";
+        wait;
+    end process;
+
+    stim: process is
+        constant values : std_ulogic_vector := "01HLXZ0W1UH0";
+    begin
+        for i in values'range loop
+            clk <= values(i);
+            wait for 1 ns;
+        end loop;
+        wait;
+    end process;
+
+    check: process (clk) is
+    begin
+        if rising_edge(clk) then
+            rising <= rising + 1;
+        end if;
+        if falling_edge(clk) then
+            falling <= falling + 1;
+        end if;
+    end process;
+
+    final: process is
+    begin
+        wait for 20 ns;
+        -- U->0, 0->1 R, 1->H, H->L F, L->X, X->Z, Z->0, 0->W, W->1,
+        -- 1->U, U->H, H->0 F
+        assert rising = 1 report "rising = " & integer'image(rising);
+        assert falling = 2 report "falling = " & integer'image(falling);
+        wait;
+    end process;
+
+end architecture;
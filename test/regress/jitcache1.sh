@@ -0,0 +1,45 @@
+set -xe
+
+pwd
+which nvc
+
+# The code cache requires LLVM
+nvc --version | grep -q LLVM || exit 0
+
+export NVC_JIT_CACHE=$PWD/cache
+export NVC_JIT_LOG=1
+
+run() {
+  nvc -a $1 -e --jit --no-save jitcache1 -r 2>&1 | tee $2
+}
+
+# First run populates the cache
+run $TESTDIR/regress/jitcache1.vhd run1.txt
+ls cache/_WORK.JITCACHE1.*
+if grep "loaded from code cache" run1.txt; then exit 1; fi
+
+# Second run loads the function from the cache
+run $TESTDIR/regress/jitcache1.vhd run2.txt
+grep "FIB.*loaded from code cache" run2.txt
+
+# Changing the function invalidates the cached code
+sed 's/n - 2/n - 2 + 0 * n/' $TESTDIR/regress/jitcache1.vhd > changed.vhd
+run changed.vhd run3.txt
+if grep "FIB.*loaded from code cache" run3.txt; then exit 1; fi
+
+# A truncated or corrupt cache file is ignored and then replaced
+for f in cache/_WORK.JITCACHE1.*; do
+  head -c 1000 $f > truncated
+  mv truncated $f
+done
+run $TESTDIR/regress/jitcache1.vhd run4.txt
+grep "ignoring invalid code cache" run4.txt
+
+for f in cache/_WORK.JITCACHE1.*; do
+  echo "not a shared library" > $f
+done
+run $TESTDIR/regress/jitcache1.vhd run5.txt
+grep "ignoring invalid code cache" run5.txt
+
+run $TESTDIR/regress/jitcache1.vhd run6.txt
+grep "FIB.*loaded from code cache" run6.txt
@@ -0,0 +1,25 @@
+entity jitcache1 is
+end entity;
+
+architecture test of jitcache1 is
+
+    function fib (n : natural) return natural is
+    begin
+        if n < 2 then
+            return n;
+        else
+            return fib(n - 1) + fib(n - 2);
+        end if;
+    end function;
+
+    signal n : natural := 20;
+
+begin
+
+    p1: process is
+    begin
+        assert fib(n) = 6765;
+        wait;
+    end process;
+
+end architecture;
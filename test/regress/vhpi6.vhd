@@ -0,0 +1,38 @@
+entity vhpi6_sub is
+    port (
+        i : in integer;
+        o : out integer );
+end entity;
+
+architecture test of vhpi6_sub is
+    signal t : integer;
+begin
+    t <= i * 2;
+    o <= t + 1;
+end architecture;
+
+-------------------------------------------------------------------------------
+
+entity vhpi6 is
+end entity;
+
+architecture test of vhpi6 is
+    signal x : integer := 5;
+    signal y : integer;
+    signal \Ext\ : bit;
+begin
+
+    u1: entity work.vhpi6_sub
+        port map ( x, y );
+
+    g: for n in 1 to 3 generate
+        signal s : integer := n;
+    begin
+    end generate;
+
+    b: block is
+        signal z : bit;
+    begin
+    end block;
+
+end architecture;
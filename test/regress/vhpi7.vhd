@@ -0,0 +1,34 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+entity vhpi7 is
+end entity;
+
+architecture test of vhpi7 is
+    type int_array is array (0 to 7) of integer;
+    type small_int is range -128 to 127;
+    type small_array is array (0 to 2) of small_int;
+    type big_int is range -2**40 to 2**40;
+    type big_array is array (0 to 1) of big_int;
+
+    signal v  : std_logic_vector(99 downto 0) := (0 => '1', others => '0');
+    signal iv : int_array := (1, 2, 3, 4, 5, 6, 7, 8);
+    signal b  : bit_vector(1 to 3) := "101";
+    signal sv : small_array := (-1, -2, 3);
+    signal lv : big_array := (-2**40, 5);
+begin
+
+    check: process is
+    begin
+        wait for 1 ns;
+        assert v(99 downto 96) = "1010";
+        assert v(95 downto 0) = (95 downto 0 => 'Z');
+        assert iv = (10, 20, 30, 40, 50, 60, 70, 80);
+        assert b = "010";
+        assert sv = (-10, 20, -128);
+        assert lv = (-7, 8);
+        report "checked values";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,46 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+entity vhpi8 is
+end entity;
+
+architecture test of vhpi8 is
+    signal clk : std_logic := '0';
+    signal b   : bit := '0';
+    signal v   : std_logic_vector(7 downto 0) := X"00";
+begin
+
+    clkgen: process is
+    begin
+        for i in 1 to 10 loop
+            clk <= '1';
+            wait for 5 ns;
+            clk <= '0';
+            wait for 5 ns;
+        end loop;
+        clk <= 'X';                     -- Not an edge
+        wait for 5 ns;
+        clk <= '1';                     -- Not an edge
+        wait for 5 ns;
+        clk <= 'L';                     -- Falling edge
+        wait for 5 ns;
+        clk <= 'H';                     -- Rising edge
+        wait;
+    end process;
+
+    b <= '1' after 3 ns, '0' after 4 ns;
+
+    stim: process is
+    begin
+        wait for 1 ns;
+        v(0) <= '1';
+        wait for 0 ns;
+        v(0) <= '0';
+        wait for 0 ns;
+        v(7) <= '1';
+        wait for 1 ns;
+        v(7) <= '0';
+        wait;
+    end process;
+
+end architecture;
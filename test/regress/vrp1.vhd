@@ -0,0 +1,79 @@
+entity vrp1 is
+end entity;
+
+architecture test of vrp1 is
+
+    -- The range checks let the JIT infer the dividend is negative
+
+    function rem_zero (x : integer) return boolean is
+    begin
+        if x > -11 then
+            if x < -4 then
+                return (x rem 3) = 0;
+            end if;
+        end if;
+        return false;
+    end function;
+
+    function mod_zero (x : integer) return boolean is
+    begin
+        if x > -11 then
+            if x < -4 then
+                return (x mod 3) = 0;
+            end if;
+        end if;
+        return false;
+    end function;
+
+    function rem_mixed (x : integer) return integer is
+    begin
+        if x > -11 and x < 7 then
+            return x rem 4;
+        end if;
+        return 100;
+    end function;
+
+    function mod_neg (x : integer) return integer is
+    begin
+        if x > -11 and x < 0 then
+            return x mod (-4);
+        end if;
+        return 100;
+    end function;
+
+begin
+
+    process is
+        variable v : integer;
+    begin
+        for i in -10 to -5 loop
+            v := i;                     -- Avoid constant folding
+            wait for 1 ns;
+            assert rem_zero(v) = (v = -9 or v = -6)
+                report "rem_zero " & integer'image(v);
+            assert mod_zero(v) = (v = -9 or v = -6)
+                report "mod_zero " & integer'image(v);
+        end loop;
+
+        for i in -10 to 6 loop
+            v := i;
+            wait for 1 ns;
+            assert rem_mixed(v) = v - (v / 4) * 4
+                report "rem_mixed " & integer'image(v);
+            assert (rem_mixed(v) = 0) = (v mod 4 = 0)
+                report "rem_mixed zero " & integer'image(v);
+        end loop;
+
+        for i in -10 to -1 loop
+            v := i;
+            wait for 1 ns;
+            assert mod_neg(v) <= 0 and mod_neg(v) > -4
+                report "mod_neg " & integer'image(v);
+            assert (mod_neg(v) = 0) = (v rem 4 = 0)
+                report "mod_neg zero " & integer'image(v);
+        end loop;
+
+        wait;
+    end process;
+
+end architecture;
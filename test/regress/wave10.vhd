@@ -0,0 +1,23 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+entity wave10 is
+end entity;
+
+architecture test of wave10 is
+    signal v : std_logic_vector(19 downto 0);
+begin
+
+    stim: process is
+    begin
+        v <= X"5a5a5";
+        wait for 1 ns;
+        v <= "01XZ0101010110101W1-";
+        wait for 1 ns;
+        v <= "11110000111100001111";
+        wait for 1 ns;
+        v <= "1111000011110000UUL1";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,6 @@
+set -xe
+
+nvc -a $TESTDIR/regress/wave9.vhd -e wave9 -r -w --dump-arrays
+
+fstdump wave9.fst > wave9.dump
+diff -u $TESTDIR/regress/gold/wave9.dump wave9.dump
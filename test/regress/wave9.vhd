@@ -0,0 +1,38 @@
+entity wave9 is
+end entity;
+
+architecture test of wave9 is
+    type state_t is (IDLE, START_BIT, DATA_BITS, STOP);
+    type int_mem_t is array (natural range <>) of integer;
+    type bit_mem_t is array (natural range <>) of bit_vector(11 downto 0);
+
+    signal wide  : bit_vector(76 downto 0);
+    signal count : integer := -5;
+    signal small : integer range 0 to 5;
+    signal state : state_t;
+    signal imem  : int_mem_t(0 to 7);
+    signal bmem  : bit_mem_t(0 to 3);
+begin
+
+    main: process is
+    begin
+        wait for 1 ns;
+        wide(0) <= '1';
+        wide(76) <= '1';
+        count <= 1000;
+        small <= 5;
+        state <= DATA_BITS;
+        imem(3) <= -1;
+        bmem(2) <= X"a5c";
+        wait for 1 ns;
+        wide(40 downto 33) <= X"ff";
+        imem(7) <= 42;
+        imem(0) <= 16#7fff0000#;
+        state <= STOP;
+        wait for 1 ns;
+        wide <= (others => '0');
+        bmem(0) <= X"fff";
+        wait;
+    end process;
+
+end architecture;
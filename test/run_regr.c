@@ -115,6 +115,7 @@ struct test {
    char      *work;
    unsigned   olevel;
    char      *heapsz;
+   char      *heaplimit;
    char      *cover;
 };
 
@@ -395,6 +396,8 @@ static bool parse_test_list(int argc, char **argv)
          }
          else if (strncmp(opt, "H=", 2) == 0)
             test->heapsz = strdup(opt + 2);
+         else if (strncmp(opt, "heap-limit=", 11) == 0)
+            test->heaplimit = strdup(opt + 11);
          else if (strncmp(opt, "cover", 5) == 0) {
             test->flags |= F_COVER;
             if (opt[5] == '=') {
@@ -742,6 +745,9 @@ static bool run_test(test_t *test)
       if (test->heapsz != NULL)
          push_arg(&args, "-H%s", test->heapsz);
 
+      if (test->heaplimit != NULL)
+         push_arg(&args, "--heap-limit=%s", test->heaplimit);
+
       push_arg(&args, "-a");
 
       if (!(test->flags & F_VERILOG))
@@ -792,6 +798,9 @@ static bool run_test(test_t *test)
 
          if (test->heapsz != NULL)
             push_arg(&args, "-H%s", test->heapsz);
+
+         if (test->heaplimit != NULL)
+            push_arg(&args, "--heap-limit=%s", test->heaplimit);
       }
 
       push_arg(&args, "-r");
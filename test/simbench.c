@@ -0,0 +1,450 @@
+//
+//  Copyright (C) 2023  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+//
+// Runs the designs in test/bench through the nvc binary and reports
+// elaboration time, simulation throughput, memory and GC statistics as
+// one JSON object per line.  With -c the results are compared against
+// an earlier run and the exit status is non-zero if any metric
+// regressed by more than the threshold.
+//
+
+#include "util.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <libgen.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_ARGS  16
+#define MIN_DELTA 10   // Ignore differences smaller than this in ms or MB
+
+typedef struct _bench bench_t;
+
+struct _bench {
+   bench_t *next;
+   char    *name;
+   char    *file;
+   char    *top;
+   char    *std;
+   char    *stop;
+};
+
+typedef struct {
+   double   elab_ms;
+   double   run_ms;
+   uint64_t sim_fs;
+   uint64_t events;
+   uint64_t activations;
+   uint64_t peak_rss_kb;
+   uint64_t gc_ms;
+   uint64_t gc_cycles;
+} result_t;
+
+static char     bin_dir[PATH_MAX];
+static char     bench_dir[PATH_MAX];
+static bench_t *bench_list = NULL;
+static FILE    *output = NULL;
+
+static void parse_bench_list(const char *filter)
+{
+   char *path LOCAL = xasprintf("%s/benchlist.txt", bench_dir);
+   FILE *f = fopen(path, "r");
+   if (f == NULL)
+      fatal_errno("cannot open %s", path);
+
+   bench_t **tail = &bench_list;
+   char line[256];
+   int lineno = 0;
+   while (fgets(line, sizeof(line), f) != NULL) {
+      lineno++;
+
+      char *hash = strchr(line, '#');
+      if (hash != NULL)
+         *hash = '\0';
+
+      char *name = strtok(line, " \t\r\n");
+      if (name == NULL)
+         continue;
+
+      char *file = strtok(NULL, " \t\r\n");
+      char *top  = strtok(NULL, " \t\r\n");
+      char *std  = strtok(NULL, " \t\r\n");
+      char *stop = strtok(NULL, " \t\r\n");
+
+      if (file == NULL || top == NULL || std == NULL)
+         fatal("%s:%d: expected NAME FILE TOP STD [STOP-TIME]", path, lineno);
+
+      if (filter != NULL && strstr(name, filter) == NULL)
+         continue;
+
+      bench_t *b = xcalloc(sizeof(bench_t));
+      b->name = xstrdup(name);
+      b->file = xasprintf("%s/%s", bench_dir, file);
+      b->top  = xstrdup(top);
+      b->std  = xstrdup(std);
+      b->stop = stop ? xstrdup(stop) : NULL;
+
+      *tail = b;
+      tail = &(b->next);
+   }
+
+   fclose(f);
+}
+
+static void run_nvc(const char *dir, const char *log, const char **args,
+                    double *wall_ms, uint64_t *maxrss)
+{
+   const char *argv[MAX_ARGS];
+   int argc = 0;
+
+   char *nvc LOCAL = xasprintf("%s/nvc", bin_dir);
+   char *work LOCAL = xasprintf("--work=%s/work", dir);
+
+   argv[argc++] = nvc;
+   for (const char **a = args; *a; a++) {
+      argv[argc++] = *a;
+      if (a == args)
+         argv[argc++] = work;   // Global options follow --std
+   }
+   argv[argc] = NULL;
+   assert(argc < MAX_ARGS);
+
+   fflush(stdout);
+   fflush(stderr);
+
+   const uint64_t start = get_timestamp_us();
+
+   pid_t pid = fork();
+   if (pid == 0) {
+      int fd = open(log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd < 0)
+         fatal_errno("open: %s", log);
+
+      dup2(fd, STDOUT_FILENO);
+      dup2(fd, STDERR_FILENO);
+      close(fd);
+
+      if (chdir(dir) != 0)
+         fatal_errno("chdir: %s", dir);
+
+      execv(argv[0], (char *const *)argv);
+      fatal_errno("execv");
+   }
+   else if (pid < 0)
+      fatal_errno("fork");
+
+   int status;
+   struct rusage ru;
+   if (wait4(pid, &status, 0, &ru) != pid)
+      fatal_errno("wait4");
+
+   *wall_ms = (get_timestamp_us() - start) / 1000.0;
+   *maxrss = ru.ru_maxrss;
+
+   if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      FILE *f = fopen(log, "r");
+      if (f != NULL) {
+         char buf[256];
+         while (fgets(buf, sizeof(buf), f))
+            fputs(buf, stderr);
+         fclose(f);
+      }
+
+      fatal("%s %s failed", argv[0], args[1]);
+   }
+}
+
+static uint64_t parse_sim_time(const char *str)
+{
+   static const struct {
+      const char *unit;
+      uint64_t    scale;
+   } units[] = {
+      { "fs", UINT64_C(1) },
+      { "ps", UINT64_C(1000) },
+      { "ns", UINT64_C(1000000) },
+      { "us", UINT64_C(1000000000) },
+      { "ms", UINT64_C(1000000000000) },
+   };
+
+   char *end;
+   const uint64_t value = strtoull(str, &end, 10);
+   for (int i = 0; i < ARRAY_LEN(units); i++) {
+      if (strncmp(end, units[i].unit, 2) == 0)
+         return value * units[i].scale;
+   }
+
+   fatal("cannot parse simulation time %s", str);
+}
+
+static void parse_stats(const char *log, result_t *r)
+{
+   FILE *f = fopen(log, "r");
+   if (f == NULL)
+      fatal_errno("cannot open %s", log);
+
+   // The line printed by --stats is a sequence of key:value pairs
+   char line[1024];
+   bool found = false;
+   while (!found && fgets(line, sizeof(line), f)) {
+      char *start = strstr(line, "setup:");
+      if (start == NULL)
+         continue;
+
+      for (char *tok = strtok(start, " \r\n"); tok;
+           tok = strtok(NULL, " \r\n")) {
+         char *colon = strchr(tok, ':');
+         if (colon == NULL)
+            continue;
+
+         *colon = '\0';
+         const char *value = colon + 1;
+
+         if (strcmp(tok, "run") == 0)
+            r->run_ms = strtoull(value, NULL, 10);
+         else if (strcmp(tok, "maxrss") == 0)
+            r->peak_rss_kb = strtoull(value, NULL, 10);
+         else if (strcmp(tok, "gc") == 0)
+            r->gc_cycles = strtoull(value, NULL, 10);
+         else if (strcmp(tok, "gctime") == 0)
+            r->gc_ms = strtoull(value, NULL, 10);
+         else if (strcmp(tok, "time") == 0)
+            r->sim_fs = parse_sim_time(value);
+         else if (strcmp(tok, "events") == 0)
+            r->events = strtoull(value, NULL, 10);
+         else if (strcmp(tok, "activations") == 0)
+            r->activations = strtoull(value, NULL, 10);
+      }
+
+      found = true;
+   }
+
+   fclose(f);
+
+   if (!found)
+      fatal("missing statistics in %s", log);
+}
+
+static void run_bench(bench_t *b, result_t *r)
+{
+   const char *tmpdir = getenv("TMPDIR") ?: "/tmp";
+   char *dir LOCAL = xasprintf("%s/simbench-XXXXXX", tmpdir);
+   if (mkdtemp(dir) == NULL)
+      fatal_errno("mkdtemp");
+
+   char *log LOCAL = xasprintf("%s/log", dir);
+   char *std LOCAL = xasprintf("--std=%s", b->std);
+   char *stop LOCAL = b->stop ? xasprintf("--stop-time=%s", b->stop) : NULL;
+
+   double wall_ms;
+   uint64_t rss;
+
+   const char *analyse[] = { std, "-a", b->file, NULL };
+   run_nvc(dir, log, analyse, &wall_ms, &rss);
+
+   const char *elab[] = { std, "-e", b->top, NULL };
+   run_nvc(dir, log, elab, &r->elab_ms, &rss);
+
+   const char *run[] = { std, "-r", "--stats", stop ?: b->top,
+                         stop ? b->top : NULL, NULL };
+   run_nvc(dir, log, run, &wall_ms, &rss);
+
+   parse_stats(log, r);
+
+   const char *rm[] = { "/bin/rm", "-rf", dir, NULL };
+   run_program(rm);
+}
+
+static double get_metric(const char *json, const char *key)
+{
+   char *pattern LOCAL = xasprintf("\"%s\":", key);
+   const char *p = strstr(json, pattern);
+   if (p == NULL)
+      return -1.0;
+   else
+      return strtod(p + strlen(pattern), NULL);
+}
+
+static bool compare_metric(const char *name, const char *key, double old,
+                           double new, double threshold, double min_delta)
+{
+   if (old <= 0.0 || new - old < min_delta)
+      return true;
+
+   const double change = (new - old) / old * 100.0;
+   if (change <= threshold)
+      return true;
+
+   color_fprintf(stderr, "$!red$%s: %s regressed by %.1f%% (%.1f -> %.1f)$$\n",
+                 name, key, change, old, new);
+   return false;
+}
+
+static bool compare_baseline(const char *file, const char *name,
+                             const result_t *r, double threshold)
+{
+   FILE *f = fopen(file, "r");
+   if (f == NULL)
+      fatal_errno("cannot open %s", file);
+
+   char *needle LOCAL = xasprintf("\"name\":\"%s\",", name);
+
+   bool pass = true;
+   char line[1024];
+   while (fgets(line, sizeof(line), f)) {
+      if (strstr(line, needle) == NULL)
+         continue;
+
+      pass &= compare_metric(name, "elab_ms", get_metric(line, "elab_ms"),
+                             r->elab_ms, threshold, MIN_DELTA);
+      pass &= compare_metric(name, "run_ms", get_metric(line, "run_ms"),
+                             r->run_ms, threshold, MIN_DELTA);
+      pass &= compare_metric(name, "peak_rss_kb",
+                             get_metric(line, "peak_rss_kb"),
+                             r->peak_rss_kb, threshold, MIN_DELTA * 1024);
+      pass &= compare_metric(name, "gc_ms", get_metric(line, "gc_ms"),
+                             r->gc_ms, threshold, MIN_DELTA);
+      break;
+   }
+
+   fclose(f);
+   return pass;
+}
+
+static void print_result(const char *name, const result_t *r)
+{
+   const double run_sec = MAX(r->run_ms, 1.0) / 1000.0;
+
+   fprintf(output, "{\"name\":\"%s\",\"elab_ms\":%.0f,\"run_ms\":%.0f,"
+           "\"sim_time_fs\":%"PRIu64",\"sim_wall_ratio\":%g,"
+           "\"events\":%"PRIu64",\"events_per_sec\":%.0f,"
+           "\"activations\":%"PRIu64",\"peak_rss_kb\":%"PRIu64","
+           "\"gc_ms\":%"PRIu64",\"gc_cycles\":%"PRIu64"}\n",
+           name, r->elab_ms, r->run_ms, r->sim_fs,
+           r->sim_fs / 1e15 / run_sec, r->events, r->events / run_sec,
+           r->activations, r->peak_rss_kb, r->gc_ms, r->gc_cycles);
+   fflush(output);
+}
+
+static void usage(void)
+{
+   printf("Usage: simbench [OPTION]...\n"
+          "\n"
+          " -c FILE\tCompare against results from an earlier run\n"
+          " -f PATTERN\tOnly run benchmarks matching PATTERN\n"
+          " -n COUNT\tRun each benchmark COUNT times and keep the best\n"
+          " -o FILE\tWrite results to FILE instead of stdout\n"
+          " -t PERCENT\tRegression threshold for -c (default 10)\n"
+          "\n"
+          "Report bugs to %s\n", PACKAGE_BUGREPORT);
+}
+
+int main(int argc, char **argv)
+{
+   term_init();
+
+   const char *filter = NULL, *baseline = NULL, *outfile = NULL;
+   double threshold = 10.0;
+   int repeat = 1;
+
+   int c;
+   while ((c = getopt(argc, argv, "c:f:hn:o:t:")) != -1) {
+      switch (c) {
+      case 'c':
+         baseline = optarg;
+         break;
+      case 'f':
+         filter = optarg;
+         break;
+      case 'h':
+         usage();
+         return 0;
+      case 'n':
+         repeat = MAX(atoi(optarg), 1);
+         break;
+      case 'o':
+         outfile = optarg;
+         break;
+      case 't':
+         threshold = strtod(optarg, NULL);
+         break;
+      default:
+         usage();
+         return EXIT_FAILURE;
+      }
+   }
+
+   if (realpath(TESTDIR "/bench", bench_dir) == NULL)
+      fatal_errno("cannot find benchmark directory");
+
+   char argv0_path[PATH_MAX];
+   if (realpath(argv[0], argv0_path) == NULL)
+      fatal_errno("realpath: %s", argv[0]);
+   strncpy(bin_dir, dirname(argv0_path), sizeof(bin_dir) - 1);
+
+   char *lib_dir LOCAL = xasprintf("%s/../lib", bin_dir);
+   setenv("NVC_LIBPATH", lib_dir, 1);
+
+   if (outfile == NULL)
+      output = stdout;
+   else if ((output = fopen(outfile, "w")) == NULL)
+      fatal_errno("cannot create %s", outfile);
+
+   parse_bench_list(filter);
+
+   bool pass = true;
+   for (bench_t *b = bench_list; b; b = b->next) {
+      color_fprintf(stderr, "$bold$%-12s$$", b->name);
+      fflush(stderr);
+
+      result_t best = {};
+      for (int i = 0; i < repeat; i++) {
+         result_t r = {};
+         run_bench(b, &r);
+
+         // Keep the fastest simulation and the fastest elaboration
+         const double elab_ms = i > 0 ? MIN(best.elab_ms, r.elab_ms)
+            : r.elab_ms;
+         if (i == 0 || r.run_ms < best.run_ms)
+            best = r;
+         best.elab_ms = elab_ms;
+      }
+
+      fprintf(stderr, " elab %.0f ms; run %.0f ms; %"PRIu64" events\n",
+              best.elab_ms, best.run_ms, best.events);
+
+      print_result(b->name, &best);
+
+      if (baseline != NULL)
+         pass &= compare_baseline(baseline, b->name, &best, threshold);
+   }
+
+   if (output != stdout)
+      fclose(output);
+
+   return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -27,11 +27,13 @@
 #include "option.h"
 #include "phase.h"
 #include "scan.h"
+#include "thread.h"
 #include "type.h"
 
 #include <math.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <unistd.h>
 
 #define REG(r) ((jit_value_t){ .kind = JIT_VALUE_REG, .reg = (r) })
 #define CONST(i) ((jit_value_t){ .kind = JIT_VALUE_INT64, .int64 = (i) })
@@ -1816,6 +1818,429 @@ START_TEST(test_tlab1)
 }
 END_TEST
 
+START_TEST(test_inline1)
+{
+   jit_t *j = jit_new();
+
+   const char *text1 =
+      "    RECV    R0, #1       \n"
+      "    ADD     R1, R0, #1   \n"
+      "    SEND    #0, R1       \n"
+      "    RET                  \n";
+
+   jit_assemble(j, ident_new("inline1"), text1);
+
+   const char *text2 =
+      "    RECV    R0, #1           \n"
+      "    SEND    #1, R0           \n"
+      "    CALL    <inline1>        \n"
+      "    RECV    R1, #0           \n"
+      "    ADD     R2, R1, R1       \n"
+      "    SEND    #0, R2           \n"
+      "    RET                      \n";
+
+   jit_handle_t h2 = jit_assemble(j, ident_new("myfunc2"), text2);
+
+   jit_func_t *f2 = jit_get_func(j, h2);
+   jit_do_inline(f2);
+
+   ck_assert_int_eq(f2->nirs, 10);
+   ck_assert_int_eq(f2->ninlines, 1);
+   ck_assert_int_eq(f2->inlines[0].first, 2);
+   ck_assert_int_eq(f2->inlines[0].last, 5);
+
+   for (int i = 0; i < f2->nirs; i++)
+      ck_assert_int_ne(f2->irbuf[i].op, J_CALL);
+
+   check_unary(f2, 1, J_MOV, REG(0));
+   check_unary(f2, 5, J_JUMP, LABEL(6));
+   ck_assert_int_eq(f2->irbuf[6].target, 1);
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 5 };
+   fail_unless(jit_fastcall(j, h2, &result, p0, p0, &tlab));
+
+   ck_assert_int_eq(result.integer, 12);
+
+   const char *text3 =
+      "    RECV    R0, #1           \n"
+      "    SEND    #1, R0           \n"
+      "    CALL    <myfunc3>        \n"
+      "    RECV    R1, #0           \n"
+      "    SEND    #0, R1           \n"
+      "    RET                      \n";
+
+   jit_handle_t h3 = jit_assemble(j, ident_new("myfunc3"), text3);
+
+   jit_func_t *f3 = jit_get_func(j, h3);
+   jit_do_inline(f3);
+
+   ck_assert_int_eq(f3->nirs, 6);
+   ck_assert_int_eq(f3->ninlines, 0);
+   ck_assert_int_eq(f3->irbuf[2].op, J_CALL);
+
+   jit_free(j);
+}
+END_TEST
+
+START_TEST(test_vrp1)
+{
+   jit_t *j = jit_new();
+
+   const char *text =
+      "    RECV      R0, #0         \n"
+      "    CMP.GT    R0, #100       \n"
+      "    JUMP.T    L1             \n"
+      "    CMP.LT    R0, #0         \n"
+      "    JUMP.T    L1             \n"
+      "    ADD.O.32  R1, R0, #5     \n"
+      "    JUMP.F    L2             \n"
+      "    $EXIT     #1             \n"
+      "L2: CMP.GT    R1, #200       \n"
+      "    JUMP.T    L3             \n"
+      "    SEND      #0, R1         \n"
+      "    RET                      \n"
+      "L3: $EXIT     #0             \n"
+      "L1: MOV       R1, #0         \n"
+      "    SEND      #0, R1         \n"
+      "    RET                      \n";
+
+   jit_handle_t h = jit_assemble(j, ident_new("myfunc"), text);
+
+   jit_func_t *f = jit_get_func(j, h);
+   ck_assert_int_eq(jit_do_vrp(f), 2);
+
+   check_unary(f, 2, J_JUMP, LABEL(13));
+   ck_assert_int_eq(f->irbuf[2].cc, JIT_CC_T);
+   check_unary(f, 6, J_JUMP, LABEL(8));
+   ck_assert_int_eq(f->irbuf[6].cc, JIT_CC_NONE);
+   ck_assert_int_eq(f->irbuf[7].op, J_NOP);
+   ck_assert_int_eq(f->irbuf[9].op, J_NOP);
+   ck_assert_int_eq(f->irbuf[12].op, J_NOP);
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 42 };
+   fail_unless(jit_fastcall(j, h, &result, p0, p0, &tlab));
+   ck_assert_int_eq(result.integer, 47);
+
+   p0.integer = 500;
+   fail_unless(jit_fastcall(j, h, &result, p0, p0, &tlab));
+   ck_assert_int_eq(result.integer, 0);
+
+   jit_free(j);
+}
+END_TEST
+
+START_TEST(test_licm1)
+{
+   jit_t *j = jit_new();
+
+   const char *text =
+      "    RECV      R0, #0         \n"
+      "    RECV      R1, #1         \n"
+      "    MOV       R3, #0         \n"
+      "    MOV       R4, #0         \n"
+      "L1: CMP.GE    R4, R0         \n"
+      "    JUMP.T    L2             \n"
+      "    MUL       R5, R1, #3     \n"
+      "    ADD       R6, R5, #1     \n"
+      "    ADD       R3, R3, R6     \n"
+      "    ADD       R4, R4, #1     \n"
+      "    JUMP      L1             \n"
+      "L2: SEND      #0, R3         \n"
+      "    RET                      \n";
+
+   jit_handle_t h = jit_assemble(j, ident_new("myfunc"), text);
+
+   jit_func_t *f = jit_get_func(j, h);
+   jit_do_licm(f);
+
+   ck_assert_int_eq(f->nirs, 15);
+   ck_assert_int_eq(f->irbuf[4].op, J_MUL);
+   ck_assert_int_eq(f->irbuf[5].op, J_ADD);
+   ck_assert_int_eq(f->irbuf[5].result, 6);
+   ck_assert_int_eq(f->irbuf[6].op, J_CMP);
+   ck_assert_int_eq(f->irbuf[8].op, J_NOP);
+   ck_assert_int_eq(f->irbuf[9].op, J_NOP);
+   check_unary(f, 7, J_JUMP, LABEL(13));
+   check_unary(f, 12, J_JUMP, LABEL(6));
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result;
+   jit_scalar_t p0 = { .integer = 4 }, p1 = { .integer = 2 };
+   fail_unless(jit_fastcall(j, h, &result, p0, p1, &tlab));
+   ck_assert_int_eq(result.integer, 28);
+
+   const char *text2 =
+      "    RECV      R0, #0         \n"
+      "    $SALLOC   R1, #0, #8     \n"
+      "    STORE.32  R0, [R1]       \n"
+      "    MOV       R2, #0         \n"
+      "    MOV       R3, #0         \n"
+      "L1: CMP.GE    R3, #4         \n"
+      "    JUMP.T    L2             \n"
+      "    LOAD.32   R4, [R1]       \n"
+      "    CMP.LT    R4, #0         \n"
+      "    CSEL      R5, #-1, #1    \n"
+      "    ADD       R2, R2, R5     \n"
+      "    ADD       R3, R3, #1     \n"
+      "    STORE.32  R3, [R1+4]     \n"
+      "    JUMP      L1             \n"
+      "L2: SEND      #0, R2         \n"
+      "    RET                      \n";
+
+   jit_handle_t h2 = jit_assemble(j, ident_new("myfunc2"), text2);
+
+   jit_func_t *f2 = jit_get_func(j, h2);
+   jit_do_licm(f2);
+
+   ck_assert_int_eq(f2->nirs, 19);
+   ck_assert_int_eq(f2->irbuf[5].op, J_LOAD);
+   ck_assert_int_eq(f2->irbuf[6].op, J_CMP);
+   ck_assert_int_eq(f2->irbuf[7].op, J_CSEL);
+   ck_assert_int_eq(f2->irbuf[8].op, J_CMP);
+   ck_assert_int_eq(f2->irbuf[10].op, J_NOP);
+   ck_assert_int_eq(f2->irbuf[11].op, J_CMP);
+   ck_assert_int_eq(f2->irbuf[12].op, J_NOP);
+
+   p0.integer = 7;
+   fail_unless(jit_fastcall(j, h2, &result, p0, p0, &tlab));
+   ck_assert_int_eq(result.integer, 4);
+
+   p0.integer = -3;
+   fail_unless(jit_fastcall(j, h2, &result, p0, p0, &tlab));
+   ck_assert_int_eq(result.integer, -4);
+
+   jit_free(j);
+}
+END_TEST
+
+static void *dummy_tier_init(jit_t *j)
+{
+   return NULL;
+}
+
+static void dummy_tier_cgen(jit_t *j, jit_handle_t handle, void *context)
+{
+}
+
+static void dummy_tier_cleanup(void *context)
+{
+}
+
+static const jit_plugin_t dummy_tier = {
+   .name    = "dummy",
+   .init    = dummy_tier_init,
+   .cgen    = dummy_tier_cgen,
+   .cleanup = dummy_tier_cleanup,
+};
+
+START_TEST(test_tierup1)
+{
+   opt_set_int(OPT_JIT_ASYNC, 0);
+
+   const char *tmp = getenv("TEMP") ?: "/tmp";
+   char *profile LOCAL = xasprintf("%s" DIR_SEP "nvc-jit-profile.%d",
+                                   tmp, getpid());
+   remove(profile);
+
+   const char *text =
+      "    RECV      R0, #0         \n"
+      "    MOV       R1, #0         \n"
+      "L1: ADD       R1, R1, #1     \n"
+      "    CMP.LT    R1, R0         \n"
+      "    JUMP.T    L1             \n"
+      "    SEND      #0, R1         \n"
+      "    RET                      \n";
+
+   {
+      jit_t *j = jit_new();
+      jit_add_tier(j, 2, &dummy_tier);
+      jit_load_profile(j, profile);
+
+      jit_handle_t h = jit_assemble(j, ident_new("myfunc"), text);
+      jit_func_t *f = jit_get_func(j, h);
+      ck_assert_int_eq(f->hotness, 2);
+
+      tlab_t tlab = jit_null_tlab(j);
+      jit_scalar_t result, p0 = { .integer = 1000 };
+      fail_unless(jit_fastcall(j, h, &result, p0, p0, &tlab));
+      ck_assert_int_eq(result.integer, 1000);
+
+      // A single call with a long running loop should tier up
+      ck_assert_ptr_null(f->next_tier);
+      ck_assert_int_eq(f->calls, 1);
+      ck_assert_int_eq(f->backedges, 999);
+
+      jit_free(j);
+   }
+
+   {
+      jit_t *j = jit_new();
+      jit_add_tier(j, 10, &dummy_tier);
+      jit_load_profile(j, profile);
+
+      jit_handle_t h = jit_assemble(j, ident_new("myfunc"), text);
+      jit_func_t *f = jit_get_func(j, h);
+      ck_assert_int_eq(f->hotness, 1);
+
+      tlab_t tlab = jit_null_tlab(j);
+      jit_scalar_t result, p0 = { .integer = 1 };
+      fail_unless(jit_fastcall(j, h, &result, p0, p0, &tlab));
+      ck_assert_int_eq(result.integer, 1);
+
+      // Hot in the previous run so compiled on the first call
+      ck_assert_ptr_null(f->next_tier);
+
+      jit_free(j);
+   }
+
+   {
+      // Counts are averaged with the previous run rather than summed
+      FILE *f = fopen(profile, "r");
+      fail_if(f == NULL);
+
+      char line[64];
+      fail_if(fgets(line, sizeof(line), f) == NULL);
+      ck_assert_str_eq(line, "1 499 myfunc\n");
+
+      fclose(f);
+   }
+
+   remove(profile);
+}
+END_TEST
+
+static int tierup2_release;
+static jit_handle_t tierup2_order[3];
+static int tierup2_count;
+
+static void tierup2_cgen(jit_t *j, jit_handle_t handle, void *context)
+{
+   // Hold up the first compilation until the rest are queued
+   while (tierup2_count == 0 && !load_acquire(&tierup2_release))
+      thread_sleep(100);
+
+   ck_assert_int_lt(tierup2_count, ARRAY_LEN(tierup2_order));
+   tierup2_order[tierup2_count++] = handle;
+}
+
+static const jit_plugin_t tierup2_tier = {
+   .name    = "tierup2",
+   .init    = dummy_tier_init,
+   .cgen    = tierup2_cgen,
+   .cleanup = dummy_tier_cleanup,
+};
+
+START_TEST(test_tierup2)
+{
+   opt_set_int(OPT_JIT_ASYNC, 1);
+   opt_set_int(OPT_JIT_THREADS, 1);
+
+   const char *text =
+      "    RECV      R0, #0         \n"
+      "    MOV       R1, #0         \n"
+      "L1: ADD       R1, R1, #1     \n"
+      "    CMP.LT    R1, R0         \n"
+      "    JUMP.T    L1             \n"
+      "    SEND      #0, R1         \n"
+      "    RET                      \n";
+
+   jit_t *j = jit_new();
+   jit_add_tier(j, 1, &tierup2_tier);
+
+   jit_handle_t h1 = jit_assemble(j, ident_new("func1"), text);
+   jit_handle_t h2 = jit_assemble(j, ident_new("func2"), text);
+   jit_handle_t h3 = jit_assemble(j, ident_new("func3"), text);
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result;
+   jit_scalar_t p1 = { .integer = 10000 };
+   jit_scalar_t p2 = { .integer = 1 };
+   jit_scalar_t p3 = { .integer = 5000 };
+
+   // The first function is compiled straight away and the other two
+   // are then compiled in order of hotness
+   fail_unless(jit_fastcall(j, h1, &result, p1, p1, &tlab));
+   fail_unless(jit_fastcall(j, h2, &result, p2, p2, &tlab));
+   fail_unless(jit_fastcall(j, h3, &result, p3, p3, &tlab));
+
+   store_release(&tierup2_release, 1);
+   jit_cgen_barrier(j);
+
+   ck_assert_int_eq(tierup2_count, 3);
+   ck_assert_int_eq(tierup2_order[0], h1);
+   ck_assert_int_eq(tierup2_order[1], h3);
+   ck_assert_int_eq(tierup2_order[2], h2);
+
+   jit_free(j);
+
+   opt_set_int(OPT_JIT_ASYNC, 0);
+}
+END_TEST
+
+START_TEST(test_counters1)
+{
+   opt_set_int(OPT_JIT_COUNTERS, 5);
+
+   jit_t *j = jit_new();
+
+   const char *text =
+      "    RECV      R0, #0         \n"
+      "    MOV       R1, #0         \n"
+      "L1: ADD       R1, R1, #1     \n"
+      "    CMP.LT    R1, R0         \n"
+      "    JUMP.T    L1             \n"
+      "    SEND      #0, R1         \n"
+      "    RET                      \n";
+
+   jit_handle_t h = jit_assemble(j, ident_new("myfunc"), text);
+   jit_func_t *f = jit_get_func(j, h);
+   ck_assert_ptr_nonnull(f->counters);
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 10 };
+   fail_unless(jit_fastcall(j, h, &result, p0, p0, &tlab));
+   ck_assert_int_eq(result.integer, 10);
+
+   const uint64_t *ops = f->counters->ops;
+   ck_assert_ptr_nonnull(ops);
+   ck_assert_int_eq(ops[0], 1);
+   ck_assert_int_eq(ops[1], 1);
+   ck_assert_int_eq(ops[2], 10);
+   ck_assert_int_eq(ops[4], 10);
+   ck_assert_int_eq(ops[5], 1);
+   ck_assert_int_eq(ops[6], 1);
+
+   jit_count_exit(f, 3, JIT_EXIT_OVERFLOW);
+   jit_count_exit(f, 5, JIT_EXIT_REPORT);
+   jit_count_exit(f, 3, JIT_EXIT_OVERFLOW);
+
+   ck_assert_int_eq(f->counters->nsites, 2);
+   ck_assert_int_eq(f->counters->sites[0].irpos, 3);
+   ck_assert_int_eq(f->counters->sites[0].which, JIT_EXIT_OVERFLOW);
+   ck_assert_int_eq(f->counters->sites[0].count, 2);
+   ck_assert_int_eq(f->counters->sites[1].count, 1);
+
+   jit_counter_summary_t s;
+   jit_summarise_counters(j, &s);
+   ck_assert_int_eq(s.nexits, 3);
+   ck_assert_int_eq(s.nops, 34);
+   ck_assert_int_eq(s.kinds.count, 2);
+   ck_assert_int_eq(s.kinds.items[0].kind, JIT_EXIT_OVERFLOW);
+   ck_assert_int_eq(s.kinds.items[0].count, 2);
+   ck_assert_int_eq(s.ops.items[0].count, 10);
+   ck_assert_int_eq(s.funcs.count, 1);
+   ck_assert_ptr_eq(s.funcs.items[0].func, f);
+   ck_assert_int_eq(s.funcs.items[0].count, 34);
+   jit_free_counter_summary(&s);
+
+   opt_set_int(OPT_JIT_COUNTERS, 0);
+
+   jit_free(j);
+}
+END_TEST
+
 Suite *get_jit_tests(void)
 {
    Suite *s = suite_create("jit");
@@ -1865,6 +2290,12 @@ Suite *get_jit_tests(void)
    tcase_add_test(tc, test_nops1);
    tcase_add_test(tc, test_issue608);
    tcase_add_test(tc, test_tlab1);
+   tcase_add_test(tc, test_inline1);
+   tcase_add_test(tc, test_vrp1);
+   tcase_add_test(tc, test_licm1);
+   tcase_add_test(tc, test_tierup1);
+   tcase_add_test(tc, test_tierup2);
+   tcase_add_test(tc, test_counters1);
    suite_add_tcase(s, tc);
 
    return s;
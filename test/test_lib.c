@@ -22,6 +22,7 @@
 #include "tree.h"
 #include "type.h"
 #include "util.h"
+#include "vcode.h"
 
 #include <stdlib.h>
 
@@ -325,6 +326,47 @@ START_TEST(test_lib_save)
 }
 END_TEST
 
+START_TEST(test_lib_vcode)
+{
+   ident_t name = ident_new("TEST_LIB.pack");
+
+   {
+      make_new_arena();
+
+      tree_t pack = tree_new(T_PACKAGE);
+      tree_set_ident(pack, name);
+
+      lib_put(work, pack);
+
+      vcode_unit_t vu = emit_package(name, tree_to_object(pack), NULL);
+      emit_return(VCODE_INVALID_REG);
+      vcode_close();
+
+      lib_put_vcode(work, pack, vu);
+      lib_save(work);
+
+      vcode_unit_unref(vu);
+   }
+
+   lib_free(work);
+
+   lib_add_search_path(tmp);
+   work = lib_find(ident_new("test_lib"));
+   fail_if(work == NULL);
+
+   // The vcode section is not read until the tree is loaded
+   fail_unless(vcode_find_unit(name) == NULL);
+
+   tree_t pack = lib_get(work, name);
+   fail_if(pack == NULL);
+   fail_unless(tree_kind(pack) == T_PACKAGE);
+
+   vcode_unit_t vu = vcode_find_unit(name);
+   fail_if(vu == NULL);
+   fail_unless(vcode_unit_object(vu) == tree_to_object(pack));
+}
+END_TEST
+
 Suite *get_lib_tests(void)
 {
    Suite *s = suite_create("lib");
@@ -334,6 +376,7 @@ Suite *get_lib_tests(void)
    tcase_add_test(tc_core, test_lib_new);
    tcase_add_test(tc_core, test_lib_fopen);
    tcase_add_test(tc_core, test_lib_save);
+   tcase_add_test(tc_core, test_lib_vcode);
    suite_add_tcase(s, tc_core);
 
    return s;
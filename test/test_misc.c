@@ -455,6 +455,59 @@ START_TEST(test_count_clear)
 }
 END_TEST
 
+START_TEST(test_count_set)
+{
+   bit_mask_t m;
+   mask_init(&m, mask_size[_i]);
+
+   mask_set_range(&m, 3, 2);
+
+   ck_assert_int_eq(mask_count_set(&m, 0), 0);
+   ck_assert_int_eq(mask_count_set(&m, 3), 2);
+   ck_assert_int_eq(mask_count_set(&m, 4), 1);
+   ck_assert_int_eq(mask_count_set(&m, 5), 0);
+
+   mask_setall(&m);
+
+   ck_assert_int_eq(mask_count_set(&m, 0), mask_size[_i]);
+   ck_assert_int_eq(mask_count_set(&m, 5), mask_size[_i] - 5);
+   ck_assert_int_eq(mask_count_set(&m, mask_size[_i] - 1), 1);
+
+   if (mask_size[_i] > 131) {
+      mask_clear_range(&m, 130, 1);
+
+      ck_assert_int_eq(mask_count_set(&m, 0), 130);
+      ck_assert_int_eq(mask_count_set(&m, 64), 66);
+      ck_assert_int_eq(mask_count_set(&m, 129), 1);
+      ck_assert_int_eq(mask_count_set(&m, 131), mask_size[_i] - 131);
+   }
+
+   mask_free(&m);
+}
+END_TEST
+
+START_TEST(test_mask_resize)
+{
+   bit_mask_t m;
+   mask_init(&m, mask_size[_i]);
+   mask_setall(&m);
+
+   const int newsize = mask_size[_i] * 2 + 70;
+   mask_resize(&m, newsize);
+
+   ck_assert_int_eq(m.size, newsize);
+   ck_assert_int_eq(mask_popcount(&m), mask_size[_i]);
+   ck_assert_int_eq(mask_count_set(&m, 0), mask_size[_i]);
+   ck_assert_int_eq(mask_count_clear(&m, mask_size[_i]),
+                    newsize - mask_size[_i]);
+
+   mask_set(&m, newsize - 1);
+   ck_assert(mask_test(&m, newsize - 1));
+
+   mask_free(&m);
+}
+END_TEST
+
 START_TEST(test_scan_backwards)
 {
    bit_mask_t m;
@@ -661,6 +714,8 @@ Suite *get_misc_tests(void)
    tcase_add_loop_test(tc_mask, test_mask, 0, ARRAY_LEN(mask_size));
    tcase_add_loop_test(tc_mask, test_set_clear_range, 0, ARRAY_LEN(mask_size));
    tcase_add_loop_test(tc_mask, test_count_clear, 0, ARRAY_LEN(mask_size));
+   tcase_add_loop_test(tc_mask, test_count_set, 0, ARRAY_LEN(mask_size));
+   tcase_add_loop_test(tc_mask, test_mask_resize, 0, ARRAY_LEN(mask_size));
    tcase_add_loop_test(tc_mask, test_scan_backwards, 0, ARRAY_LEN(mask_size));
    tcase_add_loop_test(tc_mask, test_subtract, 0, ARRAY_LEN(mask_size));
    tcase_add_test(tc_mask, test_empty_mask);
@@ -19,6 +19,7 @@
 #include "rt/mspace.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 START_TEST(test_sanity)
 {
@@ -277,6 +278,142 @@ START_TEST(test_end_ptr)
 }
 END_TEST
 
+struct tree {
+   struct tree *left;
+   struct tree *right;
+   int          value;
+};
+
+__attribute__((noinline))
+static struct tree *build_tree(mspace_t *m, int depth, int *next)
+{
+   if (depth == 0)
+      return NULL;
+
+   struct tree *t = mspace_alloc(m, sizeof(struct tree));
+   ck_assert_ptr_nonnull(t);
+   t->value = (*next)++;
+   t->left  = build_tree(m, depth - 1, next);
+   t->right = build_tree(m, depth - 1, next);
+
+   // Interleave garbage so the live nodes are spread over the heap
+   generate_garbage(m, 1, (1 + rand() % 10) * sizeof(int));
+
+   return t;
+}
+
+static int sum_tree(struct tree *t)
+{
+   return t == NULL ? 0 : t->value + sum_tree(t->left) + sum_tree(t->right);
+}
+
+START_TEST(test_parallel)
+{
+   // Large enough that marking is split between the helper threads
+   // when more than one processor is available
+   mspace_t *m = mspace_new(4 * 1024 * 1024);
+
+   generate_garbage(m, 5, sizeof(int));
+
+   mptr_t p = mptr_new(m, "tree");
+
+   int next = 0;
+   *mptr_get(p) = build_tree(m, 14, &next);
+
+   const int expect = sum_tree(*mptr_get(p));
+   ck_assert_int_eq(expect, next * (next - 1) / 2);
+
+   // Do enough allocations to trigger several GCs
+   for (int i = 0; i < 5; i++)
+      generate_garbage(m, 40000, 20 * sizeof(int));
+
+   ck_assert_int_eq(sum_tree(*mptr_get(p)), expect);
+
+   mptr_free(m, &p);
+   mspace_destroy(m);
+}
+END_TEST
+
+START_TEST(test_size_classes)
+{
+   mspace_t *m = mspace_new(64 * 1024);
+
+   generate_garbage(m, 5, sizeof(int));
+
+   // Keep a mix of small, medium, and large objects alive while the
+   // heap churns so that all the free lists are exercised
+   const int nobjs = 64;
+   mptr_t p = mptr_new(m, "table");
+   *mptr_get(p) = mspace_alloc_array(m, nobjs, sizeof(char *));
+
+   size_t sizes[nobjs];
+   for (int i = 0; i < 2000; i++) {
+      const int n = i < nobjs ? i : rand() % nobjs;
+      const size_t size = 1 + rand() % (i % 3 == 0 ? 1000 : 200);
+
+      char *obj = mspace_alloc(m, size);
+      ck_assert_ptr_nonnull(obj);
+      memset(obj, n, size);
+
+      ((char **)*mptr_get(p))[n] = obj;
+      sizes[n] = size;
+
+      generate_garbage(m, 2, (1 + rand() % 50) * sizeof(int));
+   }
+
+   for (int i = 0; i < nobjs; i++) {
+      char *obj = ((char **)*mptr_get(p))[i];
+
+      size_t size;
+      ck_assert_ptr_eq(mspace_find(m, obj + sizes[i] - 1, &size), obj);
+      ck_assert_int_ge(size, sizes[i]);
+
+      for (int j = 0; j < sizes[i]; j++)
+         ck_assert_int_eq(obj[j], i);
+   }
+
+   mptr_free(m, &p);
+   mspace_destroy(m);
+}
+END_TEST
+
+START_TEST(test_grow)
+{
+   mspace_t *m = mspace_new_growable(64 * 1024, 4 * 1024 * 1024);
+
+   generate_garbage(m, 5, sizeof(int));
+
+   mptr_t p = mptr_new(m, "tree");
+
+   // Needs several times the initial heap size to hold
+   int next = 0;
+   *mptr_get(p) = build_tree(m, 12, &next);
+
+   const int expect = sum_tree(*mptr_get(p));
+   ck_assert_int_eq(expect, next * (next - 1) / 2);
+
+   // Larger than the initial heap
+   char *big = mspace_alloc(m, 256 * 1024);
+   ck_assert_ptr_nonnull(big);
+   big[256 * 1024 - 1] = 42;
+
+   generate_garbage(m, 10000, 20 * sizeof(int));
+
+   ck_assert_int_eq(sum_tree(*mptr_get(p)), expect);
+
+   mspace_stats_t stats;
+   mspace_get_stats(m, &stats);
+   ck_assert_int_gt(stats.growths, 0);
+   ck_assert_int_gt(stats.heap_size, 64 * 1024);
+   ck_assert_int_le(stats.heap_size, 4 * 1024 * 1024);
+   ck_assert_int_le(stats.peak_size, stats.heap_size);
+   ck_assert_int_gt(stats.collections, 0);
+
+   mptr_free(m, &p);
+   mspace_destroy(m);
+}
+END_TEST
+
 Suite *get_mspace_tests(void)
 {
    Suite *s = suite_create("mspace");
@@ -291,6 +428,9 @@ Suite *get_mspace_tests(void)
    tcase_add_test(tc, test_linked_list);
    tcase_add_test(tc, test_tlab);
    tcase_add_test(tc, test_end_ptr);
+   tcase_add_test(tc, test_parallel);
+   tcase_add_test(tc, test_size_classes);
+   tcase_add_test(tc, test_grow);
    suite_add_tcase(s, tc);
 
    return s;
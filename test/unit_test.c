@@ -82,6 +82,7 @@ int main(int argc, char **argv)
    opt_set_size(OPT_ARENA_SIZE, 1 << 20);
    opt_set_str(OPT_GC_VERBOSE, getenv("NVC_GC_VERBOSE"));
    opt_set_size(OPT_HEAP_SIZE, 128 * 1024);
+   opt_set_size(OPT_HEAP_LIMIT, 128 * 1024);
    opt_set_int(OPT_GC_STRESS, getenv("NVC_GC_STRESS") != 0);
 
    if (getenv("NVC_LIBPATH") == NULL)
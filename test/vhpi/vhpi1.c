@@ -203,6 +203,8 @@ static void startup()
    check_error();
 
    vhpi_printf("tool is %s", vhpi_get_str(vhpiNameP, NULL));
+   fail_unless(strcmp((char *)vhpi_get_str(vhpiCaseNameP, NULL),
+                      (char *)vhpi_get_str(vhpiNameP, NULL)) == 0);
 
    vhpiHandleT root = vhpi_handle(vhpiRootInst, NULL);
    check_error();
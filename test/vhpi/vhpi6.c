@@ -0,0 +1,129 @@
+#include "vhpi_user.h"
+
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define fail_if(x)                                                      \
+   if (x) vhpi_assert(vhpiFailure, "assertion '%s' failed at %s:%d",    \
+                      #x, __FILE__, __LINE__)
+#define fail_unless(x) fail_if(!(x))
+
+static void check_error(void)
+{
+   vhpiErrorInfoT info;
+   if (vhpi_check_error(&info))
+      vhpi_assert(vhpiFailure, "unexpected error '%s'", info.message);
+}
+
+static int count_iter(vhpiOneToManyT type, vhpiHandleT handle)
+{
+   vhpiHandleT it = vhpi_iterator(type, handle);
+   check_error();
+
+   int count = 0;
+   for (vhpiHandleT h; it != NULL && (h = vhpi_scan(it)); count++) {
+      vhpi_printf("%s %s", vhpi_get_str(vhpiKindStrP, h),
+                  vhpi_get_str(vhpiFullNameP, h));
+      check_error();
+   }
+
+   return count;
+}
+
+static int get_int(const char *name)
+{
+   vhpiHandleT h = vhpi_handle_by_name(name, NULL);
+   check_error();
+   fail_if(h == NULL);
+
+   vhpiValueT value = {
+      .format = vhpiIntVal
+   };
+   vhpi_get_value(h, &value);
+   check_error();
+
+   return value.value.intg;
+}
+
+static void end_of_sim(const vhpiCbDataT *cb_data)
+{
+   fail_unless(get_int(":vhpi6:u1:t") == 10);
+   fail_unless(get_int("u1:o") == 11);
+   fail_unless(get_int("y") == 11);
+   fail_unless(get_int(":VHPI6:G(2):S") == 2);
+   fail_unless(get_int("vhpi6:g(3):s") == 3);
+
+   vhpi_printf("end of sim callback");
+}
+
+static void startup()
+{
+   vhpiHandleT root = vhpi_handle(vhpiRootInst, NULL);
+   check_error();
+   fail_if(root == NULL);
+
+   vhpi_printf("root name is %s", vhpi_get_str(vhpiNameP, root));
+   vhpi_printf("root full name is %s", vhpi_get_str(vhpiFullNameP, root));
+
+   fail_unless(count_iter(vhpiInternalRegions, root) == 5);
+   fail_unless(count_iter(vhpiSigDecls, root) == 3);
+   fail_unless(count_iter(vhpiPortDecls, root) == 0);
+
+   vhpiHandleT u1 = vhpi_handle_by_name("U1", root);
+   check_error();
+   fail_if(u1 == NULL);
+   fail_unless(vhpi_get(vhpiKindP, u1) == vhpiCompInstStmtK);
+   fail_unless(vhpi_handle(vhpiUpperRegion, u1) == root);
+
+   fail_unless(count_iter(vhpiDecls, u1) == 3);
+   fail_unless(count_iter(vhpiPortDecls, u1) == 2);
+
+   vhpiHandleT t = vhpi_handle_by_name("t", u1);
+   check_error();
+   fail_if(t == NULL);
+   fail_unless(vhpi_handle(vhpiImmRegion, t) == u1);
+   fail_unless(vhpi_handle_by_name(":vhpi6:u1:t", NULL) == t);
+   fail_unless(vhpi_handle_by_name("u1:t", root) == t);
+   fail_unless(vhpi_handle_by_name(
+                  (char *)vhpi_get_str(vhpiFullNameP, t), NULL) == t);
+
+   vhpiHandleT g2 = vhpi_handle_by_name("g(2)", NULL);
+   check_error();
+   fail_if(g2 == NULL);
+   fail_unless(vhpi_get(vhpiKindP, g2) == vhpiForGenerateK);
+
+   vhpiHandleT b = vhpi_handle_by_name("b", NULL);
+   check_error();
+   fail_if(b == NULL);
+   fail_unless(vhpi_get(vhpiKindP, b) == vhpiBlockStmtK);
+   fail_if(vhpi_handle_by_name("b:z", NULL) == NULL);
+
+   fail_if(vhpi_handle_by_name("\\Ext\\", NULL) == NULL);
+   fail_unless(vhpi_handle_by_name("\\EXT\\", NULL) == NULL);
+   fail_unless(vhpi_handle_by_name("nothere", NULL) == NULL);
+   fail_unless(vhpi_handle_by_name("x:y", NULL) == NULL);
+   fail_unless(vhpi_handle_by_name(":other:x", NULL) == NULL);
+   check_error();
+
+   vhpiHandleT it = vhpi_iterator(vhpiSigDecls, root);
+   check_error();
+   fail_if(it == NULL);
+   fail_if(vhpi_scan(it) == NULL);
+   vhpi_release_handle(it);
+
+   vhpiCbDataT cb_data = {
+      .reason = vhpiCbEndOfSimulation,
+      .cb_rtn = end_of_sim,
+   };
+   vhpi_register_cb(&cb_data, 0);
+   check_error();
+
+   vhpi_release_handle(root);
+}
+
+void (*vhpi_startup_routines[])() = {
+   startup,
+   NULL
+};
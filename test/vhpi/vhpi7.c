@@ -0,0 +1,154 @@
+#include "vhpi_user.h"
+#include "vhpi_ext_nvc.h"
+
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define fail_if(x)                                                      \
+   if (x) vhpi_assert(vhpiFailure, "assertion '%s' failed at %s:%d",    \
+                      #x, __FILE__, __LINE__)
+#define fail_unless(x) fail_if(!(x))
+
+#define V_WIDTH  100
+#define IV_WIDTH 8
+#define B_WIDTH  3
+#define SV_WIDTH 3
+#define LV_WIDTH 2
+
+static vhpiHandleT handles[5];
+
+static void check_error(void)
+{
+   vhpiErrorInfoT info;
+   if (vhpi_check_error(&info))
+      vhpi_assert(vhpiFailure, "unexpected error '%s'", info.message);
+}
+
+static void end_of_sim(const vhpiCbDataT *cb_data)
+{
+   vhpiEnumT v[V_WIDTH], b[B_WIDTH];
+   vhpiIntT iv[IV_WIDTH], sv[SV_WIDTH], lv[LV_WIDTH];
+
+   vhpiValueT values[5] = {
+      { .format = vhpiLogicVecVal, .bufSize = sizeof(v), .value.enumvs = v },
+      { .format = vhpiIntVecVal, .bufSize = sizeof(iv), .value.intgs = iv },
+      { .format = vhpiLogicVecVal, .bufSize = sizeof(b), .value.enumvs = b },
+      { .format = vhpiIntVecVal, .bufSize = sizeof(sv), .value.intgs = sv },
+      { .format = vhpiIntVecVal, .bufSize = sizeof(lv), .value.intgs = lv },
+   };
+
+   fail_unless(vhpi_get_values(handles, values, 5) == 0);
+   check_error();
+
+   fail_unless(values[0].numElems == V_WIDTH);
+   fail_unless(v[0] == vhpi1 && v[1] == vhpi0 && v[2] == vhpi1);
+   fail_unless(v[3] == vhpi0 && v[4] == vhpiZ && v[V_WIDTH - 1] == vhpiZ);
+
+   for (int i = 0; i < IV_WIDTH; i++)
+      fail_unless(iv[i] == (i + 1) * 10);
+
+   fail_unless(values[2].numElems == B_WIDTH);
+   fail_unless(b[0] == 0 && b[1] == 1 && b[2] == 0);
+
+   // Narrower and wider integers are sign extended or truncated
+   fail_unless(values[3].numElems == SV_WIDTH);
+   fail_unless(sv[0] == -10 && sv[1] == 20 && sv[2] == -128);
+
+   fail_unless(values[4].numElems == LV_WIDTH);
+   fail_unless(lv[0] == -7 && lv[1] == 8);
+
+   vhpi_printf("end of sim callback");
+}
+
+static void start_of_sim(const vhpiCbDataT *cb_data)
+{
+   vhpiEnumT v[V_WIDTH], b[B_WIDTH];
+   vhpiIntT iv[IV_WIDTH], sv[SV_WIDTH], lv[LV_WIDTH];
+
+   vhpiValueT values[5] = {
+      { .format = vhpiObjTypeVal, .bufSize = sizeof(v), .value.enumvs = v },
+      { .format = vhpiObjTypeVal, .bufSize = sizeof(iv), .value.intgs = iv },
+      { .format = vhpiObjTypeVal, .bufSize = sizeof(b), .value.enumvs = b },
+      { .format = vhpiIntVecVal, .bufSize = sizeof(sv), .value.intgs = sv },
+      { .format = vhpiIntVecVal, .bufSize = sizeof(lv), .value.intgs = lv },
+   };
+
+   fail_unless(vhpi_get_values(handles, values, 5) == 0);
+   check_error();
+
+   fail_unless(values[0].format == vhpiLogicVecVal);
+   fail_unless(values[0].numElems == V_WIDTH);
+   fail_unless(v[V_WIDTH - 1] == vhpi1);
+   for (int i = 0; i < V_WIDTH - 1; i++)
+      fail_unless(v[i] == vhpi0);
+
+   fail_unless(values[1].format == vhpiIntVecVal);
+   fail_unless(values[1].numElems == IV_WIDTH);
+   for (int i = 0; i < IV_WIDTH; i++)
+      fail_unless(iv[i] == i + 1);
+
+   fail_unless(values[2].format == vhpiLogicVecVal);
+   fail_unless(values[2].numElems == B_WIDTH);
+   fail_unless(b[0] == 1 && b[1] == 0 && b[2] == 1);
+
+   fail_unless(values[3].numElems == SV_WIDTH);
+   fail_unless(sv[0] == -1 && sv[1] == -2 && sv[2] == 3);
+
+   // The low 32 bits of -2**40 are all zero
+   fail_unless(values[4].numElems == LV_WIDTH);
+   fail_unless(lv[0] == 0 && lv[1] == 5);
+
+   for (int i = 0; i < V_WIDTH; i++)
+      v[i] = i < 4 ? (i % 2 ? vhpi0 : vhpi1) : vhpiZ;
+
+   for (int i = 0; i < IV_WIDTH; i++)
+      iv[i] = (i + 1) * 10;
+
+   for (int i = 0; i < B_WIDTH; i++)
+      b[i] = !b[i];
+
+   sv[0] = -10;
+   sv[1] = 20;
+   sv[2] = -128;
+
+   lv[0] = -7;
+   lv[1] = 8;
+
+   fail_unless(vhpi_put_values(handles, values, 5, vhpiForcePropagate) == 0);
+   check_error();
+
+   vhpiCbDataT cb_data2 = {
+      .reason = vhpiCbEndOfSimulation,
+      .cb_rtn = end_of_sim,
+   };
+   vhpi_register_cb(&cb_data2, 0);
+   check_error();
+}
+
+static void startup()
+{
+   vhpiHandleT root = vhpi_handle(vhpiRootInst, NULL);
+   check_error();
+   fail_if(root == NULL);
+
+   static const char *names[] = { "v", "iv", "b", "sv", "lv" };
+   for (int i = 0; i < 5; i++) {
+      handles[i] = vhpi_handle_by_name(names[i], root);
+      check_error();
+      fail_if(handles[i] == NULL);
+   }
+
+   vhpiCbDataT cb_data = {
+      .reason = vhpiCbStartOfSimulation,
+      .cb_rtn = start_of_sim,
+   };
+   vhpi_register_cb(&cb_data, 0);
+   check_error();
+}
+
+void (*vhpi_startup_routines[])() = {
+   startup,
+   NULL
+};
@@ -0,0 +1,114 @@
+#include "vhpi_user.h"
+#include "vhpi_ext_nvc.h"
+
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define fail_if(x)                                                      \
+   if (x) vhpi_assert(vhpiFailure, "assertion '%s' failed at %s:%d",    \
+                      #x, __FILE__, __LINE__)
+#define fail_unless(x) fail_if(!(x))
+
+enum {
+   CLK_RISING, CLK_FALLING, CLK_ANY, B_RISING, V0_ANY, V7_RISING,
+   V_ONCE, V_ANY, NUM_COUNTERS
+};
+
+static int counters[NUM_COUNTERS];
+
+static void check_error(void)
+{
+   vhpiErrorInfoT info;
+   if (vhpi_check_error(&info))
+      vhpi_assert(vhpiFailure, "unexpected error '%s'", info.message);
+}
+
+static void count_cb(const vhpiCbDataT *cb_data)
+{
+   (*(int *)cb_data->user_data)++;
+}
+
+static void register_filtered(const char *name, int counter,
+                              vhpiEdgeT edge, int offset, int count,
+                              int once)
+{
+   vhpiHandleT h = vhpi_handle_by_name(name, NULL);
+   check_error();
+   fail_if(h == NULL);
+
+   vhpiCbDataT v_cb_data = {
+      .reason    = vhpiCbValueChange,
+      .cb_rtn    = count_cb,
+      .obj       = h,
+      .user_data = &(counters[counter]),
+   };
+
+   const vhpiCbFilterT filter = {
+      .edge   = edge,
+      .offset = offset,
+      .count  = count,
+      .once   = once,
+   };
+
+   vhpi_register_filtered_cb(&v_cb_data, &filter, 0);
+   check_error();
+}
+
+static void end_of_sim(const vhpiCbDataT *cb_data)
+{
+   for (int i = 0; i < NUM_COUNTERS; i++)
+      vhpi_printf("counter %d = %d", i, counters[i]);
+
+   fail_unless(counters[CLK_RISING] == 11);
+   fail_unless(counters[CLK_FALLING] == 11);
+   fail_unless(counters[CLK_ANY] == 24);
+   fail_unless(counters[B_RISING] == 1);
+   fail_unless(counters[V0_ANY] == 2);
+   fail_unless(counters[V7_RISING] == 1);
+   fail_unless(counters[V_ONCE] == 2);
+   fail_unless(counters[V_ANY] == 4);
+}
+
+static void start_of_sim(const vhpiCbDataT *cb_data)
+{
+   register_filtered("clk", CLK_RISING, vhpiRisingEdge, 0, 0, 0);
+   register_filtered("clk", CLK_FALLING, vhpiFallingEdge, 0, 0, 0);
+   register_filtered("clk", CLK_ANY, vhpiAnyEdge, 0, 0, 0);
+   register_filtered("b", B_RISING, vhpiRisingEdge, 0, 0, 0);
+   register_filtered("v", V0_ANY, vhpiAnyEdge, 7, 1, 0);
+   register_filtered("v", V7_RISING, vhpiRisingEdge, 0, 1, 0);
+   register_filtered("v", V_ONCE, vhpiAnyEdge, 0, 0, 1);
+
+   vhpiCbDataT v_cb_data = {
+      .reason    = vhpiCbValueChange,
+      .cb_rtn    = count_cb,
+      .obj       = vhpi_handle_by_name("v", NULL),
+      .user_data = &(counters[V_ANY]),
+   };
+   vhpi_register_cb(&v_cb_data, 0);
+   check_error();
+}
+
+static void startup()
+{
+   vhpiCbDataT cb_data1 = {
+      .reason = vhpiCbStartOfSimulation,
+      .cb_rtn = start_of_sim,
+   };
+   vhpi_register_cb(&cb_data1, 0);
+   check_error();
+
+   vhpiCbDataT cb_data2 = {
+      .reason = vhpiCbEndOfSimulation,
+      .cb_rtn = end_of_sim,
+   };
+   vhpi_register_cb(&cb_data2, 0);
+   check_error();
+}
+
+void (*vhpi_startup_routines[])() = {
+   startup,
+   NULL
+};